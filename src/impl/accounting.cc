@@ -0,0 +1,181 @@
+/*
+ * (C) 2021 Jack Hay
+ *
+ * Untitled Swamp game
+ */
+
+#include "accounting.h"
+#include "metrics.h"
+#include "compositor.h"
+#include <unordered_map>
+#include <vector>
+#include <mutex>
+
+namespace impl {
+namespace accounting {
+
+  //textures are uploaded as 32 bit pixels
+  #define BYTES_PER_PIXEL 4
+
+  /**
+   * A tracked texture
+   */
+  typedef struct record_t {
+    std::string category;
+    std::string owner;
+    size_t bytes;
+  } record_t;
+
+  //guards the accounting state (textures are created by the render and
+  //loading threads)
+  static std::mutex accounting_lock;
+  //the owner new textures are attributed to
+  static std::string current_owner = GLOBAL_OWNER;
+  //tracked textures
+  static std::unordered_map<SDL_Texture*, record_t> textures;
+  //running totals
+  static std::map<std::string, size_t> by_category;
+  static std::map<std::string, size_t> by_owner;
+
+  //the metrics gauges the active level publishes object counts to
+  static const char *count_names[] = {
+    "entities", "env_elems", "items", "insects", "foam_particles", "tilemap_bytes"
+  };
+
+  /**
+   * Remove a record from the totals
+   * (expects the lock to be held)
+   * @param r the record
+   */
+  static void untrack(const record_t& r) {
+    by_category[r.category] -= r.bytes;
+    by_owner[r.owner] -= r.bytes;
+
+    //drop levels that have been freed entirely
+    if (by_owner[r.owner] == 0) {
+      by_owner.erase(r.owner);
+    }
+  }
+
+  /**
+   * Constructor
+   * @param owner the owner for allocations in this scope
+   */
+  owner_scope_t::owner_scope_t(const std::string& owner) {
+    std::unique_lock<std::mutex> lock(accounting_lock);
+    prev = current_owner;
+    current_owner = owner;
+  }
+
+  /**
+   * Restore the previous owner
+   */
+  owner_scope_t::~owner_scope_t() {
+    std::unique_lock<std::mutex> lock(accounting_lock);
+    current_owner = prev;
+  }
+
+  /**
+   * Register a texture with the accountant
+   * (registering a texture again changes its category)
+   * @param texture  the texture
+   * @param category the subsystem the texture belongs to
+   * @param w        the width of the texture
+   * @param h        the height of the texture
+   */
+  void track_texture(SDL_Texture* texture,
+                     const std::string& category,
+                     int w, int h) {
+    if (texture == NULL) {
+      return;
+    }
+
+    std::unique_lock<std::mutex> lock(accounting_lock);
+
+    //re-registered (i.e. generated texture used as a tileset)
+    auto existing = textures.find(texture);
+    if (existing != textures.end()) {
+      untrack(existing->second);
+    }
+
+    record_t r = {category, current_owner, (size_t) w * h * BYTES_PER_PIXEL};
+    by_category[r.category] += r.bytes;
+    by_owner[r.owner] += r.bytes;
+    textures[texture] = r;
+  }
+
+  /**
+   * Unregister and destroy a texture
+   * @param texture the texture to free
+   */
+  void free_texture(SDL_Texture* texture) {
+    if (texture == NULL) {
+      return;
+    }
+
+    {
+      std::unique_lock<std::mutex> lock(accounting_lock);
+      auto existing = textures.find(texture);
+      if (existing != textures.end()) {
+        untrack(existing->second);
+        textures.erase(existing);
+      }
+    }
+
+    compositor::forget(texture);
+    SDL_DestroyTexture(texture);
+  }
+
+  /**
+   * Get the total texture bytes in each category
+   * @return bytes by category
+   */
+  std::map<std::string, size_t> category_totals() {
+    std::unique_lock<std::mutex> lock(accounting_lock);
+    return by_category;
+  }
+
+  /**
+   * Get the total texture bytes held by each owner
+   * @return bytes by owner
+   */
+  std::map<std::string, size_t> owner_totals() {
+    std::unique_lock<std::mutex> lock(accounting_lock);
+    return by_owner;
+  }
+
+  /**
+   * Get the object counts published by the active level
+   * (entities, environment elements, items, particle pools, tilemap bytes)
+   * @return counts by name
+   */
+  std::map<std::string, int64_t> object_counts() {
+    //looked up once (lookups take the registry lock)
+    static std::vector<metrics::gauge_t*> gauges = []() {
+      std::vector<metrics::gauge_t*> found;
+      for (const char *name : count_names) {
+        found.push_back(&metrics::gauge(name));
+      }
+      return found;
+    }();
+
+    std::map<std::string, int64_t> counts;
+    for (size_t i=0; i<gauges.size(); i++) {
+      counts[count_names[i]] = gauges.at(i)->get();
+    }
+    return counts;
+  }
+
+  /**
+   * Dump all totals and object counts
+   * @return the totals as json
+   */
+  json dump() {
+    std::map<std::string, int64_t> counts = object_counts();
+    std::unique_lock<std::mutex> lock(accounting_lock);
+    return {{"textures", textures.size()},
+            {"categories", by_category},
+            {"owners", by_owner},
+            {"counts", counts}};
+  }
+}}
@@ -0,0 +1,98 @@
+/*
+ * (C) 2021 Jack Hay
+ *
+ * Untitled Swamp game
+ */
+
+#ifndef _IO_JACKHAY_SWAMP_ACCOUNTING_H
+#define _IO_JACKHAY_SWAMP_ACCOUNTING_H
+
+#include <SDL2/SDL.h>
+#include <string>
+#include <map>
+#include <json/nlohmann_json.h>
+
+namespace impl {
+namespace accounting {
+
+  typedef nlohmann::json json;
+
+  //texture categories
+  #define TEXTURE_FILE "file"
+  #define TEXTURE_FONT "font"
+  #define TEXTURE_GENERATED "generated"
+  #define TEXTURE_TILESET "tileset"
+  #define TEXTURE_TARGET "target"
+
+  //the owner for allocations outside of any level
+  #define GLOBAL_OWNER "global"
+
+  /**
+   * Attributes new allocations to some owner (i.e. a level)
+   * while in scope, then restores the previous owner
+   */
+  struct owner_scope_t {
+  private:
+    //the owner before this scope
+    std::string prev;
+
+  public:
+    /**
+     * Constructor
+     * @param owner the owner for allocations in this scope
+     */
+    owner_scope_t(const std::string& owner);
+    owner_scope_t(const owner_scope_t&) = delete;
+    owner_scope_t& operator=(const owner_scope_t&) = delete;
+
+    /**
+     * Restore the previous owner
+     */
+    ~owner_scope_t();
+  };
+
+  /**
+   * Register a texture with the accountant
+   * (registering a texture again changes its category)
+   * @param texture  the texture
+   * @param category the subsystem the texture belongs to
+   * @param w        the width of the texture
+   * @param h        the height of the texture
+   */
+  void track_texture(SDL_Texture* texture,
+                     const std::string& category,
+                     int w, int h);
+
+  /**
+   * Unregister and destroy a texture
+   * @param texture the texture to free
+   */
+  void free_texture(SDL_Texture* texture);
+
+  /**
+   * Get the total texture bytes in each category
+   * @return bytes by category
+   */
+  std::map<std::string, size_t> category_totals();
+
+  /**
+   * Get the total texture bytes held by each owner
+   * @return bytes by owner
+   */
+  std::map<std::string, size_t> owner_totals();
+
+  /**
+   * Get the object counts published by the active level
+   * (entities, environment elements, items, particle pools, tilemap bytes)
+   * @return counts by name
+   */
+  std::map<std::string, int64_t> object_counts();
+
+  /**
+   * Dump all totals and object counts
+   * @return the totals as json
+   */
+  json dump();
+}}
+
+#endif /*_IO_JACKHAY_SWAMP_ACCOUNTING_H*/
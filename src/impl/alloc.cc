@@ -0,0 +1,377 @@
+/*
+ * (C) 2021 Jack Hay
+ *
+ * Untitled Swamp game
+ */
+
+#include "alloc.h"
+#include "metrics.h"
+#include "logger.h"
+#include <atomic>
+#include <mutex>
+#include <map>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <new>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <execinfo.h>
+#include <unistd.h>
+
+namespace impl {
+namespace alloc {
+
+  //modes (as stored)
+  #define MODE_OFF 0
+  #define MODE_COUNT 1
+  #define MODE_ASSERT 2
+
+  //frames captured for an allocation and the one used as its call site
+  //(0 is record, 1 is operator new, 2 is usually an allocator)
+  #define ALLOC_TRACE_DEPTH 12
+  #define ALLOC_SITE_FRAME 3
+
+  //the sampled sites dumped
+  #define ALLOC_TOP_SITES 10
+
+  /**
+   * Allocations made by a thread since its last publish
+   * (plain data so operator new can use it before anything is initialized)
+   */
+  typedef struct thread_stats_t {
+    uint64_t allocs[ALLOC_MAX_ZONES];
+    uint64_t bytes[ALLOC_MAX_ZONES];
+    //the current zone
+    int zone;
+    //whether in a steady state loop
+    bool steady;
+    //set while the tracker itself allocates
+    bool busy;
+    //allocations seen (for sampling)
+    uint64_t seen;
+  } thread_stats_t;
+
+  /**
+   * A published interval
+   */
+  typedef struct interval_t {
+    uint64_t allocs[ALLOC_MAX_ZONES];
+    uint64_t bytes[ALLOC_MAX_ZONES];
+  } interval_t;
+
+  /**
+   * A call site (addresses are claimed once and never released)
+   */
+  typedef struct site_t {
+    std::atomic<void*> addr;
+    std::atomic<uint64_t> samples;
+    //whether a steady state allocation here was reported
+    std::atomic<bool> reported;
+  } site_t;
+
+  static thread_local thread_stats_t stats;
+
+  static std::atomic<int> mode(MODE_OFF);
+  static std::atomic<int> sample_every(0);
+
+  //zone names by id (only ids below the count are read)
+  static const char *zone_names[ALLOC_MAX_ZONES] = {ALLOC_ZONE_OTHER};
+  static std::atomic<int> zone_count(1);
+  static std::mutex zone_lock;
+
+  static site_t sites[ALLOC_MAX_SITES];
+
+  //allocations made in steady state (assert mode)
+  static std::atomic<uint64_t> steady_allocs(0);
+
+  //the last published intervals by name
+  static std::map<std::string, interval_t> intervals;
+  static std::mutex interval_lock;
+
+  /**
+   * Get the id of a zone, registering it on first use
+   * @param  name the zone
+   * @return      the id (the other zone if there are too many)
+   */
+  static int zone_id(const char *name) {
+    int count = zone_count.load(std::memory_order_acquire);
+    for (int i=0; i<count; i++) {
+      if ((zone_names[i] == name) || (std::strcmp(zone_names[i], name) == 0)) {
+        return i;
+      }
+    }
+
+    std::unique_lock<std::mutex> lk(zone_lock);
+    count = zone_count.load(std::memory_order_relaxed);
+    for (int i=0; i<count; i++) {
+      if (std::strcmp(zone_names[i], name) == 0) {
+        return i;
+      }
+    }
+    if (count >= ALLOC_MAX_ZONES) {
+      return 0;
+    }
+    zone_names[count] = name;
+    zone_count.store(count + 1, std::memory_order_release);
+    return count;
+  }
+
+  /**
+   * Constructor
+   * @param name the zone (a string literal, registered on first use)
+   */
+  zone_t::zone_t(const char *name)
+    : prev(stats.zone) {
+    stats.zone = zone_id(name);
+  }
+
+  /**
+   * Attribute further allocations in this scope to another zone
+   * @param name the zone
+   */
+  void zone_t::enter(const char *name) {
+    stats.zone = zone_id(name);
+  }
+
+  /**
+   * Restore the previous zone
+   */
+  zone_t::~zone_t() {
+    stats.zone = prev;
+  }
+
+  /**
+   * Constructor
+   * @param steady whether allocations are unexpected in this scope
+   */
+  steady_scope_t::steady_scope_t(bool steady)
+    : prev(stats.steady) {
+    stats.steady = steady;
+  }
+
+  /**
+   * Restore the previous state
+   */
+  steady_scope_t::~steady_scope_t() {
+    stats.steady = prev;
+  }
+
+  /**
+   * Start tracking allocations (off by default)
+   * @param mode         ALLOC_OFF, ALLOC_COUNT or ALLOC_ASSERT
+   * @param sample_every sample the call site of every nth allocation on a thread (0 for none)
+   */
+  void set_mode(const std::string& mode, int sample_every) {
+    int m = MODE_OFF;
+    if (mode == ALLOC_COUNT) {
+      m = MODE_COUNT;
+    } else if (mode == ALLOC_ASSERT) {
+      m = MODE_ASSERT;
+    } else if (mode != ALLOC_OFF) {
+      logger::log_warn("unknown allocation tracking mode: " + mode);
+    }
+
+    alloc::sample_every.store(std::max(sample_every, 0));
+    alloc::mode.store(m);
+
+    if (m != MODE_OFF) {
+      logger::log_info("tracking allocations (" + mode + ")");
+    }
+  }
+
+  /**
+   * Find or claim the entry for a call site
+   * @param  addr the call site
+   * @return      the entry (NULL if the table is full)
+   */
+  static site_t* find_site(void *addr) {
+    size_t idx = (((uintptr_t) addr) >> 4) % ALLOC_MAX_SITES;
+    for (size_t i=0; i<ALLOC_MAX_SITES; i++) {
+      site_t& site = sites[(idx + i) % ALLOC_MAX_SITES];
+      void *current = site.addr.load();
+      if (current == addr) {
+        return &site;
+      }
+      if ((current == NULL) && (site.addr.compare_exchange_strong(current, addr) || (current == addr))) {
+        return &site;
+      }
+    }
+    return NULL;
+  }
+
+  /**
+   * Record an allocation (called by operator new)
+   * @param bytes the size
+   */
+  void record(size_t bytes) {
+    int m = mode.load(std::memory_order_relaxed);
+    if ((m == MODE_OFF) || stats.busy) {
+      return;
+    }
+
+    stats.allocs[stats.zone]++;
+    stats.bytes[stats.zone] += bytes;
+    stats.seen++;
+
+    int every = sample_every.load(std::memory_order_relaxed);
+    bool sample = (every > 0) && ((stats.seen % every) == 0);
+    bool steady = stats.steady && (m == MODE_ASSERT);
+    if (!sample && !steady) {
+      return;
+    }
+
+    //backtrace may allocate the first time
+    stats.busy = true;
+
+    void *frames[ALLOC_TRACE_DEPTH];
+    int depth = backtrace(frames, ALLOC_TRACE_DEPTH);
+    site_t *site = (depth > 0) ? find_site(frames[std::min(depth - 1, ALLOC_SITE_FRAME)]) : NULL;
+
+    if (sample && (site != NULL)) {
+      site->samples.fetch_add(1);
+    }
+
+    if (steady) {
+      steady_allocs.fetch_add(1);
+
+      //report each site once (without allocating)
+      if ((site != NULL) && !site->reported.exchange(true)) {
+        static const char msg[] = "lvl=warn,msg=\"allocation in steady state loop\"\n";
+        if (write(STDERR_FILENO, msg, sizeof(msg) - 1) > 0) {
+          backtrace_symbols_fd(frames, depth, STDERR_FILENO);
+        }
+      }
+    }
+
+    stats.busy = false;
+  }
+
+  /**
+   * Publish the allocations this thread made since its last publish
+   * as an interval (i.e. "tick" on the update thread, "frame" on the render thread)
+   * @param interval the interval name (a string literal)
+   */
+  void publish(const char *interval) {
+    if (mode.load(std::memory_order_relaxed) == MODE_OFF) {
+      return;
+    }
+
+    //publishing isn't counted
+    stats.busy = true;
+
+    uint64_t allocs = 0;
+    uint64_t bytes = 0;
+    {
+      std::unique_lock<std::mutex> lk(interval_lock);
+      interval_t& published = intervals[interval];
+      for (size_t i=0; i<ALLOC_MAX_ZONES; i++) {
+        published.allocs[i] = stats.allocs[i];
+        published.bytes[i] = stats.bytes[i];
+        allocs += stats.allocs[i];
+        bytes += stats.bytes[i];
+        stats.allocs[i] = 0;
+        stats.bytes[i] = 0;
+      }
+    }
+
+    metrics::gauge(std::string("allocs_per_") + interval).set(allocs);
+    metrics::gauge(std::string("alloc_bytes_per_") + interval).set(bytes);
+
+    stats.busy = false;
+  }
+
+  /**
+   * Dump the last published intervals by zone, steady state
+   * allocations and the most sampled call sites
+   * @return the report as json
+   */
+  json dump() {
+    static const char *modes[] = {ALLOC_OFF, ALLOC_COUNT, ALLOC_ASSERT};
+
+    json report;
+    report["mode"] = modes[mode.load()];
+    report["steady_allocs"] = steady_allocs.load();
+
+    int count = zone_count.load(std::memory_order_acquire);
+    json published = json::object();
+    {
+      std::unique_lock<std::mutex> lk(interval_lock);
+      for (auto it=intervals.begin(); it!=intervals.end(); it++) {
+        const interval_t& iv = it->second;
+        uint64_t allocs = 0;
+        uint64_t bytes = 0;
+        json zones = json::object();
+
+        for (int i=0; i<count; i++) {
+          if (iv.allocs[i] > 0) {
+            zones[zone_names[i]] = {{"allocs", iv.allocs[i]}, {"bytes", iv.bytes[i]}};
+          }
+          allocs += iv.allocs[i];
+          bytes += iv.bytes[i];
+        }
+        published[it->first] = {{"allocs", allocs}, {"bytes", bytes}, {"zones", zones}};
+      }
+    }
+    report["intervals"] = published;
+
+    //the most sampled call sites
+    std::vector<std::pair<uint64_t, void*>> sampled;
+    for (size_t i=0; i<ALLOC_MAX_SITES; i++) {
+      uint64_t samples = sites[i].samples.load();
+      if (samples > 0) {
+        sampled.push_back(std::make_pair(samples, sites[i].addr.load()));
+      }
+    }
+    std::sort(sampled.begin(), sampled.end(), std::greater<std::pair<uint64_t, void*>>());
+    sampled.resize(std::min(sampled.size(), (size_t) ALLOC_TOP_SITES));
+
+    json top = json::array();
+    std::vector<void*> addrs;
+    for (size_t i=0; i<sampled.size(); i++) {
+      addrs.push_back(sampled.at(i).second);
+    }
+    char **symbols = addrs.empty() ? NULL : backtrace_symbols(addrs.data(), addrs.size());
+    for (size_t i=0; i<sampled.size(); i++) {
+      top.push_back({{"site", (symbols != NULL) ? symbols[i] : "?"},
+                     {"samples", sampled.at(i).first}});
+    }
+    free(symbols);
+    report["sites"] = top;
+
+    return report;
+  }
+}}
+
+/**
+ * Global allocation (counted when tracking)
+ */
+void* operator new(std::size_t size) {
+  impl::alloc::record(size);
+  void *ptr = std::malloc((size == 0) ? 1 : size);
+  if (ptr == NULL) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void* operator new[](std::size_t size) {
+  return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
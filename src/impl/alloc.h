@@ -0,0 +1,116 @@
+/*
+ * (C) 2021 Jack Hay
+ *
+ * Untitled Swamp game
+ */
+
+#ifndef _IO_JACKHAY_SWAMP_ALLOC_H
+#define _IO_JACKHAY_SWAMP_ALLOC_H
+
+#include <string>
+#include <json/nlohmann_json.h>
+
+namespace impl {
+namespace alloc {
+
+  typedef nlohmann::json json;
+
+  //tracking modes
+  #define ALLOC_OFF "off"
+  #define ALLOC_COUNT "count"
+  //count and report allocations in steady state loops
+  #define ALLOC_ASSERT "assert"
+
+  //the most zones that can be registered (later zones count as the first)
+  #define ALLOC_MAX_ZONES 32
+
+  //the zone for allocations outside of any zone
+  #define ALLOC_ZONE_OTHER "other"
+
+  //call sites kept for sampled allocations
+  #define ALLOC_MAX_SITES 512
+
+  /**
+   * Attributes allocations on this thread to a profiling zone
+   * while in scope, then restores the previous zone
+   */
+  struct zone_t {
+  private:
+    //the zone before this scope
+    int prev;
+
+  public:
+    /**
+     * Constructor
+     * @param name the zone (a string literal, registered on first use)
+     */
+    zone_t(const char *name);
+    zone_t(const zone_t&) = delete;
+    zone_t& operator=(const zone_t&) = delete;
+
+    /**
+     * Attribute further allocations in this scope to another zone
+     * @param name the zone
+     */
+    void enter(const char *name);
+
+    /**
+     * Restore the previous zone
+     */
+    ~zone_t();
+  };
+
+  /**
+   * Marks a steady state loop (or a loading step within one) on
+   * this thread while in scope, then restores the previous state
+   * Allocations in steady state are reported in assert mode
+   */
+  struct steady_scope_t {
+  private:
+    //the state before this scope
+    bool prev;
+
+  public:
+    /**
+     * Constructor
+     * @param steady whether allocations are unexpected in this scope
+     */
+    steady_scope_t(bool steady=true);
+    steady_scope_t(const steady_scope_t&) = delete;
+    steady_scope_t& operator=(const steady_scope_t&) = delete;
+
+    /**
+     * Restore the previous state
+     */
+    ~steady_scope_t();
+  };
+
+  /**
+   * Start tracking allocations (off by default)
+   * @param mode         ALLOC_OFF, ALLOC_COUNT or ALLOC_ASSERT
+   * @param sample_every sample the call site of every nth allocation on a thread (0 for none)
+   */
+  void set_mode(const std::string& mode, int sample_every);
+
+  /**
+   * Record an allocation (called by operator new)
+   * @param bytes the size
+   */
+  void record(size_t bytes);
+
+  /**
+   * Publish the allocations this thread made since its last publish
+   * as an interval (i.e. "tick" on the update thread, "frame" on the render thread)
+   * @param interval the interval name (a string literal)
+   */
+  void publish(const char *interval);
+
+  /**
+   * Dump the last published intervals by zone, steady state
+   * allocations and the most sampled call sites
+   * @return the report as json
+   */
+  json dump();
+}}
+
+#endif /*_IO_JACKHAY_SWAMP_ALLOC_H*/
@@ -0,0 +1,150 @@
+/*
+ * (C) 2021 Jack Hay
+ *
+ * Untitled Swamp game
+ */
+
+#include "arena.h"
+#include "logger.h"
+#include <algorithm>
+#include <atomic>
+
+namespace impl {
+namespace arena {
+
+  /**
+   * Constructor
+   * @param next the resource allocated from
+   */
+  counted_t::counted_t(std::pmr::memory_resource *next)
+    : next(next),
+      bytes(0) {}
+
+  void* counted_t::do_allocate(size_t bytes, size_t align) {
+    this->bytes += bytes;
+    return next->allocate(bytes, align);
+  }
+
+  void counted_t::do_deallocate(void *p, size_t bytes, size_t align) {
+    next->deallocate(p, bytes, align);
+  }
+
+  bool counted_t::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+  }
+
+  /**
+   * Constructor
+   * @param capacity the initial buffer size (bytes)
+   */
+  tick_arena_t::tick_arena_t(size_t capacity)
+    : buffer(),
+      capacity(capacity),
+      overflow(std::pmr::new_delete_resource()),
+      resource(),
+      used(NULL),
+      used_bytes(metrics::gauge("tick_arena_bytes")) {
+    this->make_resource();
+  }
+
+  /**
+   * Allocate the buffer and the resource over it
+   */
+  void tick_arena_t::make_resource() {
+    //the old resource returns its overflow before the buffer goes
+    resource.reset();
+    buffer = std::make_unique<char[]>(capacity);
+    resource = std::make_unique<std::pmr::monotonic_buffer_resource>(buffer.get(),
+                                                                      capacity,
+                                                                      &overflow);
+    used.set_next(resource.get());
+  }
+
+  /**
+   * Release everything allocated this tick
+   * (if the buffer overflowed it is grown so later ticks fit)
+   */
+  void tick_arena_t::reset() {
+    used_bytes.set(used.get_bytes());
+    used.reset();
+
+    if (overflow.get_bytes() > 0) {
+      capacity = std::max(capacity * 2, capacity + overflow.get_bytes());
+      overflow.reset();
+      logger::log_lazy(LOG_DEBUG, [this]() {
+        return "tick arena grown to " + std::to_string(capacity) + " bytes";
+      });
+      this->make_resource();
+    } else {
+      resource->release();
+    }
+  }
+
+  //the arena level objects on this thread are made in
+  static thread_local level_arena_t *current_level = NULL;
+
+  //bytes held by all level arenas
+  static std::atomic<int64_t> level_bytes(0);
+
+  /**
+   * Constructor
+   * @param block the size of the first block (later blocks grow)
+   */
+  level_arena_t::level_arena_t(size_t block)
+    : blocks(std::pmr::new_delete_resource()),
+      resource(block, &blocks),
+      published(0) {}
+
+  /**
+   * Publish the bytes held by all level arenas
+   */
+  void level_arena_t::publish() {
+    static metrics::gauge_t& held = metrics::gauge("level_arena_bytes");
+    int64_t change = (int64_t) blocks.get_bytes() - (int64_t) published;
+    published = blocks.get_bytes();
+    held.set(level_bytes.fetch_add(change) + change);
+  }
+
+  /**
+   * Release all blocks
+   */
+  level_arena_t::~level_arena_t() {
+    logger::log_lazy(LOG_DEBUG, [this]() {
+      return "released level arena (" + std::to_string(blocks.get_bytes()) + " bytes)";
+    });
+    resource.release();
+    blocks.reset();
+    this->publish();
+  }
+
+  /**
+   * Constructor
+   * @param arena the arena for level objects (NULL for the heap)
+   */
+  level_scope_t::level_scope_t(level_arena_t *arena)
+    : prev(current_level) {
+    current_level = arena;
+  }
+
+  /**
+   * Restore the previous arena
+   */
+  level_scope_t::~level_scope_t() {
+    //publish what the level took
+    if (current_level != NULL) {
+      current_level->publish();
+    }
+    current_level = prev;
+  }
+
+  /**
+   * Get the resource for level objects
+   * @return the level arena in scope or the heap
+   */
+  std::pmr::memory_resource* level() {
+    if (current_level == NULL) {
+      return std::pmr::get_default_resource();
+    }
+    return &current_level->get();
+  }
+}}
@@ -0,0 +1,218 @@
+/*
+ * (C) 2021 Jack Hay
+ *
+ * Untitled Swamp game
+ */
+
+#ifndef _IO_JACKHAY_SWAMP_ARENA_H
+#define _IO_JACKHAY_SWAMP_ARENA_H
+
+#include <memory>
+#include <memory_resource>
+#include "metrics.h"
+
+namespace impl {
+namespace arena {
+
+  //the initial size of the tick arena (bytes)
+  #define TICK_ARENA_SIZE (64 * 1024)
+
+  //the size of the first block a level arena takes from the heap (bytes)
+  #define LEVEL_ARENA_BLOCK (1024 * 1024)
+
+  /**
+   * Forwards to another resource and counts the bytes allocated
+   */
+  struct counted_t : public std::pmr::memory_resource {
+  private:
+    //the resource allocated from
+    std::pmr::memory_resource *next;
+
+    //bytes allocated since the last reset
+    size_t bytes;
+
+    void* do_allocate(size_t bytes, size_t align) override;
+    void do_deallocate(void *p, size_t bytes, size_t align) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+  public:
+    /**
+     * Constructor
+     * @param next the resource allocated from
+     */
+    counted_t(std::pmr::memory_resource *next);
+    counted_t(const counted_t&) = delete;
+    counted_t& operator=(const counted_t&) = delete;
+
+    /**
+     * Set the resource allocated from
+     * @param next the resource
+     */
+    void set_next(std::pmr::memory_resource *next) { this->next = next; }
+
+    /**
+     * Get the bytes allocated since the last reset
+     * @return the bytes
+     */
+    size_t get_bytes() const { return bytes; }
+
+    /**
+     * Reset the count
+     */
+    void reset() { bytes = 0; }
+  };
+
+  /**
+   * Memory for data that only lives for one tick (positions, scratch lists)
+   * Allocation is a pointer bump into a preallocated buffer and
+   * nothing is freed until the whole arena is reset at the end of the tick
+   * (update thread only)
+   */
+  struct tick_arena_t {
+  private:
+    //the preallocated buffer
+    std::unique_ptr<char[]> buffer;
+    size_t capacity;
+
+    //allocations past the end of the buffer (from the heap)
+    counted_t overflow;
+
+    //bump allocation into the buffer
+    std::unique_ptr<std::pmr::monotonic_buffer_resource> resource;
+
+    //what the tick allocated
+    counted_t used;
+
+    //bytes used by the last tick (metrics)
+    metrics::gauge_t& used_bytes;
+
+    /**
+     * Allocate the buffer and the resource over it
+     */
+    void make_resource();
+
+  public:
+    /**
+     * Constructor
+     * @param capacity the initial buffer size (bytes)
+     */
+    tick_arena_t(size_t capacity=TICK_ARENA_SIZE);
+    tick_arena_t(const tick_arena_t&) = delete;
+    tick_arena_t& operator=(const tick_arena_t&) = delete;
+
+    /**
+     * Get the resource to allocate tick data from
+     * @return the resource
+     */
+    std::pmr::memory_resource& get() { return used; }
+
+    /**
+     * Get the buffer size
+     * @return the capacity in bytes
+     */
+    size_t get_capacity() const { return capacity; }
+
+    /**
+     * Release everything allocated this tick
+     * (if the buffer overflowed it is grown so later ticks fit)
+     */
+    void reset();
+  };
+
+  /**
+   * Memory for objects that live exactly as long as a level (tiles,
+   * environment elements, forks, the tilemap itself)
+   * Objects are bump allocated from large heap blocks and nothing is returned
+   * until the arena is destroyed, so the level is released in bulk and doesn't
+   * fragment the heap (objects still have their destructors run first)
+   * Anything allocated here must be released before the arena
+   * (allocation from the thread loading the level only)
+   */
+  struct level_arena_t {
+  private:
+    //the heap blocks
+    counted_t blocks;
+
+    //bump allocation into the blocks
+    std::pmr::monotonic_buffer_resource resource;
+
+    //the bytes last published (metrics)
+    size_t published;
+
+  public:
+    /**
+     * Constructor
+     * @param block the size of the first block (later blocks grow)
+     */
+    level_arena_t(size_t block=LEVEL_ARENA_BLOCK);
+    level_arena_t(const level_arena_t&) = delete;
+    level_arena_t& operator=(const level_arena_t&) = delete;
+
+    /**
+     * Get the resource to allocate level objects from
+     * @return the resource
+     */
+    std::pmr::memory_resource& get() { return resource; }
+
+    /**
+     * Get the bytes taken from the heap
+     * @return the bytes
+     */
+    size_t get_bytes() const { return blocks.get_bytes(); }
+
+    /**
+     * Publish the bytes held by all level arenas
+     */
+    void publish();
+
+    /**
+     * Release all blocks
+     */
+    ~level_arena_t();
+  };
+
+  /**
+   * Allocates level objects made on this thread from a level arena
+   * while in scope, then restores the previous arena
+   */
+  struct level_scope_t {
+  private:
+    //the arena before this scope
+    level_arena_t *prev;
+
+  public:
+    /**
+     * Constructor
+     * @param arena the arena for level objects (NULL for the heap)
+     */
+    level_scope_t(level_arena_t *arena);
+    level_scope_t(const level_scope_t&) = delete;
+    level_scope_t& operator=(const level_scope_t&) = delete;
+
+    /**
+     * Restore the previous arena
+     */
+    ~level_scope_t();
+  };
+
+  /**
+   * Get the resource for level objects
+   * @return the level arena in scope or the heap
+   */
+  std::pmr::memory_resource* level();
+
+  /**
+   * Make an object that lives as long as the level
+   * (the object and its control block are one allocation from the level arena
+   * in scope, or the heap if there isn't one)
+   * @param  args the constructor arguments
+   * @return      the object
+   */
+  template <typename T, typename... Args>
+  std::shared_ptr<T> make_level(Args&&... args) {
+    return std::allocate_shared<T>(std::pmr::polymorphic_allocator<T>(level()),
+                                   std::forward<Args>(args)...);
+  }
+}}
+
+#endif /*_IO_JACKHAY_SWAMP_ARENA_H*/
@@ -0,0 +1,231 @@
+/*
+ * (C) 2021 Jack Hay
+ *
+ * Untitled Swamp game
+ */
+
+#include "atlas.h"
+#include "accounting.h"
+#include "compositor.h"
+#include "exceptions.h"
+#include "utils.h"
+#include <algorithm>
+#include <climits>
+
+namespace impl {
+namespace atlas {
+
+  //pages are uploaded as 32 bit pixels
+  #define BYTES_PER_PIXEL 4
+
+  /**
+   * Constructor (pages are created on the first add)
+   * @param page_dim the dimension of each page
+   * @param category the accounting category of the pages
+   */
+  atlas_t::atlas_t(int page_dim, const std::string& category)
+    : page_dim(page_dim),
+      category(category),
+      pages(),
+      footprint(0) {}
+
+  /**
+   * Free pages
+   */
+  atlas_t::~atlas_t() {
+    for (size_t i=0; i<pages.size(); i++) {
+      accounting::free_texture(pages.at(i).texture);
+    }
+  }
+
+  /**
+   * Find the lowest position an image fits at a skyline node
+   * @param  page the page
+   * @param  idx  the node the image starts at
+   * @param  w    the padded width
+   * @param  h    the padded height
+   * @return      the y position or -1 if it doesn't fit
+   */
+  int atlas_t::fit(const page_t& page, size_t idx, int w, int h) const {
+    if ((page.skyline.at(idx).x + w) > page.w) {
+      return -1;
+    }
+
+    //rest on the highest node under the image
+    int y = 0;
+    int remaining = w;
+    for (size_t i=idx; remaining > 0; i++) {
+      y = std::max(y, page.skyline.at(i).y);
+      if ((y + h) > page.h) {
+        return -1;
+      }
+      remaining -= page.skyline.at(i).w;
+    }
+    return y;
+  }
+
+  /**
+   * Find space on a page and raise the skyline over it
+   * @param  page the page
+   * @param  w    the padded width
+   * @param  h    the padded height
+   * @param  rect the position found (set by the call)
+   * @return      whether the image fit
+   */
+  bool atlas_t::pack(page_t& page, int w, int h, SDL_Rect& rect) {
+    int best_bottom = INT_MAX;
+    int best_w = INT_MAX;
+    int best_idx = -1;
+
+    //lowest bottom edge, then the narrowest node
+    for (size_t i=0; i<page.skyline.size(); i++) {
+      int y = fit(page, i, w, h);
+      if ((y >= 0) &&
+          (((y + h) < best_bottom) ||
+           (((y + h) == best_bottom) && (page.skyline.at(i).w < best_w)))) {
+        best_bottom = y + h;
+        best_w = page.skyline.at(i).w;
+        best_idx = i;
+      }
+    }
+
+    if (best_idx < 0) {
+      return false;
+    }
+
+    rect = {page.skyline.at(best_idx).x, best_bottom - h, w, h};
+    page.skyline.insert(page.skyline.begin() + best_idx, {rect.x, best_bottom, w});
+
+    //shrink or remove the nodes now under the image
+    size_t i = best_idx + 1;
+    while (i < page.skyline.size()) {
+      const skyline_node_t& prev = page.skyline.at(i - 1);
+      skyline_node_t& node = page.skyline.at(i);
+      int overlap = (prev.x + prev.w) - node.x;
+
+      if (overlap <= 0) {
+        break;
+      }
+
+      node.x += overlap;
+      node.w -= overlap;
+      if (node.w <= 0) {
+        page.skyline.erase(page.skyline.begin() + i);
+      } else {
+        break;
+      }
+    }
+
+    //merge neighbours at the same height
+    for (size_t j=0; (j + 1)<page.skyline.size();) {
+      if (page.skyline.at(j).y == page.skyline.at(j + 1).y) {
+        page.skyline.at(j).w += page.skyline.at(j + 1).w;
+        page.skyline.erase(page.skyline.begin() + j + 1);
+      } else {
+        j++;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Create a page
+   * @param  renderer the renderer
+   * @param  w        the page width
+   * @param  h        the page height
+   * @return          the page index (-1 if the texture couldn't be created)
+   */
+  int atlas_t::add_page(SDL_Renderer& renderer, int w, int h) {
+    SDL_Texture *texture = SDL_CreateTexture(&renderer,
+                                             SDL_PIXELFORMAT_RGBA32,
+                                             SDL_TEXTUREACCESS_STATIC,
+                                             w, h);
+    if (texture == NULL) {
+      return -1;
+    }
+
+    //start transparent so padding never shows
+    std::vector<Uint32> clear((size_t) w * h, 0);
+    SDL_UpdateTexture(texture, NULL, clear.data(), w * BYTES_PER_PIXEL);
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+
+    accounting::track_texture(texture, category, w, h);
+    compositor::mirror(texture, w, h);
+    footprint += (size_t) w * h * BYTES_PER_PIXEL;
+
+    pages.push_back({texture, w, h, {{0, 0, w}}});
+    return pages.size() - 1;
+  }
+
+  /**
+   * Pack an image and upload its pixels
+   * Throws gen exception if the image can't be uploaded
+   * @param  renderer the renderer
+   * @param  surface  the image (freed by the call)
+   * @return          where the image was packed
+   */
+  atlas_region_t atlas_t::add(SDL_Renderer& renderer, SDL_Surface *surface) {
+    //pages use a single pixel layout
+    if (surface->format->format != SDL_PIXELFORMAT_RGBA32) {
+      SDL_Surface *converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA32, 0);
+      SDL_FreeSurface(surface);
+      if (converted == NULL) {
+        throw exceptions::gen_exception_t("failed to convert atlas image: " +
+                                          std::string(SDL_GetError()));
+      }
+      surface = converted;
+    }
+
+    int w = surface->w + ATLAS_PADDING;
+    int h = surface->h + ATLAS_PADDING;
+    atlas_region_t region = {-1, {0,0,0,0}};
+
+    //first page with space
+    for (size_t i=0; i<pages.size(); i++) {
+      if (pack(pages.at(i), w, h, region.rect)) {
+        region.page = i;
+        break;
+      }
+    }
+
+    if (region.page < 0) {
+      //pages can't be larger than the renderer's largest texture
+      int max_w, max_h;
+      utils::max_texture_size(renderer, max_w, max_h);
+      int dim_w = std::min(page_dim, max_w);
+      int dim_h = std::min(page_dim, max_h);
+
+      if ((w > max_w) || (h > max_h)) {
+        SDL_FreeSurface(surface);
+        throw exceptions::gen_exception_t("atlas image " + std::to_string(w) + "x" +
+                                          std::to_string(h) + " is larger than the largest texture");
+      }
+
+      //images larger than a page get their own
+      if ((w > dim_w) || (h > dim_h)) {
+        region.page = add_page(renderer, w, h);
+      } else {
+        region.page = add_page(renderer, dim_w, dim_h);
+      }
+
+      if (region.page < 0) {
+        SDL_FreeSurface(surface);
+        throw exceptions::gen_exception_t("failed to create atlas page: " +
+                                          std::string(SDL_GetError()));
+      }
+      pack(pages.at(region.page), w, h, region.rect);
+    }
+
+    //exclude padding
+    region.rect.w = surface->w;
+    region.rect.h = surface->h;
+
+    SDL_UpdateTexture(pages.at(region.page).texture,
+                      &region.rect,
+                      surface->pixels,
+                      surface->pitch);
+    compositor::update(pages.at(region.page).texture, region.rect, *surface);
+    SDL_FreeSurface(surface);
+    return region;
+  }
+}}
@@ -0,0 +1,143 @@
+/*
+ * (C) 2021 Jack Hay
+ *
+ * Untitled Swamp game
+ */
+
+#ifndef _IO_JACKHAY_SWAMP_ATLAS_H
+#define _IO_JACKHAY_SWAMP_ATLAS_H
+
+#include <SDL2/SDL.h>
+#include <string>
+#include <vector>
+
+namespace impl {
+namespace atlas {
+
+  //default page dimension (pixels, square)
+  #define ATLAS_PAGE_DIM 1024
+
+  //empty pixels between packed images
+  #define ATLAS_PADDING 1
+
+  /**
+   * An image packed into an atlas
+   */
+  struct atlas_region_t {
+    //the page index
+    int page;
+    //the image bounds within the page
+    SDL_Rect rect;
+  };
+
+  /**
+   * Packs images into shared texture pages (skyline bottom-left)
+   * Pages are added as needed, images too large for a page get their own
+   * (render thread only)
+   */
+  struct atlas_t {
+  private:
+    //a horizontal segment of the packed outline
+    typedef struct skyline_node_t {
+      int x;
+      int y;
+      int w;
+    } skyline_node_t;
+
+    /**
+     * A texture page and its packed outline
+     */
+    typedef struct page_t {
+      SDL_Texture *texture;
+      int w;
+      int h;
+      std::vector<skyline_node_t> skyline;
+    } page_t;
+
+    //the dimension of new pages
+    int page_dim;
+
+    //the accounting category of the pages
+    std::string category;
+
+    //the pages
+    std::vector<page_t> pages;
+
+    //the total page bytes
+    size_t footprint;
+
+    /**
+     * Find the lowest position an image fits at a skyline node
+     * @param  page the page
+     * @param  idx  the node the image starts at
+     * @param  w    the padded width
+     * @param  h    the padded height
+     * @return      the y position or -1 if it doesn't fit
+     */
+    int fit(const page_t& page, size_t idx, int w, int h) const;
+
+    /**
+     * Find space on a page and raise the skyline over it
+     * @param  page the page
+     * @param  w    the padded width
+     * @param  h    the padded height
+     * @param  rect the position found (set by the call)
+     * @return      whether the image fit
+     */
+    bool pack(page_t& page, int w, int h, SDL_Rect& rect);
+
+    /**
+     * Create a page
+     * @param  renderer the renderer
+     * @param  w        the page width
+     * @param  h        the page height
+     * @return          the page index (-1 if the texture couldn't be created)
+     */
+    int add_page(SDL_Renderer& renderer, int w, int h);
+
+  public:
+    /**
+     * Constructor (pages are created on the first add)
+     * @param page_dim the dimension of each page
+     * @param category the accounting category of the pages
+     */
+    atlas_t(int page_dim, const std::string& category);
+    atlas_t(const atlas_t&) = delete;
+    atlas_t& operator=(const atlas_t&) = delete;
+
+    /**
+     * Free pages
+     */
+    ~atlas_t();
+
+    /**
+     * Pack an image and upload its pixels
+     * Throws gen exception if the image can't be uploaded
+     * @param  renderer the renderer
+     * @param  surface  the image (freed by the call)
+     * @return          where the image was packed
+     */
+    atlas_region_t add(SDL_Renderer& renderer, SDL_Surface *surface);
+
+    /**
+     * Get the texture for a page
+     * @param  page the page index
+     * @return      the page texture
+     */
+    SDL_Texture* get_texture(int page) const { return pages.at(page).texture; }
+
+    /**
+     * Get the number of pages
+     * @return the number of pages
+     */
+    size_t get_page_count() const { return pages.size(); }
+
+    /**
+     * Get the size of the page textures
+     * @return the texture size in bytes
+     */
+    size_t get_footprint() const { return footprint; }
+  };
+}}
+
+#endif /*_IO_JACKHAY_SWAMP_ATLAS_H*/
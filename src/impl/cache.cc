@@ -0,0 +1,450 @@
+/*
+ * (C) 2021 Jack Hay
+ *
+ * Untitled Swamp game
+ */
+
+#include "cache.h"
+#include "logger.h"
+#include "rng.h"
+#include "metrics.h"
+#include <fstream>
+#include <filesystem>
+#include <cstring>
+#include <cstdio>
+#include <thread>
+#include <functional>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <tuple>
+
+namespace impl {
+namespace cache {
+
+  //entry header values
+  #define CACHE_MAGIC 0x43505753 // "SWPC"
+  #define ENTRY_SURFACE 1
+  #define ENTRY_INTS 2
+
+  //fnv-1a prime
+  #define KEY_PRIME 0x100000001B3ULL
+
+  //the cache directory ("" if disabled), set once at startup
+  static std::string cache_dir;
+
+  //the size limit (0 for none) and the bytes held (approximate between prunes)
+  static size_t cache_budget = 0;
+  static std::atomic<size_t> cache_bytes(0);
+
+  //one prune at a time
+  static std::mutex prune_lock;
+
+  /**
+   * Constructor
+   * @param kind the generator name
+   */
+  key_t::key_t(const std::string& kind)
+    : h(rng::hash_str(kind)) {
+    //entries from older generators never match
+    add((int64_t) CACHE_VERSION);
+  }
+
+  /**
+   * Add an integer parameter
+   * @param  v the value
+   * @return   this key
+   */
+  key_t& key_t::add(int64_t v) {
+    uint64_t bits = (uint64_t) v;
+    for (int i=0; i<8; i++) {
+      h ^= (bits >> (i * 8)) & 0xFF;
+      h *= KEY_PRIME;
+    }
+    return *this;
+  }
+
+  /**
+   * Add a float parameter
+   * @param  v the value
+   * @return   this key
+   */
+  key_t& key_t::add_float(float v) {
+    uint32_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    return add((int64_t) bits);
+  }
+
+  /**
+   * Add a color parameter
+   * @param  r,g,b the color
+   * @return       this key
+   */
+  key_t& key_t::add_rgb(int r, int g, int b) {
+    return add(r).add(g).add(b);
+  }
+
+  /**
+   * Remove the least recently used entries (oldest modification time,
+   * loads touch entries) until the cache is under 3/4 of its budget
+   * Does nothing if the cache is within budget or another thread is pruning
+   */
+  static void prune() {
+    std::unique_lock<std::mutex> lk(prune_lock, std::try_to_lock);
+    if (!lk.owns_lock() || (cache_budget == 0)) {
+      return;
+    }
+
+    //(last used, size, path) of every entry
+    std::vector<std::tuple<std::filesystem::file_time_type, size_t, std::filesystem::path>> entries;
+    size_t total = 0;
+
+    std::error_code ec;
+    for (std::filesystem::directory_iterator it(cache_dir, ec);
+         !ec && (it != std::filesystem::directory_iterator());
+         it.increment(ec)) {
+      if (it->path().extension() != ".bin") {
+        continue;
+      }
+
+      std::error_code entry_ec;
+      size_t size = it->file_size(entry_ec);
+      std::filesystem::file_time_type used = it->last_write_time(entry_ec);
+      if (!entry_ec) {
+        entries.push_back(std::make_tuple(used, size, it->path()));
+        total += size;
+      }
+    }
+
+    if (total <= cache_budget) {
+      cache_bytes = total;
+      return;
+    }
+
+    std::sort(entries.begin(), entries.end());
+    size_t target = (cache_budget / 4) * 3;
+    size_t removed = 0;
+
+    for (size_t i=0; (i<entries.size()) && (total > target); i++) {
+      std::error_code remove_ec;
+      if (std::filesystem::remove(std::get<2>(entries.at(i)), remove_ec)) {
+        total -= std::get<1>(entries.at(i));
+        removed++;
+      }
+    }
+    cache_bytes = total;
+
+    static metrics::counter_t& pruned = metrics::counter("cache_pruned");
+    pruned.add(removed);
+    logger::log_lazy(LOG_DEBUG, [removed,total]() {
+      return "pruned " + std::to_string(removed) + " cache entries (" +
+             std::to_string(total / 1024) + " KB left)";
+    });
+  }
+
+  /**
+   * Set the cache directory ("" disables the cache)
+   * Least recently used entries are removed past the budget
+   * @param dir    the directory
+   * @param budget the size limit in bytes (0 for no limit)
+   */
+  void set_dir(const std::string& dir, size_t budget) {
+    cache_dir = dir;
+    cache_budget = budget;
+    if (cache_dir.empty()) {
+      return;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(cache_dir, ec);
+    if (ec) {
+      logger::log_err("failed to create cache directory " + cache_dir + ", cache disabled");
+      cache_dir.clear();
+      return;
+    }
+
+    //entries left by earlier runs
+    prune();
+  }
+
+  /**
+   * Whether the cache is enabled
+   * @return whether a directory is set
+   */
+  bool enabled() {
+    return !cache_dir.empty();
+  }
+
+  /**
+   * Get the path of an entry
+   * @param  key the entry key
+   * @return     the path
+   */
+  static std::string entry_path(uint64_t key) {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long) key);
+    return (std::filesystem::path(cache_dir) / name).string();
+  }
+
+  /**
+   * Read a value from a stream
+   */
+  template <typename T>
+  static bool read_val(std::ifstream& in, T& v) {
+    return (bool) in.read(reinterpret_cast<char*>(&v), sizeof(T));
+  }
+
+  /**
+   * Write a value to a stream
+   */
+  template <typename T>
+  static void write_val(std::ofstream& out, const T& v) {
+    out.write(reinterpret_cast<const char*>(&v), sizeof(T));
+  }
+
+  /**
+   * Open an entry and check its header
+   * @param  in   the stream set by the call
+   * @param  key  the entry key
+   * @param  type the expected entry type
+   * @return      whether the entry is valid
+   */
+  static bool open_entry(std::ifstream& in, uint64_t key, uint32_t type) {
+    if (!enabled()) {
+      return false;
+    }
+
+    static metrics::counter_t& hits = metrics::counter("cache_hits");
+    static metrics::counter_t& misses = metrics::counter("cache_misses");
+
+    std::string path = entry_path(key);
+    in.open(path, std::ios::binary);
+    uint32_t magic, version, entry_type;
+    uint64_t entry_key;
+
+    bool valid = in.is_open() &&
+                 read_val(in, magic) && (magic == CACHE_MAGIC) &&
+                 read_val(in, version) && (version == CACHE_VERSION) &&
+                 read_val(in, entry_type) && (entry_type == type) &&
+                 read_val(in, entry_key) && (entry_key == key);
+
+    (valid ? hits : misses).add();
+
+    if (valid) {
+      //recently used entries are pruned last
+      std::error_code ec;
+      std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ec);
+    }
+    return valid;
+  }
+
+  /**
+   * Get the bytes left to read in an entry
+   * @param  in the stream
+   * @return    the bytes after the read position
+   */
+  static size_t remaining(std::ifstream& in) {
+    std::streampos pos = in.tellg();
+    in.seekg(0, std::ios::end);
+    std::streampos end = in.tellg();
+    in.seekg(pos);
+
+    if ((pos < 0) || (end < pos)) {
+      return 0;
+    }
+    return (size_t) (end - pos);
+  }
+
+  /**
+   * Write an entry (to a temporary file, then moved into place
+   * so readers never see a partial entry)
+   * @param key   the entry key
+   * @param type  the entry type
+   * @param write writes the payload
+   */
+  static void write_entry(uint64_t key, uint32_t type,
+                          const std::function<void(std::ofstream&)>& write) {
+    if (!enabled()) {
+      return;
+    }
+
+    std::string path = entry_path(key);
+    std::string tmp = path + "." +
+                      std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) +
+                      ".tmp";
+    {
+      std::ofstream out(tmp, std::ios::binary);
+      if (!out.is_open()) {
+        logger::log_err("failed to write cache entry " + path);
+        return;
+      }
+
+      write_val(out, (uint32_t) CACHE_MAGIC);
+      write_val(out, (uint32_t) CACHE_VERSION);
+      write_val(out, type);
+      write_val(out, key);
+      write(out);
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmp, path, ec);
+    if (ec) {
+      std::filesystem::remove(tmp, ec);
+      return;
+    }
+
+    //(replaced entries are counted twice until the next prune)
+    size_t size = std::filesystem::file_size(path, ec);
+    if (!ec && (cache_budget > 0) && ((cache_bytes += size) > cache_budget)) {
+      prune();
+    }
+  }
+
+  /**
+   * Load a generated pixel buffer
+   * @param  key     the entry key
+   * @param  surface the surface set by the call (caller frees)
+   * @param  frames  the number of animation frames set by the call
+   * @param  frame_w the width of one frame set by the call
+   * @return         whether the entry was found and valid
+   */
+  bool load_surface(uint64_t key, SDL_Surface*& surface, int& frames, int& frame_w) {
+    std::ifstream in;
+    if (!open_entry(in, key, ENTRY_SURFACE)) {
+      logger::log_lazy(LOG_DEBUG, [key]() {
+        return "cache miss " + std::to_string(key);
+      });
+      return false;
+    }
+
+    uint32_t format, runs;
+    int32_t w, h, f, fw;
+    if (!read_val(in, format) || !read_val(in, w) || !read_val(in, h) ||
+        !read_val(in, f) || !read_val(in, fw) || !read_val(in, runs) ||
+        (w <= 0) || (h <= 0)) {
+      return false;
+    }
+
+    //pixels are written as 32 bit values and each run is a (count, pixel)
+    //pair, a corrupt or foreign entry is a miss
+    if (SDL_ISPIXELFORMAT_FOURCC(format) ||
+        (SDL_BITSPERPIXEL(format) != 32) || (SDL_BYTESPERPIXEL(format) != 4) ||
+        (((size_t) runs * 2 * sizeof(uint32_t)) != remaining(in))) {
+      logger::log_lazy(LOG_WARN, [key]() {
+        return "invalid cache entry " + entry_path(key);
+      });
+      return false;
+    }
+
+    surface = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, format);
+    if (surface == NULL) {
+      return false;
+    }
+
+    //pixels are stored as (count, pixel) runs in row order
+    SDL_LockSurface(surface);
+    size_t total = (size_t) w * h;
+    size_t px = 0;
+    bool valid = true;
+
+    for (uint32_t r=0; r<runs; r++) {
+      uint32_t count, value;
+      if (!read_val(in, count) || !read_val(in, value) || ((px + count) > total)) {
+        valid = false;
+        break;
+      }
+
+      for (uint32_t c=0; c<count; c++, px++) {
+        Uint8 *row = (Uint8*) surface->pixels + ((px / w) * surface->pitch);
+        ((Uint32*) row)[px % w] = value;
+      }
+    }
+    SDL_UnlockSurface(surface);
+
+    if (!valid || (px != total)) {
+      SDL_FreeSurface(surface);
+      surface = NULL;
+      return false;
+    }
+
+    frames = f;
+    frame_w = fw;
+    return true;
+  }
+
+  /**
+   * Store a generated pixel buffer
+   * @param key     the entry key
+   * @param surface the surface (32 bit)
+   * @param frames  the number of animation frames
+   * @param frame_w the width of one frame
+   */
+  void store_surface(uint64_t key, SDL_Surface& surface, int frames, int frame_w) {
+    write_entry(key, ENTRY_SURFACE, [&surface,frames,frame_w](std::ofstream& out) {
+      //run length encode (generated textures are mostly empty or solid)
+      std::vector<std::pair<uint32_t,uint32_t>> runs;
+
+      SDL_LockSurface(&surface);
+      for (int y=0; y<surface.h; y++) {
+        Uint32 *row = (Uint32*)((Uint8*) surface.pixels + (y * surface.pitch));
+        for (int x=0; x<surface.w; x++) {
+          if (!runs.empty() && (runs.back().second == row[x])) {
+            runs.back().first++;
+          } else {
+            runs.push_back(std::make_pair(1, row[x]));
+          }
+        }
+      }
+      SDL_UnlockSurface(&surface);
+
+      write_val(out, (uint32_t) surface.format->format);
+      write_val(out, (int32_t) surface.w);
+      write_val(out, (int32_t) surface.h);
+      write_val(out, (int32_t) frames);
+      write_val(out, (int32_t) frame_w);
+      write_val(out, (uint32_t) runs.size());
+      for (size_t i=0; i<runs.size(); i++) {
+        write_val(out, runs.at(i).first);
+        write_val(out, runs.at(i).second);
+      }
+    });
+  }
+
+  /**
+   * Load generated data (i.e. a tile layout)
+   * @param  key  the entry key
+   * @param  data the data set by the call
+   * @return      whether the entry was found and valid
+   */
+  bool load_ints(uint64_t key, std::vector<int32_t>& data) {
+    std::ifstream in;
+    uint32_t count;
+    if (!open_entry(in, key, ENTRY_INTS) || !read_val(in, count)) {
+      return false;
+    }
+
+    //a truncated or corrupt entry is a miss
+    if (((size_t) count * sizeof(int32_t)) != remaining(in)) {
+      logger::log_lazy(LOG_WARN, [&]() {
+        return "invalid cache entry " + entry_path(key);
+      });
+      return false;
+    }
+
+    data.resize(count);
+    return count == 0 ||
+           (bool) in.read(reinterpret_cast<char*>(data.data()), count * sizeof(int32_t));
+  }
+
+  /**
+   * Store generated data (i.e. a tile layout)
+   * @param key  the entry key
+   * @param data the data
+   */
+  void store_ints(uint64_t key, const std::vector<int32_t>& data) {
+    write_entry(key, ENTRY_INTS, [&data](std::ofstream& out) {
+      write_val(out, (uint32_t) data.size());
+      out.write(reinterpret_cast<const char*>(data.data()), data.size() * sizeof(int32_t));
+    });
+  }
+}}
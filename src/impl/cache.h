@@ -0,0 +1,114 @@
+/*
+ * (C) 2021 Jack Hay
+ *
+ * Untitled Swamp game
+ */
+
+#ifndef _IO_JACKHAY_SWAMP_CACHE_H
+#define _IO_JACKHAY_SWAMP_CACHE_H
+
+#include <SDL2/SDL.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace impl {
+namespace cache {
+
+  //bump when any generator changes its output for the same parameters
+  #define CACHE_VERSION 3
+
+  /**
+   * Builds a cache key from a generator name and its parameters
+   * (the seed and every value that affects the output)
+   */
+  struct key_t {
+  private:
+    //the hash so far
+    uint64_t h;
+
+  public:
+    /**
+     * Constructor
+     * @param kind the generator name
+     */
+    explicit key_t(const std::string& kind);
+
+    /**
+     * Add an integer parameter
+     * @param  v the value
+     * @return   this key
+     */
+    key_t& add(int64_t v);
+
+    /**
+     * Add a float parameter
+     * @param  v the value
+     * @return   this key
+     */
+    key_t& add_float(float v);
+
+    /**
+     * Add a color parameter
+     * @param  r,g,b the color
+     * @return       this key
+     */
+    key_t& add_rgb(int r, int g, int b);
+
+    /**
+     * Get the key
+     * @return the hash
+     */
+    uint64_t get() const { return h; }
+  };
+
+  /**
+   * Set the cache directory ("" disables the cache)
+   * Least recently used entries are removed past the budget
+   * @param dir    the directory
+   * @param budget the size limit in bytes (0 for no limit)
+   */
+  void set_dir(const std::string& dir, size_t budget);
+
+  /**
+   * Whether the cache is enabled
+   * @return whether a directory is set
+   */
+  bool enabled();
+
+  /**
+   * Load a generated pixel buffer
+   * @param  key     the entry key
+   * @param  surface the surface set by the call (caller frees)
+   * @param  frames  the number of animation frames set by the call
+   * @param  frame_w the width of one frame set by the call
+   * @return         whether the entry was found and valid
+   */
+  bool load_surface(uint64_t key, SDL_Surface*& surface, int& frames, int& frame_w);
+
+  /**
+   * Store a generated pixel buffer
+   * @param key     the entry key
+   * @param surface the surface (32 bit)
+   * @param frames  the number of animation frames
+   * @param frame_w the width of one frame
+   */
+  void store_surface(uint64_t key, SDL_Surface& surface, int frames, int frame_w);
+
+  /**
+   * Load generated data (i.e. a tile layout)
+   * @param  key  the entry key
+   * @param  data the data set by the call
+   * @return      whether the entry was found and valid
+   */
+  bool load_ints(uint64_t key, std::vector<int32_t>& data);
+
+  /**
+   * Store generated data (i.e. a tile layout)
+   * @param key  the entry key
+   * @param data the data
+   */
+  void store_ints(uint64_t key, const std::vector<int32_t>& data);
+}}
+
+#endif /*_IO_JACKHAY_SWAMP_CACHE_H*/
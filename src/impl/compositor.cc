@@ -0,0 +1,570 @@
+/*
+ * (C) 2021 Jack Hay
+ *
+ * Untitled Swamp game
+ */
+
+#include "compositor.h"
+#include "jobs.h"
+#include "logger.h"
+#include "metrics.h"
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+
+namespace impl {
+namespace compositor {
+
+  //whether textures keep cpu pixels (once a frame is created)
+  static std::atomic<bool> mirroring(false);
+
+  //cpu pixels by texture
+  static std::unordered_map<SDL_Texture*, std::shared_ptr<pixels_t>> mirrors;
+  static int64_t mirror_bytes = 0;
+  static std::mutex mirrors_lock;
+
+  //the frame draws are recorded into (render thread)
+  static frame_t *active = NULL;
+
+  /**
+   * Divide by 255 (rounded) for products of two channels
+   * @param  x the product
+   * @return   x / 255
+   */
+  static inline Uint32 div255(Uint32 x) {
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+  }
+
+  /**
+   * Multiply a pixel by color and alpha mods
+   * @param  src the pixel
+   * @param  op  the mods
+   * @return     the modulated pixel
+   */
+  static inline Uint32 modulate(Uint32 src, const op_t& op) {
+    Uint32 a = div255((src >> 24) * op.a);
+    Uint32 r = div255(((src >> 16) & 0xFF) * op.r);
+    Uint32 g = div255(((src >> 8) & 0xFF) * op.g);
+    Uint32 b = div255((src & 0xFF) * op.b);
+    return (a << 24) | (r << 16) | (g << 8) | b;
+  }
+
+  /**
+   * Blend a pixel with the same rules as sdl's renderers
+   * @param  dst  the pixel drawn over
+   * @param  src  the pixel drawn
+   * @param  mode the blend mode (unknown modes blend)
+   * @return      the result
+   */
+  static inline Uint32 blend_pixel(Uint32 dst, Uint32 src, SDL_BlendMode mode) {
+    Uint32 sa = src >> 24;
+    Uint32 out = dst & 0xFF000000;
+
+    if (mode == SDL_BLENDMODE_NONE) {
+      return src;
+
+    } else if (mode == SDL_BLENDMODE_ADD) {
+      //dst rgb = src rgb * src a + dst rgb
+      for (int shift=0; shift<24; shift+=8) {
+        Uint32 c = ((dst >> shift) & 0xFF) + div255(((src >> shift) & 0xFF) * sa);
+        out |= std::min(c, (Uint32) 0xFF) << shift;
+      }
+      return out;
+
+    } else if (mode == SDL_BLENDMODE_MOD) {
+      //dst rgb = src rgb * dst rgb
+      for (int shift=0; shift<24; shift+=8) {
+        out |= div255(((src >> shift) & 0xFF) * ((dst >> shift) & 0xFF)) << shift;
+      }
+      return out;
+    }
+
+    //dst rgb = src rgb * src a + dst rgb * (1 - src a), dst a = src a + dst a * (1 - src a)
+    if (sa == 0xFF) {
+      return src;
+    } else if (sa == 0) {
+      return dst;
+    }
+    Uint32 inv = 0xFF - sa;
+    out = (sa + div255((dst >> 24) * inv)) << 24;
+    for (int shift=0; shift<24; shift+=8) {
+      out |= div255(((src >> shift) & 0xFF) * sa + ((dst >> shift) & 0xFF) * inv) << shift;
+    }
+    return out;
+  }
+
+  /**
+   * Blend a span of pixels
+   * (opaque and transparent pixels, the common case for color keyed
+   * images, are copied or skipped without blending)
+   * @param dst  the pixels drawn over
+   * @param src  the pixels drawn
+   * @param n    the span length
+   * @param mode the blend mode
+   */
+  static void blend_span(Uint32 *dst, const Uint32 *src, int n, SDL_BlendMode mode) {
+    if (mode == SDL_BLENDMODE_NONE) {
+      std::memcpy(dst, src, n * sizeof(Uint32));
+      return;
+    }
+
+    if ((mode != SDL_BLENDMODE_ADD) && (mode != SDL_BLENDMODE_MOD)) {
+      for (int i=0; i<n; i++) {
+        Uint32 sa = src[i] >> 24;
+        if (sa == 0xFF) {
+          dst[i] = src[i];
+        } else if (sa != 0) {
+          dst[i] = blend_pixel(dst[i], src[i], SDL_BLENDMODE_BLEND);
+        }
+      }
+      return;
+    }
+
+    for (int i=0; i<n; i++) {
+      dst[i] = blend_pixel(dst[i], src[i], mode);
+    }
+  }
+
+  /**
+   * Fill a span of pixels with a color
+   * @param dst   the pixels drawn over
+   * @param n     the span length
+   * @param color the color
+   * @param mode  the blend mode
+   */
+  static void fill_span(Uint32 *dst, int n, Uint32 color, SDL_BlendMode mode) {
+    Uint32 ca = color >> 24;
+    bool blends = (mode == SDL_BLENDMODE_ADD) || (mode == SDL_BLENDMODE_MOD) ||
+                  ((mode != SDL_BLENDMODE_NONE) && (ca != 0xFF));
+
+    if (!blends) {
+      std::fill(dst, dst + n, color);
+    } else if ((mode == SDL_BLENDMODE_ADD) || (mode == SDL_BLENDMODE_MOD) || (ca != 0)) {
+      for (int i=0; i<n; i++) {
+        dst[i] = blend_pixel(dst[i], color, mode);
+      }
+    }
+  }
+
+  /**
+   * Get the color of an op
+   * @param  op the op
+   * @return    the color (ARGB8888)
+   */
+  static inline Uint32 op_color(const op_t& op) {
+    return ((Uint32) op.a << 24) | ((Uint32) op.r << 16) | ((Uint32) op.g << 8) | op.b;
+  }
+
+  /**
+   * Constructor (starts keeping cpu pixels for textures created after)
+   * @param width_p  the logical width
+   * @param height_p the logical height
+   */
+  frame_t::frame_t(int width_p, int height_p)
+    : width_p(width_p),
+      height_p(height_p),
+      pixels((size_t) width_p * height_p, 0),
+      ops(),
+      op_count(0),
+      missing(0) {
+    mirroring = true;
+  }
+
+  /**
+   * Get the next op to record into
+   * @return the op
+   */
+  op_t& frame_t::next_op() {
+    if (op_count == ops.size()) {
+      ops.push_back(op_t());
+    }
+    return ops.at(op_count++);
+  }
+
+  /**
+   * Record draws into this frame until end
+   */
+  void frame_t::begin() {
+    active = this;
+    op_count = 0;
+    missing = 0;
+  }
+
+  /**
+   * Stop recording and composite the frame
+   */
+  void frame_t::end() {
+    active = NULL;
+
+    //each band draws every op in order, clipped to its rows
+    size_t bands = (height_p + COMPOSITOR_BAND_ROWS - 1) / COMPOSITOR_BAND_ROWS;
+    jobs::parallel_for(bands, [this](size_t i) {
+      int y0 = i * COMPOSITOR_BAND_ROWS;
+      composite(y0, std::min(y0 + COMPOSITOR_BAND_ROWS, height_p));
+    });
+
+    //don't hold pixels of textures freed before the next frame
+    for (size_t i=0; i<op_count; i++) {
+      ops.at(i).src.reset();
+    }
+
+    if (missing > 0) {
+      static bool warned = false;
+      if (!warned) {
+        warned = true;
+        size_t skipped = missing;
+        logger::log_lazy(LOG_WARN, [skipped]() {
+          return "compositor skipped " + std::to_string(skipped) +
+                 " copies of textures without cpu pixels";
+        });
+      }
+    }
+  }
+
+  /**
+   * Composite every op into some rows
+   * @param y0 the first row
+   * @param y1 the row after the last
+   */
+  void frame_t::composite(int y0, int y1) {
+    //scaled, flipped or modulated copies are gathered first
+    std::vector<Uint32> row(width_p);
+
+    for (size_t i=0; i<op_count; i++) {
+      const op_t& op = ops.at(i);
+
+      if (op.kind == OP_LINE) {
+        if ((std::max(op.y1, op.y2) < y0) || (std::min(op.y1, op.y2) >= y1)) {
+          continue;
+        }
+
+        //bresenham (clipped to the frame when recorded)
+        int dx = std::abs(op.x2 - op.x1);
+        int dy = -std::abs(op.y2 - op.y1);
+        int sx = (op.x1 < op.x2) ? 1 : -1;
+        int sy = (op.y1 < op.y2) ? 1 : -1;
+        int err = dx + dy;
+        int x = op.x1;
+        int y = op.y1;
+        Uint32 color = op_color(op);
+
+        while (true) {
+          if ((y >= y0) && (y < y1)) {
+            Uint32 *dst = &pixels[(size_t) y * width_p + x];
+            *dst = blend_pixel(*dst, color, op.blend);
+          }
+          if ((x == op.x2) && (y == op.y2)) {
+            break;
+          }
+          int e2 = 2 * err;
+          if (e2 >= dy) {
+            err += dy;
+            x += sx;
+          }
+          if (e2 <= dx) {
+            err += dx;
+            y += sy;
+          }
+        }
+        continue;
+      }
+
+      const SDL_Rect& d = op.dest;
+      int top = std::max(d.y, y0);
+      int bottom = std::min(d.y + d.h, y1);
+      int left = std::max(d.x, 0);
+      int right = std::min(d.x + d.w, width_p);
+      if ((top >= bottom) || (left >= right)) {
+        continue;
+      }
+      int n = right - left;
+
+      if (op.kind == OP_FILL) {
+        Uint32 color = op_color(op);
+        for (int y=top; y<bottom; y++) {
+          fill_span(&pixels[(size_t) y * width_p + left], n, color, op.blend);
+        }
+        continue;
+      }
+
+      //copies
+      const pixels_t& src = *op.src;
+      const SDL_Rect& s = op.sample;
+      bool modulated = (op.r != 0xFF) || (op.g != 0xFF) || (op.b != 0xFF) || (op.a != 0xFF);
+      bool direct = (s.w == d.w) && !(op.flip & SDL_FLIP_HORIZONTAL) && !modulated;
+
+      for (int y=top; y<bottom; y++) {
+        //nearest source row
+        int v = (int) (((int64_t) (y - d.y) * s.h) / d.h);
+        if (op.flip & SDL_FLIP_VERTICAL) {
+          v = s.h - 1 - v;
+        }
+        const Uint32 *src_row = &src.data[(size_t) (s.y + v) * src.w + s.x];
+        Uint32 *dst_row = &pixels[(size_t) y * width_p];
+
+        if (direct) {
+          blend_span(dst_row + left, src_row + (left - d.x), n, op.blend);
+          continue;
+        }
+
+        for (int x=left; x<right; x++) {
+          int u = (int) (((int64_t) (x - d.x) * s.w) / d.w);
+          if (op.flip & SDL_FLIP_HORIZONTAL) {
+            u = s.w - 1 - u;
+          }
+          row[x - left] = modulated ? modulate(src_row[u], op) : src_row[u];
+        }
+        blend_span(dst_row + left, row.data(), n, op.blend);
+      }
+    }
+  }
+
+  /**
+   * Record a copy (rotation isn't composited, nothing in the game rotates)
+   * @param  texture the texture (must have cpu pixels)
+   * @param  src     the source area (NULL for the whole texture)
+   * @param  dst     the destination area (NULL for the whole frame)
+   * @param  flip    the flip
+   * @return         0 on success, -1 if the texture has no cpu pixels
+   */
+  int frame_t::copy(SDL_Texture& texture,
+                    const SDL_Rect *src,
+                    const SDL_Rect *dst,
+                    const SDL_RendererFlip flip) {
+    std::shared_ptr<const pixels_t> found;
+    {
+      std::unique_lock<std::mutex> lock(mirrors_lock);
+      auto it = mirrors.find(&texture);
+      if (it != mirrors.end()) {
+        found = it->second;
+      }
+    }
+
+    if (found == NULL) {
+      missing++;
+      return -1;
+    }
+
+    //like sdl, the source is clipped to the texture (not rescaled)
+    SDL_Rect sample = {0, 0, found->w, found->h};
+    if ((src != NULL) && !SDL_IntersectRect(src, &sample, &sample)) {
+      return 0;
+    }
+
+    SDL_Rect bounds = {0, 0, width_p, height_p};
+    SDL_Rect dest = (dst == NULL) ? bounds : *dst;
+    if (!SDL_HasIntersection(&dest, &bounds)) {
+      return 0;
+    }
+
+    op_t& op = next_op();
+    op.kind = OP_COPY;
+    SDL_GetTextureBlendMode(&texture, &op.blend);
+    SDL_GetTextureColorMod(&texture, &op.r, &op.g, &op.b);
+    SDL_GetTextureAlphaMod(&texture, &op.a);
+    op.src = found;
+    op.sample = sample;
+    op.flip = flip;
+    op.dest = dest;
+    return 0;
+  }
+
+  /**
+   * Record a fill with the renderer's draw color and blend mode
+   * @param  renderer the renderer
+   * @param  rect     the area (NULL for the whole frame)
+   * @return          0
+   */
+  int frame_t::fill(SDL_Renderer& renderer, const SDL_Rect *rect) {
+    SDL_Rect bounds = {0, 0, width_p, height_p};
+    SDL_Rect area = (rect == NULL) ? bounds : *rect;
+    if (!SDL_HasIntersection(&area, &bounds)) {
+      return 0;
+    }
+
+    op_t& op = next_op();
+    op.kind = OP_FILL;
+    SDL_GetRenderDrawBlendMode(&renderer, &op.blend);
+    SDL_GetRenderDrawColor(&renderer, &op.r, &op.g, &op.b, &op.a);
+    op.dest = area;
+    return 0;
+  }
+
+  /**
+   * Record a line with the renderer's draw color and blend mode
+   * @param  renderer the renderer
+   * @param  x1       the start x
+   * @param  y1       the start y
+   * @param  x2       the end x
+   * @param  y2       the end y
+   * @return          0
+   */
+  int frame_t::line(SDL_Renderer& renderer, int x1, int y1, int x2, int y2) {
+    //clip so bands only walk visible points
+    SDL_Rect bounds = {0, 0, width_p, height_p};
+    if (!SDL_IntersectRectAndLine(&bounds, &x1, &y1, &x2, &y2)) {
+      return 0;
+    }
+
+    op_t& op = next_op();
+    op.kind = OP_LINE;
+    SDL_GetRenderDrawBlendMode(&renderer, &op.blend);
+    SDL_GetRenderDrawColor(&renderer, &op.r, &op.g, &op.b, &op.a);
+    op.x1 = x1;
+    op.y1 = y1;
+    op.x2 = x2;
+    op.y2 = y2;
+    return 0;
+  }
+
+  /**
+   * Record a clear to the renderer's draw color (ignores blending)
+   * @param  renderer the renderer
+   * @return          0
+   */
+  int frame_t::clear(SDL_Renderer& renderer) {
+    fill(renderer, NULL);
+    ops.at(op_count - 1).blend = SDL_BLENDMODE_NONE;
+    return 0;
+  }
+
+  /**
+   * Get the frame draws are recorded into
+   * @return the frame or NULL when drawing with the renderer
+   */
+  frame_t* recording() {
+    return active;
+  }
+
+  /**
+   * Replace the cpu pixels of a texture
+   * @param texture the texture
+   * @param pixels  the pixels (NULL to drop them)
+   */
+  static void keep(SDL_Texture *texture, std::shared_ptr<pixels_t> pixels) {
+    std::unique_lock<std::mutex> lock(mirrors_lock);
+
+    auto it = mirrors.find(texture);
+    if (it != mirrors.end()) {
+      mirror_bytes -= (int64_t) it->second->data.size() * sizeof(Uint32);
+      mirrors.erase(it);
+    }
+
+    if (pixels != NULL) {
+      mirror_bytes += (int64_t) pixels->data.size() * sizeof(Uint32);
+      mirrors[texture] = pixels;
+    }
+
+    static metrics::gauge_t& bytes = metrics::gauge("mirror_bytes");
+    bytes.set(mirror_bytes);
+  }
+
+  /**
+   * Copy surface pixels into cpu pixels
+   * @param  surface the surface
+   * @param  dest    the pixels copied to
+   * @param  rect    the area copied to (the size of the surface)
+   * @return         whether the surface could be converted
+   */
+  static bool copy_surface(SDL_Surface& surface, pixels_t& dest, const SDL_Rect& rect) {
+    SDL_Surface *converted = SDL_ConvertSurfaceFormat(&surface, SDL_PIXELFORMAT_ARGB8888, 0);
+    if (converted == NULL) {
+      std::string error(SDL_GetError());
+      logger::log_lazy(LOG_WARN, [error]() {
+        return "failed to keep cpu pixels: " + error;
+      });
+      return false;
+    }
+
+    //clipped to the destination
+    int w = std::min(std::min(converted->w, rect.w), dest.w - rect.x);
+    int h = std::min(std::min(converted->h, rect.h), dest.h - rect.y);
+    for (int y=0; y<h; y++) {
+      std::memcpy(&dest.data[(size_t) (rect.y + y) * dest.w + rect.x],
+                  (Uint8*) converted->pixels + ((size_t) y * converted->pitch),
+                  std::max(w, 0) * sizeof(Uint32));
+    }
+
+    SDL_FreeSurface(converted);
+    return true;
+  }
+
+  /**
+   * Keep the cpu pixels of a texture (no-op unless a frame was created)
+   * @param texture the texture
+   * @param surface the pixels it was created from
+   */
+  void mirror(SDL_Texture *texture, SDL_Surface& surface) {
+    if (!mirroring || (texture == NULL)) {
+      return;
+    }
+
+    //color keyed pixels become transparent as they do for the texture
+    std::shared_ptr<pixels_t> pixels = std::make_shared<pixels_t>();
+    pixels->w = surface.w;
+    pixels->h = surface.h;
+    pixels->data.assign((size_t) surface.w * surface.h, 0);
+
+    if (copy_surface(surface, *pixels, {0, 0, surface.w, surface.h})) {
+      keep(texture, pixels);
+    }
+  }
+
+  /**
+   * Keep transparent cpu pixels for a texture (no-op unless a frame was created)
+   * @param texture the texture
+   * @param w       the width
+   * @param h       the height
+   */
+  void mirror(SDL_Texture *texture, int w, int h) {
+    if (!mirroring || (texture == NULL)) {
+      return;
+    }
+
+    std::shared_ptr<pixels_t> pixels = std::make_shared<pixels_t>();
+    pixels->w = w;
+    pixels->h = h;
+    pixels->data.assign((size_t) w * h, 0);
+    keep(texture, pixels);
+  }
+
+  /**
+   * Update an area of a texture's cpu pixels (no-op without cpu pixels)
+   * @param texture the texture
+   * @param rect    the area
+   * @param surface the new pixels (the size of the area)
+   */
+  void update(SDL_Texture *texture, const SDL_Rect& rect, SDL_Surface& surface) {
+    if (!mirroring) {
+      return;
+    }
+
+    std::shared_ptr<pixels_t> pixels;
+    {
+      std::unique_lock<std::mutex> lock(mirrors_lock);
+      auto it = mirrors.find(texture);
+      if (it != mirrors.end()) {
+        pixels = it->second;
+      }
+    }
+
+    //updated between frames on the render thread (not while compositing)
+    if (pixels != NULL) {
+      copy_surface(surface, *pixels, rect);
+    }
+  }
+
+  /**
+   * Drop the cpu pixels of a texture (before destroying it)
+   * @param texture the texture
+   */
+  void forget(SDL_Texture *texture) {
+    if (mirroring) {
+      keep(texture, NULL);
+    }
+  }
+}}
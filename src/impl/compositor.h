@@ -0,0 +1,204 @@
+/*
+ * (C) 2021 Jack Hay
+ *
+ * Untitled Swamp game
+ */
+
+#ifndef _IO_JACKHAY_SWAMP_COMPOSITOR_H
+#define _IO_JACKHAY_SWAMP_COMPOSITOR_H
+
+#include <SDL2/SDL.h>
+#include <vector>
+#include <memory>
+
+namespace impl {
+namespace compositor {
+
+  //the rows of the frame composited by one job
+  #define COMPOSITOR_BAND_ROWS 16
+
+  /**
+   * The cpu copy of a texture's pixels (ARGB8888)
+   */
+  struct pixels_t {
+    int w;
+    int h;
+    std::vector<Uint32> data;
+  };
+
+  /**
+   * The kinds of recorded draws
+   */
+  enum op_kind_t {
+    OP_COPY,
+    OP_FILL,
+    OP_LINE
+  };
+
+  /**
+   * A recorded draw
+   */
+  struct op_t {
+    op_kind_t kind;
+    SDL_BlendMode blend;
+    //the draw color (the color and alpha mods for copies)
+    Uint8 r, g, b, a;
+    //the source pixels and area (copies)
+    std::shared_ptr<const pixels_t> src;
+    SDL_Rect sample;
+    SDL_RendererFlip flip;
+    //the area drawn to (copies and fills)
+    SDL_Rect dest;
+    //the end points (lines)
+    int x1, y1, x2, y2;
+  };
+
+  /**
+   * A frame composited on the cpu: draws are recorded between
+   * begin and end, then composited in bands of rows across the
+   * job pool (render thread only)
+   */
+  struct frame_t {
+  private:
+    //the logical size
+    int width_p;
+    int height_p;
+
+    //the composited pixels (ARGB8888)
+    std::vector<Uint32> pixels;
+
+    //the draws since begin (kept between frames to reuse storage)
+    std::vector<op_t> ops;
+    size_t op_count;
+
+    //copies of textures without cpu pixels this frame
+    size_t missing;
+
+    /**
+     * Get the next op to record into
+     * @return the op
+     */
+    op_t& next_op();
+
+    /**
+     * Composite every op into some rows
+     * @param y0 the first row
+     * @param y1 the row after the last
+     */
+    void composite(int y0, int y1);
+
+  public:
+    /**
+     * Constructor (starts keeping cpu pixels for textures created after)
+     * @param width_p  the logical width
+     * @param height_p the logical height
+     */
+    frame_t(int width_p, int height_p);
+    frame_t(const frame_t&) = delete;
+    frame_t& operator=(const frame_t&) = delete;
+
+    /**
+     * Record draws into this frame until end
+     */
+    void begin();
+
+    /**
+     * Stop recording and composite the frame
+     */
+    void end();
+
+    /**
+     * Record a copy (rotation isn't composited, nothing in the game rotates)
+     * @param  texture the texture (must have cpu pixels)
+     * @param  src     the source area (NULL for the whole texture)
+     * @param  dst     the destination area (NULL for the whole frame)
+     * @param  flip    the flip
+     * @return         0 on success, -1 if the texture has no cpu pixels
+     */
+    int copy(SDL_Texture& texture,
+             const SDL_Rect *src,
+             const SDL_Rect *dst,
+             const SDL_RendererFlip flip);
+
+    /**
+     * Record a fill with the renderer's draw color and blend mode
+     * @param  renderer the renderer
+     * @param  rect     the area (NULL for the whole frame)
+     * @return          0
+     */
+    int fill(SDL_Renderer& renderer, const SDL_Rect *rect);
+
+    /**
+     * Record a line with the renderer's draw color and blend mode
+     * @param  renderer the renderer
+     * @param  x1       the start x
+     * @param  y1       the start y
+     * @param  x2       the end x
+     * @param  y2       the end y
+     * @return          0
+     */
+    int line(SDL_Renderer& renderer, int x1, int y1, int x2, int y2);
+
+    /**
+     * Record a clear to the renderer's draw color (ignores blending)
+     * @param  renderer the renderer
+     * @return          0
+     */
+    int clear(SDL_Renderer& renderer);
+
+    /**
+     * Get the composited pixels (valid after end)
+     * @return the pixels (ARGB8888, width_p per row)
+     */
+    const Uint32* get_pixels() const { return pixels.data(); }
+
+    /**
+     * Get the logical width
+     * @return the width in world pixels
+     */
+    int get_width() const { return width_p; }
+
+    /**
+     * Get the logical height
+     * @return the height in world pixels
+     */
+    int get_height() const { return height_p; }
+  };
+
+  /**
+   * Get the frame draws are recorded into
+   * @return the frame or NULL when drawing with the renderer
+   */
+  frame_t* recording();
+
+  /**
+   * Keep the cpu pixels of a texture (no-op unless a frame was created)
+   * @param texture the texture
+   * @param surface the pixels it was created from
+   */
+  void mirror(SDL_Texture *texture, SDL_Surface& surface);
+
+  /**
+   * Keep transparent cpu pixels for a texture (no-op unless a frame was created)
+   * @param texture the texture
+   * @param w       the width
+   * @param h       the height
+   */
+  void mirror(SDL_Texture *texture, int w, int h);
+
+  /**
+   * Update an area of a texture's cpu pixels (no-op without cpu pixels)
+   * @param texture the texture
+   * @param rect    the area
+   * @param surface the new pixels (the size of the area)
+   */
+  void update(SDL_Texture *texture, const SDL_Rect& rect, SDL_Surface& surface);
+
+  /**
+   * Drop the cpu pixels of a texture (before destroying it)
+   * @param texture the texture
+   */
+  void forget(SDL_Texture *texture);
+}}
+
+#endif /*_IO_JACKHAY_SWAMP_COMPOSITOR_H*/
@@ -0,0 +1,329 @@
+/*
+ * (C) 2021 Jack Hay
+ *
+ * Untitled Swamp game
+ */
+
+#include "draw.h"
+#include "compositor.h"
+#include <mutex>
+#include <cstdlib>
+#include <algorithm>
+
+namespace impl {
+namespace draw {
+
+  //the counts of the frame being drawn (render thread)
+  static std::map<std::string, pass_stats_t> current_frame;
+
+  //the counts of the last frame (read from any thread)
+  static std::map<std::string, pass_stats_t> prev_frame;
+  static std::mutex frame_lock;
+
+  //the pass draws are attributed to (NULL until the first draw)
+  static pass_stats_t *pass = NULL;
+
+  //the bounds of the target being drawn to (empty when unknown)
+  static SDL_Rect bounds = {0,0,0,0};
+
+  //the last texture copied from
+  static SDL_Texture *last_texture = NULL;
+
+  /**
+   * Get the current pass
+   * @return the pass counts
+   */
+  static pass_stats_t& get_pass() {
+    if (pass == NULL) {
+      pass = &current_frame[DRAW_PASS_OTHER];
+    }
+    return *pass;
+  }
+
+  /**
+   * Constructor
+   * @param renderer the renderer (its viewport bounds the pass)
+   * @param name     the pass for draws in this scope
+   */
+  pass_scope_t::pass_scope_t(SDL_Renderer& renderer, const std::string& name)
+    : prev(pass),
+      prev_bounds(bounds) {
+    //map nodes are kept between frames
+    pass = &current_frame[name];
+
+    compositor::frame_t *frame = compositor::recording();
+    if (frame != NULL) {
+      bounds = {0, 0, frame->get_width(), frame->get_height()};
+      return;
+    }
+
+    SDL_Rect viewport;
+    SDL_RenderGetViewport(&renderer, &viewport);
+    bounds = {0, 0, viewport.w, viewport.h};
+  }
+
+  /**
+   * Restore the previous pass
+   */
+  pass_scope_t::~pass_scope_t() {
+    pass = prev;
+    bounds = prev_bounds;
+  }
+
+  /**
+   * Count a draw call
+   * @param area the estimated pixels (if in bounds)
+   * @param rect the area drawn to (NULL for the whole target)
+   */
+  static void count(size_t area, const SDL_Rect *rect) {
+    pass_stats_t& stats = get_pass();
+    stats.calls++;
+
+    if ((rect == NULL) || SDL_RectEmpty(&bounds)) {
+      stats.pixels += area;
+      return;
+    }
+
+    //clip the estimate to the target
+    SDL_Rect clipped;
+    if (SDL_IntersectRect(rect, &bounds, &clipped)) {
+      stats.pixels += std::min(area, (size_t) (clipped.w * clipped.h));
+    } else {
+      stats.offscreen++;
+    }
+  }
+
+  /**
+   * Count a copy
+   * @param texture the texture copied from
+   * @param src     the source area (NULL for the whole texture)
+   * @param dst     the destination area (NULL for the whole target)
+   */
+  static void count_copy(SDL_Texture *texture, const SDL_Rect *src, const SDL_Rect *dst) {
+    if (texture != last_texture) {
+      get_pass().texture_changes++;
+      last_texture = texture;
+    }
+
+    size_t area = 0;
+    if (dst != NULL) {
+      area = dst->w * dst->h;
+    } else if (!SDL_RectEmpty(&bounds)) {
+      area = bounds.w * bounds.h;
+    } else if (src != NULL) {
+      area = src->w * src->h;
+    }
+    count(area, dst);
+  }
+
+  /**
+   * Counted SDL_RenderCopy
+   * (recorded instead while a cpu frame is being drawn)
+   */
+  int copy(SDL_Renderer *renderer,
+           SDL_Texture *texture,
+           const SDL_Rect *src,
+           const SDL_Rect *dst) {
+    count_copy(texture, src, dst);
+
+    compositor::frame_t *frame = compositor::recording();
+    if ((frame != NULL) && (texture != NULL)) {
+      return frame->copy(*texture, src, dst, SDL_FLIP_NONE);
+    }
+    return SDL_RenderCopy(renderer, texture, src, dst);
+  }
+
+  /**
+   * Counted SDL_RenderCopyEx
+   * (recorded instead while a cpu frame is being drawn, without rotation)
+   */
+  int copy_ex(SDL_Renderer *renderer,
+              SDL_Texture *texture,
+              const SDL_Rect *src,
+              const SDL_Rect *dst,
+              const double angle,
+              const SDL_Point *center,
+              const SDL_RendererFlip flip) {
+    count_copy(texture, src, dst);
+
+    compositor::frame_t *frame = compositor::recording();
+    if ((frame != NULL) && (texture != NULL)) {
+      return frame->copy(*texture, src, dst, flip);
+    }
+    return SDL_RenderCopyEx(renderer, texture, src, dst, angle, center, flip);
+  }
+
+  /**
+   * Counted SDL_RenderDrawPoint
+   * (recorded instead while a cpu frame is being drawn)
+   */
+  int point(SDL_Renderer *renderer, int x, int y) {
+    SDL_Rect area = {x, y, 1, 1};
+    count(1, &area);
+
+    compositor::frame_t *frame = compositor::recording();
+    if (frame != NULL) {
+      return frame->fill(*renderer, &area);
+    }
+    return SDL_RenderDrawPoint(renderer, x, y);
+  }
+
+  /**
+   * Counted SDL_RenderDrawLine
+   * (recorded instead while a cpu frame is being drawn)
+   */
+  int line(SDL_Renderer *renderer, int x1, int y1, int x2, int y2) {
+    SDL_Rect area = {std::min(x1, x2), std::min(y1, y2),
+                     std::abs(x2 - x1) + 1, std::abs(y2 - y1) + 1};
+    count(std::max(area.w, area.h), &area);
+
+    compositor::frame_t *frame = compositor::recording();
+    if (frame != NULL) {
+      return frame->line(*renderer, x1, y1, x2, y2);
+    }
+    return SDL_RenderDrawLine(renderer, x1, y1, x2, y2);
+  }
+
+  /**
+   * Counted SDL_RenderDrawRect
+   * (recorded instead while a cpu frame is being drawn)
+   */
+  int rect(SDL_Renderer *renderer, const SDL_Rect *rect) {
+    //the outline
+    size_t area = (rect == NULL) ? 0 : (2 * (rect->w + rect->h));
+    count(area, rect);
+
+    compositor::frame_t *frame = compositor::recording();
+    if (frame != NULL) {
+      SDL_Rect outline = (rect == NULL) ? bounds : *rect;
+      if ((outline.w <= 0) || (outline.h <= 0)) {
+        return 0;
+      }
+
+      //top, bottom, left and right edges (corners drawn once)
+      SDL_Rect edges[4] = {{outline.x, outline.y, outline.w, 1},
+                           {outline.x, outline.y + outline.h - 1, outline.w, 1},
+                           {outline.x, outline.y + 1, 1, outline.h - 2},
+                           {outline.x + outline.w - 1, outline.y + 1, 1, outline.h - 2}};
+      for (int i=0; i<4; i++) {
+        if ((edges[i].w > 0) && (edges[i].h > 0)) {
+          frame->fill(*renderer, &edges[i]);
+        }
+      }
+      return 0;
+    }
+    return SDL_RenderDrawRect(renderer, rect);
+  }
+
+  /**
+   * Counted SDL_RenderFillRect
+   * (recorded instead while a cpu frame is being drawn)
+   */
+  int fill_rect(SDL_Renderer *renderer, const SDL_Rect *rect) {
+    size_t area = (rect == NULL) ? (bounds.w * bounds.h) : (rect->w * rect->h);
+    count(area, rect);
+
+    compositor::frame_t *frame = compositor::recording();
+    if (frame != NULL) {
+      return frame->fill(*renderer, rect);
+    }
+    return SDL_RenderFillRect(renderer, rect);
+  }
+
+  /**
+   * Counted SDL_RenderClear
+   * (recorded instead while a cpu frame is being drawn)
+   */
+  int clear(SDL_Renderer *renderer) {
+    count(bounds.w * bounds.h, NULL);
+
+    compositor::frame_t *frame = compositor::recording();
+    if (frame != NULL) {
+      return frame->clear(*renderer);
+    }
+    return SDL_RenderClear(renderer);
+  }
+
+  /**
+   * Count an object as drawn or culled in the current pass
+   * @param  drawn whether the object is drawn
+   * @return       drawn
+   */
+  bool visible(bool drawn) {
+    if (drawn) {
+      get_pass().drawn++;
+    } else {
+      get_pass().culled++;
+    }
+    return drawn;
+  }
+
+  /**
+   * Keep the counts of the frame just drawn and start a new frame
+   * (render thread)
+   */
+  void end_frame() {
+    std::unique_lock<std::mutex> lock(frame_lock);
+
+    //passes not drawn this frame are dropped
+    prev_frame.clear();
+    for (auto it=current_frame.begin(); it!=current_frame.end(); it++) {
+      const pass_stats_t& stats = it->second;
+      if ((stats.calls > 0) || (stats.drawn > 0) || (stats.culled > 0)) {
+        prev_frame.insert(*it);
+      }
+      it->second = {0,0,0,0,0,0};
+    }
+
+    //the first copy next frame is a texture change
+    last_texture = NULL;
+  }
+
+  /**
+   * Get the counts of the last frame
+   * @return counts by pass
+   */
+  std::map<std::string, pass_stats_t> last_frame() {
+    std::unique_lock<std::mutex> lock(frame_lock);
+    return prev_frame;
+  }
+
+  /**
+   * Get pass counts as json
+   * @param  stats the counts
+   * @return       the counts as json
+   */
+  static json to_json(const pass_stats_t& stats) {
+    return {{"calls", stats.calls},
+            {"texture_changes", stats.texture_changes},
+            {"pixels", stats.pixels},
+            {"offscreen", stats.offscreen},
+            {"drawn", stats.drawn},
+            {"culled", stats.culled}};
+  }
+
+  /**
+   * Dump the counts of the last frame
+   * @return the counts by pass (and the total) as json
+   */
+  json dump() {
+    std::unique_lock<std::mutex> lock(frame_lock);
+
+    json passes = json::object();
+    pass_stats_t total = {0,0,0,0,0,0};
+
+    for (auto it=prev_frame.begin(); it!=prev_frame.end(); it++) {
+      const pass_stats_t& stats = it->second;
+      passes[it->first] = to_json(stats);
+      total.calls += stats.calls;
+      total.texture_changes += stats.texture_changes;
+      total.pixels += stats.pixels;
+      total.offscreen += stats.offscreen;
+      total.drawn += stats.drawn;
+      total.culled += stats.culled;
+    }
+
+    return {{"passes", passes},
+            {"total", to_json(total)}};
+  }
+}}
@@ -0,0 +1,146 @@
+/*
+ * (C) 2021 Jack Hay
+ *
+ * Untitled Swamp game
+ */
+
+#ifndef _IO_JACKHAY_SWAMP_DRAW_H
+#define _IO_JACKHAY_SWAMP_DRAW_H
+
+#include <SDL2/SDL.h>
+#include <string>
+#include <map>
+#include <json/nlohmann_json.h>
+
+namespace impl {
+namespace draw {
+
+  typedef nlohmann::json json;
+
+  //the pass for draws outside of any pass scope
+  #define DRAW_PASS_OTHER "other"
+
+  /**
+   * Draw counts for a render pass over one frame
+   */
+  struct pass_stats_t {
+    //draw calls
+    size_t calls;
+    //copies from a different texture than the last copy
+    size_t texture_changes;
+    //estimated pixels written (clipped to the target)
+    size_t pixels;
+    //calls that were entirely outside the target
+    size_t offscreen;
+    //objects drawn and culled
+    size_t drawn;
+    size_t culled;
+  };
+
+  /**
+   * Attributes draws to some render pass while in scope,
+   * then restores the previous pass
+   * (render thread only)
+   */
+  struct pass_scope_t {
+  private:
+    //the pass before this scope
+    pass_stats_t *prev;
+
+    //the target bounds before this scope
+    SDL_Rect prev_bounds;
+
+  public:
+    /**
+     * Constructor
+     * @param renderer the renderer (its viewport bounds the pass)
+     * @param name     the pass for draws in this scope
+     */
+    pass_scope_t(SDL_Renderer& renderer, const std::string& name);
+    pass_scope_t(const pass_scope_t&) = delete;
+    pass_scope_t& operator=(const pass_scope_t&) = delete;
+
+    /**
+     * Restore the previous pass
+     */
+    ~pass_scope_t();
+  };
+
+  /**
+   * Counted SDL_RenderCopy
+   * (recorded instead while a cpu frame is being drawn)
+   */
+  int copy(SDL_Renderer *renderer,
+           SDL_Texture *texture,
+           const SDL_Rect *src,
+           const SDL_Rect *dst);
+
+  /**
+   * Counted SDL_RenderCopyEx
+   * (recorded instead while a cpu frame is being drawn, without rotation)
+   */
+  int copy_ex(SDL_Renderer *renderer,
+              SDL_Texture *texture,
+              const SDL_Rect *src,
+              const SDL_Rect *dst,
+              const double angle,
+              const SDL_Point *center,
+              const SDL_RendererFlip flip);
+
+  /**
+   * Counted SDL_RenderDrawPoint
+   * (recorded instead while a cpu frame is being drawn)
+   */
+  int point(SDL_Renderer *renderer, int x, int y);
+
+  /**
+   * Counted SDL_RenderDrawLine
+   * (recorded instead while a cpu frame is being drawn)
+   */
+  int line(SDL_Renderer *renderer, int x1, int y1, int x2, int y2);
+
+  /**
+   * Counted SDL_RenderDrawRect
+   * (recorded instead while a cpu frame is being drawn)
+   */
+  int rect(SDL_Renderer *renderer, const SDL_Rect *rect);
+
+  /**
+   * Counted SDL_RenderFillRect
+   * (recorded instead while a cpu frame is being drawn)
+   */
+  int fill_rect(SDL_Renderer *renderer, const SDL_Rect *rect);
+
+  /**
+   * Counted SDL_RenderClear
+   * (recorded instead while a cpu frame is being drawn)
+   */
+  int clear(SDL_Renderer *renderer);
+
+  /**
+   * Count an object as drawn or culled in the current pass
+   * @param  drawn whether the object is drawn
+   * @return       drawn
+   */
+  bool visible(bool drawn);
+
+  /**
+   * Keep the counts of the frame just drawn and start a new frame
+   * (render thread)
+   */
+  void end_frame();
+
+  /**
+   * Get the counts of the last frame
+   * @return counts by pass
+   */
+  std::map<std::string, pass_stats_t> last_frame();
+
+  /**
+   * Dump the counts of the last frame
+   * @return the counts by pass (and the total) as json
+   */
+  json dump();
+}}
+
+#endif /*_IO_JACKHAY_SWAMP_DRAW_H*/
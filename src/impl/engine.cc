@@ -12,14 +12,35 @@
 #include <thread>
 #include "logger.h"
 #include "utils.h"
+#include "text.h"
+#include "exceptions.h"
+#include "timing.h"
+#include "draw.h"
+#include "alloc.h"
+#include "input.h"
+#include <cstdio>
+#include <vector>
+#include <algorithm>
 
 namespace impl {
 namespace engine {
 
   //the duration in milliseconds to sleep between updates
   const int TICK_SLEEP = 50;
-  const int FRAMES_PER_FPS = 10;
   const float MS_PER_SECOND = 1000.0;
+  //the frame duration targeted (for the frame graph)
+  const float FRAME_BUDGET_MS = MS_PER_SECOND / 60;
+  //frames longer than this are logged in debug mode
+  const float HITCH_MS = 100.0;
+  //the timing graphs (world pixels)
+  const int TIMING_GRAPH_W = 96;
+  const int TIMING_GRAPH_H = 24;
+  const int TIMING_LINE_H = 12;
+  //draw counts (world pixels)
+  const int DRAW_STATS_W = 128;
+  const int DRAW_LINE_H = 10;
+  //debug text size in world pixels
+  const int DEBUG_FONT_SIZE = 8;
 
   /**
    * Take the max value of two numbers
@@ -48,7 +69,18 @@ namespace engine {
       std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
 
       //update the game state
-      manager->update();
+      {
+        alloc::zone_t zone("tick");
+        try {
+          manager->update();
+        } catch (exceptions::gen_exception_t& e) {
+          //stop the game (the render loop exits)
+          logger::log_err("update failed: " + e.trace());
+          manager->set_running(false);
+        }
+      }
+      timing::ticks().record_since(start);
+      alloc::publish("tick");
 
       //elapsed time
       std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
@@ -63,6 +95,103 @@ namespace engine {
     pthread_exit(NULL);
   }
 
+  /**
+   * Render a timing graph and its percentiles
+   * @param renderer the renderer
+   * @param recorder the durations
+   * @param label    the label for the percentiles
+   * @param budget   the target duration in milliseconds
+   * @param x        the position x (world pixels)
+   * @param y        the position y (world pixels)
+   * @param font     the debug font
+   * @param scale    the overlay scale
+   */
+  void render_timing(SDL_Renderer& renderer,
+                     const timing::recorder_t& recorder,
+                     const char *label,
+                     float budget,
+                     int x, int y,
+                     TTF_Font& font,
+                     int scale) {
+    SDL_Rect bounds = {x * scale, y * scale, TIMING_GRAPH_W * scale, TIMING_GRAPH_H * scale};
+    timing::render_graph(renderer, recorder, bounds, budget);
+
+    //p50 p95 p99 max
+    timing::stats_t stats = recorder.get_stats();
+    char line[64];
+    snprintf(line, sizeof(line), "%s %.1f %.1f %.1f %.1f",
+             label, stats.p50, stats.p95, stats.p99, stats.max);
+    utils::render_text(renderer, line, x, y + TIMING_GRAPH_H, font, scale);
+  }
+
+  /**
+   * Render one line of draw counts
+   * (calls, texture changes, kilopixels, offscreen calls, drawn/culled objects)
+   * @param renderer the renderer
+   * @param name     the pass
+   * @param stats    the counts
+   * @param x        the position x (world pixels)
+   * @param y        the position y (world pixels)
+   * @param font     the debug font
+   * @param scale    the overlay scale
+   */
+  void render_draw_line(SDL_Renderer& renderer,
+                        const std::string& name,
+                        const draw::pass_stats_t& stats,
+                        int x, int y,
+                        TTF_Font& font,
+                        int scale) {
+    char line[96];
+    snprintf(line, sizeof(line), "%s %zu %zu %zuk %zu %zu/%zu",
+             name.c_str(), stats.calls, stats.texture_changes,
+             stats.pixels / 1000, stats.offscreen, stats.drawn, stats.culled);
+    utils::render_text(renderer, line, x, y, font, scale);
+  }
+
+  /**
+   * Render the last frame's draw counts: the total, then
+   * the passes with the most calls (as many as fit)
+   * @param renderer the renderer
+   * @param x        the position x (world pixels)
+   * @param y        the position y (world pixels)
+   * @param bottom   the last position y that fits (world pixels)
+   * @param font     the debug font
+   * @param scale    the overlay scale
+   */
+  void render_draw_stats(SDL_Renderer& renderer,
+                         int x, int y, int bottom,
+                         TTF_Font& font,
+                         int scale) {
+    const std::map<std::string, draw::pass_stats_t> passes = draw::last_frame();
+
+    std::vector<std::pair<std::string, draw::pass_stats_t>> heaviest(passes.begin(), passes.end());
+    std::sort(heaviest.begin(), heaviest.end(),
+      [](const std::pair<std::string, draw::pass_stats_t>& a,
+         const std::pair<std::string, draw::pass_stats_t>& b) {
+        return a.second.calls > b.second.calls;
+      });
+
+    draw::pass_stats_t total = {0,0,0,0,0,0};
+    for (size_t i=0; i<heaviest.size(); i++) {
+      const draw::pass_stats_t& stats = heaviest.at(i).second;
+      total.calls += stats.calls;
+      total.texture_changes += stats.texture_changes;
+      total.pixels += stats.pixels;
+      total.offscreen += stats.offscreen;
+      total.drawn += stats.drawn;
+      total.culled += stats.culled;
+    }
+    render_draw_line(renderer, "all", total, x, y, font, scale);
+
+    for (size_t i=0; i<heaviest.size(); i++) {
+      y += DRAW_LINE_H;
+      if (y > bottom) {
+        break;
+      }
+      render_draw_line(renderer, heaviest.at(i).first, heaviest.at(i).second, x, y, font, scale);
+    }
+  }
+
   /**
    * Start the update thread
    * @param manager the gamestate manager
@@ -85,33 +214,33 @@ namespace engine {
 
   /**
    * Start the render loop
-   * @param renderer the sdl renderer
+   * @param world the world target (draws with its renderer)
    * @param manager the gamestate manager
    * @param debug whether debug enabled
    * @param debug_font_name the font to use
    * @return success or failure
    */
-  bool start_renderer(SDL_Renderer& renderer,
+  bool start_renderer(render_target::world_target_t& world,
                       std::shared_ptr<state::state_manager_t> manager,
                       const bool debug,
                       const std::string& debug_font_name) {
+    SDL_Renderer& renderer = world.get_renderer();
 
     //Event handler
 		SDL_Event e;
 
-    //track fps in debug mode
-    int fps = 0;
     TTF_Font *debug_font;
-    //update fps every 10 frames
-    int frames = FRAMES_PER_FPS;
+
+    //the start of the last frame
+    std::chrono::steady_clock::time_point last_start = std::chrono::steady_clock::now();
 
     //init debug font
     if (debug) {
-      //load the debug font
-      debug_font = TTF_OpenFont(debug_font_name.c_str(), 8);
-      if (!debug_font) {
-        logger::log_err("failed to load font: " + debug_font_name +
-                        " (" + std::string(TTF_GetError()) + ")");
+      //load the debug font (drawn at window resolution)
+      try {
+        debug_font = &text::get_font(debug_font_name, DEBUG_FONT_SIZE * world.get_scale());
+      } catch (exceptions::rsrc_exception_t& e) {
+        logger::log_err("failed to load font: " + e.trace());
         return false;
       }
     }
@@ -121,14 +250,28 @@ namespace engine {
       //get the cycle start time
       std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
 
+      //frame to frame (includes waiting for vsync)
+      std::chrono::duration<float, std::milli> frame_ms = start - last_start;
+      timing::frames().record(frame_ms.count());
+      last_start = start;
+
+      if (debug && (frame_ms.count() > HITCH_MS)) {
+        logger::log_lazy(LOG_INFO, [&]() {
+          return "hitch: frame took " + std::to_string((int) frame_ms.count()) + "ms";
+        });
+      }
+
+      alloc::zone_t zone("events");
+
       //check events
+      input::queue_t& input = manager->get_input();
       while (SDL_PollEvent(&e) != 0 ) {
         //check for a quit event
         if (e.type == SDL_QUIT) {
           manager->set_running(false);
         } else {
-          //handle event (player)
-          manager->handle_event(e);
+          //queue the event for the next update (player)
+          input.post(e);
         }
       }
 
@@ -137,45 +280,60 @@ namespace engine {
         break;
       }
 
+      zone.enter("render");
+      world.begin();
+
       //Clear screen
       SDL_SetRenderDrawColor(&renderer,0xFF,0xFF,0xFF,0xFF);
-      SDL_RenderClear(&renderer);
+      draw::clear(&renderer);
 
       //render the current state
-      manager->render(renderer,debug);
+      try {
+        manager->render(renderer,debug);
+      } catch (exceptions::gen_exception_t& e) {
+        logger::log_err("render failed: " + e.trace());
+        manager->set_running(false);
+      }
+
+      //scale the world to the window
+      world.end();
 
       //render debug info
       if (debug) {
-        //render the fps
+        draw::pass_scope_t pass(renderer,"debug");
+
+        //render the fps (from the median frame)
+        timing::stats_t frame_stats = timing::frames().get_stats();
+        int fps = (frame_stats.p50 > 0) ? int (MS_PER_SECOND / frame_stats.p50) : 0;
         utils::render_text(renderer,
                            std::to_string(fps),
-                           0,0,*debug_font);
+                           0,0,*debug_font,
+                           world.get_scale());
 
         //render debug info
-        manager->render_debug_info(renderer,*debug_font);
+        manager->render_debug_info(renderer,*debug_font,world.get_scale());
+
+        //frame and tick durations
+        int graph_x = world.get_width() - TIMING_GRAPH_W;
+        render_timing(renderer, timing::frames(), "f", FRAME_BUDGET_MS,
+                      graph_x, 0, *debug_font, world.get_scale());
+        render_timing(renderer, timing::ticks(), "t", TICK_SLEEP,
+                      graph_x, TIMING_GRAPH_H + TIMING_LINE_H, *debug_font, world.get_scale());
+
+        //draw counts by pass
+        render_draw_stats(renderer,
+                          world.get_width() - DRAW_STATS_W,
+                          (TIMING_GRAPH_H + TIMING_LINE_H) * 2,
+                          world.get_height() - DRAW_LINE_H,
+                          *debug_font, world.get_scale());
       }
 
       //Update screen
-      SDL_RenderPresent(&renderer);
+      world.present();
 
-      if (debug) {
-        //update fps every 10 frames
-        if (frames <= 0) {
-          //elapsed time
-          std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
-
-          //calculate the elapsed milliseconds
-          int elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
-
-          //calculate fps
-          if (elapsed_ms > 0) {
-            fps = int (MS_PER_SECOND / elapsed_ms);
-          }
-          frames = FRAMES_PER_FPS;
-        } else {
-          frames--;
-        }
-      }
+      //keep this frame's draw counts
+      draw::end_frame();
+      alloc::publish("frame");
     }
 
     return true;
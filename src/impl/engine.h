@@ -12,6 +12,7 @@
 #include <SDL2/SDL_ttf.h>
 #include <memory>
 #include "state/state_manager.h"
+#include "render_target.h"
 
 namespace impl {
 namespace engine {
@@ -25,13 +26,13 @@ namespace engine {
 
   /**
    * Start the render loop
-   * @param renderer the sdl renderer
+   * @param world the world target (draws with its renderer)
    * @param manager the gamestate manager
    * @param debug whether debug enabled
    * @param debug_font_name the font to use
    * @return success or failure
    */
-  bool start_renderer(SDL_Renderer& renderer,
+  bool start_renderer(render_target::world_target_t& world,
                       std::shared_ptr<state::state_manager_t> manager,
                       const bool debug,
                       const std::string& debug_font_name);
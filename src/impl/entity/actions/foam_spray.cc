@@ -7,6 +7,8 @@
 #include "foam_spray.h"
 #include <stdlib.h>
 #include "../../environment/chemical_foam.h"
+#include "../../draw.h"
+#include "../../metrics.h"
 
 namespace impl {
 namespace entity {
@@ -78,6 +80,9 @@ namespace actions {
 
     //check if this action is visible
     this->visible = !particles.empty();
+
+    static metrics::gauge_t& count = metrics::gauge("foam_particles");
+    count.set(particles.size());
   }
 
   /**
@@ -98,9 +103,9 @@ namespace actions {
                              PARTICLE_COLOR_B,225);
       //render foam
       for (size_t i=0; i<particles.size(); i++) {
-        SDL_RenderDrawPoint(&renderer,
-                            particles.at(i).first - camera.x,
-                            particles.at(i).second - camera.y);
+        draw::point(&renderer,
+                    particles.at(i).first - camera.x,
+                    particles.at(i).second - camera.y);
       }
     }
   }
@@ -5,12 +5,14 @@
  */
 
 #include "anim_set.h"
+#include "../accounting.h"
 #include <json/nlohmann_json.h>
 #include <fstream>
 #include <iostream>
 #include "../exceptions.h"
 #include "../utils.h"
 #include "../logger.h"
+#include "../draw.h"
 
 namespace impl {
 namespace entity {
@@ -101,7 +103,7 @@ namespace entity {
   */
   anim_set_t::~anim_set_t() {
     if (texture != NULL) {
-      SDL_DestroyTexture(texture);
+      accounting::free_texture(texture);
       texture = NULL;
     }
   }
@@ -165,18 +167,18 @@ namespace entity {
     if (texture != NULL) {
       if (facing_left) {
         //flip and render the current frame
-        SDL_RenderCopyEx(&renderer,
-                         this->texture,
-                         &sample_bounds,
-                         &image_bounds,
-                         0, NULL,
-                         SDL_FLIP_HORIZONTAL);
+        draw::copy_ex(&renderer,
+                      this->texture,
+                      &sample_bounds,
+                      &image_bounds,
+                      0, NULL,
+                      SDL_FLIP_HORIZONTAL);
       } else {
         //render the current animation frame
-        SDL_RenderCopy(&renderer,
-                       this->texture,
-                       &sample_bounds,
-                       &image_bounds);
+        draw::copy(&renderer,
+                   this->texture,
+                   &sample_bounds,
+                   &image_bounds);
       }
     }
   }
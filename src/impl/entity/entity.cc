@@ -6,6 +6,7 @@
 
 #include "entity.h"
 #include "../exceptions.h"
+#include "../draw.h"
 #include <iostream>
 
 namespace impl {
@@ -272,7 +273,7 @@ namespace entity {
    * @param entity_pos the positions of all entities in the map
    * @param map        the tilemap
    */
-  void entity_t::update_behavior(const std::vector<entity_pos_t>& entity_pos,
+  void entity_t::update_behavior(const entity_positions_t& entity_pos,
                                  const tilemap::abstract_tilemap_t& map) {
     int cx,cy;
     this->get_center(cx,cy);
@@ -310,7 +311,7 @@ namespace entity {
       SDL_Rect bounds = {0,0,camera.w,camera.h};
       //render damage (TEMP)
       SDL_SetRenderDrawColor(&renderer,255,0,0,255);
-      SDL_RenderDrawRect(&renderer,&bounds);
+      draw::rect(&renderer,&bounds);
     }
 
     if (debug) {
@@ -323,7 +324,7 @@ namespace entity {
       SDL_SetRenderDrawColor(&renderer,0,255,0,127);
 
       //render the bounds
-      SDL_RenderDrawRect(&renderer,&bounds);
+      draw::rect(&renderer,&bounds);
     }
   }
 }}
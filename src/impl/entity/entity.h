@@ -10,6 +10,7 @@
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL.h>
 #include <vector>
+#include <memory_resource>
 #include <memory>
 #include <string>
 #include <functional>
@@ -58,10 +59,17 @@ namespace entity {
   #define EPOS_TYPE 4
   #define EPOS_STATE 5
 
+  /*
+   * The positions of all entities in a map, rebuilt each tick
+   * (in tick memory, behaviors can allocate scratch from the same
+   * resource with get_allocator().resource())
+   */
+  typedef std::pmr::vector<entity_pos_t> entity_positions_t;
+
   /*
    * A behavior handler
    */
-  typedef std::function<void(const std::vector<entity_pos_t>&,
+  typedef std::function<void(const entity_positions_t&,
                              const tilemap::abstract_tilemap_t&,
                              int, int,
                              entity_state&,
@@ -217,7 +225,7 @@ namespace entity {
      * @param entity_pos the positions of all entities in the map
      * @param map        the tilemap
      */
-    virtual void update_behavior(const std::vector<entity_pos_t>& entity_pos,
+    virtual void update_behavior(const entity_positions_t& entity_pos,
                                  const tilemap::abstract_tilemap_t& map);
 
     /**
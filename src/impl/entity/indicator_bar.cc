@@ -5,6 +5,7 @@
  */
 
 #include "indicator_bar.h"
+#include "../draw.h"
 
 namespace impl {
 namespace entity {
@@ -44,16 +45,16 @@ namespace entity {
     SDL_Rect rect = {x,y,w,BAR_HEIGHT};
 
     //render the bounds
-    SDL_RenderDrawRect(&renderer,&rect);
+    draw::rect(&renderer,&rect);
 
     //map the current value to the bar size
     int bar_len = ((float) curr_val / (float) max_val) * (w - 2);
 
     //render the progress bar
-    SDL_RenderDrawLine(&renderer,
-                       x + 1,
-                       y + 1,
-                       x + bar_len,
-                       y + 1);
+    draw::line(&renderer,
+               x + 1,
+               y + 1,
+               x + bar_len,
+               y + 1);
   }
 }}
@@ -7,8 +7,9 @@
 #include "insects.h"
 #include <json/nlohmann_json.h>
 #include "../exceptions.h"
+#include "../draw.h"
+#include "../metrics.h"
 #include <fstream>
-#include <stdlib.h>
 
 namespace impl {
 namespace entity {
@@ -48,13 +49,12 @@ namespace entity {
   /**
    * Initialize map wide insect swarm
    * @param cfg_path the path to the insect configuration file
+   * @param seed     the level seed
    */
-  insects_t::insects_t(const std::string& cfg_path) {
+  insects_t::insects_t(const std::string& cfg_path, uint64_t seed)
+    : rng(seed, rng::INSECTS) {
 
     try {
-      //init random seed
-      srand(time(NULL));
-
       std::ifstream in_stream(cfg_path);
       nlohmann::json config;
 
@@ -90,9 +90,9 @@ namespace entity {
           for (int j=0; j<insects_per_section; j++) {
             //add a random position
             positions.push_back(
-              std::make_pair((rand() % this->bounds_w.at(i).second) +
+              std::make_pair(rng.next_int(this->bounds_w.at(i).second) +
                                     this->bounds_w.at(i).first,
-                             (rand() % bounds_bot) + bounds_top));
+                             rng.next_int(bounds_bot) + bounds_top));
           }
         }
       }
@@ -108,7 +108,8 @@ namespace entity {
       bounds_top(0),
       bounds_bot(0),
       bounds_w(),
-      r(0), b(0), g(0) {}
+      r(0), b(0), g(0),
+      rng(0, rng::INSECTS) {}
 
   /**
    * Check if a given point lies within the rectangle provided
@@ -130,9 +131,9 @@ namespace entity {
     //update each insect
     for (size_t i=0; i<positions.size(); i++) {
       //only update sometimes
-      if ((rand() % 2) == 0) {
-        int dx = (rand() % 3) - 1;
-        int dy = (rand() % 3) - 1;
+      if (rng.next_int(2) == 0) {
+        int dx = rng.next_int(3) - 1;
+        int dy = rng.next_int(3) - 1;
 
         //store the previous x value
         int prev_x = positions.at(i).first;
@@ -167,6 +168,9 @@ namespace entity {
         }
       }
     }
+
+    static metrics::gauge_t& count = metrics::gauge("insects");
+    count.set(positions.size());
   }
 
   /**
@@ -184,11 +188,11 @@ namespace entity {
     //render each insect
     for (size_t i=0; i<positions.size(); i++) {
       //check if the point is in view
-      if (in_camera(positions.at(i), camera)) {
+      if (draw::visible(in_camera(positions.at(i), camera))) {
         //render a pixel
-        SDL_RenderDrawPoint(&renderer,
-                            positions.at(i).first - camera.x,
-                            positions.at(i).second - camera.y);
+        draw::point(&renderer,
+                    positions.at(i).first - camera.x,
+                    positions.at(i).second - camera.y);
       }
     }
   }
@@ -11,6 +11,7 @@
 #include <SDL2/SDL.h>
 #include <vector>
 #include <string>
+#include "../rng.h"
 
 namespace impl {
 namespace entity {
@@ -33,6 +34,9 @@ namespace entity {
     int b;
     int g;
 
+    //the random stream for the swarm
+    rng::rng_t rng;
+
     /**
      * Check if a given point lies within the rectangle provided
      * @param pt the point to check
@@ -45,13 +49,20 @@ namespace entity {
     /**
      * Initialize map wide insect swarm
      * @param cfg_path the path to the insect configuration file
+     * @param seed     the level seed
      */
-    insects_t(const std::string& cfg_path);
+    insects_t(const std::string& cfg_path, uint64_t seed);
     //default, empty constructor
     insects_t();
     insects_t(const insects_t&) = delete;
     insects_t& operator=(const insects_t&) = delete;
 
+    /**
+     * Get the number of insects in the swarm
+     * @return the insect count
+     */
+    size_t get_count() const { return positions.size(); }
+
     /**
      * Update the cloud of insects
      */
@@ -24,7 +24,7 @@ namespace npc_behavior {
    * @param state the state set based on decision
    * @param facing_left set by the call (updates entity facing direction)
    */
-  void surveyor(const std::vector<entity_pos_t>& pos,
+  void surveyor(const entity_positions_t& pos,
                 const tilemap::abstract_tilemap_t& map,
                 int x, int y,
                 entity_state& state,
@@ -18,7 +18,7 @@ namespace entity {
   /**
    * Empty behavior handler for player
    */
-  void behavior_noop(const std::vector<entity_pos_t>&,
+  void behavior_noop(const entity_positions_t&,
                      const tilemap::abstract_tilemap_t&,int,int,
                      entity_state&, bool&) {  }
 
@@ -73,7 +73,7 @@ namespace entity {
    * Add a new item to inventory
    * @param item the item to add
    */
-  void player_t::add_item(std::shared_ptr<items::item_t> item) {
+  void player_t::add_item(const std::shared_ptr<items::item_t>& item) {
     held_items.push_back(item);
   }
 
@@ -85,7 +85,7 @@ namespace entity {
      * Add a new item to inventory
      * @param item the item to add
      */
-    void add_item(std::shared_ptr<items::item_t> item);
+    void add_item(const std::shared_ptr<items::item_t>& item);
 
     /**
      * Handle some key event
@@ -106,7 +106,7 @@ namespace entity {
       * @param entity_pos the positions of all entities in the map
       * @param map        the tilemap
       */
-     void update_behavior(const std::vector<entity_pos_t>&,
+     void update_behavior(const entity_positions_t&,
                           const tilemap::abstract_tilemap_t&) override {}
 
     /**
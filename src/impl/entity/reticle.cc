@@ -5,6 +5,7 @@
  */
 
 #include "reticle.h"
+#include "../draw.h"
 
 namespace impl {
 namespace entity {
@@ -35,13 +36,9 @@ namespace entity {
    */
   void reticle_t::handle_event(const SDL_Event& e) {
     if (e.type == SDL_MOUSEMOTION) {
-     int mx = 0;
-     int my = 0;
-     SDL_GetMouseState(&mx,&my);
-
-     //scale the position
-     x = mx / window_scale;
-     y = my / window_scale;
+     //scale the position (from the event, it may have been queued)
+     x = e.motion.x / window_scale;
+     y = e.motion.y / window_scale;
    }
   }
 
@@ -55,9 +52,9 @@ namespace entity {
     SDL_SetRenderDrawColor(&renderer,255,255,255,225);
 
     //draw the reticle
-    SDL_RenderDrawPoint(&renderer,x,y - 1);
-    SDL_RenderDrawPoint(&renderer,x - 1,y);
-    SDL_RenderDrawPoint(&renderer,x,y + 1);
-    SDL_RenderDrawPoint(&renderer,x + 1,y);
+    draw::point(&renderer,x,y - 1);
+    draw::point(&renderer,x - 1,y);
+    draw::point(&renderer,x,y + 1);
+    draw::point(&renderer,x + 1,y);
   }
 }}
@@ -6,10 +6,10 @@
 
 #include "chemical_foam.h"
 #include <iostream>
-#include <stdlib.h>
 #include <algorithm>
 #include <random>
 #include "../entity/player.h"
+#include "../draw.h"
 
 namespace impl {
 namespace environment {
@@ -29,20 +29,19 @@ namespace environment {
    * @param w     width
    * @param h     height
    * @param density the density of the foam
-   * @param debug whether debug mode enabled
+   * @param rng   the random stream for this element
    */
   chemical_foam_t::chemical_foam_t(int x,int y,
                                    int w, int h,
-                                   float density)
+                                   float density,
+                                   const rng::rng_t& rng)
     : renderable_t({x,y,w,h}, false, false),
-      bubbles(), foam(), dispersed(false) {
+      bubbles(), foam(), dispersed(false), rng(rng) {
 
-    //init random seed
-    srand(time(NULL));
     std::vector<int> x_count;
 
-    //normal distribution generator
-    std::default_random_engine generator;
+    //normal distribution generator (seeded from this element's stream)
+    std::default_random_engine generator(this->rng.next());
     std::normal_distribution<double> distribution(w/2,w/4);
 
     //add a vertical count for each x coord
@@ -55,7 +54,7 @@ namespace environment {
       double number = distribution(generator);
       if ((number > 0.0) &&
           (number < w) &&
-          ((rand() % w) < (density * w))) {
+          (this->rng.next_int(w) < (density * w))) {
         //add a point to this x point
         x_count.at((int)number) = x_count.at((int) number) + 1;
       }
@@ -80,9 +79,9 @@ namespace environment {
    */
   void chemical_foam_t::mk_random_bubble() {
     //make a new random bubble and add to vector
-    bubbles.push_back(std::make_tuple((rand() % bounds.w) + bounds.x,
+    bubbles.push_back(std::make_tuple(rng.next_int(bounds.w) + bounds.x,
                                       bounds.y + bounds.h - 1,
-                                      rand() % BUBBLE_TICKS_PER_RISE));
+                                      rng.next_int(BUBBLE_TICKS_PER_RISE)));
   }
 
   /**
@@ -99,14 +98,14 @@ namespace environment {
   void chemical_foam_t::disperse_foam() {
     //erase some of the foam
     for (size_t i=0; i<foam.size(); i++) {
-      if (rand() % DISPERSE_FOAM_RATE == 0) {
+      if (rng.next_int(DISPERSE_FOAM_RATE) == 0) {
         foam.erase(foam.begin() + i);
       }
     }
 
     //erase some of the bubbles
     for (size_t i=0; i<bubbles.size(); i++) {
-      if (rand() % (DISPERSE_FOAM_RATE * 2) == 0) {
+      if (rng.next_int(DISPERSE_FOAM_RATE * 2) == 0) {
         bubbles.erase(bubbles.begin() + i);
       }
     }
@@ -144,8 +143,9 @@ namespace environment {
 
   /**
    * Update the renderable component
+   * @param tick memory for data that only lives for this tick
    */
-  void chemical_foam_t::update() {
+  void chemical_foam_t::update(std::pmr::memory_resource& /*tick*/) {
     if (!dispersed) {
       //update existing bubbles
       for (size_t i=0; i<bubbles.size(); i++) {
@@ -159,7 +159,7 @@ namespace environment {
 
           //check if the bubble is too high
           if ((std::get<1>(bubbles.at(i)) > bounds.h) &&
-              (rand() % 3 == 0)) {
+              (rng.next_int(3) == 0)) {
             //remove
             bubbles.erase(bubbles.begin() + i);
             //replace
@@ -180,21 +180,21 @@ namespace environment {
                                const SDL_Rect& camera,
                                bool debug) const {
     //check if this element is in view
-    if (this->is_collided(camera,false) && !this->dispersed) {
+    if (draw::visible(this->is_collided(camera,false) && !this->dispersed)) {
       //temp foam color
       SDL_SetRenderDrawColor(&renderer,FOAM_R,FOAM_G,FOAM_B,225);
       //render foam
       for (size_t i=0; i<foam.size(); i++) {
-        SDL_RenderDrawPoint(&renderer,
-                            foam.at(i).first - camera.x,
-                            foam.at(i).second - camera.y);
+        draw::point(&renderer,
+                    foam.at(i).first - camera.x,
+                    foam.at(i).second - camera.y);
       }
 
       //render bubbles
       for (size_t i=0; i<bubbles.size(); i++) {
-        SDL_RenderDrawPoint(&renderer,
-                            std::get<0>(bubbles.at(i)) - camera.x,
-                            std::get<1>(bubbles.at(i)) - camera.y);
+        draw::point(&renderer,
+                    std::get<0>(bubbles.at(i)) - camera.x,
+                    std::get<1>(bubbles.at(i)) - camera.y);
       }
 
       if (debug) {
@@ -207,7 +207,7 @@ namespace environment {
         SDL_SetRenderDrawColor(&renderer,255,102,0,255);
 
         //render the bounds
-        SDL_RenderDrawRect(&renderer,&debug_bounds);
+        draw::rect(&renderer,&debug_bounds);
       }
     }
   }
@@ -10,6 +10,7 @@
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL.h>
 #include "renderable.h"
+#include "../rng.h"
 #include <string>
 #include <vector>
 #include <utility>
@@ -32,6 +33,9 @@ namespace environment {
     //whether the foam has been dispersed
     bool dispersed;
 
+    //random stream for foam and bubbles
+    rng::rng_t rng;
+
     /**
      * Create a random bubble
      */
@@ -45,10 +49,12 @@ namespace environment {
      * @param w     width
      * @param h     height
      * @param density the density of the foam
+     * @param rng   the random stream for this element
      */
     chemical_foam_t(int x,int y,
                     int w, int h,
-                    float density);
+                    float density,
+                    const rng::rng_t& rng);
     chemical_foam_t(const chemical_foam_t&) = delete;
     chemical_foam_t& operator=(const chemical_foam_t&) = delete;
 
@@ -82,8 +88,9 @@ namespace environment {
 
     /**
      * Update the renderable component
+     * @param tick memory for data that only lives for this tick
      */
-    void update();
+    void update(std::pmr::memory_resource& tick);
 
     /**
      * Render the component
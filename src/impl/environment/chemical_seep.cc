@@ -5,6 +5,7 @@
  */
 
 #include "chemical_seep.h"
+#include "../draw.h"
 #include <stdlib.h>
 
 namespace impl {
@@ -24,12 +25,14 @@ namespace environment {
    * @param y     position y
    * @param w     width
    * @param h     height
-   * @param debug whether debug mode enabled
+   * @param rng   the random stream for this element
    */
   chemical_seep_t::chemical_seep_t(int x,int y,
-                                   int w, int h)
+                                   int w, int h,
+                                   const rng::rng_t& rng)
     : renderable_t({x,y,w,h},true,false),
-      drips() {}
+      drips(),
+      rng(rng) {}
 
   /**
    * Interact with the seep (collecting sample)
@@ -42,8 +45,9 @@ namespace environment {
 
   /**
    * Update the seep
+   * @param tick memory for data that only lives for this tick
    */
-  void chemical_seep_t::update() {
+  void chemical_seep_t::update(std::pmr::memory_resource& /*tick*/) {
     //update current drips
     for (size_t i=0; i<drips.size(); i++) {
       drips.at(i).second += GRAVITY_PER_TICK;
@@ -54,13 +58,13 @@ namespace environment {
 
       } else if (drips.at(i).second > (bounds.y + bounds.h)) {
         //turn drip into a splash
-        drips.at(i).second -= rand() % SPLASH_RADIUS + 2;
-        drips.at(i).first += (rand() % (2 * SPLASH_RADIUS)) - SPLASH_RADIUS;
+        drips.at(i).second -= rng.next_int(SPLASH_RADIUS) + 2;
+        drips.at(i).first += rng.next_int(2 * SPLASH_RADIUS) - SPLASH_RADIUS;
       }
     }
 
     //random chance of creating a new drip
-    if (rand() % DRIP_CHANCE_PER_TICK == 0) {
+    if (rng.next_int(DRIP_CHANCE_PER_TICK) == 0) {
       drips.push_back(std::make_pair(bounds.x,bounds.y));
     }
   }
@@ -75,14 +79,14 @@ namespace environment {
                                const SDL_Rect& camera,
                                bool debug) const {
 
-    if (this->is_collided(camera,false)) {
+    if (draw::visible(this->is_collided(camera,false))) {
       //set the color
       SDL_SetRenderDrawColor(&renderer,DRIP_R,DRIP_G,DRIP_B,225);
 
       for (size_t i=0; i<drips.size(); i++) {
-        SDL_RenderDrawPoint(&renderer,
-                            drips.at(i).first - camera.x,
-                            drips.at(i).second - camera.y);
+        draw::point(&renderer,
+                    drips.at(i).first - camera.x,
+                    drips.at(i).second - camera.y);
       }
 
       if (debug) {
@@ -93,7 +97,7 @@ namespace environment {
                                  bounds.y - camera.y,
                                  bounds.w, bounds.h};
         //render the bounds
-        SDL_RenderDrawRect(&renderer,&debug_bounds);
+        draw::rect(&renderer,&debug_bounds);
       }
     }
   }
@@ -10,6 +10,7 @@
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL.h>
 #include "renderable.h"
+#include "../rng.h"
 #include <string>
 #include <vector>
 #include <utility>
@@ -25,6 +26,9 @@ namespace environment {
     //drips
     std::vector<std::pair<int,int>> drips;
 
+    //random stream for drips
+    rng::rng_t rng;
+
   public:
     /**
      * Chemical seep constructor
@@ -32,8 +36,9 @@ namespace environment {
      * @param y     position y
      * @param w     width
      * @param h     height
+     * @param rng   the random stream for this element
      */
-    chemical_seep_t(int x,int y, int w, int h);
+    chemical_seep_t(int x,int y, int w, int h, const rng::rng_t& rng);
     chemical_seep_t(const chemical_seep_t&) = delete;
     chemical_seep_t& operator=(const chemical_seep_t&) = delete;
 
@@ -48,8 +53,9 @@ namespace environment {
 
     /**
      * Update the seep
+     * @param tick memory for data that only lives for this tick
      */
-    void update();
+    void update(std::pmr::memory_resource& tick);
 
     /**
      * Render the seep
@@ -5,6 +5,7 @@
  */
 
 #include "crows.h"
+#include "../draw.h"
 
 namespace impl {
 namespace environment {
@@ -16,15 +17,18 @@ namespace environment {
    * @param anim_path    the path to the tree texture
    * @param base_path    the path to the resources folder
    * @param renderer the renderer for loading the texture
+   * @param rng      the random stream for this element
    */
   crows_t::crows_t(int count,
                    int width,
                    const std::string& anim_path,
                    const std::string& base_path,
-                   SDL_Renderer& renderer)
+                   SDL_Renderer& renderer,
+                   const rng::rng_t& rng)
     : renderable_t({0,0,0,0},false,false),
       crows(),
-      width(width) {
+      width(width),
+      rng(rng) {
 
     //create the animation
     anim = std::make_unique<entity::anim_set_t>(anim_path,
@@ -34,9 +38,6 @@ namespace environment {
     for (int i=0; i<count; i++) {
       crows.push_back(this->new_crow(true));
     }
-
-    srand(time(NULL));
-
   }
 
   /**
@@ -44,9 +45,9 @@ namespace environment {
    * @return the crow position and direction
    */
   std::tuple<int,int,bool> crows_t::new_crow(bool initial) {
-    bool left = ((rand() % 2) == 0);
+    bool left = (rng.next_int(2) == 0);
     //random height
-    float y = 15 + ((rand() % 30) - 15);
+    float y = 15 + (rng.next_int(30) - 15);
 
     //starting x based on direction
     float x = 0;
@@ -56,7 +57,7 @@ namespace environment {
 
     if (initial) {
       //put the crow anywhere
-      x = (rand() % width);
+      x = rng.next_int(width);
     }
 
     return std::make_tuple(x,y,left);
@@ -64,12 +65,13 @@ namespace environment {
 
   /**
    * Update the crows
+   * @param tick memory for data that only lives for this tick
    */
-  void crows_t::update() {
+  void crows_t::update(std::pmr::memory_resource& tick) {
     anim->update();
 
     //crows to remove (and then replace)
-    std::vector<int> reset;
+    std::pmr::vector<int> reset(&tick);
 
     for (size_t i=0; i<crows.size(); i++) {
       if (std::get<2>(crows.at(i))) {
@@ -89,7 +91,7 @@ namespace environment {
 
     //reset any crows out of bounds
     for (size_t i=0; i<reset.size(); i++) {
-      crows.at(i) = this->new_crow(false);
+      crows.at(reset.at(i)) = this->new_crow(false);
     }
   }
 
@@ -128,7 +130,7 @@ namespace environment {
       crow_bounds.y = (int)std::get<1>(crows.at(i)) - (crow_bounds.h / 2);
 
       //check camera intersection
-      if (in_camera(crow_bounds, camera)) {
+      if (draw::visible(in_camera(crow_bounds, camera))) {
         anim->render(renderer,
                      (int)std::get<0>(crows.at(i)) - camera.x,
                      (int)std::get<1>(crows.at(i)) - camera.y,
@@ -16,6 +16,7 @@
 #include <vector>
 #include <tuple>
 #include "../entity/anim_set.h"
+#include "../rng.h"
 
 namespace impl {
 namespace environment {
@@ -34,6 +35,9 @@ namespace environment {
     //point in map to the right of which crows moving left are created
     int width;
 
+    //random stream for crow positions
+    rng::rng_t rng;
+
     /**
      * Create a new crow
      * @param whether this is the initial setup phase
@@ -57,20 +61,22 @@ namespace environment {
      * @param anim_path    the path to the tree texture
      * @param base_path    the path to the resources folder
      * @param renderer the renderer for loading the texture
-     * @param total_frames the number of animation frames
+     * @param rng      the random stream for this element
      */
     crows_t(int count,
             int width,
             const std::string& anim_path,
             const std::string& base_path,
-            SDL_Renderer& renderer);
+            SDL_Renderer& renderer,
+            const rng::rng_t& rng);
     crows_t(const crows_t&) = delete;
     crows_t& operator=(const crows_t&) = delete;
 
     /**
      * Update the crows
+     * @param tick memory for data that only lives for this tick
      */
-    void update();
+    void update(std::pmr::memory_resource& tick);
 
     /**
      * Render the crows
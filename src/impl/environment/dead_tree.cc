@@ -6,6 +6,7 @@
 
 #include "dead_tree.h"
 #include "../utils.h"
+#include "../draw.h"
 
 namespace impl {
 namespace environment {
@@ -55,22 +56,53 @@ namespace environment {
 
       //check that player orientation and direction match
       if (left == facing_left) {
-        //flip the animation if left
-        anim->set_flipped(left);
-
-        if (left) {
-          //adjust the bounds of where the tree will land
-          felled_bounds = {bounds.x - bounds.h,
-                           bounds.y + bounds.h - bounds.w,
-                           bounds.h,
-                           bounds.w};
-        }
-
-        felled = true;
+        this->fell();
       }
     }
   }
 
+  /**
+   * Fell the tree in the current direction
+   */
+  void dead_tree_t::fell() {
+    //flip the animation if left
+    anim->set_flipped(left);
+
+    if (left) {
+      //adjust the bounds of where the tree will land
+      felled_bounds = {bounds.x - bounds.h,
+                       bounds.y + bounds.h - bounds.w,
+                       bounds.h,
+                       bounds.w};
+    }
+
+    felled = true;
+  }
+
+  /**
+   * Save the felled state of the tree
+   * @param j the json to write changes to
+   * @return whether the tree has been felled
+   */
+  bool dead_tree_t::save_changes(json& j) const {
+    if (felled) {
+      j["left"] = left;
+    }
+    return felled;
+  }
+
+  /**
+   * Restore a felled tree
+   * @param j the saved changes
+   */
+  void dead_tree_t::restore_changes(const json& j) {
+    j.at("left").get_to(left);
+    this->fell();
+
+    //the tree has already landed
+    anim->finish();
+  }
+
   /**
    * Whether this tree can still be felled
    * @return whether this tree can be interacted with
@@ -121,8 +153,9 @@ namespace environment {
 
   /**
    * Update the tree
+   * @param tick memory for data that only lives for this tick
    */
-  void dead_tree_t::update() {
+  void dead_tree_t::update(std::pmr::memory_resource& /*tick*/) {
     if (felled) {
       anim->update();
     }
@@ -137,7 +170,7 @@ namespace environment {
   void dead_tree_t::render(SDL_Renderer& renderer,
                            const SDL_Rect& camera,
                            bool debug) const {
-    if (this->is_collided(camera,false)) {
+    if (draw::visible(this->is_collided(camera,false))) {
       //render the animation
       anim->render(renderer,
                    (bounds.x - (bounds.w / 2)) - camera.x,
@@ -161,7 +194,7 @@ namespace environment {
         SDL_SetRenderDrawColor(&renderer,255,102,0,255);
 
         //render the bounds
-        SDL_RenderDrawRect(&renderer,&debug_bounds);
+        draw::rect(&renderer,&debug_bounds);
       }
     }
   }
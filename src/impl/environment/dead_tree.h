@@ -33,6 +33,11 @@ namespace environment {
     //whether the tree is falling left (t), right (f)
     bool left;
 
+    /**
+     * Fell the tree in the current direction
+     */
+    void fell();
+
   public:
     /**
      * Dead tree constructor
@@ -89,10 +94,24 @@ namespace environment {
      */
     bool is_collided(int x, int y) const;
 
+    /**
+     * Save the felled state of the tree
+     * @param j the json to write changes to
+     * @return whether the tree has been felled
+     */
+    bool save_changes(json& j) const;
+
+    /**
+     * Restore a felled tree
+     * @param j the saved changes
+     */
+    void restore_changes(const json& j);
+
     /**
      * Update the tree
+     * @param tick memory for data that only lives for this tick
      */
-    void update();
+    void update(std::pmr::memory_resource& tick);
 
     /**
      * Render the tree
@@ -5,6 +5,7 @@
  */
 
 #include "door.h"
+#include "../draw.h"
 
 namespace impl {
 namespace environment {
@@ -53,18 +54,49 @@ namespace environment {
 
       //check that the player position and direction match
       if (left == facing_left) {
-        anim->set_flipped(left);
+        this->open();
+      }
+    }
+  }
 
-        if (left) {
-          bounds.x -= DEFAULT_DOOR_W;
-        }
-        //set the width for camera collision
-        bounds.w = DEFAULT_DOOR_W;
+  /**
+   * Open the door in the current direction
+   */
+  void door_t::open() {
+    anim->set_flipped(left);
 
-        //set opened
-        opened = true;
-      }
+    if (left) {
+      bounds.x -= DEFAULT_DOOR_W;
+    }
+    //set the width for camera collision
+    bounds.w = DEFAULT_DOOR_W;
+
+    //set opened
+    opened = true;
+  }
+
+  /**
+   * Save the opened state of the door
+   * @param j the json to write changes to
+   * @return whether the door has been opened
+   */
+  bool door_t::save_changes(json& j) const {
+    if (opened) {
+      j["left"] = left;
     }
+    return opened;
+  }
+
+  /**
+   * Restore an opened door
+   * @param j the saved changes
+   */
+  void door_t::restore_changes(const json& j) {
+    j.at("left").get_to(left);
+    this->open();
+
+    //the door has already swung open
+    anim->finish();
   }
 
   /**
@@ -90,8 +122,9 @@ namespace environment {
 
   /**
    * Update the tree
+   * @param tick memory for data that only lives for this tick
    */
-  void door_t::update() {
+  void door_t::update(std::pmr::memory_resource& /*tick*/) {
     if (opened) {
       anim->update();
     }
@@ -106,7 +139,7 @@ namespace environment {
   void door_t::render(SDL_Renderer& renderer,
                       const SDL_Rect& camera,
                       bool debug) const {
-    if (this->is_collided(camera,false)) {
+    if (draw::visible(this->is_collided(camera,false))) {
 
       int texture_x = bounds.x + (DEFAULT_DOOR_W * (opened && left));
       //render animation
@@ -124,7 +157,7 @@ namespace environment {
         SDL_SetRenderDrawColor(&renderer,255,102,0,255);
 
         //render the bounds
-        SDL_RenderDrawRect(&renderer,&debug_bounds);
+        draw::rect(&renderer,&debug_bounds);
       }
     }
   }
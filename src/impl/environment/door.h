@@ -30,6 +30,11 @@ namespace environment {
     //whether the door opened left
     bool left;
 
+    /**
+     * Open the door in the current direction
+     */
+    void open();
+
   public:
     /**
      * Door constructor
@@ -80,10 +85,24 @@ namespace environment {
     bool is_collided(const SDL_Rect& rect,
                      bool interaction) const;
 
+    /**
+     * Save the opened state of the door
+     * @param j the json to write changes to
+     * @return whether the door has been opened
+     */
+    bool save_changes(json& j) const;
+
+    /**
+     * Restore an opened door
+     * @param j the saved changes
+     */
+    void restore_changes(const json& j);
+
     /**
      * Update the door
+     * @param tick memory for data that only lives for this tick
      */
-    void update();
+    void update(std::pmr::memory_resource& tick);
 
     /**
      * Render the door
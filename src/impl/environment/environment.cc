@@ -6,6 +6,8 @@
 
 #include "environment.h"
 #include "procedural_elem.h"
+#include "../metrics.h"
+#include <algorithm>
 
 namespace impl {
 namespace environment {
@@ -17,6 +19,56 @@ namespace environment {
   environment_t::environment_t(std::vector<std::shared_ptr<environment::renderable_t>>& env_renderable)
     : env_renderable(env_renderable) {}
 
+  /**
+   * Add elements (i.e. from a region paged in)
+   * @param elems the elements
+   */
+  void environment_t::add(const std::vector<std::shared_ptr<environment::renderable_t>>& elems) {
+    env_renderable.insert(env_renderable.end(), elems.begin(), elems.end());
+  }
+
+  /**
+   * Remove elements (i.e. from a region paged out)
+   * @param elems the elements
+   */
+  void environment_t::remove(const std::vector<std::shared_ptr<environment::renderable_t>>& elems) {
+    env_renderable.erase(
+      std::remove_if(env_renderable.begin(), env_renderable.end(),
+        [&elems](const std::shared_ptr<environment::renderable_t>& e) {
+          return std::find(elems.begin(), elems.end(), e) != elems.end();
+        }),
+      env_renderable.end());
+  }
+
+  /**
+   * Save changes the player has made to elements in the environment
+   * (elements are identified by their position in the load order)
+   * @param j the json array to append changes to
+   */
+  void environment_t::save_changes(json& j) const {
+    for (size_t i=0; i<env_renderable.size(); i++) {
+      json elem;
+      if (env_renderable.at(i)->save_changes(elem)) {
+        j.push_back({{"idx", i}, {"changes", elem}});
+      }
+    }
+  }
+
+  /**
+   * Restore changes written by save_changes
+   * @param j the saved changes
+   */
+  void environment_t::restore_changes(const json& j) {
+    for (const json& elem : j) {
+      size_t idx = elem.at("idx").get<size_t>();
+
+      //the cfg may have changed since the changes were saved
+      if (idx < env_renderable.size()) {
+        env_renderable.at(idx)->restore_changes(elem.at("changes"));
+      }
+    }
+  }
+
   /**
    * Check if an element at a position is solid
    * @param  x the x coordinate
@@ -75,9 +127,11 @@ namespace environment {
   /**
    * Update elements
    * @param  player_bounds the bounds of the player
+   * @param  tick          memory for data that only lives for this tick
    * @return               total damage accumulated to apply to the player
    */
-  int environment_t::update(const SDL_Rect& player_bounds) {
+  int environment_t::update(const SDL_Rect& player_bounds,
+                            std::pmr::memory_resource& tick) {
     int total_damage = 0;
     //update each renderable environment element
     for (size_t i=0; i<env_renderable.size(); i++) {
@@ -87,9 +141,13 @@ namespace environment {
       }
 
       //update the environment element
-      env_renderable.at(i)->update();
+      env_renderable.at(i)->update(tick);
     }
 
+    //elements in the active level
+    static metrics::gauge_t& elems = metrics::gauge("env_elems");
+    elems.set(env_renderable.size());
+
     //return the total env damage to the player
     return total_damage;
   }
@@ -121,10 +179,10 @@ namespace environment {
     //render any elements that have background components
     for (size_t i=0; i<env_renderable.size(); i++) {
       //check if this is a procedural element (may have background components)
-      std::shared_ptr<procedural_elem_t> proc
-        = std::dynamic_pointer_cast<procedural_elem_t>(env_renderable.at(i));
+      const procedural_elem_t *proc
+        = dynamic_cast<const procedural_elem_t*>(env_renderable.at(i).get());
 
-      if (proc) {
+      if (proc != NULL) {
         proc->render_bg(renderer,camera,debug);
       }
     }
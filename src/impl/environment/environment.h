@@ -36,6 +36,37 @@ namespace environment {
     environment_t(const environment_t&) = delete;
     environment_t& operator=(const environment_t&) = delete;
 
+    /**
+     * Get the number of elements in the environment
+     * @return the element count
+     */
+    size_t size() const { return env_renderable.size(); }
+
+    /**
+     * Add elements (i.e. from a region paged in)
+     * @param elems the elements
+     */
+    void add(const std::vector<std::shared_ptr<environment::renderable_t>>& elems);
+
+    /**
+     * Remove elements (i.e. from a region paged out)
+     * @param elems the elements
+     */
+    void remove(const std::vector<std::shared_ptr<environment::renderable_t>>& elems);
+
+    /**
+     * Save changes the player has made to elements in the environment
+     * (elements are identified by their position in the load order)
+     * @param j the json array to append changes to
+     */
+    void save_changes(json& j) const;
+
+    /**
+     * Restore changes written by save_changes
+     * @param j the saved changes
+     */
+    void restore_changes(const json& j);
+
     /**
      * Check if an element at a position is solid
      * @param  x the x coordinate
@@ -58,8 +89,8 @@ namespace environment {
     template <typename T>
     void for_each(std::function<void(T&)> fn) {
       for (size_t i=0; i<env_renderable.size(); i++) {
-        std::shared_ptr<T> e = std::dynamic_pointer_cast<T>(env_renderable.at(i));
-        if (e) {
+        T *e = dynamic_cast<T*>(env_renderable.at(i).get());
+        if (e != NULL) {
           fn(*e);
         }
       }
@@ -78,9 +109,11 @@ namespace environment {
     /**
      * Update elements
      * @param  player_bounds the bounds of the player
+     * @param  tick          memory for data that only lives for this tick
      * @return               total damage accumulated to apply to the player
      */
-    [[nodiscard]] int update(const SDL_Rect& player_bounds);
+    [[nodiscard]] int update(const SDL_Rect& player_bounds,
+                             std::pmr::memory_resource& tick);
 
     /**
      * Render environmental elements in the foreground
@@ -16,6 +16,8 @@
 #include "crows.h"
 #include "procedural_trees.h"
 #include "procedural_groundcover.h"
+#include "../rng.h"
+#include "../arena.h"
 
 namespace impl {
 namespace environment {
@@ -97,11 +99,13 @@ namespace environment {
    * @param cfg_path the path to the environment configuration
    * @param renderer the sdl renderer
    * @param base_path the resource folder base path
+   * @param seed     the level seed for procedural elements
    */
   void load_env_elems(std::vector<std::shared_ptr<environment::renderable_t>>& elems,
                       const std::string& cfg_path,
                       SDL_Renderer& renderer,
-                      const std::string& base_path) {
+                      const std::string& base_path,
+                      uint64_t seed) {
     nlohmann::json config;
 
     try {
@@ -112,65 +116,72 @@ namespace environment {
       for (json& env : config) {
         //load the configuration
         env_set_cfg cfg = env.get<env_set_cfg>();
+        //elements are keyed by their position in the configuration
+        uint64_t elem_idx = elems.size();
 
         //check the type
         if (cfg.type == CHEMICAL_FOAM_TYPE) {
           //add the chemical foam element to the environment
-          elems.push_back(std::make_shared<environment::chemical_foam_t>(cfg.x,
-                                                                         cfg.y,
-                                                                         cfg.w,
-                                                                         cfg.h,
-                                                                         cfg.density));
+          elems.push_back(arena::make_level<environment::chemical_foam_t>(cfg.x,
+                                                                          cfg.y,
+                                                                          cfg.w,
+                                                                          cfg.h,
+                                                                          cfg.density,
+                                                                          rng::rng_t(seed, rng::FOAM, elem_idx)));
         } else if (cfg.type == DEAD_TREE_TYPE) {
           //add a dead tree to the environment
-          elems.push_back(std::make_shared<environment::dead_tree_t>(cfg.x,
-                                                                     cfg.y,
-                                                                     cfg.w,
-                                                                     cfg.h,
-                                                                     base_path + cfg.animation_path,
-                                                                     renderer,
-                                                                     cfg.animation_frames));
+          elems.push_back(arena::make_level<environment::dead_tree_t>(cfg.x,
+                                                                      cfg.y,
+                                                                      cfg.w,
+                                                                      cfg.h,
+                                                                      base_path + cfg.animation_path,
+                                                                      renderer,
+                                                                      cfg.animation_frames));
         } else if (cfg.type == CHEMICAL_SEEP_TYPE) {
           //add a chemical seep to the environment
-          elems.push_back(std::make_shared<environment::chemical_seep_t>(cfg.x,
-                                                                         cfg.y,
-                                                                         cfg.w,
-                                                                         cfg.h));
+          elems.push_back(arena::make_level<environment::chemical_seep_t>(cfg.x,
+                                                                          cfg.y,
+                                                                          cfg.w,
+                                                                          cfg.h,
+                                                                          rng::rng_t(seed, rng::SEEP, elem_idx)));
         } else if (cfg.type == DOOR_TYPE) {
           //add a door to the environment
-          elems.push_back(std::make_shared<environment::door_t>(cfg.x,
-                                                                cfg.y,
-                                                                cfg.w,
-                                                                cfg.h,
-                                                                base_path + cfg.animation_path,
-                                                                renderer,
-                                                                cfg.animation_frames));
+          elems.push_back(arena::make_level<environment::door_t>(cfg.x,
+                                                                 cfg.y,
+                                                                 cfg.w,
+                                                                 cfg.h,
+                                                                 base_path + cfg.animation_path,
+                                                                 renderer,
+                                                                 cfg.animation_frames));
         } else if (cfg.type == PUSHABLE_TYPE) {
           SDL_Rect interact_bounds = {cfg.interact_x, cfg.interact_y,
                                       cfg.interact_w, cfg.interact_h};
           SDL_Rect solid_bounds = {cfg.x, cfg.y, cfg.w, cfg.h};
           //add the pushable element
-          elems.push_back(std::make_shared<environment::pushable_t>(interact_bounds,
-                                                                    solid_bounds,
-                                                                    cfg.range,
-                                                                    base_path + cfg.animation_path,
-                                                                    renderer));
+          elems.push_back(arena::make_level<environment::pushable_t>(interact_bounds,
+                                                                     solid_bounds,
+                                                                     cfg.range,
+                                                                     base_path + cfg.animation_path,
+                                                                     renderer));
         } else if (cfg.type == CROW_TYPE) {
-          elems.push_back(std::make_shared<environment::crows_t>((int)cfg.density,
-                                                                 cfg.w,
-                                                                 cfg.animation_path,
-                                                                 base_path,
-                                                                 renderer));
+          elems.push_back(arena::make_level<environment::crows_t>((int)cfg.density,
+                                                                  cfg.w,
+                                                                  cfg.animation_path,
+                                                                  base_path,
+                                                                  renderer,
+                                                                  rng::rng_t(seed, rng::CROWS, elem_idx)));
         } else if (cfg.type == PROC_TREES) {
           SDL_Rect region = {cfg.x,cfg.y,cfg.w,cfg.h};
-          elems.push_back(std::make_shared<environment::procedural_trees_t>(region,
-                                                                            renderer,
-                                                                            cfg.animation_frames));
+          elems.push_back(arena::make_level<environment::procedural_trees_t>(region,
+                                                                             renderer,
+                                                                             cfg.animation_frames,
+                                                                             rng::rng_t(seed, rng::TREES, elem_idx)));
         } else if (cfg.type == PROC_GCOVER) {
           SDL_Rect region = {cfg.x,cfg.y,cfg.w,cfg.h};
-          elems.push_back(std::make_shared<environment::procedural_groundcover_t>(region,
-                                                                                  renderer,
-                                                                                  cfg.animation_frames));
+          elems.push_back(arena::make_level<environment::procedural_groundcover_t>(region,
+                                                                                   renderer,
+                                                                                   cfg.animation_frames,
+                                                                                   rng::rng_t(seed, rng::GROUNDCOVER, elem_idx)));
         }
       }
 
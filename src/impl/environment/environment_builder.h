@@ -12,6 +12,7 @@
 #include <memory>
 #include <vector>
 #include <string>
+#include <cstdint>
 #include "renderable.h"
 
 namespace impl {
@@ -23,11 +24,13 @@ namespace environment {
    * @param cfg_path the path to the environment configuration
    * @param renderer the sdl renderer
    * @param base_path the resource folder base path
+   * @param seed     the level seed for procedural elements
    */
   void load_env_elems(std::vector<std::shared_ptr<environment::renderable_t>>& elems,
                       const std::string& cfg_path,
                       SDL_Renderer& renderer,
-                      const std::string& base_path);
+                      const std::string& base_path,
+                      uint64_t seed);
 }}
 
 #endif /*_IO_JACKHAY_SWAMP_ENVIRONMENT_ENVIRONMENT_BUILDER_H*/
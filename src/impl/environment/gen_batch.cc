@@ -0,0 +1,116 @@
+/*
+ * (C) 2021 Jack Hay
+ *
+ * Untitled Swamp game
+ */
+
+#include "gen_batch.h"
+#include "../jobs.h"
+#include "../cache.h"
+
+namespace impl {
+namespace environment {
+
+  gen_batch_t::gen_batch_t()
+    : builders(), keys(), surfaces(), results() {}
+
+  //free any surfaces that were never uploaded
+  gen_batch_t::~gen_batch_t() {
+    for (size_t i=0; i<surfaces.size(); i++) {
+      if (surfaces.at(i) != NULL) {
+        SDL_FreeSurface(surfaces.at(i));
+      }
+    }
+  }
+
+  /**
+   * Queue a texture
+   * @param  builder fills the texture constructor
+   * @param  key     the cache key (cache::key_t) of the builder's
+   *                 parameters, skips the builder on a hit (0 to always build)
+   * @return         the index of the result
+   */
+  size_t gen_batch_t::add(builder_t builder, uint64_t key) {
+    builders.push_back(builder);
+    keys.push_back(key);
+    return builders.size() - 1;
+  }
+
+  /**
+   * Build all queued pixel buffers in parallel (blocks until done)
+   * (cached buffers are loaded instead)
+   */
+  void gen_batch_t::build() {
+    surfaces.resize(builders.size(), NULL);
+    results.resize(builders.size(), {NULL,0,0,1,0,{-1,{0,0,0,0}}});
+
+    //each job writes only its own slot
+    jobs::parallel_for(builders.size(), [this](size_t i) {
+      gen_result_t& result = results.at(i);
+      uint64_t key = keys.at(i);
+
+      if ((key != 0) &&
+          cache::load_surface(key, surfaces.at(i), result.frames, result.frame_w)) {
+        return;
+      }
+
+      texture_constructor_t constructor;
+      builders.at(i)(constructor);
+
+      result.frames = constructor.get_frames();
+      result.frame_w = constructor.get_width();
+      surfaces.at(i) = constructor.generate_surface();
+
+      if (key != 0) {
+        cache::store_surface(key, *surfaces.at(i), result.frames, result.frame_w);
+      }
+    });
+  }
+
+  /**
+   * Upload built buffers to textures (render thread)
+   * @param renderer the renderer
+   */
+  void gen_batch_t::upload(SDL_Renderer& renderer) {
+    for (size_t i=0; i<surfaces.size(); i++) {
+      if (surfaces.at(i) != NULL) {
+        //frees the surface (even if it throws)
+        SDL_Surface *surface = surfaces.at(i);
+        surfaces.at(i) = NULL;
+        results.at(i).texture = upload_surface(renderer,
+                                               surface,
+                                               results.at(i).w,
+                                               results.at(i).h);
+      }
+    }
+  }
+
+  /**
+   * Pack built buffers into atlas pages instead of separate
+   * textures (render thread, results have no texture of their own)
+   * @param renderer the renderer
+   * @param atlas    the atlas
+   */
+  void gen_batch_t::upload(SDL_Renderer& renderer, atlas::atlas_t& atlas) {
+    for (size_t i=0; i<surfaces.size(); i++) {
+      if (surfaces.at(i) != NULL) {
+        results.at(i).w = surfaces.at(i)->w;
+        results.at(i).h = surfaces.at(i)->h;
+
+        //frees the surface (even if it throws)
+        SDL_Surface *surface = surfaces.at(i);
+        surfaces.at(i) = NULL;
+        results.at(i).region = atlas.add(renderer, surface);
+      }
+    }
+  }
+
+  /**
+   * Build and upload
+   * @param renderer the renderer
+   */
+  void gen_batch_t::generate(SDL_Renderer& renderer) {
+    build();
+    upload(renderer);
+  }
+}}
@@ -0,0 +1,110 @@
+/*
+ * (C) 2021 Jack Hay
+ *
+ * Untitled Swamp game
+ */
+
+#ifndef _IO_JACKHAY_SWAMP_GEN_BATCH_H
+#define _IO_JACKHAY_SWAMP_GEN_BATCH_H
+
+#include <SDL2/SDL_image.h>
+#include <SDL2/SDL.h>
+#include <vector>
+#include <functional>
+#include "texture_constructor.h"
+#include "../atlas.h"
+
+namespace impl {
+namespace environment {
+
+  /*
+   * A generated texture
+   */
+  struct gen_result_t {
+    SDL_Texture *texture;
+    //texture dimensions (all frames)
+    int w;
+    int h;
+    //the number of animation frames
+    int frames;
+    //the width of a single frame
+    int frame_w;
+    //where the texture was packed (atlas uploads only, page -1 otherwise)
+    atlas::atlas_region_t region;
+  };
+
+  /**
+   * Batch of independent procedural textures
+   * Pixel buffers are built concurrently on the job pool,
+   * then uploaded together on the render thread
+   */
+  struct gen_batch_t {
+  private:
+    //fills a constructor (must only touch its own state)
+    typedef std::function<void(texture_constructor_t&)> builder_t;
+
+    //the queued builders
+    std::vector<builder_t> builders;
+
+    //cache keys for each builder (0 if not cached)
+    std::vector<uint64_t> keys;
+
+    //built surfaces waiting for upload
+    std::vector<SDL_Surface*> surfaces;
+
+    //results by index
+    std::vector<gen_result_t> results;
+
+  public:
+    gen_batch_t();
+    gen_batch_t(const gen_batch_t&) = delete;
+    gen_batch_t& operator=(const gen_batch_t&) = delete;
+
+    //free any surfaces that were never uploaded
+    ~gen_batch_t();
+
+    /**
+     * Queue a texture
+     * @param  builder fills the texture constructor
+     * @param  key     the cache key (cache::key_t) of the builder's
+     *                 parameters, skips the builder on a hit (0 to always build)
+     * @return         the index of the result
+     */
+    size_t add(builder_t builder, uint64_t key=0);
+
+    /**
+     * Build all queued pixel buffers in parallel (blocks until done)
+     * (cached buffers are loaded instead)
+     */
+    void build();
+
+    /**
+     * Upload built buffers to textures (render thread)
+     * @param renderer the renderer
+     */
+    void upload(SDL_Renderer& renderer);
+
+    /**
+     * Pack built buffers into atlas pages instead of separate
+     * textures (render thread, results have no texture of their own)
+     * @param renderer the renderer
+     * @param atlas    the atlas
+     */
+    void upload(SDL_Renderer& renderer, atlas::atlas_t& atlas);
+
+    /**
+     * Build and upload
+     * @param renderer the renderer
+     */
+    void generate(SDL_Renderer& renderer);
+
+    /**
+     * Get a result (after upload)
+     * @param  idx the index returned by add
+     * @return     the result
+     */
+    const gen_result_t& get(size_t idx) const { return results.at(idx); }
+  };
+}}
+
+#endif /*_IO_JACKHAY_SWAMP_GEN_BATCH_H*/
@@ -10,7 +10,6 @@
 #include <iostream>
 #include <math.h>
 #include <algorithm>
-#include <stdlib.h>
 #include <cmath>
 
 namespace impl {
@@ -104,6 +103,7 @@ namespace proc_generation {
    * Render the l system component
    * @param state       the l system state to render from
    * @param constructor the texture constructor to add to
+   * @param rng         the random stream
    * @param x           position x
    * @param y           position y
    * @param dist        the distance in the forward direction
@@ -111,6 +111,7 @@ namespace proc_generation {
    */
   void render(const l_system_state& state,
               texture_constructor_t& constructor,
+              rng::rng_t& rng,
               int x, int y,
               int dist, int angle) {
 
@@ -151,10 +152,10 @@ namespace proc_generation {
           }
 
           if (command == ANGLE_MINUS) {
-            curr_angle -= ((rand() % 5) + 20);
+            curr_angle -= (rng.next_int(5) + 20);
 
           } else if (command == ANGLE_PLUS) {
-            curr_angle += ((rand() % 5) + 20);
+            curr_angle += (rng.next_int(5) + 20);
           }
         }
 
@@ -165,6 +166,7 @@ namespace proc_generation {
           render(
             std::get<l_system_state>(state.s.at(i)),
             constructor,
+            rng,
             curr_x, curr_y,
             dist,
             curr_angle
@@ -178,6 +180,7 @@ namespace proc_generation {
   /**
    * Execute a fractal plant l system on this texture constructor
    * @param constructor the texture constructor
+   * @param rng         the random stream
    * @param iters       the number of iterations to evaluate for
    * @param r           color r
    * @param g           color g
@@ -186,6 +189,7 @@ namespace proc_generation {
    * @param y           position y
    */
   void fractal_tree_lsystem(texture_constructor_t& constructor,
+                          rng::rng_t& rng,
                             int iters,
                             int r, int g, int b,
                             int x, int y) {
@@ -239,12 +243,13 @@ namespace proc_generation {
     constructor.set_default_color(r,g,b);
 
     //render the state onto the constructor
-    render(state,constructor,x,y,dist,angle); //state
+    render(state,constructor,rng,x,y,dist,angle); //state
   }
 
   /**
    * Add a leaf at a given position
    * @param constructor the texture constructor
+   * @param rng         the random stream
    * @param x           position x
    * @param y           position y
    * @param r           color r
@@ -252,6 +257,7 @@ namespace proc_generation {
    * @param b           color b
    */
   void add_leaf(texture_constructor_t& constructor,
+              rng::rng_t& rng,
                 int x, int y,
                 int r, int g, int b) {
     //leaf center
@@ -263,12 +269,12 @@ namespace proc_generation {
 
     //a few randoms
     for (int i=0; i<4; i++) {
-      int px = x + (rand() % 4 - 2);
-      int py = y + (rand() % 4 - 2);
+      int px = x + (rng.next_int(4) - 2);
+      int py = y + (rng.next_int(4) - 2);
 
       //add to some of the frames
       for (int f=0; f<MAX_FRAMES; f++) {
-        if (rand() % MAX_FRAMES != 0) {
+        if (rng.next_int(MAX_FRAMES) != 0) {
           constructor.set(px,py,r,g,b,f);
         }
       }
@@ -288,6 +294,7 @@ namespace proc_generation {
   /**
    * Generate trunk foliage given a pre constructed trunk texture
    * @param constructor the constructor that already has a trunk
+   * @param rng         the random stream
    * @param count       the number of leaves (density)
    * @param r           leaf color r
    * @param g           leaf color g
@@ -298,6 +305,7 @@ namespace proc_generation {
    * @param b2          leaf color b (second)
    */
   void trunk_foliage(texture_constructor_t& constructor,
+                   rng::rng_t& rng,
                      int count,
                      int r, int g, int b,
                      bool two_color,
@@ -315,15 +323,15 @@ namespace proc_generation {
 
     int rem = count;
     while (rem > 0) {
-      int x = cx + (rand() % (2 * range_x) - range_x);
-      int y = cy + (rand() % (2 * range_y) - range_y);
+      int x = cx + (rng.next_int(2 * range_x) - range_x);
+      int y = cy + (rng.next_int(2 * range_y) - range_y);
 
       if (constructor.is_set(x,y) ||
-          ((rand() % 50 == 0) && (distance(cx,cy,x,y) < (cx / 2)))) {
-        int set_x = x + (rand() % 10 - 5);
-        int set_y = y + (rand() % 10 - 5);
+          ((rng.next_int(50) == 0) && (distance(cx,cy,x,y) < (cx / 2)))) {
+        int set_x = x + (rng.next_int(10) - 5);
+        int set_y = y + (rng.next_int(10) - 5);
         //add a leaf at this position
-        add_leaf(constructor,set_x,set_y,r,g,b);
+        add_leaf(constructor,rng,set_x,set_y,r,g,b);
         rem--;
 
         if (two_color) {
@@ -336,6 +344,7 @@ namespace proc_generation {
   /**
    * Branch out at an angle
    * @param constructor texture constructor
+   * @param rng         the random stream
    * @param x           branch position x
    * @param y           branch position y
    * @param angle       angle to branch at
@@ -343,6 +352,7 @@ namespace proc_generation {
    * @param frame       the animation frame
    */
   void branch_at_angle(texture_constructor_t& constructor,
+                     rng::rng_t& rng,
                        int x, int y,
                        int angle,
                        float volume,
@@ -351,12 +361,14 @@ namespace proc_generation {
   /**
    * Create an animated branch
    * @param constructor texture constructor
+   * @param rng         the random stream
    * @param x           position x
    * @param y           position y
    * @param angle       angle
    * @parm volume       the volume of the branch
    */
   void animated_branch_at_angle(texture_constructor_t& constructor,
+                              rng::rng_t& rng,
                                 int x, int y,
                                 int angle,
                                 float volume) {
@@ -364,6 +376,7 @@ namespace proc_generation {
     for (int i=0; i<(MAX_FRAMES / 2); i++) {
       branch_at_angle(
         constructor,
+        rng,
         x,y,angle,
         volume,
         i
@@ -374,6 +387,7 @@ namespace proc_generation {
     for (int i=(MAX_FRAMES / 2); i<MAX_FRAMES; i++) {
       branch_at_angle(
         constructor,
+        rng,
         x + 1,
         y,angle,
         volume,
@@ -385,6 +399,7 @@ namespace proc_generation {
   /**
    * Branch out at an angle
    * @param constructor texture constructor
+   * @param rng         the random stream
    * @param x           branch position x
    * @param y           branch position y
    * @param angle       angle to branch at
@@ -392,6 +407,7 @@ namespace proc_generation {
    * @param frame       the animation frame
    */
   void branch_at_angle(texture_constructor_t& constructor,
+                     rng::rng_t& rng,
                        int x, int y,
                        int angle,
                        float volume,
@@ -407,7 +423,7 @@ namespace proc_generation {
     constructor.set_line(x,y,brx,bry,(int) ceil(volume),frame);
 
     if (volume > 0.1) {
-      float volume_l = static_cast<float>(rand()) / static_cast<float>(RAND_MAX/volume);
+      float volume_l = rng.next_float() * volume;
       float volume_r = volume - volume_l;
 
       if (volume_l > 0.0) {
@@ -415,8 +431,9 @@ namespace proc_generation {
         // if (volume_l <= 0.2) {
         //   animated_branch_at_angle(
         //     constructor,
+        //     rng,
         //     brx,bry,
-        //     angle - (rand() % 25) + 1,
+        //     angle - rng.next_int(25) + 1,
         //     volume_l
         //   );
         //
@@ -424,8 +441,9 @@ namespace proc_generation {
           //left branch
           branch_at_angle(
             constructor,
+            rng,
             brx,bry,
-            angle - (rand() % 25) + 1,
+            angle - rng.next_int(25) + 1,
             volume_l,
             frame
           );
@@ -436,8 +454,9 @@ namespace proc_generation {
         // if (volume_r <= 0.2) {
         //   animated_branch_at_angle(
         //     constructor,
+        //     rng,
         //     brx,bry,
-        //     angle - (rand() % 25) + 1,
+        //     angle - rng.next_int(25) + 1,
         //     volume_r
         //   );
         //
@@ -445,8 +464,9 @@ namespace proc_generation {
           //right branch
           branch_at_angle(
             constructor,
+            rng,
             brx,bry,
-            angle + (rand() % 25) + 1,
+            angle + rng.next_int(25) + 1,
             volume_r,
             frame
           );
@@ -458,16 +478,18 @@ namespace proc_generation {
   /**
    * Build a tree trunk by branching and conserving "volume"
    * @param constructor texture constructor
+   * @param rng         the random stream
    * @param x,y position
    * @param r,g,b the color of the trunk
    */
   void branching_tree_growth(texture_constructor_t& constructor,
+                           rng::rng_t& rng,
                              int x, int y,
                              int r, int g, int b,
                              int start_vol) {
     constructor.set_default_color(r,g,b);
     //trunk starts with volume 4
-    branch_at_angle(constructor,x,y,0,(float)start_vol,-1);
+    branch_at_angle(constructor,rng,x,y,0,(float)start_vol,-1);
   }
 
 }}}
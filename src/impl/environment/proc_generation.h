@@ -13,6 +13,7 @@
 #include <vector>
 #include <string>
 #include "texture_constructor.h"
+#include "../rng.h"
 
 namespace impl {
 namespace environment {
@@ -21,6 +22,7 @@ namespace proc_generation {
   /**
    * Execute a fractal plant l system on this texture constructor
    * @param constructor the texture constructor
+   * @param rng         the random stream
    * @param iters       the number of iterations to evaluate for
    * @param r           color r
    * @param g           color g
@@ -29,6 +31,7 @@ namespace proc_generation {
    * @param y           position y
    */
   void fractal_tree_lsystem(texture_constructor_t& constructor,
+                            rng::rng_t& rng,
                             int iters,
                             int r, int g, int b,
                             int x, int y);
@@ -41,6 +44,7 @@ namespace proc_generation {
    *
    *
    * @param constructor the constructor that already has a trunk
+   * @param rng         the random stream
    * @param count       the number of leaves (density)
    * @param r           leaf color r
    * @param g           leaf color g
@@ -51,6 +55,7 @@ namespace proc_generation {
    * @param b2          leaf color b (second)
    */
   void trunk_foliage(texture_constructor_t& constructor,
+                     rng::rng_t& rng,
                      int count,
                      int r, int g, int b,
                      bool two_color,
@@ -59,10 +64,12 @@ namespace proc_generation {
   /**
    * Build a tree trunk by branching and conserving "volume"
    * @param constructor texture constructor
+   * @param rng         the random stream
    * @param x,y position
    * @param r,g,b the color of the trunk
    */
   void branching_tree_growth(texture_constructor_t& constructor,
+                             rng::rng_t& rng,
                              int x, int y,
                              int r, int g, int b,
                              int start_vol=4);
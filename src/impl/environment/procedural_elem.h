@@ -10,6 +10,7 @@
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL.h>
 #include "renderable.h"
+#include "../rng.h"
 
 namespace impl {
 namespace environment {
@@ -35,9 +36,14 @@ namespace environment {
    * A procedurally generated element in the environment
    */
   struct procedural_elem_t : public renderable_t {
+  protected:
+    //the random stream for generating this element
+    rng::rng_t rng;
+
   public:
-    //Constructor takes the procedurally generated region
-    procedural_elem_t(const SDL_Rect& region) : renderable_t(region,false,false) {}
+    //Constructor takes the procedurally generated region and its random stream
+    procedural_elem_t(const SDL_Rect& region, const rng::rng_t& rng)
+      : renderable_t(region,false,false), rng(rng) {}
     procedural_elem_t(const procedural_elem_t&) = delete;
     procedural_elem_t& operator=(const procedural_elem_t&) = delete;
 
@@ -67,8 +73,9 @@ namespace environment {
 
     /**
      * Update the renderable component
+     * @param tick memory for data that only lives for this tick
      */
-    virtual void update() override = 0;
+    virtual void update(std::pmr::memory_resource& tick) override = 0;
 
     /**
      * Render any background components
@@ -7,6 +7,9 @@
 #include "procedural_groundcover.h"
 #include "proc_generation.h"
 #include "procedural_elem.h"
+#include "gen_batch.h"
+#include "../cache.h"
+#include "../draw.h"
 
 namespace impl {
 namespace environment {
@@ -19,11 +22,13 @@ namespace environment {
    * @param region         the region to populate
    * @param renderer       the renderer for generating textures
    * @param frame_duration the duration of each animation frame
+   * @param rng            the random stream for this element
    */
   procedural_groundcover_t::procedural_groundcover_t(const SDL_Rect& region,
                            SDL_Renderer& renderer,
-                           int frame_duration)
-    : procedural_elem_t(region),
+                           int frame_duration,
+                           const rng::rng_t& rng)
+    : procedural_elem_t(region, rng),
       frame_duration(frame_duration) {
     this->generate(renderer);
   }
@@ -32,9 +37,11 @@ namespace environment {
   /**
    * Populate the foreground or the background texture
    * @param constructor the texture constructor
+   * @param region_rng  the random stream for this region
    * @param fg          whether to use foreground colors (vs background)
    */
   void procedural_groundcover_t::populate_region(texture_constructor_t& constructor,
+                                                 rng::rng_t& region_rng,
                                                  bool fg) const {
    int grass_r = MED_LIGHT_GREEN_R;
    int grass_g = MED_LIGHT_GREEN_G;
@@ -51,20 +58,21 @@ namespace environment {
 
    //generate bushes
    int bush_interval = (bounds.w / BUSH_SPACING);
-   int bush_count = rand() % std::max(bush_interval,1) + 1;
+   int bush_count = region_rng.next_int(std::max(bush_interval,1)) + 1;
    int bush_x = BUSH_BUFFER;
 
    for (int b=0; b<bush_count; b++) {
      //use the lsystem
      proc_generation::fractal_tree_lsystem(
        constructor,
+       region_rng,
        3,
        grass_r, grass_g, grass_b,
        bush_x,
        bounds.y
      );
 
-     bush_x += rand() % BUSH_SPACING + BUSH_BUFFER;
+     bush_x += region_rng.next_int(BUSH_SPACING) + BUSH_BUFFER;
    }
   }
 
@@ -73,34 +81,48 @@ namespace environment {
    * @param renderer the renderer for loading textures
    */
   void procedural_groundcover_t::generate(SDL_Renderer& renderer) {
-    int w,h;
-    //generate the foreground region
-    texture_constructor_t fg_constructor;
-    populate_region(fg_constructor,true);
-
-    //create the animation
+    //generate the foreground and background regions together
+    gen_batch_t batch;
+    rng::rng_t fg_rng = rng.split(0);
+    rng::rng_t bg_rng = rng.split(1);
+
+    //everything that affects the region's pixels
+    cache::key_t key("procedural_groundcover");
+    key.add(bounds.w).add(bounds.y).add(BUSH_SPACING).add(BUSH_BUFFER)
+       .add_rgb(MED_LIGHT_GREEN_R,MED_LIGHT_GREEN_G,MED_LIGHT_GREEN_B)
+       .add_rgb(DARK_GREEN_R,DARK_GREEN_G,DARK_GREEN_B);
+    cache::key_t fg_key = key;
+    cache::key_t bg_key = key;
+
+    size_t fg_idx = batch.add([this,fg_rng](texture_constructor_t& constructor) mutable {
+      populate_region(constructor,fg_rng,true);
+    }, fg_key.add(fg_rng.get_state()).add(true).get());
+    size_t bg_idx = batch.add([this,bg_rng](texture_constructor_t& constructor) mutable {
+      populate_region(constructor,bg_rng,false);
+    }, bg_key.add(bg_rng.get_state()).add(false).get());
+    batch.generate(renderer);
+
+    //create the animations
+    const gen_result_t& fg = batch.get(fg_idx);
     anim_fg = std::make_unique<entity::anim_set_t>(
-      fg_constructor.generate(renderer,w,h),
-      w,h,fg_constructor.get_frames(),
+      fg.texture,
+      fg.w,fg.h,fg.frames,
       frame_duration
     );
 
-    //generate the background region
-    texture_constructor_t bg_constructor;
-    populate_region(bg_constructor,false);
-
-    //create the animation
+    const gen_result_t& bg = batch.get(bg_idx);
     anim_bg = std::make_unique<entity::anim_set_t>(
-      bg_constructor.generate(renderer,w,h),
-      w,h,bg_constructor.get_frames(),
+      bg.texture,
+      bg.w,bg.h,bg.frames,
       frame_duration
     );
   }
 
   /**
    * Update the renderable component (animations)
+   * @param tick memory for data that only lives for this tick
    */
-  void procedural_groundcover_t::update() {
+  void procedural_groundcover_t::update(std::pmr::memory_resource& /*tick*/) {
     anim_fg->update();
     anim_bg->update();
   }
@@ -114,7 +136,7 @@ namespace environment {
   void procedural_groundcover_t::render(SDL_Renderer& renderer,
                                         const SDL_Rect& camera,
                                         bool debug) const {
-    if (is_collided(camera,false)) {
+    if (draw::visible(is_collided(camera,false))) {
       //render the background
       anim_fg->render(
         renderer,
@@ -134,7 +156,7 @@ namespace environment {
   void procedural_groundcover_t::render_bg(SDL_Renderer& renderer,
                                            const SDL_Rect& camera,
                                            bool debug) const {
-    if (is_collided(camera,false)) {
+    if (draw::visible(is_collided(camera,false))) {
       //render the background
       anim_bg->render(
         renderer,
@@ -153,7 +175,7 @@ namespace environment {
       SDL_SetRenderDrawColor(&renderer,255,102,0,255);
 
       //render the bounds
-      SDL_RenderDrawRect(&renderer,&debug_bounds);
+      draw::rect(&renderer,&debug_bounds);
     }
   }
 }}
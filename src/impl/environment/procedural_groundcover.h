@@ -33,15 +33,18 @@ namespace environment {
     /**
      * Populate the foreground or the background texture
      * @param constructor the texture constructor
+     * @param region_rng  the random stream for this region
      * @param fg          whether to use foreground colors (vs background)
      */
     void populate_region(texture_constructor_t& constructor,
+                         rng::rng_t& region_rng,
                          bool fg) const;
 
   public:
     procedural_groundcover_t(const SDL_Rect& region,
                              SDL_Renderer& renderer,
-                             int frame_duration);
+                             int frame_duration,
+                             const rng::rng_t& rng);
     procedural_groundcover_t(const procedural_groundcover_t&) = delete;
     procedural_groundcover_t& operator=(const procedural_groundcover_t&) = delete;
 
@@ -53,8 +56,9 @@ namespace environment {
 
     /**
      * Update the renderable component (animations)
+     * @param tick memory for data that only lives for this tick
      */
-    void update() override;
+    void update(std::pmr::memory_resource& tick) override;
 
     /**
      * Render foreground components
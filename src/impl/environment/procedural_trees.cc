@@ -7,6 +7,9 @@
 #include "procedural_trees.h"
 #include "proc_generation.h"
 #include "procedural_elem.h"
+#include "gen_batch.h"
+#include "../cache.h"
+#include "../draw.h"
 #include <iostream>
 
 namespace impl {
@@ -24,11 +27,13 @@ namespace environment {
    * @param region the range in which this tree can be constructed
    * @param renderer the renderer for generating textures
    * @param frame_duration the duration of an animation frame
+   * @param rng the random stream for this element
    */
   procedural_trees_t::procedural_trees_t(const SDL_Rect& region,
                                          SDL_Renderer& renderer,
-                                         int frame_duration)
-    : procedural_elem_t(region),
+                                         int frame_duration,
+                                         const rng::rng_t& rng)
+    : procedural_elem_t(region, rng),
       frame_duration(frame_duration),
       anims_fg(),
       positions_fg(),
@@ -40,11 +45,14 @@ namespace environment {
   /**
    * Create a tree in a random position
    * @param constructor the texture constructor
+   * @param tree_rng    the random stream for this tree
    * @param fg          whether to use foreground colors (vs background)
    * @param x position x
    * @param y position y
    */
-  void procedural_trees_t::mk_tree(texture_constructor_t& constructor, bool fg, int x, int y) const {
+  void procedural_trees_t::mk_tree(texture_constructor_t& constructor,
+                                   rng::rng_t& tree_rng,
+                                   bool fg, int x, int y) const {
     int trunk_r = MED_DARK_GREEN_R;
     int trunk_g = MED_DARK_GREEN_G;
     int trunk_b = MED_DARK_GREEN_B;
@@ -61,12 +69,14 @@ namespace environment {
     }
 
     proc_generation::branching_tree_growth(constructor,
+                                           tree_rng,
                                            x,y,
                                            trunk_r,
                                            trunk_g,
                                            trunk_b);
 
     proc_generation::trunk_foliage(constructor,
+                                  tree_rng,
                                   LEAF_COUNT,
                                   leaf_r,leaf_g,leaf_b,
                                   !fg,
@@ -80,31 +90,50 @@ namespace environment {
    * @param renderer the renderer for loading textures
    */
   void procedural_trees_t::generate(SDL_Renderer& renderer) {
-    /*
-     * Background trees
-     */
-
     int bg_trees = 1;
     int fg_trees = 4;
 
+    //build every tree concurrently (each tree gets its own stream)
+    gen_batch_t batch;
+    for (int i=0; i<(bg_trees + fg_trees); i++) {
+      bool fg = i >= bg_trees;
+      rng::rng_t tree_rng = rng.split(i);
+
+      //everything that affects the tree's pixels
+      cache::key_t key("procedural_tree");
+      key.add(tree_rng.get_state()).add(fg)
+         .add(TREE_WIDTH_MAX/2).add(TREE_HEIGHT_MAX).add(LEAF_COUNT)
+         .add_rgb(MED_DARK_GREEN_R,MED_DARK_GREEN_G,MED_DARK_GREEN_B)
+         .add_rgb(MED_LIGHT_GREEN_R,MED_LIGHT_GREEN_G,MED_LIGHT_GREEN_B)
+         .add_rgb(LIGHT_GREEN_R,LIGHT_GREEN_G,LIGHT_GREEN_B)
+         .add_rgb(DARK_R,DARK_G,DARK_B)
+         .add_rgb(DARK_GREEN_R,DARK_GREEN_G,DARK_GREEN_B);
+
+      batch.add([this,fg,tree_rng](texture_constructor_t& constructor) mutable {
+        this->mk_tree(constructor,tree_rng,fg,TREE_WIDTH_MAX/2,TREE_HEIGHT_MAX);
+      }, key.get());
+    }
+    batch.generate(renderer);
+
+    /*
+     * Background trees (placement uses the element stream)
+     */
     int curr_x = bounds.x;
 
     for (int i=0; i<bg_trees; i++) {
-      texture_constructor_t constructor;
-      this->mk_tree(constructor,false,TREE_WIDTH_MAX/2,TREE_HEIGHT_MAX);
-      int w,h;
+      const gen_result_t& tree = batch.get(i);
       anims_bg.push_back(std::make_unique<entity::anim_set_t>(
-        constructor.generate(renderer,w,h),
-        w,h,constructor.get_frames(),frame_duration
+        tree.texture,
+        tree.w,tree.h,tree.frames,frame_duration
       ));
 
       //get the height of the generated tree to root it in the bounding box
       positions_bg.push_back(
         std::make_pair(
-          curr_x + (constructor.get_width() / 2),
-          bounds.y + bounds.h - (h / 2)));
+          curr_x + (tree.frame_w / 2),
+          bounds.y + bounds.h - (tree.h / 2)));
 
-      curr_x += rand() % constructor.get_width() + MIN_SPACING;
+      curr_x += rng.next_int(tree.frame_w) + MIN_SPACING;
     }
 
     curr_x = bounds.x;
@@ -113,28 +142,27 @@ namespace environment {
      * Foreground trees
      */
      for (int i=0; i<fg_trees; i++) {
-       texture_constructor_t constructor;
-       this->mk_tree(constructor,true,TREE_WIDTH_MAX/2,TREE_HEIGHT_MAX);
-       int w,h;
+       const gen_result_t& tree = batch.get(bg_trees + i);
        anims_fg.push_back(std::make_unique<entity::anim_set_t>(
-         constructor.generate(renderer,w,h),
-         w,h,constructor.get_frames(),frame_duration
+         tree.texture,
+         tree.w,tree.h,tree.frames,frame_duration
        ));
 
        //get the height of the generated tree to root it in the bounding box
        positions_fg.push_back(
          std::make_pair(
-           curr_x + (constructor.get_width() / 2),
-           bounds.y + bounds.h - (h / 2)));
+           curr_x + (tree.frame_w / 2),
+           bounds.y + bounds.h - (tree.h / 2)));
 
-       curr_x += rand() % constructor.get_width() + MIN_SPACING;
+       curr_x += rng.next_int(tree.frame_w) + MIN_SPACING;
      }
   }
 
   /**
    * Update the renderable component
+   * @param tick memory for data that only lives for this tick
    */
-  void procedural_trees_t::update() {
+  void procedural_trees_t::update(std::pmr::memory_resource& /*tick*/) {
     for (size_t i=0; i<anims_fg.size(); i++) {
       anims_fg.at(i)->update();
     }
@@ -153,7 +181,7 @@ namespace environment {
                                   const SDL_Rect& camera,
                                   bool debug) const {
     //check if this region collides with the camera
-    if (is_collided(camera,false)) {
+    if (draw::visible(is_collided(camera,false))) {
       for (size_t i=0; i<anims_fg.size(); i++) {
         //render this tree
         anims_fg.at(i)->render(
@@ -176,7 +204,7 @@ namespace environment {
                                      const SDL_Rect& camera,
                                      bool debug) const {
     //check if this region collides with the camera
-    if (is_collided(camera,false)) {
+    if (draw::visible(is_collided(camera,false))) {
        for (size_t i=0; i<anims_bg.size(); i++) {
          //render this tree
          anims_bg.at(i)->render(
@@ -196,7 +224,7 @@ namespace environment {
          SDL_SetRenderDrawColor(&renderer,255,102,0,255);
 
          //render the bounds
-         SDL_RenderDrawRect(&renderer,&debug_bounds);
+         draw::rect(&renderer,&debug_bounds);
        }
     }
   }
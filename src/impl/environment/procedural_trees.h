@@ -39,11 +39,13 @@ namespace environment {
     /**
      * Create a tree in a random position
      * @param constructor the texture constructor
+     * @param tree_rng    the random stream for this tree
      * @param fg          whether to use foreground colors (vs background)
      * @param x position x
      * @param y position y
      */
     void mk_tree(texture_constructor_t& constructor,
+                 rng::rng_t& tree_rng,
                  bool fg,
                  int x,
                  int y) const;
@@ -51,7 +53,8 @@ namespace environment {
   public:
     procedural_trees_t(const SDL_Rect& region,
                        SDL_Renderer& renderer,
-                       int frame_duration);
+                       int frame_duration,
+                       const rng::rng_t& rng);
     procedural_trees_t(const procedural_trees_t&) = delete;
     procedural_trees_t& operator=(const procedural_trees_t&) = delete;
 
@@ -63,8 +66,9 @@ namespace environment {
 
     /**
      * Update the renderable component
+     * @param tick memory for data that only lives for this tick
      */
-    void update() override;
+    void update(std::pmr::memory_resource& tick) override;
 
     /**
      * Render foreground components
@@ -5,7 +5,9 @@
  */
 
 #include "pushable.h"
+#include "../accounting.h"
 #include "../utils.h"
+#include "../draw.h"
 #include <iostream>
 
 namespace impl {
@@ -45,7 +47,7 @@ namespace environment {
    */
   pushable_t::~pushable_t() {
     if (texture != NULL) {
-      SDL_DestroyTexture(texture);
+      accounting::free_texture(texture);
     }
   }
 
@@ -89,10 +91,37 @@ namespace environment {
     }
   }
 
+  /**
+   * Save the distance the element has been pushed
+   * @param j the json to write changes to
+   * @return whether the element has been moved
+   */
+  bool pushable_t::save_changes(json& j) const {
+    //the element starts centered in its range
+    int start_x = (min_x + max_x - bounds.w) / 2;
+
+    if (bounds.x != start_x) {
+      j["dx"] = bounds.x - start_x;
+      return true;
+    }
+    return false;
+  }
+
+  /**
+   * Restore the pushed position of the element
+   * @param j the saved changes
+   */
+  void pushable_t::restore_changes(const json& j) {
+    int dx = j.at("dx").get<int>();
+    bounds.x += dx;
+    interact_bounds.x += dx;
+  }
+
   /**
    * Update the element
+   * @param tick memory for data that only lives for this tick
    */
-  void pushable_t::update() {
+  void pushable_t::update(std::pmr::memory_resource& /*tick*/) {
     if (moving_frames > 0) {
       if (left && (bounds.x > min_x)) {
         bounds.x--;
@@ -116,7 +145,7 @@ namespace environment {
                           const SDL_Rect& camera,
                           bool debug) const {
     //check if visible
-    if (this->is_collided(camera,true)) {
+    if (draw::visible(this->is_collided(camera,true))) {
       //center the texture on the interactive bounds
       int texture_x = (interact_bounds.x + (interact_bounds.w / 2)) - (texture_w / 2);
       int texture_y = (interact_bounds.y + (interact_bounds.h / 2)) - (texture_h / 2);
@@ -127,10 +156,10 @@ namespace environment {
                                texture_w,texture_h};
 
       //render the texture
-      SDL_RenderCopy(&renderer,
-                     texture,
-                     &sample_bounds,
-                     &image_bounds);
+      draw::copy(&renderer,
+                 texture,
+                 &sample_bounds,
+                 &image_bounds);
 
       if (debug) {
         //render the solid portion
@@ -141,7 +170,7 @@ namespace environment {
         SDL_SetRenderDrawColor(&renderer,255,0,0,255);
 
         //render the bounds
-        SDL_RenderDrawRect(&renderer,&solid_bounds);
+        draw::rect(&renderer,&solid_bounds);
 
         //render the interactive portion
         SDL_Rect pushable_bounds = {interact_bounds.x - camera.x,
@@ -152,7 +181,7 @@ namespace environment {
         SDL_SetRenderDrawColor(&renderer,255,102,0,255);
 
         //render the bounds
-        SDL_RenderDrawRect(&renderer,&pushable_bounds);
+        draw::rect(&renderer,&pushable_bounds);
       }
     }
   }
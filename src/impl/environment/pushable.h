@@ -77,10 +77,24 @@ namespace environment {
      */
     void interact(player_action a, int x, int y, bool facing_left);
 
+    /**
+     * Save the distance the element has been pushed
+     * @param j the json to write changes to
+     * @return whether the element has been moved
+     */
+    bool save_changes(json& j) const;
+
+    /**
+     * Restore the pushed position of the element
+     * @param j the saved changes
+     */
+    void restore_changes(const json& j);
+
     /**
      * Update the element
+     * @param tick memory for data that only lives for this tick
      */
-    void update();
+    void update(std::pmr::memory_resource& tick);
 
     /**
      * Render the element
@@ -7,12 +7,16 @@
 #ifndef _IO_JACKHAY_SWAMP_ENVIRONMENT_RENDERABLE_H
 #define _IO_JACKHAY_SWAMP_ENVIRONMENT_RENDERABLE_H
 
+#include <memory_resource>
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL.h>
+#include <json/nlohmann_json.h>
 
 namespace impl {
 namespace environment {
 
+  typedef nlohmann::json json;
+
   enum player_action {
     PUSH,
     NONE
@@ -92,10 +96,25 @@ namespace environment {
      */
     virtual bool is_collided(int x, int y) const;
 
+    /**
+     * Save any changes the player has made to this element
+     * (enough to restore the element after the level is reloaded)
+     * @param j the json to write changes to
+     * @return whether this element has changed since it was loaded
+     */
+    virtual bool save_changes(json& j) const { return false; }
+
+    /**
+     * Restore changes written by save_changes
+     * @param j the saved changes
+     */
+    virtual void restore_changes(const json& j) {}
+
     /**
      * Update the renderable component
+     * @param tick memory for data that only lives for this tick
      */
-    virtual void update() {}
+    virtual void update(std::pmr::memory_resource& tick) {}
 
     /**
      * Render the component
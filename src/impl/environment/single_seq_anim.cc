@@ -5,7 +5,9 @@
  */
 
 #include "single_seq_anim.h"
+#include "../accounting.h"
 #include "../utils.h"
+#include "../draw.h"
 
 namespace impl {
 namespace environment {
@@ -36,7 +38,7 @@ namespace environment {
    */
   single_seq_anim_t::~single_seq_anim_t() {
     if (texture != NULL) {
-      SDL_DestroyTexture(texture);
+      accounting::free_texture(texture);
       texture = NULL;
     }
   }
@@ -73,19 +75,19 @@ namespace environment {
         image_bounds = {x - frame_width, y, frame_width, texture_height};
 
         //render the texture and flip
-        SDL_RenderCopyEx(&renderer,
-                         texture,
-                         &sample_bounds,
-                         &image_bounds,
-                         0, NULL,
-                         SDL_FLIP_HORIZONTAL);
+        draw::copy_ex(&renderer,
+                      texture,
+                      &sample_bounds,
+                      &image_bounds,
+                      0, NULL,
+                      SDL_FLIP_HORIZONTAL);
 
       } else {
         //render the texture
-        SDL_RenderCopy(&renderer,
-                       texture,
-                       &sample_bounds,
-                       &image_bounds);
+        draw::copy(&renderer,
+                   texture,
+                   &sample_bounds,
+                   &image_bounds);
       }
     }
   }
@@ -58,6 +58,11 @@ namespace environment {
      */
     void set_flipped(bool flipped) { this->flipped = flipped; }
 
+    /**
+     * Skip to the last frame of the animation
+     */
+    void finish() { current_frame = total_frames - 1; }
+
     /**
      * Update the animation
      */
@@ -5,7 +5,9 @@
  */
 
 #include "texture_constructor.h"
-#include "../logger.h"
+#include "../accounting.h"
+#include "../compositor.h"
+#include "../exceptions.h"
 #include <iostream>
 #include <cmath>
 #include <algorithm>
@@ -119,6 +121,61 @@ namespace environment {
     return set;
   }
 
+  /**
+   * Get the color of the pixel at a position (first frame)
+   * @param  x     pos x
+   * @param  y     pos y
+   * @param  r,g,b the color (set by the call if the pixel is set)
+   * @return       whether a pixel is set at this position
+   */
+  bool texture_constructor_t::get(int x, int y, Uint8& r, Uint8& g, Uint8& b) const {
+    if (frame_sets.empty()) {
+      return false;
+    }
+
+    std::unordered_map<pos_t,px_t>::const_iterator it = frame_sets.at(0)->find(std::make_pair(x,y));
+    if (it == frame_sets.at(0)->end()) {
+      return false;
+    }
+
+    r = std::get<0>(std::get<PINFO_RGB>(it->second));
+    g = std::get<1>(std::get<PINFO_RGB>(it->second));
+    b = std::get<2>(std::get<PINFO_RGB>(it->second));
+    return true;
+  }
+
+  /**
+   * Grow the bounds of the texture to include a position
+   * (without setting a pixel)
+   * @param x pos x
+   * @param y pos y
+   */
+  void texture_constructor_t::include(int x, int y) {
+    if (x >= w) {
+      w = x + 1;
+    }
+    if (y >= h) {
+      h = y + 1;
+    }
+    if (y < min_y) {
+      min_y = y;
+    }
+    if (x < min_x) {
+      min_x = x;
+    }
+  }
+
+  /**
+   * Shrink the bounds of the texture (i.e. after erasing
+   * pixels at the edge, bounds never grow)
+   * @param w the max width
+   * @param h the max height
+   */
+  void texture_constructor_t::shrink(int w, int h) {
+    this->w = std::min(this->w, w);
+    this->h = std::min(this->h, h);
+  }
+
   /**
    * Set the default colors to use
    * @param r r channel
@@ -166,6 +223,17 @@ namespace environment {
     }
   }
 
+  /**
+   * Erase a rectangle, takes position, dimension and frame
+   */
+  void texture_constructor_t::erase_rect(int x, int y, int w, int h, int frame) {
+    for (int i=x; i<(x + w); i++) {
+      for (int j=y; j<(y + h); j++) {
+        this->erase(i,j,frame);
+      }
+    }
+  }
+
   /**
    * Render a line between two points
    * https://en.wikipedia.org/wiki/Bresenham%27s_line_algorithm
@@ -234,18 +302,7 @@ namespace environment {
     }
 
     //adjust dimensions
-    if (x >= w) {
-      w = x + 1;
-    }
-    if (y >= h) {
-      h = y + 1;
-    }
-    if (y < min_y) {
-      min_y = y;
-    }
-    if (x < min_x) {
-      min_x = x;
-    }
+    include(x,y);
 
     std::pair<int,int> pos = std::make_pair(x,y);
 
@@ -266,16 +323,13 @@ namespace environment {
   }
 
   /**
-   * Generate the texture
-   * @param  renderer the renderer for loading the texture
-   * @param  w        the width of the texture set by the call
-   * @param  h        the height of the texture set by the call
-   * @return the      texture
+   * Generate the pixel buffer (safe to call off the render thread)
+   * Throws gen_exception_t if the buffer can't be made
+   * @return the surface (caller frees or uploads)
    */
-  SDL_Texture* texture_constructor_t::generate(SDL_Renderer& renderer, int& w, int& h) const {
+  SDL_Surface* texture_constructor_t::generate_surface() const {
     if (frame_sets.empty() || frame_sets.at(0)->empty()) {
-      logger::log_err("cannot create texture from empty pixel set");
-      exit(1);
+      throw exceptions::gen_exception_t("cannot create texture from empty pixel set");
     }
 
     SDL_Surface *surface;
@@ -306,9 +360,8 @@ namespace environment {
                                    bmask,
                                    amask);
     if (surface == NULL) {
-      logger::log_err("failed to create RGB surface: " +
-                        std::string(SDL_GetError()));
-      exit(1);
+      throw exceptions::gen_exception_t("failed to create RGB surface: " +
+                                        std::string(SDL_GetError()));
     }
 
     //edit the pixel data
@@ -351,7 +404,30 @@ namespace environment {
     });
 
     SDL_UnlockSurface(surface);
+    return surface;
+  }
 
+  /**
+   * Generate the texture
+   * @param  renderer the renderer for loading the texture
+   * @param  w        the width of the texture set by the call
+   * @param  h        the height of the texture set by the call
+   * @return the      texture
+   */
+  SDL_Texture* texture_constructor_t::generate(SDL_Renderer& renderer, int& w, int& h) const {
+    return upload_surface(renderer, generate_surface(), w, h);
+  }
+
+  /**
+   * Upload a generated surface to a texture and free the surface
+   * (render thread only, throws gen exception on failure)
+   * @param  renderer the renderer for loading the texture
+   * @param  surface  the surface (freed by the call)
+   * @param  w        the width of the texture set by the call
+   * @param  h        the height of the texture set by the call
+   * @return          the texture
+   */
+  SDL_Texture* upload_surface(SDL_Renderer& renderer, SDL_Surface* surface, int& w, int& h) {
     //convert to a texture
     w = surface->w;
     h = surface->h;
@@ -360,11 +436,14 @@ namespace environment {
     SDL_Texture *texture = SDL_CreateTextureFromSurface(&renderer,surface);
 
     if(texture == NULL) {
-      logger::log_err("failed to create texture: " +
-                       std::string(SDL_GetError()));
-      exit(1);
+      SDL_FreeSurface(surface);
+      throw exceptions::gen_exception_t("failed to create texture: " +
+                                        std::string(SDL_GetError()));
     }
 
+    accounting::track_texture(texture, TEXTURE_GENERATED, w, h);
+    compositor::mirror(texture, *surface);
+
     //free surface
     SDL_FreeSurface(surface);
     return texture;
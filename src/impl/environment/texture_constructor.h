@@ -123,6 +123,31 @@ namespace environment {
      */
     bool is_set(int x, int y) const;
 
+    /**
+     * Get the color of the pixel at a position (first frame)
+     * @param  x     pos x
+     * @param  y     pos y
+     * @param  r,g,b the color (set by the call if the pixel is set)
+     * @return       whether a pixel is set at this position
+     */
+    bool get(int x, int y, Uint8& r, Uint8& g, Uint8& b) const;
+
+    /**
+     * Grow the bounds of the texture to include a position
+     * (without setting a pixel)
+     * @param x pos x
+     * @param y pos y
+     */
+    void include(int x, int y);
+
+    /**
+     * Shrink the bounds of the texture (i.e. after erasing
+     * pixels at the edge, bounds never grow)
+     * @param w the max width
+     * @param h the max height
+     */
+    void shrink(int w, int h);
+
     /**
      * Set the default color to use
      * @param r r channel
@@ -150,6 +175,11 @@ namespace environment {
      */
     void erase(int x, int y, int frame=-1);
 
+    /**
+     * Erase a rectangle, takes position, dimension and frame
+     */
+    void erase_rect(int x, int y, int w, int h, int frame=-1);
+
     /**
      * Render a line between two points
      */
@@ -167,6 +197,13 @@ namespace environment {
      */
     void set(int x, int y, Uint8 r, Uint8 g, Uint8 b, int frame=-1);
 
+    /**
+     * Generate the pixel buffer (safe to call off the render thread)
+     * Throws gen_exception_t if the buffer can't be made
+     * @return the surface (caller frees or uploads)
+     */
+    SDL_Surface* generate_surface() const;
+
     /**
      * Generate the texture
      * @param  renderer the renderer for loading the texture
@@ -177,6 +214,17 @@ namespace environment {
     SDL_Texture* generate(SDL_Renderer& renderer, int& w, int& h) const;
 
   };
+
+  /**
+   * Upload a generated surface to a texture and free the surface
+   * (render thread only, throws gen exception on failure)
+   * @param  renderer the renderer for loading the texture
+   * @param  surface  the surface (freed by the call)
+   * @param  w        the width of the texture set by the call
+   * @param  h        the height of the texture set by the call
+   * @return          the texture
+   */
+  SDL_Texture* upload_surface(SDL_Renderer& renderer, SDL_Surface* surface, int& w, int& h);
 }}
 
 #endif /*_IO_JACKHAY_SWAMP_TEXTURE_CONSTRUCTOR_H*/
@@ -39,6 +39,29 @@ namespace exceptions {
       return detail + ": " + path;
     }
   };
+
+  /**
+   * Exception thrown when generated content can't be built
+   * (on job threads this reaches the thread that submitted the work)
+   */
+  struct gen_exception_t : public std::exception {
+  private:
+    std::string detail;
+  public:
+    gen_exception_t(const std::string& detail)
+      : detail(detail) {}
+    gen_exception_t(const gen_exception_t& other)
+      : detail(other.detail) {}
+    gen_exception_t& operator=(const gen_exception_t&) = delete;
+
+    /**
+     * Get the error message
+     * @return error message
+     */
+    const std::string trace() const throw () {
+      return detail;
+    }
+  };
 }}
 
 #endif /*_IO_JACKHAY_SWAMP_EXCEPTIONS_H*/
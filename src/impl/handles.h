@@ -0,0 +1,181 @@
+/*
+ * (C) 2021 Jack Hay
+ *
+ * Untitled Swamp game
+ */
+
+#ifndef _IO_JACKHAY_SWAMP_HANDLES_H
+#define _IO_JACKHAY_SWAMP_HANDLES_H
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+namespace impl {
+namespace handles {
+
+  /**
+   * A stable id for an object in a registry
+   * The generation changes whenever the slot is freed, so a handle to a
+   * removed object is detected (default handles refer to nothing)
+   */
+  struct handle_t {
+    uint32_t index;
+    uint32_t generation;
+
+    handle_t() : index(0), generation(0) {}
+    handle_t(uint32_t index, uint32_t generation)
+      : index(index), generation(generation) {}
+
+    bool operator==(const handle_t& other) const {
+      return (index == other.index) && (generation == other.generation);
+    }
+    bool operator!=(const handle_t& other) const { return !(*this == other); }
+  };
+
+  /**
+   * Game objects of one type in a vector of slots (freed slots are reused)
+   * Each slot owns its object through a shared pointer, so objects don't
+   * move as slots are added. Other code keeps handles and iteration never
+   * copies an owning pointer
+   */
+  template <typename T>
+  struct registry_t {
+  private:
+    /**
+     * An object and the generation of its slot
+     * (generations start at 1, even when free)
+     */
+    typedef struct slot_t {
+      uint32_t generation;
+      std::shared_ptr<T> obj;
+    } slot_t;
+
+    std::vector<slot_t> slots;
+
+    //freed slots (reused last freed first)
+    std::vector<uint32_t> free_slots;
+
+    //the objects held
+    size_t live;
+
+    /**
+     * Get the slot a handle refers to
+     * @param  h the handle
+     * @return   the slot (NULL if the handle is stale)
+     */
+    const slot_t* find(handle_t h) const {
+      if ((h.index >= slots.size()) || (slots[h.index].generation != h.generation)) {
+        return NULL;
+      }
+      return slots[h.index].obj ? &slots[h.index] : NULL;
+    }
+
+  public:
+    registry_t() : slots(), free_slots(), live(0) {}
+    registry_t(const registry_t&) = delete;
+    registry_t& operator=(const registry_t&) = delete;
+
+    /**
+     * Add an object
+     * @param  obj the object (not null)
+     * @return     the handle
+     */
+    handle_t add(std::shared_ptr<T> obj) {
+      uint32_t idx;
+      if (free_slots.empty()) {
+        idx = slots.size();
+        slots.push_back({1, std::move(obj)});
+      } else {
+        idx = free_slots.back();
+        free_slots.pop_back();
+        slots[idx].obj = std::move(obj);
+      }
+      live++;
+      return handle_t(idx, slots[idx].generation);
+    }
+
+    /**
+     * Remove an object (the handle and any copies become stale)
+     * @param  h the handle
+     * @return   whether the object was held
+     */
+    bool remove(handle_t h) {
+      if (find(h) == NULL) {
+        return false;
+      }
+      slot_t& slot = slots[h.index];
+      slot.obj.reset();
+      slot.generation++;
+      free_slots.push_back(h.index);
+      live--;
+      return true;
+    }
+
+    /**
+     * Check whether a handle refers to an object held
+     * @param  h the handle
+     * @return   whether the handle is valid
+     */
+    bool valid(handle_t h) const { return find(h) != NULL; }
+
+    /**
+     * Get an object
+     * @param  h the handle
+     * @return   the object (NULL if the handle is stale)
+     */
+    T* get(handle_t h) const {
+      const slot_t *slot = find(h);
+      return (slot == NULL) ? NULL : slot->obj.get();
+    }
+
+    /**
+     * Get the owning pointer of an object (to share ownership
+     * with something outside the registry)
+     * @param  h the handle
+     * @return   the pointer (null if the handle is stale)
+     */
+    std::shared_ptr<T> share(handle_t h) const {
+      const slot_t *slot = find(h);
+      return (slot == NULL) ? std::shared_ptr<T>() : slot->obj;
+    }
+
+    /**
+     * Get the objects held
+     * @return the count
+     */
+    size_t size() const { return live; }
+
+    /**
+     * Call a function on each object in slot order
+     * fn may remove any object, including the one it was called with, but
+     * the reference it was given is invalid once that object is removed
+     * (unless shared elsewhere). Objects added to freed slots behind the
+     * current one are not visited
+     * @param fn called with the handle and the object
+     */
+    template <typename F>
+    void for_each(F fn) {
+      for (size_t i=0; i<slots.size(); i++) {
+        if (slots[i].obj) {
+          fn(handle_t(i, slots[i].generation), *slots[i].obj);
+        }
+      }
+    }
+
+    /**
+     * Call a function on each object in slot order
+     * @param fn called with the handle and the object
+     */
+    template <typename F>
+    void for_each(F fn) const {
+      for (size_t i=0; i<slots.size(); i++) {
+        if (slots[i].obj) {
+          fn(handle_t(i, slots[i].generation), (const T&) *slots[i].obj);
+        }
+      }
+    }
+  };
+}}
+
+#endif /*_IO_JACKHAY_SWAMP_HANDLES_H*/
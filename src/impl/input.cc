@@ -0,0 +1,98 @@
+/*
+ * (C) 2021 Jack Hay
+ *
+ * Untitled Swamp game
+ */
+
+#include "input.h"
+#include "timing.h"
+#include "logger.h"
+
+namespace impl {
+namespace input {
+
+  queue_t::queue_t()
+    : events(),
+      head(0),
+      tail(0),
+      open_slot(INPUT_NO_SLOT),
+      coalesced(metrics::counter("input_coalesced")),
+      dropped(metrics::counter("input_dropped")) {}
+
+  /**
+   * Add an event to the ring
+   * @param  e the event (dropped if the queue is full)
+   * @return   whether the event was queued
+   */
+  bool queue_t::push(const SDL_Event& e) {
+    size_t next = tail.load(std::memory_order_relaxed);
+    if ((next - head.load(std::memory_order_acquire)) == INPUT_QUEUE_SIZE) {
+      //the update thread is far behind
+      if (dropped.get() == 0) {
+        logger::log_warn("input queue full, dropping events");
+      }
+      dropped.add();
+      return false;
+    }
+    events[next & (INPUT_QUEUE_SIZE - 1)] = e;
+
+    //opened before it's visible so the consumer can always close it
+    open_slot.store((e.type == SDL_MOUSEMOTION) ? next : INPUT_NO_SLOT,
+                    std::memory_order_release);
+    tail.store(next + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Merge motion into the newest queued event if it's open motion
+   * @param  e the motion
+   * @return   whether the motion was merged
+   */
+  bool queue_t::merge(const SDL_Event& e) {
+    size_t open = open_slot.load(std::memory_order_relaxed);
+    if ((open == INPUT_NO_SLOT) ||
+        ((open + 1) != tail.load(std::memory_order_relaxed)) ||
+        !open_slot.compare_exchange_strong(open, open | INPUT_SLOT_BUSY,
+                                           std::memory_order_acquire)) {
+      //read (or being read) by the consumer
+      return false;
+    }
+
+    //take the latest position and add up the movement
+    //(the first timestamp is kept, it's how long the input waited)
+    SDL_Event& motion = events[open & (INPUT_QUEUE_SIZE - 1)];
+    Uint32 received = motion.motion.timestamp;
+    Sint32 xrel = motion.motion.xrel + e.motion.xrel;
+    Sint32 yrel = motion.motion.yrel + e.motion.yrel;
+    motion = e;
+    motion.motion.timestamp = received;
+    motion.motion.xrel = xrel;
+    motion.motion.yrel = yrel;
+    coalesced.add();
+
+    //the consumer doesn't close a busy slot (publishes the merge)
+    open_slot.store(open, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Queue an event (producer)
+   * @param e the event
+   */
+  void queue_t::post(const SDL_Event& e) {
+    //other events close the open motion, keeping the order events happened in
+    if ((e.type != SDL_MOUSEMOTION) || !this->merge(e)) {
+      this->push(e);
+    }
+  }
+
+  /**
+   * Record the time from an event being received to it being applied
+   * @param e the event applied
+   */
+  void record_latency(const SDL_Event& e) {
+    //sdl timestamps are ticks when the event was received
+    Uint32 waited = SDL_GetTicks() - e.common.timestamp;
+    timing::input().record((float) waited);
+  }
+}}
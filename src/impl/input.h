@@ -0,0 +1,118 @@
+/*
+ * (C) 2021 Jack Hay
+ *
+ * Untitled Swamp game
+ */
+
+#ifndef _IO_JACKHAY_SWAMP_INPUT_H
+#define _IO_JACKHAY_SWAMP_INPUT_H
+
+#include <SDL2/SDL.h>
+#include <atomic>
+#include <array>
+#include <cstdint>
+#include <algorithm>
+#include "metrics.h"
+
+namespace impl {
+namespace input {
+
+  //the events the queue holds between ticks (power of 2)
+  #define INPUT_QUEUE_SIZE 256
+
+  //no queued motion can be merged into
+  #define INPUT_NO_SLOT SIZE_MAX
+  //set on the open slot while the producer merges into it
+  #define INPUT_SLOT_BUSY (SIZE_MAX ^ (SIZE_MAX >> 1))
+
+  /**
+   * Carries input events from the render thread (which polls sdl) to
+   * the update thread (which applies them at the start of a tick) without
+   * either thread waiting on the other or on the state lock
+   * Mouse motion is merged into the newest queued event while that event
+   * is unconsumed motion, so a slow tick applies one motion per run of
+   * motion (across frames) instead of one per frame
+   * (one producer and one consumer thread)
+   */
+  struct queue_t {
+  private:
+    std::array<SDL_Event, INPUT_QUEUE_SIZE> events;
+
+    //the next slot read (consumer) and written (producer)
+    std::atomic<size_t> head;
+    std::atomic<size_t> tail;
+
+    //the newest queued motion if it can still be merged into
+    //(the consumer closes it before reading, the producer marks it
+    //busy while merging and the consumer leaves a busy slot open, it's
+    //read on a later drain)
+    std::atomic<size_t> open_slot;
+
+    //events merged and dropped (metrics)
+    metrics::counter_t& coalesced;
+    metrics::counter_t& dropped;
+
+    /**
+     * Add an event to the ring
+     * @param  e the event (dropped if the queue is full)
+     * @return   whether the event was queued
+     */
+    bool push(const SDL_Event& e);
+
+    /**
+     * Merge motion into the newest queued event if it's open motion
+     * @param  e the motion
+     * @return   whether the motion was merged
+     */
+    bool merge(const SDL_Event& e);
+
+  public:
+    queue_t();
+    queue_t(const queue_t&) = delete;
+    queue_t& operator=(const queue_t&) = delete;
+
+    /**
+     * Queue an event (producer)
+     * @param e the event
+     */
+    void post(const SDL_Event& e);
+
+    /**
+     * Take every queued event in order (consumer)
+     * @param fn called with each event
+     * @return   the number of events taken
+     */
+    template <typename F>
+    size_t drain(F fn) {
+      size_t first = head.load(std::memory_order_relaxed);
+      size_t last = tail.load(std::memory_order_acquire);
+
+      //stop merges into what is read
+      size_t open = open_slot.load(std::memory_order_acquire);
+      while (open != INPUT_NO_SLOT) {
+        if (open & INPUT_SLOT_BUSY) {
+          //being merged into: read it next drain
+          last = std::min(last, open & ~INPUT_SLOT_BUSY);
+          break;
+        }
+        if (open_slot.compare_exchange_weak(open, INPUT_NO_SLOT, std::memory_order_acq_rel)) {
+          break;
+        }
+      }
+
+      for (size_t i=first; i!=last; i++) {
+        fn((const SDL_Event&) events[i & (INPUT_QUEUE_SIZE - 1)]);
+      }
+      head.store(last, std::memory_order_release);
+      return last - first;
+    }
+  };
+
+  /**
+   * Record the time from an event being received to it being applied
+   * @param e the event applied
+   */
+  void record_latency(const SDL_Event& e);
+}}
+
+#endif /*_IO_JACKHAY_SWAMP_INPUT_H*/
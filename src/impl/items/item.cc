@@ -5,7 +5,9 @@
  */
 
 #include "item.h"
+#include "../accounting.h"
 #include "../utils.h"
+#include "../draw.h"
 
 namespace impl {
 namespace items {
@@ -48,7 +50,7 @@ namespace items {
    */
   item_t::~item_t() {
     if (texture != NULL) {
-      SDL_DestroyTexture(texture);
+      accounting::free_texture(texture);
       texture = NULL;
     }
   }
@@ -186,10 +188,10 @@ namespace items {
                                texture_w,texture_h};
 
       //render the texture
-      SDL_RenderCopy(&renderer,
-                     texture,
-                     &sample_bounds,
-                     &image_bounds);
+      draw::copy(&renderer,
+                 texture,
+                 &sample_bounds,
+                 &image_bounds);
 
       if (debug) {
         SDL_Rect pickup_bounds = {(x - (texture_w / 2) - PICK_UP_RADIUS) - camera.x,
@@ -199,7 +201,7 @@ namespace items {
         //set the draw color
         SDL_SetRenderDrawColor(&renderer,74,7,100,255);
         //render the bounds
-        SDL_RenderDrawRect(&renderer,&pickup_bounds);
+        draw::rect(&renderer,&pickup_bounds);
       }
     } else if (displayable) {
       //create a clip for the current frame
@@ -211,10 +213,10 @@ namespace items {
                                texture_w,texture_h};
       if (texture != NULL) {
         //render the texture
-        SDL_RenderCopy(&renderer,
-                       texture,
-                       &sample_bounds,
-                       &image_bounds);
+        draw::copy(&renderer,
+                   texture,
+                   &sample_bounds,
+                   &image_bounds);
       }
     }
   }
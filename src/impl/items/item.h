@@ -75,6 +75,12 @@ namespace items {
      */
     bool removable() const { return displayable; }
 
+    /**
+     * Whether the player has picked up this item
+     * @return whether the item has been picked up
+     */
+    bool is_picked_up() const { return picked_up; }
+
     /**
      * Set the location for displaying this item
      * @param display_x the display coordinate x
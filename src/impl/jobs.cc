@@ -0,0 +1,225 @@
+/*
+ * (C) 2021 Jack Hay
+ *
+ * Untitled Swamp game
+ */
+
+#include "jobs.h"
+#include "arena.h"
+#include <exception>
+#include <algorithm>
+
+namespace impl {
+namespace jobs {
+
+  /**
+   * Constructor
+   * @param threads the number of worker threads (may be 0)
+   */
+  pool_t::pool_t(size_t threads)
+    : queues(),
+      workers(),
+      next_queue(0),
+      pending(0),
+      stopping(false) {
+
+    for (size_t i=0; i<std::max(threads,(size_t) 1); i++) {
+      queues.push_back(std::make_unique<queue_t>());
+    }
+
+    for (size_t i=0; i<threads; i++) {
+      workers.emplace_back(&pool_t::work, this, i);
+    }
+  }
+
+  //finish queued jobs and join workers
+  pool_t::~pool_t() {
+    {
+      std::unique_lock<std::mutex> lk(wake_lock);
+      stopping = true;
+    }
+    wake.notify_all();
+
+    for (size_t i=0; i<workers.size(); i++) {
+      workers.at(i).join();
+    }
+  }
+
+  /**
+   * Take a job from a queue, stealing from others if empty
+   * @param  idx the queue to try first
+   * @param  job the job set by the call
+   * @return     whether a job was taken
+   */
+  bool pool_t::take(size_t idx, job_t& job) {
+    for (size_t i=0; i<queues.size(); i++) {
+      queue_t& q = *queues.at((idx + i) % queues.size());
+      std::unique_lock<std::mutex> lk(q.lock);
+
+      if (!q.jobs.empty()) {
+        if (i == 0) {
+          //own queue: oldest first
+          job = std::move(q.jobs.front());
+          q.jobs.pop_front();
+        } else {
+          //steal from the other end
+          job = std::move(q.jobs.back());
+          q.jobs.pop_back();
+        }
+        pending--;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * Run a job outside of any level scope (a job run by a thread waiting
+   * on a parallel_for must not allocate from that thread's level)
+   * @param job the job
+   */
+  static void run(job_t& job) {
+    arena::level_scope_t none(NULL);
+    job();
+  }
+
+  /**
+   * Worker loop
+   * @param idx the worker's queue
+   */
+  void pool_t::work(size_t idx) {
+    while (true) {
+      job_t job;
+      if (take(idx, job)) {
+        run(job);
+        continue;
+      }
+
+      std::unique_lock<std::mutex> lk(wake_lock);
+      wake.wait(lk, [this]() { return stopping || (pending > 0); });
+
+      if (stopping && (pending == 0)) {
+        return;
+      }
+    }
+  }
+
+  /**
+   * Queue a job
+   * @param job the job
+   */
+  void pool_t::submit(job_t job) {
+    queue_t& q = *queues.at(next_queue++ % queues.size());
+    {
+      //counted before the job can be taken (so pending never goes below zero)
+      //and under the wake lock so an idle worker can't miss it
+      std::unique_lock<std::mutex> lk(wake_lock);
+      pending++;
+
+      std::unique_lock<std::mutex> qlk(q.lock);
+      q.jobs.push_back(std::move(job));
+    }
+    wake.notify_one();
+  }
+
+  /**
+   * Run one queued job on the calling thread (if any)
+   * @return whether a job was run
+   */
+  bool pool_t::run_one() {
+    job_t job;
+    if (take(next_queue % queues.size(), job)) {
+      run(job);
+      return true;
+    }
+    return false;
+  }
+
+  /**
+   * Get the shared pool (one worker per core besides the caller, at least one)
+   * @return the pool
+   */
+  pool_t& pool() {
+    static pool_t shared(std::max(std::thread::hardware_concurrency(), 2u) - 1);
+    return shared;
+  }
+
+  /**
+   * The iterations of one parallel_for, shared with the jobs helping it
+   * (helpers can start after the call returns, so this outlives it)
+   */
+  typedef struct for_state_t {
+    const std::function<void(size_t)> *fn;
+    size_t n;
+
+    //the next iteration to claim and the iterations finished
+    std::atomic<size_t> next;
+    size_t finished;
+
+    std::mutex done_lock;
+    std::condition_variable done;
+    std::exception_ptr error;
+  } for_state_t;
+
+  /**
+   * Claim and run iterations until none are left
+   * @param state the parallel_for
+   */
+  static void run_iterations(for_state_t& state) {
+    size_t i;
+    while ((i = state.next.fetch_add(1)) < state.n) {
+      std::exception_ptr error;
+      try {
+        (*state.fn)(i);
+      } catch (...) {
+        error = std::current_exception();
+      }
+
+      //the last iteration wakes the caller (under the lock so the
+      //caller can't return while this iteration is still counted)
+      std::unique_lock<std::mutex> lk(state.done_lock);
+      if (error && !state.error) {
+        state.error = error;
+      }
+      if (++state.finished == state.n) {
+        state.done.notify_all();
+      }
+    }
+  }
+
+  /**
+   * Run fn(i) for i in [0,n) across the shared pool and wait for all
+   * The calling thread runs iterations too (only this call's, never
+   * other queued jobs), the first exception is rethrown
+   * @param n  the number of iterations
+   * @param fn the function to run
+   */
+  void parallel_for(size_t n, const std::function<void(size_t)>& fn) {
+    if (n == 0) {
+      return;
+    }
+    pool_t& p = pool();
+
+    std::shared_ptr<for_state_t> state = std::make_shared<for_state_t>();
+    state->fn = &fn;
+    state->n = n;
+    state->next = 0;
+    state->finished = 0;
+
+    //helpers claim iterations from the same counter (the caller takes one)
+    size_t helpers = std::min(n - 1, p.size());
+    for (size_t i=0; i<helpers; i++) {
+      p.submit([state]() { run_iterations(*state); });
+    }
+
+    run_iterations(*state);
+
+    //wait for iterations helpers are still running
+    std::unique_lock<std::mutex> lk(state->done_lock);
+    state->done.wait(lk, [&state]() { return state->finished == state->n; });
+
+    if (state->error) {
+      std::rethrow_exception(state->error);
+    }
+  }
+}}
@@ -0,0 +1,116 @@
+/*
+ * (C) 2021 Jack Hay
+ *
+ * Untitled Swamp game
+ */
+
+#ifndef _IO_JACKHAY_SWAMP_JOBS_H
+#define _IO_JACKHAY_SWAMP_JOBS_H
+
+#include <functional>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+namespace impl {
+namespace jobs {
+
+  //a unit of work
+  typedef std::function<void()> job_t;
+
+  /**
+   * Work stealing thread pool
+   * Each worker takes jobs from the front of its own queue and
+   * steals from the back of the others when it runs out
+   */
+  struct pool_t {
+  private:
+    //a worker's queue of jobs
+    struct queue_t {
+      std::deque<job_t> jobs;
+      std::mutex lock;
+    };
+
+    //one queue per worker (at least one)
+    std::vector<std::unique_ptr<queue_t>> queues;
+
+    //worker threads
+    std::vector<std::thread> workers;
+
+    //round robin queue for new jobs
+    std::atomic<size_t> next_queue;
+
+    //jobs queued but not yet taken
+    std::atomic<size_t> pending;
+
+    //idle workers wait here
+    std::mutex wake_lock;
+    std::condition_variable wake;
+    bool stopping;
+
+    /**
+     * Take a job from a queue, stealing from others if empty
+     * @param  idx the queue to try first
+     * @param  job the job set by the call
+     * @return     whether a job was taken
+     */
+    bool take(size_t idx, job_t& job);
+
+    /**
+     * Worker loop
+     * @param idx the worker's queue
+     */
+    void work(size_t idx);
+
+  public:
+    /**
+     * Constructor
+     * @param threads the number of worker threads (may be 0)
+     */
+    explicit pool_t(size_t threads);
+    pool_t(const pool_t&) = delete;
+    pool_t& operator=(const pool_t&) = delete;
+
+    //finish queued jobs and join workers
+    ~pool_t();
+
+    /**
+     * Get the number of worker threads
+     * @return the worker count
+     */
+    size_t size() const { return workers.size(); }
+
+    /**
+     * Queue a job
+     * @param job the job
+     */
+    void submit(job_t job);
+
+    /**
+     * Run one queued job on the calling thread (if any)
+     * @return whether a job was run
+     */
+    bool run_one();
+  };
+
+  /**
+   * Get the shared pool (one worker per core besides the caller, at least one)
+   * @return the pool
+   */
+  pool_t& pool();
+
+  /**
+   * Run fn(i) for i in [0,n) across the shared pool and wait for all
+   * The calling thread runs iterations too (only this call's, never
+   * other queued jobs), the first exception is rethrown
+   * @param n  the number of iterations
+   * @param fn the function to run
+   */
+  void parallel_for(size_t n, const std::function<void(size_t)>& fn);
+}}
+
+#endif /*_IO_JACKHAY_SWAMP_JOBS_H*/
@@ -8,12 +8,20 @@
 #include "logger.h"
 #include "engine.h"
 #include "exceptions.h"
+#include "rng.h"
+#include "cache.h"
+#include "render_target.h"
+#include "text.h"
+#include "metrics.h"
+#include "alloc.h"
 #include "state/state_manager.h"
 #include "state/tilemap_state.h"
 #include "state/title_state.h"
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL_ttf.h>
+#include <memory>
+#include <algorithm>
 
 namespace impl {
 namespace launcher {
@@ -37,6 +45,41 @@ namespace launcher {
     j.at("level_cfgs").get_to(c.level_cfgs);
     j.at("major").get_to(c.major);
     j.at("minor").get_to(c.minor);
+
+    //optional
+    if (j.contains("state_budget_mb")) {
+      j.at("state_budget_mb").get_to(c.state_budget_mb);
+    }
+    if (j.contains("seed")) {
+      j.at("seed").get_to(c.seed);
+    }
+    if (j.contains("gen_cache_dir")) {
+      j.at("gen_cache_dir").get_to(c.gen_cache_dir);
+    }
+    if (j.contains("gen_cache_mb")) {
+      j.at("gen_cache_mb").get_to(c.gen_cache_mb);
+    }
+    if (j.contains("proc_streaming")) {
+      j.at("proc_streaming").get_to(c.proc_streaming);
+    }
+    if (j.contains("software_compositor")) {
+      j.at("software_compositor").get_to(c.software_compositor);
+    }
+    if (j.contains("metrics_path")) {
+      j.at("metrics_path").get_to(c.metrics_path);
+    }
+    if (j.contains("metrics_interval_ms")) {
+      j.at("metrics_interval_ms").get_to(c.metrics_interval_ms);
+    }
+    if (j.contains("metrics_format")) {
+      j.at("metrics_format").get_to(c.metrics_format);
+    }
+    if (j.contains("alloc_tracking")) {
+      j.at("alloc_tracking").get_to(c.alloc_tracking);
+    }
+    if (j.contains("alloc_sample_every")) {
+      j.at("alloc_sample_every").get_to(c.alloc_sample_every);
+    }
   }
 
   /**
@@ -59,6 +102,9 @@ namespace launcher {
    */
   bool init_from_cfg(const launch_cfg_t& cfg) {
 
+    //count allocations per tick and frame (opt in)
+    alloc::set_mode(cfg.alloc_tracking, cfg.alloc_sample_every);
+
     /*
      * SDL initializations
      */
@@ -92,6 +138,9 @@ namespace launcher {
       return false;
     }
 
+    //batch consecutive draws from the same texture (atlas pages)
+    SDL_SetHint(SDL_HINT_RENDER_BATCHING,"1");
+
     //create a window with the given dimensions
     SDL_Window *window = SDL_CreateWindow(
 			    window_title.c_str(),
@@ -109,9 +158,6 @@ namespace launcher {
       return false;
     }
 
-    //set the logical size of the renderer
-    SDL_RenderSetLogicalSize(renderer,cfg.window_width_p,cfg.window_height_p);
-
     //clear
     SDL_SetRenderDrawColor(renderer,0xFF,0xFF,0xFF,0xFF);
 
@@ -140,9 +186,16 @@ namespace launcher {
 
     { //scope destroys state manager before renderer
 
+      //the world is drawn at its logical size then scaled once
+      //(destroyed after the state manager, which draws with its renderer)
+      render_target::world_target_t world(*renderer,
+                                          cfg.window_width_p,
+                                          cfg.window_height_p,
+                                          cfg.software_compositor);
+
       //the game state manager
       std::shared_ptr<state::state_manager_t> state_manager =
-        std::make_shared<state::state_manager_t>(*renderer,
+        std::make_shared<state::state_manager_t>(world.get_renderer(),
                                                  camera,
                                                  cfg.tile_dim,
                                                  cfg.font,
@@ -156,28 +209,56 @@ namespace launcher {
                                                                       cfg.caret_image,
                                                                       cfg.font,
                                                                       cfg.base_path,
-                                                                      *renderer,
+                                                                      world.get_renderer(),
                                                                       *state_manager));
 
       //set the configuration paths in the state manager for future load
       state_manager->load_defer(cfg.level_cfgs, cfg.base_path, cfg.font);
 
+      //bound the memory used by levels that aren't being played
+      state_manager->set_memory_budget((size_t) cfg.state_budget_mb * 1024 * 1024);
+
+      //seed all generation (logged so a run can be reproduced)
+      uint64_t seed = (cfg.seed == 0) ? rng::time_seed() : cfg.seed;
+      logger::log_info("world seed " + std::to_string(seed));
+      state_manager->set_seed(seed);
+
+      //generated maps without a right edge
+      state_manager->set_proc_streaming(cfg.proc_streaming);
+
+      //reuse generated assets from previous runs
+      cache::set_dir(cfg.gen_cache_dir, (size_t) std::max(cfg.gen_cache_mb, 0) * 1024 * 1024);
+
       //title state not shown in debug mode
       if (cfg.debug) {
         //load first level right away
         state_manager->set_state(SWAMP_STATE);
       }
 
+      //snapshots for soak runs (stopped before the state manager)
+      std::unique_ptr<metrics::exporter_t> exporter;
+      if (!cfg.metrics_path.empty()) {
+        exporter = std::make_unique<metrics::exporter_t>(cfg.metrics_path,
+                                                         cfg.metrics_format,
+                                                         cfg.metrics_interval_ms);
+      }
+
       //start entity update loop
       if (!engine::start_update_thread(state_manager)) {
         logger::log_err("failed to start update thread");
         success = false;
       } else {
-        if (!engine::start_renderer(*renderer,state_manager,cfg.debug,cfg.font)) {
+        if (!engine::start_renderer(world,
+                                    state_manager,
+                                    cfg.debug,
+                                    cfg.font)) {
           logger::log_err("failed to start renderer");
           success = false;
         }
       }
+
+      //glyph pages are drawn with the world renderer
+      text::clear();
     }
 
     //free resources
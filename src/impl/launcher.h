@@ -9,6 +9,7 @@
 
 #include <vector>
 #include <string>
+#include <cstdint>
 #include <json/nlohmann_json.h>
 
 namespace impl {
@@ -34,6 +35,28 @@ namespace launcher {
     std::vector<std::string> level_cfgs = {};
     //the base directory path
     std::string base_path = "resources/";
+    //memory budget for loaded levels (inactive levels are evicted past this)
+    int state_budget_mb = 64;
+    //world seed for generation (0 for a new seed each run)
+    uint64_t seed = 0;
+    //directory for cached generated assets ("" to disable)
+    std::string gen_cache_dir = "cache/";
+    //size limit for cached generated assets (least recently used removed past this, 0 for none)
+    int gen_cache_mb = 256;
+    //whether generated maps stream in chunks (no right edge)
+    bool proc_streaming = false;
+    //whether frames are composited on the cpu (one upload per frame)
+    bool software_compositor = false;
+    //file metrics snapshots are written to ("" to disable)
+    std::string metrics_path = "";
+    //the time between metrics snapshots
+    int metrics_interval_ms = 1000;
+    //"json" (appended lines) or "prometheus" (latest snapshot)
+    std::string metrics_format = "json";
+    //allocation tracking: "off", "count" or "assert" (report steady state allocations)
+    std::string alloc_tracking = "off";
+    //sample the call site of every nth allocation (0 for none)
+    int alloc_sample_every = 0;
     //major version
     int major = 1;
     //minor version
@@ -6,23 +6,287 @@
 
 #include "logger.h"
 #include <iostream>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <ctime>
+#include <cstdio>
+#include <algorithm>
+#include <cstdlib>
 
 namespace impl {
 namespace logger {
 
+  //the lowest level written
+  std::atomic<int> min_level(LOG_INFO);
+
   /**
-   * Log information
-   * @param msg the message to log
+   * A message waiting to be written
    */
-  void log_info(const std::string& msg) {
-    std::cerr << "lvl=info,msg=\"" << msg << "\"" << std::endl;
+  typedef struct record_t {
+    int level;
+    std::chrono::system_clock::time_point time;
+    int thread;
+    std::string msg;
+  } record_t;
+
+  /**
+   * A ring slot, the sequence says whose turn it is
+   * (bounded multi producer queue, consumers hold the output lock)
+   */
+  typedef struct slot_t {
+    std::atomic<size_t> seq;
+    record_t record;
+  } slot_t;
+
+  static slot_t ring[LOG_RING_SIZE];
+
+  //the next slot to write (producers) and read (flusher)
+  static std::atomic<size_t> write_pos(0);
+  static size_t read_pos = 0;
+
+  //messages dropped because the ring was full
+  static std::atomic<size_t> dropped(0);
+
+  //whether the flusher is running
+  static std::atomic<bool> running(false);
+  static std::thread flusher;
+
+  //serializes immediate writes with the flusher (and guards read_pos)
+  static std::mutex out_lock;
+
+  //small ids for threads in order of first message
+  static std::atomic<int> next_thread(1);
+
+  /**
+   * Set the lowest level written (any thread)
+   * @param level the level
+   */
+  void set_level(int level) {
+    min_level.store(level, std::memory_order_relaxed);
   }
 
   /**
-   * Log an error message
-   * @param msg the message to log
+   * Get a level by name
+   * @param  name  debug, info, warn or err
+   * @param  level the level (set by the call)
+   * @return       whether the name is a level
    */
-  void log_err(const std::string& msg) {
-    std::cerr << "lvl=info,msg=\"" << msg << "\"" << std::endl;
+  bool parse_level(const std::string& name, int& level) {
+    if (name == "debug") {
+      level = LOG_DEBUG;
+    } else if (name == "info") {
+      level = LOG_INFO;
+    } else if (name == "warn") {
+      level = LOG_WARN;
+    } else if (name == "err") {
+      level = LOG_ERR;
+    } else {
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * Get the id of the calling thread
+   * @return the id
+   */
+  static int thread_id() {
+    thread_local int id = next_thread.fetch_add(1);
+    return id;
+  }
+
+  /**
+   * Write a message
+   * @param record the message
+   */
+  static void write(const record_t& record) {
+    static const char *names[] = {"debug", "info", "warn", "err"};
+    int level = std::min(std::max(record.level, LOG_DEBUG), LOG_ERR);
+
+    std::time_t secs = std::chrono::system_clock::to_time_t(record.time);
+    int ms = (int) (std::chrono::duration_cast<std::chrono::milliseconds>(
+                      record.time.time_since_epoch()).count() % 1000);
+    std::tm local;
+    localtime_r(&secs, &local);
+
+    char ts[32];
+    size_t len = std::strftime(ts, sizeof(ts), "%Y-%m-%dT%H:%M:%S", &local);
+    snprintf(ts + len, sizeof(ts) - len, ".%03d", ms);
+
+    std::cerr << "ts=" << ts
+              << ",lvl=" << names[level]
+              << ",tid=" << record.thread
+              << ",msg=\"" << record.msg << "\"\n";
+  }
+
+  /**
+   * Write a message from the calling thread
+   * @param record the message
+   */
+  static void write_now(const record_t& record) {
+    std::unique_lock<std::mutex> lk(out_lock);
+    write(record);
+    std::cerr.flush();
+  }
+
+  /**
+   * Take the next message from the ring (flusher)
+   * @param  record the message (set by the call)
+   * @return        whether there was a message
+   */
+  static bool take(record_t& record) {
+    slot_t& slot = ring[read_pos % LOG_RING_SIZE];
+    if (slot.seq.load(std::memory_order_acquire) != (read_pos + 1)) {
+      return false;
+    }
+
+    record = std::move(slot.record);
+
+    //free the slot for the next lap
+    slot.seq.store(read_pos + LOG_RING_SIZE, std::memory_order_release);
+    read_pos++;
+    return true;
+  }
+
+  /**
+   * Write all buffered messages (output lock held)
+   * @return whether anything was written
+   */
+  static bool drain_locked() {
+    record_t record;
+    bool wrote = false;
+
+    while (take(record)) {
+      write(record);
+      wrote = true;
+    }
+
+    size_t lost = dropped.exchange(0);
+    if (lost > 0) {
+      write({LOG_WARN, std::chrono::system_clock::now(), 0,
+             "log full, dropped " + std::to_string(lost) + " messages"});
+      wrote = true;
+    }
+
+    if (wrote) {
+      std::cerr.flush();
+    }
+    return wrote;
+  }
+
+  /**
+   * Write all buffered messages
+   * @return whether anything was written
+   */
+  static bool drain() {
+    std::unique_lock<std::mutex> lk(out_lock);
+    return drain_locked();
+  }
+
+  /**
+   * Write buffered messages then a message from the calling thread
+   * (errors, which are often followed by exit)
+   * @param record the message
+   */
+  static void write_through(const record_t& record) {
+    std::unique_lock<std::mutex> lk(out_lock);
+    drain_locked();
+    write(record);
+    std::cerr.flush();
+  }
+
+  /**
+   * Flusher loop
+   */
+  static void flush_loop() {
+    while (running.load()) {
+      if (!drain()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(LOG_FLUSH_MS));
+      }
+    }
+  }
+
+  /**
+   * Start writing messages from a background thread
+   * (messages are written immediately until started and after stopping,
+   * the thread is also stopped on exit)
+   */
+  void start() {
+    if (running.exchange(true)) {
+      return;
+    }
+
+    //exit without stop would destroy a joinable thread (terminate)
+    static bool stop_at_exit = (std::atexit(stop) == 0);
+    (void) stop_at_exit;
+
+    for (size_t i=0; i<LOG_RING_SIZE; i++) {
+      ring[i].seq.store(i, std::memory_order_relaxed);
+    }
+    write_pos.store(0);
+    read_pos = 0;
+
+    flusher = std::thread(flush_loop);
+  }
+
+  /**
+   * Write any buffered messages and stop the background thread
+   */
+  void stop() {
+    if (!running.exchange(false)) {
+      return;
+    }
+    flusher.join();
+    drain();
+  }
+
+  /**
+   * Log a message (buffered if the flusher is running, errors are
+   * written before returning)
+   * @param level the level
+   * @param msg   the message
+   */
+  void log(int level, std::string&& msg) {
+    record_t record = {level, std::chrono::system_clock::now(), thread_id(), std::move(msg)};
+
+    if (!running.load()) {
+      write_now(record);
+      return;
+    }
+
+    if (level >= LOG_ERR) {
+      //not buffered, the caller may be about to exit
+      write_through(record);
+      return;
+    }
+
+    //claim a slot
+    size_t pos = write_pos.load(std::memory_order_relaxed);
+    slot_t *slot;
+    while (true) {
+      slot = &ring[pos % LOG_RING_SIZE];
+      size_t seq = slot->seq.load(std::memory_order_acquire);
+
+      if (seq == pos) {
+        if (write_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (seq < pos) {
+        //full: warnings and errors are written anyway, the rest is dropped
+        if (level >= LOG_WARN) {
+          write_now(record);
+        } else {
+          dropped.fetch_add(1);
+        }
+        return;
+      } else {
+        //another producer took it
+        pos = write_pos.load(std::memory_order_relaxed);
+      }
+    }
+
+    slot->record = std::move(record);
+    slot->seq.store(pos + 1, std::memory_order_release);
   }
 }}
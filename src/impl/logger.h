@@ -8,21 +8,123 @@
 #define _IO_JACKHAY_SWAMP_LOGGER_H
 
 #include <string>
+#include <atomic>
+#include <utility>
 
 namespace impl {
 namespace logger {
 
+  //log levels (lowest to highest)
+  #define LOG_DEBUG 0
+  #define LOG_INFO 1
+  #define LOG_WARN 2
+  #define LOG_ERR 3
+
+  //the number of messages buffered for the flusher (power of 2)
+  #define LOG_RING_SIZE 4096
+
+  //how long the flusher sleeps when there is nothing to write (ms)
+  #define LOG_FLUSH_MS 10
+
+  //the lowest level written (checked by callers before formatting)
+  extern std::atomic<int> min_level;
+
+  /**
+   * Check whether a level is written
+   * @param  level the level
+   * @return       whether messages at this level are written
+   */
+  inline bool enabled(int level) {
+    return level >= min_level.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Set the lowest level written (any thread)
+   * @param level the level
+   */
+  void set_level(int level);
+
+  /**
+   * Get a level by name
+   * @param  name  debug, info, warn or err
+   * @param  level the level (set by the call)
+   * @return       whether the name is a level
+   */
+  bool parse_level(const std::string& name, int& level);
+
+  /**
+   * Start writing messages from a background thread
+   * (messages are written immediately until started and after stopping,
+   * the thread is also stopped on exit)
+   */
+  void start();
+
+  /**
+   * Write any buffered messages and stop the background thread
+   */
+  void stop();
+
+  /**
+   * Log a message (buffered if the flusher is running, errors are
+   * written before returning)
+   * @param level the level
+   * @param msg   the message
+   */
+  void log(int level, std::string&& msg);
+
+  /**
+   * Log a message, formatted only if the level is enabled
+   * @param level  the level
+   * @param format returns the message
+   */
+  template <typename F>
+  inline void log_lazy(int level, F&& format) {
+    if (enabled(level)) {
+      log(level, format());
+    }
+  }
+
+  /**
+   * Log debug information (for tracing load paths)
+   * The message is built by the caller even when the level is disabled,
+   * use log_lazy for messages built on the update or render threads
+   * @param msg the message to log
+   */
+  inline void log_debug(std::string msg) {
+    if (enabled(LOG_DEBUG)) {
+      log(LOG_DEBUG, std::move(msg));
+    }
+  }
+
   /**
    * Log information
    * @param msg the message to log
    */
-  void log_info(const std::string& msg);
+  inline void log_info(std::string msg) {
+    if (enabled(LOG_INFO)) {
+      log(LOG_INFO, std::move(msg));
+    }
+  }
+
+  /**
+   * Log a warning
+   * @param msg the message to log
+   */
+  inline void log_warn(std::string msg) {
+    if (enabled(LOG_WARN)) {
+      log(LOG_WARN, std::move(msg));
+    }
+  }
 
   /**
    * Log an error message
    * @param msg the message to log
    */
-  void log_err(const std::string& msg);
+  inline void log_err(std::string msg) {
+    if (enabled(LOG_ERR)) {
+      log(LOG_ERR, std::move(msg));
+    }
+  }
 }}
 
 #endif /*_IO_JACKHAY_SWAMP_LOGGER_H*/
@@ -0,0 +1,259 @@
+/*
+ * (C) 2021 Jack Hay
+ *
+ * Untitled Swamp game
+ */
+
+#include "metrics.h"
+#include "accounting.h"
+#include "timing.h"
+#include "draw.h"
+#include "alloc.h"
+#include "logger.h"
+#include <map>
+#include <memory>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <cctype>
+#include <cstdio>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/resource.h>
+
+namespace impl {
+namespace metrics {
+
+  //registered metrics (entries are never removed)
+  static std::map<std::string, std::unique_ptr<gauge_t>> gauges;
+  static std::map<std::string, std::unique_ptr<counter_t>> counters;
+  static std::mutex registry_lock;
+
+  //the process start (for uptime)
+  static const std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+
+  /**
+   * Get a gauge, registered on first use
+   * (keep the reference, lookups take a lock)
+   * @param  name the gauge name
+   * @return      the gauge
+   */
+  gauge_t& gauge(const std::string& name) {
+    std::unique_lock<std::mutex> lk(registry_lock);
+    std::unique_ptr<gauge_t>& g = gauges[name];
+    if (!g) {
+      g = std::make_unique<gauge_t>();
+    }
+    return *g;
+  }
+
+  /**
+   * Get a counter, registered on first use
+   * (keep the reference, lookups take a lock)
+   * @param  name the counter name
+   * @return      the counter
+   */
+  counter_t& counter(const std::string& name) {
+    std::unique_lock<std::mutex> lk(registry_lock);
+    std::unique_ptr<counter_t>& c = counters[name];
+    if (!c) {
+      c = std::make_unique<counter_t>();
+    }
+    return *c;
+  }
+
+  /**
+   * Get the resident memory of the process
+   * (peak resident memory where the current value isn't available)
+   * @return the bytes
+   */
+  static size_t resident_bytes() {
+    std::ifstream statm("/proc/self/statm");
+    size_t pages, resident;
+    if (statm >> pages >> resident) {
+      return resident * (size_t) sysconf(_SC_PAGESIZE);
+    }
+
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+      return 0;
+    }
+    #ifdef BUILD__MACOS__
+    //bytes on macos
+    return (size_t) usage.ru_maxrss;
+    #else
+    return (size_t) usage.ru_maxrss * 1024;
+    #endif
+  }
+
+  /**
+   * Summarize recorded durations
+   * @param  recorder the durations
+   * @return          the percentiles as json
+   */
+  static json durations(const timing::recorder_t& recorder) {
+    timing::stats_t stats = recorder.get_stats();
+    return {{"p50", stats.p50},
+            {"p95", stats.p95},
+            {"p99", stats.p99},
+            {"max", stats.max}};
+  }
+
+  /**
+   * Take a snapshot of all metrics: gauges, counters, frame and tick
+   * durations, input latency, texture memory, draw counts, allocations and
+   * resident memory
+   * @return the snapshot as json
+   */
+  json snapshot() {
+    json snap;
+    snap["ts"] = std::chrono::duration_cast<std::chrono::milliseconds>(
+                   std::chrono::system_clock::now().time_since_epoch()).count();
+    snap["uptime_s"] = std::chrono::duration_cast<std::chrono::seconds>(
+                         std::chrono::steady_clock::now() - started).count();
+
+    {
+      std::unique_lock<std::mutex> lk(registry_lock);
+      json g = json::object();
+      for (auto it=gauges.begin(); it!=gauges.end(); it++) {
+        g[it->first] = it->second->get();
+      }
+      json c = json::object();
+      for (auto it=counters.begin(); it!=counters.end(); it++) {
+        c[it->first] = it->second->get();
+      }
+      snap["gauges"] = g;
+      snap["counters"] = c;
+    }
+
+    snap["frame_ms"] = durations(timing::frames());
+    snap["tick_ms"] = durations(timing::ticks());
+    snap["input_ms"] = durations(timing::input());
+    snap["textures"] = accounting::dump();
+    snap["draw"] = draw::dump();
+    snap["allocs"] = alloc::dump();
+    snap["rss_bytes"] = resident_bytes();
+    return snap;
+  }
+
+  /**
+   * Make a prometheus metric name
+   * @param  name the name
+   * @return      the name with anything but letters, digits and _ replaced
+   */
+  static std::string metric_name(const std::string& name) {
+    std::string out = name;
+    for (size_t i=0; i<out.size(); i++) {
+      if (!std::isalnum((unsigned char) out.at(i))) {
+        out.at(i) = '_';
+      }
+    }
+    return out;
+  }
+
+  /**
+   * Write the numbers in some json as prometheus samples
+   * @param out    the text
+   * @param prefix the name so far
+   * @param j      the json
+   */
+  static void write_samples(std::ostringstream& out, const std::string& prefix, const json& j) {
+    if (j.is_object()) {
+      for (auto it=j.begin(); it!=j.end(); it++) {
+        write_samples(out, prefix + "_" + metric_name(it.key()), it.value());
+      }
+    } else if (j.is_number()) {
+      out << prefix << " " << j.dump() << "\n";
+    }
+  }
+
+  /**
+   * Format a snapshot as prometheus text (nested keys are joined with _)
+   * @param  snap the snapshot
+   * @return      the text
+   */
+  std::string to_prometheus(const json& snap) {
+    std::ostringstream out;
+    write_samples(out, "swamp", snap);
+    return out.str();
+  }
+
+  /**
+   * Start exporting
+   * @param path        the file written
+   * @param format      METRICS_JSON or METRICS_PROMETHEUS
+   * @param interval_ms the time between snapshots
+   */
+  exporter_t::exporter_t(const std::string& path, const std::string& format, int interval_ms)
+    : path(path),
+      format(format),
+      interval_ms(std::max(interval_ms, 1)),
+      worker(),
+      lock(),
+      wake(),
+      stopping(false) {
+    logger::log_info("exporting metrics to " + path + " every " +
+                     std::to_string(this->interval_ms) + "ms");
+    worker = std::thread(&exporter_t::run, this);
+  }
+
+  /**
+   * Write a last snapshot and stop
+   */
+  exporter_t::~exporter_t() {
+    {
+      std::unique_lock<std::mutex> lk(lock);
+      stopping = true;
+    }
+    wake.notify_all();
+    worker.join();
+    write();
+  }
+
+  /**
+   * Write one snapshot
+   */
+  void exporter_t::write() {
+    json snap = snapshot();
+
+    if (format == METRICS_PROMETHEUS) {
+      //the whole file is the latest snapshot (written then moved into place)
+      std::string tmp = path + ".tmp";
+      {
+        std::ofstream out(tmp, std::ios::trunc);
+        out << to_prometheus(snap);
+        if (!out) {
+          logger::log_warn("failed to write metrics to " + tmp);
+          return;
+        }
+      }
+      if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        logger::log_warn("failed to replace metrics at " + path);
+      }
+
+    } else {
+      std::ofstream out(path, std::ios::app);
+      out << snap.dump() << "\n";
+      if (!out) {
+        logger::log_warn("failed to write metrics to " + path);
+      }
+    }
+  }
+
+  /**
+   * Worker loop
+   */
+  void exporter_t::run() {
+    std::unique_lock<std::mutex> lk(lock);
+    while (!stopping) {
+      if (wake.wait_for(lk, std::chrono::milliseconds(interval_ms), [this]() { return stopping; })) {
+        break;
+      }
+
+      //snapshots don't hold up stopping
+      lk.unlock();
+      write();
+      lk.lock();
+    }
+  }
+}}
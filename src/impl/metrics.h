@@ -0,0 +1,159 @@
+/*
+ * (C) 2021 Jack Hay
+ *
+ * Untitled Swamp game
+ */
+
+#ifndef _IO_JACKHAY_SWAMP_METRICS_H
+#define _IO_JACKHAY_SWAMP_METRICS_H
+
+#include <string>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <json/nlohmann_json.h>
+
+namespace impl {
+namespace metrics {
+
+  typedef nlohmann::json json;
+
+  //snapshot formats
+  #define METRICS_JSON "json"
+  #define METRICS_PROMETHEUS "prometheus"
+
+  /**
+   * A value that goes up and down (object counts, sizes)
+   * (set and read from any thread)
+   */
+  struct gauge_t {
+  private:
+    std::atomic<int64_t> value;
+
+  public:
+    gauge_t() : value(0) {}
+    gauge_t(const gauge_t&) = delete;
+    gauge_t& operator=(const gauge_t&) = delete;
+
+    /**
+     * Set the value
+     * @param v the current value
+     */
+    void set(int64_t v) { value.store(v, std::memory_order_relaxed); }
+
+    /**
+     * Get the value
+     * @return the last value set
+     */
+    int64_t get() const { return value.load(std::memory_order_relaxed); }
+  };
+
+  /**
+   * A running total (loads, misses)
+   * (added to and read from any thread)
+   */
+  struct counter_t {
+  private:
+    std::atomic<uint64_t> value;
+
+  public:
+    counter_t() : value(0) {}
+    counter_t(const counter_t&) = delete;
+    counter_t& operator=(const counter_t&) = delete;
+
+    /**
+     * Add to the total
+     * @param n the amount
+     */
+    void add(uint64_t n=1) { value.fetch_add(n, std::memory_order_relaxed); }
+
+    /**
+     * Get the total
+     * @return the total
+     */
+    uint64_t get() const { return value.load(std::memory_order_relaxed); }
+  };
+
+  /**
+   * Get a gauge, registered on first use
+   * (keep the reference, lookups take a lock)
+   * @param  name the gauge name
+   * @return      the gauge
+   */
+  gauge_t& gauge(const std::string& name);
+
+  /**
+   * Get a counter, registered on first use
+   * (keep the reference, lookups take a lock)
+   * @param  name the counter name
+   * @return      the counter
+   */
+  counter_t& counter(const std::string& name);
+
+  /**
+   * Take a snapshot of all metrics: gauges, counters, frame and tick
+   * durations, input latency, texture memory, draw counts, allocations and
+   * resident memory
+   * @return the snapshot as json
+   */
+  json snapshot();
+
+  /**
+   * Format a snapshot as prometheus text (nested keys are joined with _)
+   * @param  snap the snapshot
+   * @return      the text
+   */
+  std::string to_prometheus(const json& snap);
+
+  /**
+   * Writes snapshots to a file at a fixed interval from a background thread
+   * json snapshots are appended as lines, prometheus text replaces the file
+   */
+  struct exporter_t {
+  private:
+    //the file written
+    std::string path;
+
+    //METRICS_JSON or METRICS_PROMETHEUS
+    std::string format;
+
+    //the time between snapshots
+    int interval_ms;
+
+    std::thread worker;
+
+    //wakes the worker to stop
+    std::mutex lock;
+    std::condition_variable wake;
+    bool stopping;
+
+    /**
+     * Write one snapshot
+     */
+    void write();
+
+    /**
+     * Worker loop
+     */
+    void run();
+
+  public:
+    /**
+     * Start exporting
+     * @param path        the file written
+     * @param format      METRICS_JSON or METRICS_PROMETHEUS
+     * @param interval_ms the time between snapshots
+     */
+    exporter_t(const std::string& path, const std::string& format, int interval_ms);
+    exporter_t(const exporter_t&) = delete;
+    exporter_t& operator=(const exporter_t&) = delete;
+
+    /**
+     * Write a last snapshot and stop
+     */
+    ~exporter_t();
+  };
+}}
+
+#endif /*_IO_JACKHAY_SWAMP_METRICS_H*/
@@ -5,8 +5,11 @@
  */
 
 #include "map_fork.h"
+#include "../accounting.h"
 #include "../utils.h"
 #include "../exceptions.h"
+#include "../draw.h"
+#include "../arena.h"
 #include <json/nlohmann_json.h>
 #include <fstream>
 
@@ -64,14 +67,14 @@ namespace misc {
         fork_cfg cfg = env.get<fork_cfg>();
 
         //add a new fork from cfg
-        forks.push_back(std::make_shared<map_fork_t>(cfg.x,
-                                                     cfg.y,
-                                                     cfg.target_x,
-                                                     cfg.target_y,
-                                                     cfg.target_text,
-                                                     cfg.target_name,
-                                                     font_path,
-                                                     renderer));
+        forks.push_back(arena::make_level<map_fork_t>(cfg.x,
+                                                      cfg.y,
+                                                      cfg.target_x,
+                                                      cfg.target_y,
+                                                      cfg.target_text,
+                                                      cfg.target_name,
+                                                      font_path,
+                                                      renderer));
       }
 
     } catch (...) {
@@ -124,7 +127,7 @@ namespace misc {
    */
   map_fork_t::~map_fork_t() {
     if (texture != NULL) {
-      SDL_DestroyTexture(texture);
+      accounting::free_texture(texture);
     }
   }
 
@@ -166,10 +169,10 @@ namespace misc {
                               texture_w,texture_h};
 
       //render the start texture
-      SDL_RenderCopy(&renderer,
-                     texture,
-                     &sample_bounds,
-                     &text_bounds);
+      draw::copy(&renderer,
+                 texture,
+                 &sample_bounds,
+                 &text_bounds);
     }
   }
 }}
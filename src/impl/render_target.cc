@@ -0,0 +1,180 @@
+/*
+ * (C) 2021 Jack Hay
+ *
+ * Untitled Swamp game
+ */
+
+#include "render_target.h"
+#include "accounting.h"
+#include "logger.h"
+#include <algorithm>
+
+namespace impl {
+namespace render_target {
+
+  /**
+   * Constructor
+   * @param window_renderer the window renderer
+   * @param width_p         the logical width
+   * @param height_p        the logical height
+   * @param software        whether to composite frames on the cpu
+   */
+  world_target_t::world_target_t(SDL_Renderer& window_renderer,
+                                 int width_p,
+                                 int height_p,
+                                 bool software)
+    : window_renderer(window_renderer),
+      frame(),
+      texture(NULL),
+      width_p(width_p),
+      height_p(height_p),
+      scale(1),
+      dest({0,0,width_p,height_p}) {
+
+    if (software) {
+      //the frame is uploaded whole each frame
+      texture = SDL_CreateTexture(&window_renderer,
+                                  SDL_PIXELFORMAT_ARGB8888,
+                                  SDL_TEXTUREACCESS_STREAMING,
+                                  width_p, height_p);
+      if (texture != NULL) {
+        //textures created from here on keep cpu pixels
+        frame.reset(new compositor::frame_t(width_p, height_p));
+        logger::log_info("compositing frames in software");
+      } else {
+        logger::log_err("failed to create software frame: " + std::string(SDL_GetError()));
+      }
+    }
+
+    if ((texture == NULL) && SDL_RenderTargetSupported(&window_renderer)) {
+      texture = SDL_CreateTexture(&window_renderer,
+                                  SDL_PIXELFORMAT_RGBA32,
+                                  SDL_TEXTUREACCESS_TARGET,
+                                  width_p, height_p);
+    }
+
+    if (texture == NULL) {
+      //let the renderer scale each draw
+      logger::log_info("render targets unavailable, using logical scaling");
+      SDL_RenderSetLogicalSize(&window_renderer,width_p,height_p);
+      return;
+    }
+
+    accounting::track_texture(texture, TEXTURE_TARGET, width_p, height_p);
+    fit();
+  }
+
+  /**
+   * Free the target
+   */
+  world_target_t::~world_target_t() {
+    if (texture != NULL) {
+      accounting::free_texture(texture);
+    }
+  }
+
+  /**
+   * Fit the world into the window at the largest integer scale
+   * (centered, the rest is left black)
+   */
+  void world_target_t::fit() {
+    int out_w = width_p;
+    int out_h = height_p;
+    SDL_GetRendererOutputSize(&window_renderer,&out_w,&out_h);
+
+    scale = std::max(1, std::min(out_w / width_p, out_h / height_p));
+    dest.w = width_p * scale;
+    dest.h = height_p * scale;
+    dest.x = (out_w - dest.w) / 2;
+    dest.y = (out_h - dest.h) / 2;
+  }
+
+  /**
+   * Direct world rendering to the target (or record it for the cpu frame)
+   */
+  void world_target_t::begin() {
+    if (frame != NULL) {
+      frame->begin();
+    } else if (texture != NULL) {
+      SDL_SetRenderTarget(&window_renderer,texture);
+    }
+  }
+
+  /**
+   * Copy the world to the window (compositing and uploading the cpu
+   * frame first), further rendering is at window resolution (overlays)
+   */
+  void world_target_t::end() {
+    if (texture == NULL) {
+      return;
+    }
+
+    if (frame != NULL) {
+      frame->end();
+
+      //one upload for the whole frame
+      SDL_UpdateTexture(texture, NULL, frame->get_pixels(), width_p * sizeof(Uint32));
+    } else {
+      SDL_SetRenderTarget(&window_renderer,NULL);
+    }
+
+    //the window may have changed size
+    fit();
+
+    SDL_SetRenderDrawColor(&window_renderer,0,0,0,0xFF);
+    SDL_RenderClear(&window_renderer);
+    SDL_RenderCopy(&window_renderer,texture,NULL,&dest);
+  }
+
+  /**
+   * Show the frame in the window
+   */
+  void world_target_t::present() {
+    SDL_RenderPresent(&window_renderer);
+  }
+
+  /**
+   * Read back the world at its logical resolution (screenshots)
+   * Call after end
+   * @return the world pixels (RGBA32, caller frees) or NULL (no target or failure)
+   */
+  SDL_Surface* world_target_t::capture() const {
+    //the window holds scaled pixels
+    if (texture == NULL) {
+      return NULL;
+    }
+
+    SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormat(0,
+                                                          width_p,
+                                                          height_p,
+                                                          32,
+                                                          SDL_PIXELFORMAT_RGBA32);
+    if (surface == NULL) {
+      return NULL;
+    }
+
+    //already on the cpu
+    if (frame != NULL) {
+      SDL_ConvertPixels(width_p, height_p,
+                        SDL_PIXELFORMAT_ARGB8888, frame->get_pixels(), width_p * sizeof(Uint32),
+                        SDL_PIXELFORMAT_RGBA32, surface->pixels, surface->pitch);
+      return surface;
+    }
+
+    //read from the target (not the scaled window)
+    SDL_SetRenderTarget(&window_renderer,texture);
+    int result = SDL_RenderReadPixels(&window_renderer,
+                                      NULL,
+                                      SDL_PIXELFORMAT_RGBA32,
+                                      surface->pixels,
+                                      surface->pitch);
+    SDL_SetRenderTarget(&window_renderer,NULL);
+
+    if (result != 0) {
+      logger::log_err("failed to read world pixels: " + std::string(SDL_GetError()));
+      SDL_FreeSurface(surface);
+      return NULL;
+    }
+    return surface;
+  }
+}}
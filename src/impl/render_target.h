@@ -0,0 +1,123 @@
+/*
+ * (C) 2021 Jack Hay
+ *
+ * Untitled Swamp game
+ */
+
+#ifndef _IO_JACKHAY_SWAMP_RENDER_TARGET_H
+#define _IO_JACKHAY_SWAMP_RENDER_TARGET_H
+
+#include "compositor.h"
+#include <SDL2/SDL.h>
+#include <memory>
+
+namespace impl {
+namespace render_target {
+
+  /**
+   * The world at its logical resolution, presented with a single
+   * integer scaled copy. Drawn either into an offscreen texture or
+   * (software compositing) into a cpu frame uploaded once per frame
+   * (falls back to renderer logical scaling without target support)
+   * (render thread only)
+   */
+  struct world_target_t {
+  private:
+    //the window renderer
+    SDL_Renderer& window_renderer;
+
+    //the cpu frame (NULL unless compositing in software)
+    std::unique_ptr<compositor::frame_t> frame;
+
+    //the offscreen world or the uploaded frame (NULL when falling back)
+    SDL_Texture *texture;
+
+    //the logical size
+    int width_p;
+    int height_p;
+
+    //the integer scale of the last present
+    int scale;
+
+    //where the world is copied to in the window
+    SDL_Rect dest;
+
+    /**
+     * Fit the world into the window at the largest integer scale
+     * (centered, the rest is left black)
+     */
+    void fit();
+
+  public:
+    /**
+     * Constructor
+     * @param window_renderer the window renderer
+     * @param width_p         the logical width
+     * @param height_p        the logical height
+     * @param software        whether to composite frames on the cpu
+     */
+    world_target_t(SDL_Renderer& window_renderer,
+                   int width_p,
+                   int height_p,
+                   bool software);
+    world_target_t(const world_target_t&) = delete;
+    world_target_t& operator=(const world_target_t&) = delete;
+
+    /**
+     * Free the target
+     */
+    ~world_target_t();
+
+    /**
+     * Get the renderer the game draws with (textures must be created with it)
+     * @return the renderer
+     */
+    SDL_Renderer& get_renderer() const {
+      return window_renderer;
+    }
+
+    /**
+     * Direct world rendering to the target (or record it for the cpu frame)
+     */
+    void begin();
+
+    /**
+     * Copy the world to the window (compositing and uploading the cpu
+     * frame first), further rendering is at window resolution (overlays)
+     */
+    void end();
+
+    /**
+     * Show the frame in the window
+     */
+    void present();
+
+    /**
+     * Get the scale of window pixels to world pixels for overlays
+     * (1 when the renderer scales instead)
+     * @return the scale
+     */
+    int get_scale() const { return (texture == NULL) ? 1 : scale; }
+
+    /**
+     * Get the logical width
+     * @return the width in world pixels
+     */
+    int get_width() const { return width_p; }
+
+    /**
+     * Get the logical height
+     * @return the height in world pixels
+     */
+    int get_height() const { return height_p; }
+
+    /**
+     * Read back the world at its logical resolution (screenshots)
+     * Call after end
+     * @return the world pixels (RGBA32, caller frees) or NULL (no target or failure)
+     */
+    SDL_Surface* capture() const;
+  };
+}}
+
+#endif /*_IO_JACKHAY_SWAMP_RENDER_TARGET_H*/
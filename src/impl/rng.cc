@@ -0,0 +1,105 @@
+/*
+ * (C) 2021 Jack Hay
+ *
+ * Untitled Swamp game
+ */
+
+#include "rng.h"
+#include <chrono>
+
+namespace impl {
+namespace rng {
+
+  //odd constant (2^64 / golden ratio) for spacing keys and counters
+  #define GOLDEN_GAMMA 0x9E3779B97F4A7C15ULL
+
+  /**
+   * Splitmix64 finalizer
+   * @param  z the value to mix
+   * @return   the mixed value
+   */
+  static uint64_t mix(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+  }
+
+  /**
+   * Constructor
+   * @param seed   the world seed
+   * @param stream the subsystem stream
+   * @param region the region within the stream (i.e. column or chunk)
+   */
+  rng_t::rng_t(uint64_t seed, stream_id stream, uint64_t region)
+    : key(mix(mix(mix(seed) + ((uint64_t) stream * GOLDEN_GAMMA)) + (region * GOLDEN_GAMMA))),
+      counter(0) {}
+
+  /**
+   * Derive an independent stream for some sub region
+   * (does not advance this stream)
+   * @param  region the sub region
+   * @return        the derived stream
+   */
+  rng_t rng_t::split(uint64_t region) const {
+    return rng_t(mix(key + ((region + 1) * GOLDEN_GAMMA)));
+  }
+
+  /**
+   * Get the next value in the stream
+   * @return a uniformly distributed 64 bit value
+   */
+  uint64_t rng_t::next() {
+    counter++;
+    return mix(key + (counter * GOLDEN_GAMMA));
+  }
+
+  /**
+   * Get the next value in the range [0,n)
+   * (drop-in for rand() % n)
+   * @param  n the upper bound
+   * @return   the value
+   */
+  int rng_t::next_int(int n) {
+    return (int) (next() % (uint64_t) n);
+  }
+
+  /**
+   * Get the next value in the range [0,1]
+   * @return the value
+   */
+  float rng_t::next_float() {
+    //top 24 bits fit a float mantissa exactly
+    return static_cast<float>(next() >> 40) / static_cast<float>((1 << 24) - 1);
+  }
+
+  /**
+   * Identify the stream and its position (i.e. for cache keys)
+   * @return the state
+   */
+  uint64_t rng_t::get_state() const {
+    return key ^ mix(counter);
+  }
+
+  /**
+   * Get a seed from the current time
+   * @return the seed
+   */
+  uint64_t time_seed() {
+    return mix(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+  }
+
+  /**
+   * Stable hash of a string (i.e. a level path) for use as a region
+   * (fnv-1a, same on every platform unlike std::hash)
+   * @param  str the string
+   * @return     the hash
+   */
+  uint64_t hash_str(const std::string& str) {
+    uint64_t h = 0xCBF29CE484222325ULL;
+    for (size_t i=0; i<str.size(); i++) {
+      h ^= (uint64_t) (unsigned char) str.at(i);
+      h *= 0x100000001B3ULL;
+    }
+    return h;
+  }
+}}
@@ -0,0 +1,110 @@
+/*
+ * (C) 2021 Jack Hay
+ *
+ * Untitled Swamp game
+ */
+
+#ifndef _IO_JACKHAY_SWAMP_RNG_H
+#define _IO_JACKHAY_SWAMP_RNG_H
+
+#include <cstdint>
+#include <string>
+
+namespace impl {
+namespace rng {
+
+  /*
+   * Independent random streams (one per subsystem)
+   */
+  enum stream_id {
+    WORLD,        // seeds for generated levels
+    TERRAIN,      // procedural surface height
+    GRND_TILES,   // ground tile erosion
+    FG_TILES,     // foreground surface tiles
+    FG_PLANTS,    // foreground trees and bushes
+    HILLS,        // background hills
+    TREES,        // configured procedural trees
+    GROUNDCOVER,  // configured procedural groundcover
+    INSECTS,
+    CROWS,
+    FOAM,
+    SEEP
+  };
+
+  /**
+   * Counter based random number stream
+   * The nth value is a pure function of (seed, stream, region, n)
+   * so streams never depend on the order other streams are used in
+   */
+  struct rng_t {
+  private:
+    //the stream key (mixed from seed, stream and region)
+    uint64_t key;
+    //the number of values drawn
+    uint64_t counter;
+
+    /**
+     * Constructor from a mixed key
+     * @param key the stream key
+     */
+    explicit rng_t(uint64_t key) : key(key), counter(0) {}
+
+  public:
+    /**
+     * Constructor
+     * @param seed   the world seed
+     * @param stream the subsystem stream
+     * @param region the region within the stream (i.e. column or chunk)
+     */
+    rng_t(uint64_t seed, stream_id stream, uint64_t region=0);
+
+    /**
+     * Derive an independent stream for some sub region
+     * (does not advance this stream)
+     * @param  region the sub region
+     * @return        the derived stream
+     */
+    [[nodiscard]] rng_t split(uint64_t region) const;
+
+    /**
+     * Get the next value in the stream
+     * @return a uniformly distributed 64 bit value
+     */
+    [[nodiscard]] uint64_t next();
+
+    /**
+     * Get the next value in the range [0,n)
+     * (drop-in for rand() % n)
+     * @param  n the upper bound
+     * @return   the value
+     */
+    [[nodiscard]] int next_int(int n);
+
+    /**
+     * Get the next value in the range [0,1]
+     * @return the value
+     */
+    [[nodiscard]] float next_float();
+
+    /**
+     * Identify the stream and its position (i.e. for cache keys)
+     * @return the state
+     */
+    [[nodiscard]] uint64_t get_state() const;
+  };
+
+  /**
+   * Get a seed from the current time
+   * @return the seed
+   */
+  [[nodiscard]] uint64_t time_seed();
+
+  /**
+   * Stable hash of a string (i.e. a level path) for use as a region
+   * @param  str the string
+   * @return     the hash
+   */
+  [[nodiscard]] uint64_t hash_str(const std::string& str);
+}}
+
+#endif /*_IO_JACKHAY_SWAMP_RNG_H*/
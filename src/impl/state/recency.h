@@ -0,0 +1,76 @@
+/*
+ * (C) 2021 Jack Hay
+ *
+ * Untitled Swamp game
+ */
+
+#ifndef _IO_JACKHAY_SWAMP_RECENCY_H
+#define _IO_JACKHAY_SWAMP_RECENCY_H
+
+#include <vector>
+#include <limits>
+#include <cstddef>
+
+namespace impl {
+namespace state {
+
+  /**
+   * Tracks when each state was last entered (for least recently used eviction)
+   * Every state added to the manager must be added here, in the same order
+   */
+  struct recency_t {
+  private:
+    //incremented every time a state is entered
+    size_t uses;
+
+    //the uses count when each state was last entered (by state index)
+    std::vector<size_t> last_used;
+
+  public:
+    recency_t() : uses(0), last_used() {}
+    recency_t(const recency_t&) = delete;
+    recency_t& operator=(const recency_t&) = delete;
+
+    /**
+     * Add a state (never entered)
+     * @return the state index
+     */
+    size_t add() {
+      last_used.push_back(0);
+      return last_used.size() - 1;
+    }
+
+    /**
+     * Mark a state as the most recently used
+     * @param idx the state index (must have been added)
+     */
+    void touch(size_t idx) { last_used.at(idx) = ++uses; }
+
+    /**
+     * Get the number of states tracked
+     * @return the count
+     */
+    size_t size() const { return last_used.size(); }
+
+    /**
+     * Find the least recently used state that can be evicted
+     * @param  evictable called with a state index, whether it can be evicted
+     * @return           the state index (size() if there isn't one)
+     */
+    template <typename F>
+    size_t oldest(F evictable) const {
+      size_t lru = last_used.size();
+      size_t when = std::numeric_limits<size_t>::max();
+
+      for (size_t i=0; i<last_used.size(); i++) {
+        if ((last_used.at(i) < when) && evictable(i)) {
+          lru = i;
+          when = last_used.at(i);
+        }
+      }
+      return lru;
+    }
+  };
+}}
+
+#endif /*_IO_JACKHAY_SWAMP_RECENCY_H*/
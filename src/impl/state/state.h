@@ -10,6 +10,7 @@
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
+#include <memory_resource>
 #include "state_manager.h"
 
 namespace impl {
@@ -71,8 +72,16 @@ namespace state {
 
     /**
      * Update this tile
+     * @param tick memory for data that only lives for this tick
      */
-    virtual void update() {}
+    virtual void update(std::pmr::memory_resource& tick) {}
+
+    /**
+     * Make and free anything that needs the renderer
+     * (render thread, before render)
+     * @param renderer the renderer
+     */
+    virtual void sync(SDL_Renderer& renderer) {}
 
     /**
      * Render the current gamestate
@@ -85,8 +94,9 @@ namespace state {
      * Render any debug info
      * @param renderer sdl renderer
      * @param font     loaded ttf font
+     * @param scale    the overlay scale
      */
-    virtual void render_debug_info(SDL_Renderer& renderer, TTF_Font& font) const {}
+    virtual void render_debug_info(SDL_Renderer& renderer, TTF_Font& font, int scale) const {}
   };
 }}
 
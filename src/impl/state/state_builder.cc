@@ -7,11 +7,16 @@
 #include "state_builder.h"
 #include "tilemap_state.h"
 #include "../logger.h"
+#include "../accounting.h"
+#include "../rng.h"
+#include "../metrics.h"
+#include "../arena.h"
 #include <json/nlohmann_json.h>
 #include <fstream>
 #include <memory>
 #include "../tilemap/tilemap.h"
 #include "../tilemap/procedural_tilemap.h"
+#include "../tilemap/stream_tilemap.h"
 #include "../tilemap/abstract_tilemap.h"
 #include "../tilemap/tileset.h"
 #include "../tilemap/transparent_block.h"
@@ -63,6 +68,12 @@ namespace state {
     std::string transparent_blocks_path = "";
     //map fork config path
     std::string map_fork_path = "";
+    //region manifest path ("" to load the whole level at once)
+    std::string regions_path = "";
+    //regions kept loaded on each side of the camera
+    int region_radius = 1;
+    //extra regions before a region is dropped
+    int region_hysteresis = 1;
   };
 
   /**
@@ -84,6 +95,17 @@ namespace state {
     j.at("items_path").get_to(c.items_path);
     j.at("transparent_blocks_path").get_to(c.transparent_blocks_path);
     j.at("map_fork_path").get_to(c.map_fork_path);
+
+    //optional
+    if (j.contains("regions_path")) {
+      j.at("regions_path").get_to(c.regions_path);
+    }
+    if (j.contains("region_radius")) {
+      j.at("region_radius").get_to(c.region_radius);
+    }
+    if (j.contains("region_hysteresis")) {
+      j.at("region_hysteresis").get_to(c.region_hysteresis);
+    }
   }
 
   /**
@@ -96,6 +118,7 @@ namespace state {
    * @param  tile_dim the dimensions of tiles
    * @param  base_path resource directory base path
    * @param  font_path the path to the font to use
+   * @param  world_seed the world seed (levels derive their own from this)
    * @param  idx_override put the state in a specific position
    */
   void load_tm_state(state::state_manager_t& state_manager,
@@ -105,8 +128,25 @@ namespace state {
                      int tile_dim,
                      const std::string& base_path,
                      const std::string& font_path,
+                     uint64_t world_seed,
                      int idx_override) {
 
+    //attribute textures loaded for this level to it
+    accounting::owner_scope_t owner(path);
+    logger::log_lazy(LOG_DEBUG, [&]() {
+      return "loading level " + path;
+    });
+
+    //objects that live as long as the level are allocated together
+    std::unique_ptr<arena::level_arena_t> level_arena = std::make_unique<arena::level_arena_t>();
+    arena::level_scope_t level(level_arena.get());
+
+    static metrics::counter_t& levels = metrics::counter("levels_loaded");
+    levels.add();
+
+    //the level seed depends only on the world seed and the level
+    uint64_t seed = rng::rng_t(world_seed, rng::WORLD, rng::hash_str(path)).next();
+
     //load the file
     state_cfg_t cfg;
 
@@ -121,26 +161,63 @@ namespace state {
       throw exceptions::rsrc_exception_t(path);
     }
 
-    //initialize the tileset from image
-    std::shared_ptr<tilemap::tileset_t> tileset =
-      std::make_shared<tilemap::tileset_t>(base_path + cfg.tileset_path,
-                                           tile_dim,
-                                           renderer);
-
     //add base path to map layer paths
     for (size_t i=0; i<cfg.map_layer_paths.size(); i++) {
       cfg.map_layer_paths.at(i) = base_path + cfg.map_layer_paths.at(i);
     }
 
-    //the tilemap from layer paths
-    std::shared_ptr<tilemap::tilemap_t> tilemap =
-      std::make_shared<tilemap::tilemap_t>(cfg.map_layer_paths,
-                                           tileset,
-                                           cfg.entity_layer_idx,
+    //split levels page regions (and the objects in them) around the camera
+    std::shared_ptr<const tilemap::region_manifest_t> manifest;
+    std::shared_ptr<tilemap::tilemap_t> tilemap;
+
+    //the layers the level loads
+    std::vector<std::string> layer_paths = cfg.map_layer_paths;
+
+    if (!cfg.regions_path.empty()) {
+      manifest = std::make_shared<const tilemap::region_manifest_t>(
+        tilemap::load_region_manifest(cfg.regions_path, base_path)
+      );
+
+      layer_paths.clear();
+      if (cfg.bg_stationary) {
+        layer_paths.push_back(cfg.map_layer_paths.at(0));
+      }
+      for (const tilemap::region_files_t& region : manifest->regions) {
+        for (const std::string& layer_path : region.layer_paths) {
+          layer_paths.push_back(base_path + layer_path);
+        }
+      }
+    }
+
+    //initialize the tileset from the tiles the level uses
+    //(on the heap, region jobs can hold it past the level)
+    std::shared_ptr<tilemap::tileset_t> tileset =
+      std::make_shared<tilemap::tileset_t>(base_path + cfg.tileset_path,
                                            tile_dim,
-                                           cfg.entity_layer_solid,
-                                           cfg.entity_layer_water,
-                                           cfg.bg_stationary);
+                                           renderer,
+                                           tilemap::used_tile_types(layer_paths));
+
+    if (manifest) {
+      tilemap = arena::make_level<tilemap::tilemap_t>(manifest,
+                                                      base_path,
+                                                      cfg.bg_stationary ? cfg.map_layer_paths.at(0) : "",
+                                                      tileset,
+                                                      cfg.entity_layer_idx,
+                                                      tile_dim,
+                                                      cfg.entity_layer_solid,
+                                                      cfg.entity_layer_water,
+                                                      cfg.region_radius,
+                                                      cfg.region_hysteresis);
+    } else {
+      //the tilemap from layer paths
+      tilemap = arena::make_level<tilemap::tilemap_t>(cfg.map_layer_paths,
+                                                      tileset,
+                                                      cfg.entity_layer_idx,
+                                                      tile_dim,
+                                                      cfg.entity_layer_solid,
+                                                      cfg.entity_layer_water,
+                                                      cfg.bg_stationary);
+    }
 
     //entities list
     std::vector<std::shared_ptr<entity::entity_t>> entities;
@@ -152,49 +229,91 @@ namespace state {
 
     //load insects
     std::shared_ptr<entity::insects_t> insects =
-      std::make_shared<entity::insects_t>(base_path + cfg.insect_cfg_path);
+      arena::make_level<entity::insects_t>(base_path + cfg.insect_cfg_path, seed);
 
-    //load renderable environmental elements
+    //env elements, items and transparent blocks of a split level
+    //are loaded with their regions
     std::vector<std::shared_ptr<environment::renderable_t>> env_renderable;
-    environment::load_env_elems(env_renderable,
-                                cfg.env_elems_path,
-                                renderer,
-                                base_path);
+    std::vector<std::shared_ptr<items::item_t>> level_items;
+    std::vector<std::shared_ptr<tilemap::transparent_block_t>> tblocks;
 
-    //make environment from elements
-    std::shared_ptr<environment::environment_t> env =
-      std::make_shared<environment::environment_t>(env_renderable);
+    if (!manifest) {
+      //load renderable environmental elements
+      environment::load_env_elems(env_renderable,
+                                  cfg.env_elems_path,
+                                  renderer,
+                                  base_path,
+                                  seed);
 
-    //load items
-    std::vector<std::shared_ptr<items::item_t>> level_items;
-    items::load_items(level_items,
-                      cfg.items_path,
-                      renderer,
-                      base_path);
+      //load items (on the heap, the player can carry them out of the level)
+      items::load_items(level_items,
+                        cfg.items_path,
+                        renderer,
+                        base_path);
 
-    //load transparent blocks
-    std::vector<std::shared_ptr<tilemap::transparent_block_t>> tblocks;
-    tilemap::mk_transparent_blocks(tblocks,
-                                   cfg.transparent_blocks_path,
-                                   renderer,
-                                   base_path);
+      //load transparent blocks
+      tilemap::mk_transparent_blocks(tblocks,
+                                     cfg.transparent_blocks_path,
+                                     renderer,
+                                     base_path);
+    }
+
+    //make environment from elements
+    std::shared_ptr<environment::environment_t> env =
+      arena::make_level<environment::environment_t>(env_renderable);
 
     //load map forks
     std::vector<std::shared_ptr<misc::map_fork_t>> forks;
     misc::load_forks(forks,base_path + cfg.map_fork_path,font_path,renderer);
 
-    //make the state and add it to the manager
-    state_manager.add_state(std::make_unique<state::tilemap_state_t>(tilemap,
-                                                                     entities,
-                                                                     insects,
-                                                                     env,
-                                                                     level_items,
-                                                                     tblocks,
-                                                                     forks,
-                                                                     cfg.player_idx,
-                                                                     state_manager,
-                                                                     camera,
-                                                                     path),
+    //make the state
+    std::unique_ptr<state::tilemap_state_t> state =
+      std::make_unique<state::tilemap_state_t>(tilemap,
+                                               entities,
+                                               insects,
+                                               env,
+                                               level_items,
+                                               tblocks,
+                                               forks,
+                                               cfg.player_idx,
+                                               state_manager,
+                                               camera,
+                                               path);
+    state->set_level_arena(std::move(level_arena));
+
+    if (manifest) {
+      //loads the objects anchored in a region as it pages in (render thread)
+      state->set_region_loader([manifest,base_path,path,seed](int r,
+                                                              region_objs_t& objs,
+                                                              SDL_Renderer& renderer) {
+        const tilemap::region_files_t& files = manifest->regions.at(r);
+        accounting::owner_scope_t owner(path);
+        logger::log_lazy(LOG_DEBUG, [&]() {
+          return "loading region " + std::to_string(r) + " of " + path;
+        });
+
+        static metrics::counter_t& regions = metrics::counter("regions_loaded");
+        regions.add();
+
+        if (!files.env_path.empty()) {
+          //elements are keyed by position in their region's cfg
+          environment::load_env_elems(objs.env,
+                                      files.env_path,
+                                      renderer,
+                                      base_path,
+                                      rng::rng_t(seed, rng::WORLD, r).next());
+        }
+        if (!files.items_path.empty()) {
+          items::load_items(objs.items, files.items_path, renderer, base_path);
+        }
+        if (!files.tblocks_path.empty()) {
+          tilemap::mk_transparent_blocks(objs.tblocks, files.tblocks_path, renderer, base_path);
+        }
+      });
+    }
+
+    //add it to the manager
+    state_manager.add_state(std::move(state),
                             //whether or not specified
                             idx_override);
 
@@ -202,45 +321,67 @@ namespace state {
 
   /**
    * Load a new procedural tilemap state
-   * @param  player   the previous player
-   * @param  tile_dim the tile dimension
-   * @param  camera   the camera to use
-   * @param  renderer the renderer for creating textures
-   * @param  manager  the state manager
-   * @return          the new state
+   * @param  player    the previous player
+   * @param  tile_dim  the tile dimension
+   * @param  camera    the camera to use
+   * @param  renderer  the renderer for creating textures
+   * @param  manager   the state manager
+   * @param  seed      the seed for the generated map
+   * @param  streaming whether the map streams in chunks (no right edge)
+   * @return           the new state
    */
   std::unique_ptr<state_t> load_procedural_state(std::shared_ptr<entity::player_t> player,
                                                  int tile_dim,
                                                  SDL_Rect& camera,
                                                  SDL_Renderer& renderer,
-                                                 state_manager_t& manager) {
+                                                 state_manager_t& manager,
+                                                 uint64_t seed,
+                                                 bool streaming) {
+
+    std::string name = "generated";
+
+    //attribute generated textures to this level
+    accounting::owner_scope_t owner(name);
+
+    //objects that live as long as the level are allocated together
+    std::unique_ptr<arena::level_arena_t> level_arena = std::make_unique<arena::level_arena_t>();
+    arena::level_scope_t level(level_arena.get());
 
     std::vector<std::shared_ptr<entity::entity_t>> entities;
     entities.push_back(player);
     player->set_position(16,16);
 
     //create a procedural map
-    std::shared_ptr<tilemap::abstract_tilemap_t> tilemap =
-      std::make_shared<tilemap::procedural_tilemap_t>(
+    std::shared_ptr<tilemap::abstract_tilemap_t> tilemap;
+    if (streaming) {
+      tilemap = arena::make_level<tilemap::stream_tilemap_t>(
+        tile_dim,
+        PROC_HEIGHT_T * tile_dim,
+        renderer,
+        seed
+      );
+
+    } else {
+      tilemap = arena::make_level<tilemap::procedural_tilemap_t>(
         tile_dim,
         PROC_WIDTH_T * tile_dim,
         PROC_HEIGHT_T * tile_dim,
-        renderer
-    );
+        renderer,
+        seed
+      );
+    }
 
     //TODO random insect generation
-    std::shared_ptr<entity::insects_t> insects = std::make_shared<entity::insects_t>();
-    std::shared_ptr<environment::environment_t> env = std::make_shared<environment::environment_t>();
+    std::shared_ptr<entity::insects_t> insects = arena::make_level<entity::insects_t>();
+    std::shared_ptr<environment::environment_t> env = arena::make_level<environment::environment_t>();
 
     //empty
     std::vector<std::shared_ptr<items::item_t>> level_items;
     std::vector<std::shared_ptr<tilemap::transparent_block_t>> trans_blocks;
     std::vector<std::shared_ptr<misc::map_fork_t>> forks;
 
-    std::string name = "generated";
-
     //create a new tilemap state
-    return std::make_unique<state::tilemap_state_t>(
+    std::unique_ptr<state::tilemap_state_t> state = std::make_unique<state::tilemap_state_t>(
       //create a procedural tilemap
       tilemap,
       entities,
@@ -255,5 +396,7 @@ namespace state {
       name,
       true //procedural
     );
+    state->set_level_arena(std::move(level_arena));
+    return state;
   }
 }}
@@ -10,6 +10,7 @@
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL.h>
 #include <string>
+#include <cstdint>
 #include "state.h"
 #include "state_manager.h"
 #include "tilemap_state.h"
@@ -28,6 +29,7 @@ namespace state {
    * @param  tile_dim the dimensions of tiles
    * @param  base_path resource directory base path
    * @param  font_path the path to the font to use
+   * @param  world_seed the world seed (levels derive their own from this)
    * @param  idx_override put the state in a specific position
    */
   void load_tm_state(state::state_manager_t& state_manager,
@@ -37,22 +39,27 @@ namespace state {
                      int tile_dim,
                      const std::string& base_path,
                      const std::string& font_path,
+                     uint64_t world_seed,
                      int idx_override=-1);
 
   /**
    * Load a new procedural tilemap state
-   * @param  player   the previous player
-   * @param  tile_dim the tile dimension
-   * @param  camera   the camera to use
-   * @param  renderer the renderer for creating textures
-   * @param  manager  the state manager
-   * @return          the new state
+   * @param  player    the previous player
+   * @param  tile_dim  the tile dimension
+   * @param  camera    the camera to use
+   * @param  renderer  the renderer for creating textures
+   * @param  manager   the state manager
+   * @param  seed      the seed for the generated map
+   * @param  streaming whether the map streams in chunks (no right edge)
+   * @return           the new state
    */
   std::unique_ptr<state_t> load_procedural_state(std::shared_ptr<entity::player_t> player,
                                                  int tile_dim,
                                                  SDL_Rect& camera,
                                                  SDL_Renderer& renderer,
-                                                 state_manager_t& manager);
+                                                 state_manager_t& manager,
+                                                 uint64_t seed,
+                                                 bool streaming);
 }}
 
 #endif /*_IO_JACKHAY_SWAMP_STATE_BUILDER_H*/
@@ -7,6 +7,9 @@
 #include "state_manager.h"
 #include "state_builder.h"
 #include "../logger.h"
+#include "../accounting.h"
+#include "../utils.h"
+#include "../rng.h"
 #include "tilemap_state.h"
 #include "pause_state.h"
 #include "../tilemap/procedural_tilemap.h"
@@ -14,6 +17,14 @@
 namespace impl {
 namespace state {
 
+  //default budget for resident tilemap states
+  #define DEFAULT_MEMORY_BUDGET (64 * 1024 * 1024)
+
+  //layout of memory totals in the debug overlay
+  #define DEBUG_MEM_Y 48
+  #define DEBUG_MEM_OWNER_X 128
+  #define DEBUG_LINE_H 12
+
   /**
    * Constructor
    * @param renderer the renderer for loading images
@@ -46,20 +57,198 @@ namespace state {
       debug(debug),
       current_state(TITLE_STATE),
       last_state(TITLE_STATE),
-      window_scale(window_scale) {}
+      window_scale(window_scale),
+      memory_budget(DEFAULT_MEMORY_BUDGET),
+      recency(),
+      evicted(),
+      world_seed(0),
+      swamps_generated(0),
+      proc_streaming(false),
+      states_loaded(metrics::gauge("states_loaded")),
+      states_evicted(metrics::counter("states_evicted")),
+      tick_arena(),
+      input(),
+      requested(CHANGE_NONE),
+      requested_state(0) {}
+
+  /**
+   * Set the memory budget for resident tilemap states
+   * (inactive states are evicted when this is exceeded)
+   * @param bytes the budget in bytes
+   */
+  void state_manager_t::set_memory_budget(size_t bytes) {
+    memory_budget = bytes;
+  }
+
+  /**
+   * Set the world seed
+   * (the same seed produces the same levels and generated maps)
+   * @param seed the world seed
+   */
+  void state_manager_t::set_seed(uint64_t seed) {
+    world_seed = seed;
+  }
+
+  /**
+   * Set whether generated maps stream in chunks as the
+   * player moves (instead of a fixed width map)
+   * @param streaming whether to stream
+   */
+  void state_manager_t::set_proc_streaming(bool streaming) {
+    proc_streaming = streaming;
+  }
+
+  /**
+   * Publish the number of resident states
+   */
+  void state_manager_t::count_loaded() const {
+    int64_t loaded = 0;
+    for (size_t i=0; i<states.size(); i++) {
+      if (states.at(i)) {
+        loaded++;
+      }
+    }
+    states_loaded.set(loaded);
+  }
+
+  /**
+   * Evict least recently used inactive tilemap states until
+   * the resident states fit in the memory budget
+   */
+  void state_manager_t::enforce_budget() {
+    //the total footprint of resident tilemap states
+    size_t total = 0;
+    for (size_t i=0; i<states.size(); i++) {
+      if (tilemap_state_t *tm = dynamic_cast<tilemap_state_t*>(states.at(i).get())) {
+        total += tm->get_footprint();
+      }
+    }
+
+    while (total > memory_budget) {
+      //find the least recently used inactive tilemap state
+      size_t lru = recency.oldest([this](size_t i) {
+        return (i != current_state) &&
+               (dynamic_cast<tilemap_state_t*>(states.at(i).get()) != nullptr);
+      });
+
+      //nothing left that can be evicted
+      if (lru == recency.size()) {
+        break;
+      }
+
+      tilemap_state_t *tm = dynamic_cast<tilemap_state_t*>(states.at(lru).get());
+      size_t footprint = tm->get_footprint();
+
+      if (tm->is_procedural()) {
+        //generated maps aren't reachable once left, nothing to restore
+        evicted.erase(lru);
+      } else {
+        evicted[lru] = {{"cfg", tm->get_cfg()}, {"changes", tm->save_changes()}};
+      }
+
+      if (debug) {
+        logger::log_lazy(LOG_INFO, [lru,footprint]() {
+          return "evicting state " + std::to_string(lru) +
+                 " (" + std::to_string(footprint / 1024) + " KB)";
+        });
+      }
+
+      states.at(lru).reset();
+      states_evicted.add();
+      total -= footprint;
+    }
+    count_loaded();
+  }
+
+  /**
+   * Reload a state that was evicted and restore its saved changes
+   * @param idx the state index
+   * @return whether the state was restored
+   */
+  bool state_manager_t::restore_evicted(size_t idx) {
+    auto record = evicted.find(idx);
+    if (record == evicted.end()) {
+      logger::log_err("no saved state to restore for state " + std::to_string(idx));
+      return false;
+    }
+
+    if (debug) {
+      logger::log_lazy(LOG_INFO, [idx]() {
+        return "restoring state " + std::to_string(idx);
+      });
+    }
+
+    //reload the state in place
+    load_tm_state(*this,
+                  record->second.at("cfg").get<std::string>(),
+                  renderer,
+                  camera,
+                  tile_dim,
+                  base_path,
+                  font_path,
+                  world_seed,
+                  idx);
+
+    if (tilemap_state_t *restored = dynamic_cast<tilemap_state_t*>(states.at(idx).get())) {
+      restored->restore_changes(record->second.at("changes"));
+    }
+
+    evicted.erase(record);
+    return true;
+  }
 
   /**
    * Reload the resources from configuration for the current map
    * Note: this should be called by the pause menu
-   * (Note: this keeps the player in the same place)
+   * (Note: this keeps the player in the same place, made by the next render)
    */
   void state_manager_t::rsrc_reload() {
+    requested = CHANGE_RELOAD;
+  }
+
+  /**
+   * Generate a new procedural map (made by the next render)
+   */
+  void state_manager_t::new_swamp() {
+    requested = CHANGE_NEW_SWAMP;
+  }
+
+  /**
+   * Set the current level state (made by the next render)
+   * @param type the state type
+   */
+  void state_manager_t::set_state(size_t type) {
+    requested = CHANGE_STATE;
+    requested_state = type;
+  }
+
+  /**
+   * Make the state change requested (render thread, state locked)
+   */
+  void state_manager_t::apply_requested() {
+    //cleared first so a change that fails isn't retried every frame
+    auto change = requested;
+    requested = CHANGE_NONE;
+
+    if (change == CHANGE_STATE) {
+      this->apply_set_state(requested_state);
+    } else if (change == CHANGE_NEW_SWAMP) {
+      this->apply_new_swamp();
+    } else if (change == CHANGE_RELOAD) {
+      this->apply_rsrc_reload();
+    }
+  }
+
+  /**
+   * Reload the resources for the current map now
+   */
+  void state_manager_t::apply_rsrc_reload() {
     //keep the player
     if (tilemap_state_t *curr_tilemap = dynamic_cast<tilemap_state_t*>(states.at(current_state).get())) {
 
       if (curr_tilemap->is_procedural()) {
         //regen
-        this->new_swamp();
+        this->apply_new_swamp();
       } else {
         //get the current player
         std::shared_ptr<entity::player_t> player = curr_tilemap->get_player();
@@ -70,8 +259,9 @@ namespace state {
         //get the current camera (applicable if the view is locked)
 
         if (debug) {
-          logger::log_info("loading state " +
-                           deferred_cfgs.at(last_state));
+          logger::log_lazy(LOG_INFO, [&]() {
+            return "loading state " + deferred_cfgs.at(last_state);
+          });
         }
 
         //reload the state
@@ -82,6 +272,7 @@ namespace state {
                       tile_dim,
                       base_path,
                       font_path,
+                      world_seed,
                       current_state);
 
         //add the player back into the reloaded state
@@ -96,17 +287,21 @@ namespace state {
         }
       }
     } else if (debug) {
-      logger::log_info("reload not implemented for non tilemap state " + std::to_string(last_state));
+      logger::log_lazy(LOG_INFO, [&]() {
+        return "reload not implemented for non tilemap state " + std::to_string(last_state);
+      });
     }
   }
 
   /**
-   * Generate a new procedural map
+   * Generate a new procedural map now
    */
-  void state_manager_t::new_swamp() {
+  void state_manager_t::apply_new_swamp() {
 
     //player needed to have been loaded already
     if (tilemap_state_t *prev_tilemap = dynamic_cast<tilemap_state_t*>(states.at(current_state).get())) {
+      //each generated map gets the next seed in the world stream
+      uint64_t seed = rng::rng_t(world_seed, rng::WORLD, swamps_generated++).next();
 
       if (prev_tilemap->is_procedural()) {
         //reset the previous procedural state
@@ -114,19 +309,26 @@ namespace state {
                                                           tile_dim,
                                                           camera,
                                                           renderer,
-                                                          *this);
+                                                          *this,
+                                                          seed,
+                                                          proc_streaming);
       } else {
-        //add a new state
-        states.push_back(load_procedural_state(prev_tilemap->get_player(),
+        //add a new state (tracked for eviction like any other)
+        this->add_state(load_procedural_state(prev_tilemap->get_player(),
                                               tile_dim,
                                               camera,
                                               renderer,
-                                              *this));
+                                              *this,
+                                              seed,
+                                              proc_streaming));
         //update previous
         last_state = current_state;
         //update the current
         current_state = states.size() - 1;
       }
+
+      recency.touch(current_state);
+      enforce_budget();
     }
   }
 
@@ -140,10 +342,10 @@ namespace state {
   }
 
   /**
-   * Set the current level state
-   * @param name the state type
+   * Set the current level state now
+   * @param type the state type
    */
-  void state_manager_t::set_state(size_t type) {
+  void state_manager_t::apply_set_state(size_t type) {
     //check if the state is not yet loaded
     if (type >= states.size()) {
       //lazily load the next state
@@ -151,8 +353,9 @@ namespace state {
 
       //attempt to load from deferred cfg list
       if (debug) {
-        logger::log_info("loading state " +
-                         deferred_cfgs.at(last_loaded));
+        logger::log_lazy(LOG_INFO, [&]() {
+          return "loading state " + deferred_cfgs.at(last_loaded);
+        });
       }
 
       if (last_loaded < (int)deferred_cfgs.size()) {
@@ -163,12 +366,16 @@ namespace state {
                       camera,
                       tile_dim,
                       base_path,
-                      font_path);
+                      font_path,
+                      world_seed);
 
       } else {
         logger::log_err("no cfg provided for next level");
         return;
       }
+    } else if (!states.at(type) && !restore_evicted(type)) {
+      //the state was evicted and could not be reloaded
+      return;
     }
 
     //set player if previous and next states are tilemaps
@@ -182,15 +389,16 @@ namespace state {
 
     //set the current state
     current_state = type;
+
+    recency.touch(current_state);
+    enforce_budget();
   }
 
   /**
-   * Handle some keypress event
+   * Handle some keypress event (state locked)
    * @param e the keypress event
    */
   void state_manager_t::handle_event(const SDL_Event& e) {
-    std::unique_lock<std::shared_mutex> state_lock(lock);
-
     if (this->paused) {
       pause_state->handle_event(e);
     } else {
@@ -231,7 +439,9 @@ namespace state {
 
     } else {
       states.push_back(std::move(s));
+      recency.add();
     }
+    count_loaded();
   }
 
   /**
@@ -282,10 +492,19 @@ namespace state {
     //get a blocking lock on the state
     std::unique_lock<std::shared_mutex> state_lock(lock);
 
+    //apply input received since the last update (even when paused)
+    input.drain([this](const SDL_Event& e) {
+      this->handle_event(e);
+      input::record_latency(e);
+    });
+
     if (!this->paused) {
       //update the state
-      states.at(current_state)->update();
+      states.at(current_state)->update(tick_arena.get());
     }
+
+    //release everything allocated this tick
+    tick_arena.reset();
   }
 
   /**
@@ -298,6 +517,12 @@ namespace state {
     //lock the state
     std::unique_lock<std::shared_mutex> state_lock(lock);
 
+    //change state if a handler asked to (loads textures)
+    this->apply_requested();
+
+    //make and free textures the last update asked for
+    states.at(current_state)->sync(renderer);
+
     //render the state
     states.at(current_state)->render(renderer, debug);
 
@@ -310,15 +535,44 @@ namespace state {
    * Render any debug info
    * @param renderer sdl renderer
    * @param font     loaded ttf font
+   * @param scale    the overlay scale
    */
   void state_manager_t::render_debug_info(SDL_Renderer& renderer,
-                                           TTF_Font& font) {
+                                           TTF_Font& font,
+                                           int scale) {
 
     //lock the state
     std::unique_lock<std::shared_mutex> state_lock(lock);
 
     if (!this->paused) {
-      states.at(current_state)->render_debug_info(renderer,font);
+      states.at(current_state)->render_debug_info(renderer,font,scale);
+    }
+
+    //texture memory by category
+    int y = DEBUG_MEM_Y;
+    for (const auto& total : accounting::category_totals()) {
+      utils::render_text(renderer,
+                         total.first + ": " + std::to_string(total.second / 1024) + "K",
+                         0, y, font, scale);
+      y += DEBUG_LINE_H;
+    }
+
+    //object counts for the active level (below the categories)
+    y += DEBUG_LINE_H;
+    for (const auto& count : accounting::object_counts()) {
+      utils::render_text(renderer,
+                         count.first + ": " + std::to_string(count.second),
+                         0, y, font, scale);
+      y += DEBUG_LINE_H;
+    }
+
+    //texture memory by owning level
+    y = DEBUG_MEM_Y;
+    for (const auto& total : accounting::owner_totals()) {
+      utils::render_text(renderer,
+                         total.first + ": " + std::to_string(total.second / 1024) + "K",
+                         DEBUG_MEM_OWNER_X, y, font, scale);
+      y += DEBUG_LINE_H;
     }
   }
 }}
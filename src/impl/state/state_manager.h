@@ -12,8 +12,15 @@
 #include <SDL2/SDL_ttf.h>
 #include <memory>
 #include <vector>
+#include <unordered_map>
 #include <shared_mutex>
+#include <mutex>
+#include <json/nlohmann_json.h>
 #include "state.h"
+#include "../metrics.h"
+#include "../arena.h"
+#include "../input.h"
+#include "recency.h"
 
 namespace impl {
 namespace state {
@@ -71,6 +78,85 @@ namespace state {
     //the window scale
     int window_scale;
 
+    //the memory budget for resident tilemap states (bytes)
+    size_t memory_budget;
+    //when each state was last entered
+    recency_t recency;
+    //changes saved for evicted states (by state index)
+    std::unordered_map<size_t, nlohmann::json> evicted;
+
+    //the world seed (all generation is derived from this)
+    uint64_t world_seed;
+
+    //the number of procedural maps generated so far
+    uint64_t swamps_generated;
+
+    //whether generated maps stream in chunks
+    bool proc_streaming;
+
+    //resident states and evictions so far (metrics)
+    metrics::gauge_t& states_loaded;
+    metrics::counter_t& states_evicted;
+
+    //memory for data that only lives for one tick (reset after each update)
+    arena::tick_arena_t tick_arena;
+
+    //events from the render thread (applied at the start of each update)
+    input::queue_t input;
+
+    //a state change asked for by a handler, made by the next render
+    //(loading and freeing states creates and destroys textures,
+    //the last request in a tick wins)
+    enum {
+      CHANGE_NONE, CHANGE_STATE, CHANGE_NEW_SWAMP, CHANGE_RELOAD
+    } requested;
+    size_t requested_state;
+
+    /**
+     * Handle some keypress event (state locked)
+     * @param e the keypress event
+     */
+    void handle_event(const SDL_Event& e);
+
+    /**
+     * Make the state change requested (render thread, state locked)
+     */
+    void apply_requested();
+
+    /**
+     * Set the current level state now
+     * @param type the state type
+     */
+    void apply_set_state(size_t type);
+
+    /**
+     * Generate a new procedural map now
+     */
+    void apply_new_swamp();
+
+    /**
+     * Reload the resources for the current map now
+     */
+    void apply_rsrc_reload();
+
+    /**
+     * Publish the number of resident states
+     */
+    void count_loaded() const;
+
+    /**
+     * Evict least recently used inactive tilemap states until
+     * the resident states fit in the memory budget
+     */
+    void enforce_budget();
+
+    /**
+     * Reload a state that was evicted and restore its saved changes
+     * @param idx the state index
+     * @return whether the state was restored
+     */
+    bool restore_evicted(size_t idx);
+
   public:
     /**
      * Constructor
@@ -94,15 +180,36 @@ namespace state {
      */
     bool is_debug() const { return debug; }
 
+    /**
+     * Set the memory budget for resident tilemap states
+     * (inactive states are evicted when this is exceeded)
+     * @param bytes the budget in bytes
+     */
+    void set_memory_budget(size_t bytes);
+
+    /**
+     * Set the world seed
+     * (the same seed produces the same levels and generated maps)
+     * @param seed the world seed
+     */
+    void set_seed(uint64_t seed);
+
+    /**
+     * Set whether generated maps stream in chunks as the
+     * player moves (instead of a fixed width map)
+     * @param streaming whether to stream
+     */
+    void set_proc_streaming(bool streaming);
+
     /**
      * Reload the resources from configuration for the current map
      * Note: this should be called by the pause menu
-     * (Note: this keeps the player in the same place)
+     * (Note: this keeps the player in the same place, made by the next render)
      */
     void rsrc_reload();
 
     /**
-     * Generate a new procedural map
+     * Generate a new procedural map (made by the next render)
      */
     void new_swamp();
 
@@ -118,16 +225,17 @@ namespace state {
     int get_window_scale() const { return window_scale; }
 
     /**
-     * Set the current level state
-     * @param name the state type
+     * Set the current level state (made by the next render)
+     * @param type the state type
      */
     void set_state(size_t type);
 
     /**
-     * Handle some keypress event
-     * @param e the keypress event
+     * Get the queue input events are posted to
+     * (render thread, events are handled by the next update)
+     * @return the queue
      */
-    void handle_event(const SDL_Event& e);
+    input::queue_t& get_input() { return input; }
 
     /**
      * Add a state to the manager
@@ -183,8 +291,9 @@ namespace state {
      * Render any debug info
      * @param renderer sdl renderer
      * @param font     loaded ttf font
+     * @param scale    the overlay scale
      */
-    void render_debug_info(SDL_Renderer& renderer, TTF_Font& font);
+    void render_debug_info(SDL_Renderer& renderer, TTF_Font& font, int scale);
   };
 }}
 
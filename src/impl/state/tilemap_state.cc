@@ -9,10 +9,20 @@
 #include "../utils.h"
 #include <iostream>
 #include "../environment/procedural_elem.h"
+#include "../logger.h"
+#include "../draw.h"
+#include "../metrics.h"
+#include "../alloc.h"
+#include <algorithm>
 
 namespace impl {
 namespace state {
 
+  //rough per object memory estimates (mostly textures)
+  #define ENTITY_FOOTPRINT_EST 65536
+  #define ENV_ELEM_FOOTPRINT_EST 16384
+  #define ITEM_FOOTPRINT_EST 1024
+
   /**
    * Constructor
    * @param tilemap    the tilemap this state uses
@@ -39,19 +49,28 @@ namespace state {
                                    const std::string& cfg_name,
                                    bool procedural)
     : state_t(manager, camera),
+      level_arena(),
       tilemap(tilemap),
       entities(entities),
       player_idx(player_idx),
       insects(insects),
       env(env),
-      level_items(level_items),
-      trans_blocks(trans_blocks),
-      forks(forks),
+      level_items(),
+      loaded_items(),
+      tilemap_footprint(tilemap->get_footprint()),
+      trans_blocks(),
+      forks(),
       show_bars(false),
       player_health_bar(5,120,50,1000,255,0,0),
       reticle(std::make_unique<entity::reticle_t>(manager.get_window_scale())),
       cfg_name(cfg_name),
-      procedural(procedural)  {
+      procedural(procedural),
+      regioned(NULL),
+      region_loader(),
+      region_objs(),
+      regions_pending(),
+      regions_retired(),
+      region_changes(json::object())  {
     //sanity check
     if (player_idx >= (int) entities.size()) {
       throw exceptions::rsrc_exception_t("not enough entities found in list");
@@ -64,13 +83,260 @@ namespace state {
     if (!player) {
       throw exceptions::rsrc_exception_t("player idx in entity list does not refer to player type");
     }
+
+    //register level objects
+    for (size_t i=0; i<level_items.size(); i++) {
+      loaded_items.push_back(this->level_items.add(level_items.at(i)));
+    }
+    for (size_t i=0; i<trans_blocks.size(); i++) {
+      this->trans_blocks.add(trans_blocks.at(i));
+    }
+    for (size_t i=0; i<forks.size(); i++) {
+      this->forks.add(forks.at(i));
+    }
+  }
+
+  /**
+   * Get the approximate memory footprint of this state
+   * (tilemap textures and tiles plus an estimate per object)
+   * @return the footprint in bytes
+   */
+  size_t tilemap_state_t::get_footprint() const {
+    return tilemap_footprint +
+           (entities.size() * ENTITY_FOOTPRINT_EST) +
+           (env->size() * ENV_ELEM_FOOTPRINT_EST) +
+           (level_items.size() * ITEM_FOOTPRINT_EST);
+  }
+
+  /**
+   * Save the changes the player has made to this level
+   * (felled trees, moved pushables, items taken)
+   * @return the changes
+   */
+  json tilemap_state_t::save_changes() const {
+    json env_changes = json::array();
+    //elements of a split level are saved by region
+    if (!regioned) {
+      env->save_changes(env_changes);
+    }
+
+    //items are identified by load order
+    json taken = json::array();
+    for (size_t i=0; i<loaded_items.size(); i++) {
+      const items::item_t *item = level_items.get(loaded_items.at(i));
+      if ((item == NULL) || item->is_picked_up()) {
+        taken.push_back(i);
+      }
+    }
+
+    json changes = {{"env", env_changes}, {"taken_items", taken}};
+
+    if (regioned) {
+      //paged out regions plus the resident ones
+      json regions = region_changes;
+      for (auto it=region_objs.begin(); it!=region_objs.end(); it++) {
+        regions[std::to_string(it->first)] = save_region(it->second);
+      }
+      changes["regions"] = regions;
+    }
+    return changes;
+  }
+
+  /**
+   * Restore changes written by save_changes to a freshly loaded level
+   * @param j the saved changes
+   */
+  void tilemap_state_t::restore_changes(const json& j) {
+    env->restore_changes(j.at("env"));
+
+    for (const json& idx_json : j.at("taken_items")) {
+      size_t idx = idx_json.get<size_t>();
+
+      if (idx < loaded_items.size()) {
+        //remove the item from the level (the player already holds it)
+        level_items.remove(loaded_items.at(idx));
+      }
+    }
+
+    if (j.contains("regions")) {
+      //applied to regions as they page in
+      region_changes = j.at("regions");
+
+      for (auto it=region_objs.begin(); it!=region_objs.end(); it++) {
+        std::string key = std::to_string(it->first);
+        if (region_changes.contains(key)) {
+          restore_region(it->second, region_changes.at(key));
+        }
+      }
+    }
+  }
+
+  /**
+   * Set the loader for objects anchored in regions
+   * (only used if the tilemap is split into regions)
+   * @param loader the loader
+   */
+  void tilemap_state_t::set_region_loader(region_loader_t loader) {
+    regioned = dynamic_cast<tilemap::tilemap_t*>(tilemap.get());
+    region_loader = loader;
+  }
+
+  /**
+   * Take the arena the level's objects were allocated from
+   * (released with this state)
+   * @param level_arena the arena
+   */
+  void tilemap_state_t::set_level_arena(std::unique_ptr<arena::level_arena_t> level_arena) {
+    this->level_arena = std::move(level_arena);
+  }
+
+  /**
+   * Save the changes the player has made to the objects in a region
+   * @param  objs the region objects
+   * @return      the changes
+   */
+  json tilemap_state_t::save_region(const region_objs_t& objs) const {
+    json env_changes = json::array();
+    for (size_t i=0; i<objs.env.size(); i++) {
+      json elem;
+      if (objs.env.at(i)->save_changes(elem)) {
+        env_changes.push_back({{"idx", i}, {"changes", elem}});
+      }
+    }
+
+    //items are identified by load order in the region
+    json taken = json::array();
+    for (size_t i=0; i<objs.items.size(); i++) {
+      if (!objs.items.at(i) || objs.items.at(i)->is_picked_up()) {
+        taken.push_back(i);
+      }
+    }
+
+    return {{"env", env_changes}, {"taken_items", taken}};
+  }
+
+  /**
+   * Restore changes written by save_region
+   * @param objs the region objects (freshly loaded)
+   * @param j    the saved changes
+   */
+  void tilemap_state_t::restore_region(region_objs_t& objs, const json& j) {
+    for (const json& elem : j.at("env")) {
+      size_t idx = elem.at("idx").get<size_t>();
+
+      //the cfg may have changed since the changes were saved
+      if (idx < objs.env.size()) {
+        objs.env.at(idx)->restore_changes(elem.at("changes"));
+      }
+    }
+
+    for (const json& idx_json : j.at("taken_items")) {
+      size_t idx = idx_json.get<size_t>();
+      if (idx < objs.items.size()) {
+        objs.items.at(idx) = nullptr;
+      }
+    }
+  }
+
+  /**
+   * Remove the objects anchored in regions the tilemap paged out
+   * and queue the regions it paged in (loaded by sync)
+   */
+  void tilemap_state_t::page_objects() {
+    std::vector<int> paged_in, paged_out;
+    regioned->take_region_changes(paged_in, paged_out);
+
+    for (int r : paged_out) {
+      //paged out before its objects were loaded
+      regions_pending.erase(std::remove(regions_pending.begin(), regions_pending.end(), r),
+                            regions_pending.end());
+
+      auto it = region_objs.find(r);
+      if (it == region_objs.end()) {
+        continue;
+      }
+      region_objs_t& objs = it->second;
+
+      //keep the changes for when the region comes back
+      region_changes[std::to_string(r)] = save_region(objs);
+
+      env->remove(objs.env);
+
+      //items the player is holding stay
+      for (size_t i=0; i<objs.item_handles.size(); i++) {
+        const items::item_t *item = level_items.get(objs.item_handles.at(i));
+        if ((item != NULL) && !item->is_picked_up()) {
+          level_items.remove(objs.item_handles.at(i));
+        }
+      }
+
+      for (size_t i=0; i<objs.tblock_handles.size(); i++) {
+        trans_blocks.remove(objs.tblock_handles.at(i));
+      }
+
+      //the last references, released on the render thread
+      regions_retired.push_back(std::move(objs));
+      region_objs.erase(it);
+    }
+
+    for (int r : paged_in) {
+      if (std::find(regions_pending.begin(), regions_pending.end(), r) == regions_pending.end()) {
+        regions_pending.push_back(r);
+      }
+    }
+  }
+
+  /**
+   * Load the objects in regions paged in and free the ones paged out
+   * (render thread, textures are made and destroyed here)
+   * @param renderer the renderer
+   */
+  void tilemap_state_t::sync(SDL_Renderer& renderer) {
+    if (regions_retired.empty() && regions_pending.empty()) {
+      return;
+    }
+
+    alloc::steady_scope_t loading(false);
+    alloc::zone_t zone("regions");
+
+    //free objects of regions paged out
+    regions_retired.clear();
+
+    for (size_t p=0; p<regions_pending.size(); p++) {
+      int r = regions_pending.at(p);
+      region_objs_t& objs = region_objs[r];
+
+      try {
+        region_loader(r, objs, renderer);
+      } catch (exceptions::rsrc_exception_t& e) {
+        logger::log_lazy(LOG_ERR, [&]() {
+          return "failed to load region " + std::to_string(r) + " objects: " + e.trace();
+        });
+      }
+
+      std::string key = std::to_string(r);
+      if (region_changes.contains(key)) {
+        restore_region(objs, region_changes.at(key));
+      }
+
+      env->add(objs.env);
+      for (size_t i=0; i<objs.items.size(); i++) {
+        if (objs.items.at(i)) {
+          objs.item_handles.push_back(level_items.add(objs.items.at(i)));
+        }
+      }
+      for (size_t i=0; i<objs.tblocks.size(); i++) {
+        objs.tblock_handles.push_back(trans_blocks.add(objs.tblocks.at(i)));
+      }
+    }
+    regions_pending.clear();
   }
 
   /**
    * Set the player
    * @param player the player to add to state
    */
-  void tilemap_state_t::set_player(std::shared_ptr<entity::player_t> player) {
+  void tilemap_state_t::set_player(const std::shared_ptr<entity::player_t>& player) {
     this->player = player;
 
     //update the player in the entities list
@@ -156,19 +422,19 @@ namespace state {
 
     if (use_fork) {
       //update map forks
-      for (size_t i=0; i<forks.size(); i++) {
-        if (forks.at(i)->can_interact()) {
+      forks.for_each([this](handles::handle_t, misc::map_fork_t& fork) {
+        if (fork.can_interact()) {
           //set the player position
           int target_x;
           int target_y;
-          forks.at(i)->get_target(target_x, target_y);
+          fork.get_target(target_x, target_y);
           //set the player position
           player->set_position(target_x, target_y);
 
           //change the current state
-          manager.set_state(forks.at(i)->get_dest());
+          manager.set_state(fork.get_dest());
         }
-      }
+      });
     }
 
     //interact with the environment
@@ -200,13 +466,33 @@ namespace state {
 
   /**
    * Update this tile
+   * @param tick memory for data that only lives for this tick
    */
-  void tilemap_state_t::update() {
-    //update tilemap
-    tilemap->update();
+  void tilemap_state_t::update(std::pmr::memory_resource& tick) {
+    //allocations are reported in steady state (except loading)
+    alloc::steady_scope_t steady;
+    alloc::zone_t zone("tilemap");
+
+    {
+      alloc::steady_scope_t loading(false);
+
+      //update tilemap
+      tilemap->update();
+      //streamed maps grow and shrink as chunks load
+      tilemap_footprint = tilemap->get_footprint();
+
+      //remove objects anchored in regions paged out (and queue those paged in)
+      if (regioned && region_loader) {
+        zone.enter("regions");
+        this->page_objects();
+      }
+    }
+
+    zone.enter("entities");
 
     //generate the positions of all entities
-    std::vector<impl::entity::entity_pos_t> e_positions;
+    impl::entity::entity_positions_t e_positions(&tick);
+    e_positions.reserve(entities.size());
     int e_pos_x,e_pos_y;
     //generate entity position vector
     for (size_t i=0; i<entities.size(); i++) {
@@ -266,44 +552,61 @@ namespace state {
     int px = player_bounds.x + (player_bounds.w / 2);
     int py = player_bounds.y + (player_bounds.h / 2);
 
+    zone.enter("blocks");
+
     //update transparent blocks
-    for (size_t i=0; i<trans_blocks.size(); i++) {
-      trans_blocks.at(i)->update(player_bounds);
-    }
+    trans_blocks.for_each([&player_bounds](handles::handle_t, tilemap::transparent_block_t& block) {
+      block.update(player_bounds);
+    });
+
+    zone.enter("forks");
 
     //update map forks
-    for (size_t i=0; i<forks.size(); i++) {
-      forks.at(i)->update(player_bounds);
-    }
+    forks.for_each([&player_bounds](handles::handle_t, misc::map_fork_t& fork) {
+      fork.update(player_bounds);
+    });
+
+    zone.enter("items");
 
     //update the items
-    for (size_t i=0; i<level_items.size(); i++) {
+    level_items.for_each([&](handles::handle_t h, items::item_t& item) {
       //check if the player can pick up the item
-      if (level_items.at(i)->is_collided(player_bounds)) {
+      if (item.is_collided(player_bounds)) {
         //pick up this item to the center of the player
-        level_items.at(i)->pick_up(px,py);
+        item.pick_up(px,py);
         //add this item to the player's inventory
-        player->add_item(level_items.at(i));
+        player->add_item(level_items.share(h));
       }
 
-      level_items.at(i)->update(*tilemap);
+      item.update(*tilemap);
 
       //if the item can be removed from the environment, do so
       //at this point the item is likely held by the player
-      if (level_items.at(i)->removable()) {
-        level_items.erase(level_items.begin() + i);
+      if (item.removable()) {
+        level_items.remove(h);
       }
-    }
+    });
 
     //update the insects
+    zone.enter("insects");
     insects->update();
 
     //update the environment and apply any damage
-    player->do_damage(env->update(player_bounds));
+    zone.enter("env");
+    player->do_damage(env->update(player_bounds, tick));
+    zone.enter("tilemap");
 
     //set the player health bar level
     player_health_bar.set_val(player->get_health());
 
+    //object counts for the active level (environment and insects publish their own)
+    static metrics::gauge_t& entity_count = metrics::gauge("entities");
+    static metrics::gauge_t& item_count = metrics::gauge("items");
+    static metrics::gauge_t& tilemap_bytes = metrics::gauge("tilemap_bytes");
+    entity_count.set(entities.size());
+    item_count.set(level_items.size());
+    tilemap_bytes.set(tilemap_footprint);
+
     //center the camera on the player
     int center_x, center_y;
     player->get_center(center_x,center_y);
@@ -342,44 +645,76 @@ namespace state {
    */
   void tilemap_state_t::render(SDL_Renderer& renderer, bool debug) const {
 
+    //allocations are reported in steady state
+    alloc::steady_scope_t steady;
+
     //determine which camera to use
     const SDL_Rect& camera = this->get_active_camera();
 
     //render background layer
-    tilemap->render_bg(renderer,camera,debug);
+    {
+      draw::pass_scope_t pass(renderer,"tilemap_bg");
+      tilemap->render_bg(renderer,camera,debug);
+    }
 
     //render the environment (background layers)
-    env->render_bg(renderer,camera,debug);
+    {
+      draw::pass_scope_t pass(renderer,"env_bg");
+      env->render_bg(renderer,camera,debug);
+    }
 
     //render entities
-    for (size_t i=0; i<entities.size(); i++) {
-      entities.at(i)->render(renderer,camera,debug);
+    {
+      draw::pass_scope_t pass(renderer,"entities");
+      for (size_t i=0; i<entities.size(); i++) {
+        entities.at(i)->render(renderer,camera,debug);
+      }
     }
 
     //render insect swarm
-    insects->render(renderer,camera,debug);
+    {
+      draw::pass_scope_t pass(renderer,"insects");
+      insects->render(renderer,camera,debug);
+    }
 
     //render the environment (foreground layers)
-    env->render(renderer,camera,debug);
+    {
+      draw::pass_scope_t pass(renderer,"env_fg");
+      env->render(renderer,camera,debug);
+    }
 
     //render items
-    for (size_t i=0; i<level_items.size(); i++) {
-      level_items.at(i)->render(renderer,camera,debug);
+    {
+      draw::pass_scope_t pass(renderer,"items");
+      level_items.for_each([&](handles::handle_t, const items::item_t& item) {
+        item.render(renderer,camera,debug);
+      });
     }
 
     //render foreground layer
-    tilemap->render_fg(renderer,camera,debug);
+    {
+      draw::pass_scope_t pass(renderer,"tilemap_fg");
+      tilemap->render_fg(renderer,camera,debug);
+    }
 
     //render transparent blocks
-    for (size_t i=0; i<trans_blocks.size(); i++) {
-      trans_blocks.at(i)->render(renderer,camera,debug);
+    {
+      draw::pass_scope_t pass(renderer,"blocks");
+      trans_blocks.for_each([&](handles::handle_t, const tilemap::transparent_block_t& block) {
+        block.render(renderer,camera,debug);
+      });
     }
 
     //render map forks
-    for (size_t i=0; i<forks.size(); i++) {
-      forks.at(i)->render(renderer,camera,debug);
+    {
+      draw::pass_scope_t pass(renderer,"forks");
+      forks.for_each([&](handles::handle_t, const misc::map_fork_t& fork) {
+        fork.render(renderer,camera,debug);
+      });
     }
 
+    draw::pass_scope_t pass(renderer,"hud");
+
     //render indicator bars on screen
     if (show_bars) {
       player_health_bar.render(renderer);
@@ -393,8 +728,9 @@ namespace state {
    * Render any debug info
    * @param renderer sdl renderer
    * @param font     loaded ttf font
+   * @param scale    the overlay scale
    */
-  void tilemap_state_t::render_debug_info(SDL_Renderer& renderer, TTF_Font& font) const {
+  void tilemap_state_t::render_debug_info(SDL_Renderer& renderer, TTF_Font& font, int scale) const {
     int center_x, center_y;
     player->get_center(center_x,center_y);
 
@@ -402,14 +738,14 @@ namespace state {
     const std::string player_position = std::to_string(center_x) + "," + std::to_string(center_y);
 
     //render text
-    utils::render_text(renderer,player_position,0,12,font);
+    utils::render_text(renderer,player_position,0,12,font,scale);
 
     int rx,ry;
     reticle->get_lvl_target(rx,ry,this->get_active_camera());
     const std::string reticle_position = std::to_string(rx) + "," + std::to_string(ry);
 
     //render the reticle position
-    utils::render_text(renderer,reticle_position,0,24,font);
+    utils::render_text(renderer,reticle_position,0,24,font,scale);
 
     std::string camera_state = "C L: ";
 
@@ -419,6 +755,6 @@ namespace state {
       camera_state += "on";
     }
     //render the reticle position
-    utils::render_text(renderer,camera_state,0,36,font);
+    utils::render_text(renderer,camera_state,0,36,font,scale);
   }
 }}
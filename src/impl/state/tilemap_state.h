@@ -13,7 +13,11 @@
 #include "state_manager.h"
 #include <memory>
 #include <vector>
+#include <map>
+#include <functional>
+#include <json/nlohmann_json.h>
 #include "../tilemap/abstract_tilemap.h"
+#include "../tilemap/tilemap.h"
 #include "../tilemap/transparent_block.h"
 #include "../entity/entity.h"
 #include "../entity/player.h"
@@ -23,15 +27,41 @@
 #include "../items/item.h"
 #include "../misc/map_fork.h"
 #include "../entity/reticle.h"
+#include "../arena.h"
+#include "../handles.h"
 
 namespace impl {
 namespace state {
 
+  typedef nlohmann::json json;
+
+  /**
+   * The objects anchored in one region of a split level
+   */
+  struct region_objs_t {
+    //environment elements
+    std::vector<std::shared_ptr<environment::renderable_t>> env;
+    //items in the order they were loaded (null if taken)
+    std::vector<std::shared_ptr<items::item_t>> items;
+    //transparent blocks
+    std::vector<std::shared_ptr<tilemap::transparent_block_t>> tblocks;
+
+    //the handles of the items and blocks in the level registries (while resident)
+    std::vector<handles::handle_t> item_handles;
+    std::vector<handles::handle_t> tblock_handles;
+  };
+
+  //loads the objects anchored in a region (by region index, render thread)
+  typedef std::function<void(int, region_objs_t&, SDL_Renderer&)> region_loader_t;
+
   /**
    * The main tilemap state
    */
   struct tilemap_state_t : public state_t {
   private:
+    //memory for the level's objects (declared first so it is released last)
+    std::unique_ptr<arena::level_arena_t> level_arena;
+
     //the game tilemap
     std::shared_ptr<tilemap::abstract_tilemap_t> tilemap;
 
@@ -50,13 +80,17 @@ namespace state {
     std::shared_ptr<environment::environment_t> env;
 
     //items in the level
-    std::vector<std::shared_ptr<items::item_t>> level_items;
+    handles::registry_t<items::item_t> level_items;
+    //items in the order they were loaded (stale once taken)
+    std::vector<handles::handle_t> loaded_items;
+    //the tilemap footprint (refreshed each update for streamed maps)
+    size_t tilemap_footprint;
 
     //transparent blocks in the level
-    std::vector<std::shared_ptr<tilemap::transparent_block_t>> trans_blocks;
+    handles::registry_t<tilemap::transparent_block_t> trans_blocks;
 
     //forks in the map
-    std::vector<std::shared_ptr<misc::map_fork_t>> forks;
+    handles::registry_t<misc::map_fork_t> forks;
 
     //whether indicator bars are visible
     bool show_bars;
@@ -72,6 +106,19 @@ namespace state {
     //whether this map was generated procedurally
     bool procedural;
 
+    //the tilemap if it pages regions (null otherwise)
+    tilemap::tilemap_t *regioned;
+    //loads the objects anchored in a region
+    region_loader_t region_loader;
+    //objects in resident regions
+    std::map<int, region_objs_t> region_objs;
+    //regions paged in whose objects haven't been loaded yet
+    std::vector<int> regions_pending;
+    //objects of regions paged out (freed on the render thread)
+    std::vector<region_objs_t> regions_retired;
+    //changes to objects in regions that were paged out (by region)
+    json region_changes;
+
     /**
      * Check if a given bounding box is on solid ground
      * @param  bounds the bounding box
@@ -79,6 +126,26 @@ namespace state {
      */
     bool on_solid_ground(const SDL_Rect& bounds) const;
 
+    /**
+     * Remove the objects anchored in regions the tilemap paged out
+     * and queue the regions it paged in (loaded by sync)
+     */
+    void page_objects();
+
+    /**
+     * Save the changes the player has made to the objects in a region
+     * @param  objs the region objects
+     * @return      the changes
+     */
+    json save_region(const region_objs_t& objs) const;
+
+    /**
+     * Restore changes written by save_region
+     * @param objs the region objects (freshly loaded)
+     * @param j    the saved changes
+     */
+    void restore_region(region_objs_t& objs, const json& j);
+
   public:
     /**
      * Constructor
@@ -119,11 +186,45 @@ namespace state {
      */
     const std::string& get_cfg() const { return cfg_name; }
 
+    /**
+     * Get the approximate memory footprint of this state
+     * (tilemap textures and tiles plus an estimate per object)
+     * @return the footprint in bytes
+     */
+    size_t get_footprint() const;
+
+    /**
+     * Save the changes the player has made to this level
+     * (felled trees, moved pushables, items taken)
+     * @return the changes
+     */
+    json save_changes() const;
+
+    /**
+     * Restore changes written by save_changes to a freshly loaded level
+     * @param j the saved changes
+     */
+    void restore_changes(const json& j);
+
+    /**
+     * Set the loader for objects anchored in regions
+     * (only used if the tilemap is split into regions)
+     * @param loader the loader
+     */
+    void set_region_loader(region_loader_t loader);
+
+    /**
+     * Take the arena the level's objects were allocated from
+     * (released with this state)
+     * @param level_arena the arena
+     */
+    void set_level_arena(std::unique_ptr<arena::level_arena_t> level_arena);
+
     /**
      * Set the player
      * @param player the player to add to state
      */
-    void set_player(std::shared_ptr<entity::player_t> player);
+    void set_player(const std::shared_ptr<entity::player_t>& player);
 
     /**
      * Get the player
@@ -151,8 +252,16 @@ namespace state {
 
     /**
      * Update this tile
+     * @param tick memory for data that only lives for this tick
+     */
+    void update(std::pmr::memory_resource& tick);
+
+    /**
+     * Load the objects in regions paged in and free the ones paged out
+     * (render thread, textures are made and destroyed here)
+     * @param renderer the renderer
      */
-    void update();
+    void sync(SDL_Renderer& renderer);
 
     /**
      * Render the current gamestate
@@ -165,8 +274,9 @@ namespace state {
      * Render any debug info
      * @param renderer sdl renderer
      * @param font     loaded ttf font
+     * @param scale    the overlay scale
      */
-    void render_debug_info(SDL_Renderer& renderer, TTF_Font& font) const;
+    void render_debug_info(SDL_Renderer& renderer, TTF_Font& font, int scale) const;
   };
 }}
 
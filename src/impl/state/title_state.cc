@@ -5,8 +5,10 @@
  */
 
 #include "title_state.h"
+#include "../accounting.h"
 #include "../utils.h"
 #include "../exceptions.h"
+#include "../draw.h"
 
 namespace impl {
 namespace state {
@@ -75,19 +77,19 @@ namespace state {
   title_state_t::~title_state_t() {
     //destroy textures
     if (texture != NULL) {
-      SDL_DestroyTexture(texture);
+      accounting::free_texture(texture);
     }
     if (start_texture != NULL) {
-      SDL_DestroyTexture(start_texture);
+      accounting::free_texture(start_texture);
     }
     if (options_texture != NULL) {
-      SDL_DestroyTexture(options_texture);
+      accounting::free_texture(options_texture);
     }
     if (quit_texture != NULL) {
-      SDL_DestroyTexture(quit_texture);
+      accounting::free_texture(quit_texture);
     }
     if (caret_texture != NULL) {
-      SDL_DestroyTexture(caret_texture);
+      accounting::free_texture(caret_texture);
     }
   }
 
@@ -153,8 +155,9 @@ namespace state {
 
   /**
    * Update this tile
+   * @param tick memory for data that only lives for this tick
    */
-  void title_state_t::update() {
+  void title_state_t::update(std::pmr::memory_resource& /*tick*/) {
 
   }
 
@@ -168,10 +171,10 @@ namespace state {
     SDL_Rect image_bounds = {0,0,this->width, this->height};
 
     //render the background texture
-    SDL_RenderCopy(&renderer,
-                   this->texture,
-                   &image_bounds,
-                   &image_bounds);
+    draw::copy(&renderer,
+               this->texture,
+               &image_bounds,
+               &image_bounds);
 
     int x_offset = this->width / 6;
     int y_offset = this->height / 4;
@@ -183,10 +186,10 @@ namespace state {
                             text_w_start,text_h_start};
 
     //render the start texture
-    SDL_RenderCopy(&renderer,
-                   this->start_texture,
-                   &sample_bounds,
-                   &text_bounds);
+    draw::copy(&renderer,
+               this->start_texture,
+               &sample_bounds,
+               &text_bounds);
 
     //add vertical spacing
     y_offset += text_h_start;
@@ -197,10 +200,10 @@ namespace state {
                    text_w_options,text_h_options};
 
     //render the options texture
-    SDL_RenderCopy(&renderer,
-                  this->options_texture,
-                  &sample_bounds,
-                  &text_bounds);
+    draw::copy(&renderer,
+              this->options_texture,
+              &sample_bounds,
+              &text_bounds);
 
     //add vertical spacing
     y_offset += text_h_start;
@@ -211,10 +214,10 @@ namespace state {
                    text_w_quit,text_h_quit};
 
     //render the quit texture
-    SDL_RenderCopy(&renderer,
-                   this->quit_texture,
-                   &sample_bounds,
-                   &text_bounds);
+    draw::copy(&renderer,
+               this->quit_texture,
+               &sample_bounds,
+               &text_bounds);
 
     //compute caret coordinates based on selection
     int caret_offset_x = x_offset - caret_w;
@@ -233,9 +236,9 @@ namespace state {
                    caret_w,caret_h};
 
     //render the caret
-    SDL_RenderCopy(&renderer,
-                   this->caret_texture,
-                   &sample_bounds,
-                   &text_bounds);
+    draw::copy(&renderer,
+               this->caret_texture,
+               &sample_bounds,
+               &text_bounds);
   }
 }}
@@ -106,8 +106,9 @@ namespace state {
 
     /**
      * Update this tile
+     * @param tick memory for data that only lives for this tick
      */
-    void update();
+    void update(std::pmr::memory_resource& tick);
 
     /**
      * Render the current gamestate
@@ -0,0 +1,168 @@
+/*
+ * (C) 2021 Jack Hay
+ *
+ * Untitled Swamp game
+ */
+
+#include "text.h"
+#include "exceptions.h"
+#include "accounting.h"
+#include "draw.h"
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace impl {
+namespace text {
+
+  //open fonts by path and size
+  static std::map<std::pair<std::string, int>, TTF_Font*> fonts;
+
+  //glyph atlases by font
+  static std::map<TTF_Font*, std::unique_ptr<glyph_atlas_t>> atlases;
+
+  //fonts are opened while loading states (any thread)
+  static std::mutex lock;
+
+  /**
+   * Render each glyph once and pack them
+   * @param renderer the renderer
+   * @param font     the font
+   */
+  glyph_atlas_t::glyph_atlas_t(SDL_Renderer& renderer, TTF_Font& font)
+    : atlas(GLYPH_PAGE_DIM, TEXTURE_FONT),
+      glyphs(),
+      height(TTF_FontHeight(&font)),
+      quads() {
+    //white glyphs, tinted when drawn
+    SDL_Color white = {255,255,255,255};
+
+    for (int c=GLYPH_FIRST; c<=GLYPH_LAST; c++) {
+      glyph_t glyph = {{-1, {0,0,0,0}}, 0};
+      char str[2] = {(char) c, '\0'};
+
+      //rendered as text so the glyph sits on the baseline
+      SDL_Surface *surface = TTF_RenderText_Solid(&font, str, white);
+      if (surface != NULL) {
+        glyph.advance = surface->w;
+        glyph.region = atlas.add(renderer, surface);
+      }
+
+      int minx, maxx, miny, maxy, advance;
+      if (TTF_GlyphMetrics(&font, c, &minx, &maxx, &miny, &maxy, &advance) == 0) {
+        glyph.advance = advance;
+      }
+      glyphs.push_back(glyph);
+    }
+  }
+
+  /**
+   * Lay out a line of text (unknown characters are skipped)
+   * @param text  the text
+   * @param quads the glyph copies (cleared and set by the call)
+   * @return      the width of the text
+   */
+  int glyph_atlas_t::layout(const std::string& text, std::vector<glyph_quad_t>& quads) const {
+    quads.clear();
+    int x = 0;
+
+    for (size_t i=0; i<text.size(); i++) {
+      int c = (unsigned char) text.at(i);
+      if ((c < GLYPH_FIRST) || (c > GLYPH_LAST)) {
+        continue;
+      }
+
+      const glyph_t& glyph = glyphs.at(c - GLYPH_FIRST);
+      if (glyph.region.page >= 0) {
+        const SDL_Rect& rect = glyph.region.rect;
+        quads.push_back({glyph.region.page, rect, {x, 0, rect.w, rect.h}});
+      }
+      x += glyph.advance;
+    }
+    return x;
+  }
+
+  /**
+   * Draw a line of text
+   * (consecutive copies from the same page are batched by sdl)
+   * @param renderer the renderer
+   * @param text     the text
+   * @param x        the position x
+   * @param y        the position y
+   * @param color    the text color
+   */
+  void glyph_atlas_t::draw(SDL_Renderer& renderer,
+                           const std::string& text,
+                           int x, int y,
+                           SDL_Color color) const {
+    layout(text, quads);
+
+    for (size_t p=0; p<atlas.get_page_count(); p++) {
+      SDL_SetTextureColorMod(atlas.get_texture(p), color.r, color.g, color.b);
+    }
+
+    for (size_t i=0; i<quads.size(); i++) {
+      const glyph_quad_t& quad = quads.at(i);
+      SDL_Rect dest = {x + quad.dest.x, y + quad.dest.y, quad.dest.w, quad.dest.h};
+      draw::copy(&renderer, atlas.get_texture(quad.page), &quad.sample, &dest);
+    }
+  }
+
+  /**
+   * Get a font, opened on first use and kept until clear
+   * Throws resource exception on failure
+   * @param  path the path to the font
+   * @param  size the point size
+   * @return      the font
+   */
+  TTF_Font& get_font(const std::string& path, int size) {
+    std::unique_lock<std::mutex> lk(lock);
+
+    auto it = fonts.find(std::make_pair(path, size));
+    if (it != fonts.end()) {
+      return *it->second;
+    }
+
+    TTF_Font *font = TTF_OpenFont(path.c_str(), size);
+    if (!font) {
+      //failed to load the font
+      throw exceptions::rsrc_exception_t(path,
+                                         "could not load font (" +
+                                         std::string(TTF_GetError()) + ")");
+    }
+
+    fonts[std::make_pair(path, size)] = font;
+    return *font;
+  }
+
+  /**
+   * Get the glyph atlas for a font, built on first use
+   * (render thread only)
+   * @param  renderer the renderer
+   * @param  font     the font
+   * @return          the glyph atlas
+   */
+  const glyph_atlas_t& get_glyphs(SDL_Renderer& renderer, TTF_Font& font) {
+    std::unique_lock<std::mutex> lk(lock);
+
+    std::unique_ptr<glyph_atlas_t>& glyphs = atlases[&font];
+    if (!glyphs) {
+      glyphs = std::make_unique<glyph_atlas_t>(renderer, font);
+    }
+    return *glyphs;
+  }
+
+  /**
+   * Free all glyph atlases and close all fonts
+   * (before the renderer is destroyed)
+   */
+  void clear() {
+    std::unique_lock<std::mutex> lk(lock);
+    atlases.clear();
+
+    for (auto it=fonts.begin(); it!=fonts.end(); it++) {
+      TTF_CloseFont(it->second);
+    }
+    fonts.clear();
+  }
+}}
@@ -0,0 +1,126 @@
+/*
+ * (C) 2021 Jack Hay
+ *
+ * Untitled Swamp game
+ */
+
+#ifndef _IO_JACKHAY_SWAMP_TEXT_H
+#define _IO_JACKHAY_SWAMP_TEXT_H
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include <string>
+#include <vector>
+#include "atlas.h"
+
+namespace impl {
+namespace text {
+
+  //the printable ascii range kept in a glyph atlas
+  #define GLYPH_FIRST 32
+  #define GLYPH_LAST 126
+
+  //glyph atlas page dimension
+  #define GLYPH_PAGE_DIM 512
+
+  /**
+   * A glyph copy (positions relative to the text origin)
+   */
+  struct glyph_quad_t {
+    int page;
+    SDL_Rect sample;
+    SDL_Rect dest;
+  };
+
+  /**
+   * The printable glyphs of a font packed into atlas pages so
+   * dynamic text is drawn without creating textures
+   * (render thread only)
+   */
+  struct glyph_atlas_t {
+  private:
+    /**
+     * A packed glyph
+     */
+    typedef struct glyph_t {
+      atlas::atlas_region_t region;
+      int advance;
+    } glyph_t;
+
+    //the glyph pages
+    atlas::atlas_t atlas;
+
+    //glyphs from GLYPH_FIRST
+    std::vector<glyph_t> glyphs;
+
+    //the line height
+    int height;
+
+    //reused between draws
+    mutable std::vector<glyph_quad_t> quads;
+
+  public:
+    /**
+     * Render each glyph once and pack them
+     * @param renderer the renderer
+     * @param font     the font
+     */
+    glyph_atlas_t(SDL_Renderer& renderer, TTF_Font& font);
+    glyph_atlas_t(const glyph_atlas_t&) = delete;
+    glyph_atlas_t& operator=(const glyph_atlas_t&) = delete;
+
+    /**
+     * Lay out a line of text (unknown characters are skipped)
+     * @param text  the text
+     * @param quads the glyph copies (cleared and set by the call)
+     * @return      the width of the text
+     */
+    int layout(const std::string& text, std::vector<glyph_quad_t>& quads) const;
+
+    /**
+     * Draw a line of text
+     * (consecutive copies from the same page are batched by sdl)
+     * @param renderer the renderer
+     * @param text     the text
+     * @param x        the position x
+     * @param y        the position y
+     * @param color    the text color
+     */
+    void draw(SDL_Renderer& renderer,
+              const std::string& text,
+              int x, int y,
+              SDL_Color color) const;
+
+    /**
+     * Get the line height
+     * @return the height in pixels
+     */
+    int get_height() const { return height; }
+  };
+
+  /**
+   * Get a font, opened on first use and kept until clear
+   * Throws resource exception on failure
+   * @param  path the path to the font
+   * @param  size the point size
+   * @return      the font
+   */
+  TTF_Font& get_font(const std::string& path, int size);
+
+  /**
+   * Get the glyph atlas for a font, built on first use
+   * (render thread only)
+   * @param  renderer the renderer
+   * @param  font     the font
+   * @return          the glyph atlas
+   */
+  const glyph_atlas_t& get_glyphs(SDL_Renderer& renderer, TTF_Font& font);
+
+  /**
+   * Free all glyph atlases and close all fonts
+   * (before the renderer is destroyed)
+   */
+  void clear();
+}}
+
+#endif /*_IO_JACKHAY_SWAMP_TEXT_H*/
@@ -60,6 +60,13 @@ namespace tilemap {
      */
     virtual int get_height() const = 0;
 
+    /**
+     * Get the approximate memory footprint of the map
+     * (texture bytes and tile storage)
+     * @return the footprint in bytes
+     */
+    virtual size_t get_footprint() const = 0;
+
     /**
      * Update any updatable tiles
      */
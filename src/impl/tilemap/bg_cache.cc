@@ -0,0 +1,241 @@
+/*
+ * (C) 2021 Jack Hay
+ *
+ * Untitled Swamp game
+ */
+
+#include "bg_cache.h"
+#include "../accounting.h"
+#include "../logger.h"
+#include "../draw.h"
+#include "../compositor.h"
+#include <cstdlib>
+#include <algorithm>
+
+namespace impl {
+namespace tilemap {
+
+  /**
+   * Get a position in the ring buffer
+   * @param  v   the world position
+   * @param  dim the buffer dimension
+   * @return     the buffer position
+   */
+  static int wrap(int v, int dim) {
+    return ((v % dim) + dim) % dim;
+  }
+
+  /**
+   * Split a world area where it wraps in the ring buffer
+   * @param  area   the world area (at most the buffer size)
+   * @param  w      the buffer width
+   * @param  h      the buffer height
+   * @param  pieces the pieces (set by the call)
+   * @return        the number of pieces (up to four)
+   */
+  static int split(const SDL_Rect& area, int w, int h, SDL_Rect pieces[4]) {
+    int first_w = std::min(area.w, w - wrap(area.x, w));
+    int first_h = std::min(area.h, h - wrap(area.y, h));
+
+    //the columns and rows either side of the wrap
+    SDL_Rect cols[2] = {{area.x, 0, first_w, 0},
+                        {area.x + first_w, 0, area.w - first_w, 0}};
+    SDL_Rect rows[2] = {{0, area.y, 0, first_h},
+                        {0, area.y + first_h, 0, area.h - first_h}};
+
+    int count = 0;
+    for (int r=0; r<2; r++) {
+      for (int c=0; c<2; c++) {
+        if ((cols[c].w > 0) && (rows[r].h > 0)) {
+          pieces[count++] = {cols[c].x, rows[r].y, cols[c].w, rows[r].h};
+        }
+      }
+    }
+    return count;
+  }
+
+  /**
+   * Constructor
+   */
+  bg_cache_t::bg_cache_t()
+    : texture(NULL),
+      w(0), h(0),
+      x(0), y(0),
+      valid(false),
+      version(0),
+      disabled(false) {}
+
+  /**
+   * Free the ring buffer
+   */
+  bg_cache_t::~bg_cache_t() {
+    if (texture != NULL) {
+      accounting::free_texture(texture);
+    }
+  }
+
+  /**
+   * Create the ring buffer for a camera size
+   * @param  renderer the renderer
+   * @param  camera   the camera
+   * @return          whether the buffer is usable
+   */
+  bool bg_cache_t::create(SDL_Renderer& renderer, const SDL_Rect& camera) {
+    if (texture != NULL) {
+      accounting::free_texture(texture);
+      texture = NULL;
+    }
+
+    w = camera.w + BG_CACHE_MARGIN;
+    h = camera.h + BG_CACHE_MARGIN;
+    valid = false;
+
+    //cpu frames draw the layers directly (no render targets)
+    if (SDL_RenderTargetSupported(&renderer) && (compositor::recording() == NULL)) {
+      texture = SDL_CreateTexture(&renderer,
+                                  SDL_PIXELFORMAT_RGBA32,
+                                  SDL_TEXTUREACCESS_TARGET,
+                                  w, h);
+    }
+
+    //layers blended into the cleared buffer leave premultiplied pixels
+    //(copying those with SDL_BLENDMODE_BLEND would apply alpha twice)
+    SDL_BlendMode premultiplied = SDL_ComposeCustomBlendMode(SDL_BLENDFACTOR_ONE,
+                                                             SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+                                                             SDL_BLENDOPERATION_ADD,
+                                                             SDL_BLENDFACTOR_ONE,
+                                                             SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+                                                             SDL_BLENDOPERATION_ADD);
+
+    if ((texture != NULL) && (SDL_SetTextureBlendMode(texture, premultiplied) != 0)) {
+      accounting::free_texture(texture);
+      texture = NULL;
+    }
+
+    if (texture == NULL) {
+      logger::log_info("background cache unavailable, drawing directly");
+      disabled = true;
+      return false;
+    }
+
+    accounting::track_texture(texture, TEXTURE_TARGET, w, h);
+    return true;
+  }
+
+  /**
+   * Redraw an area of the world into the ring buffer
+   * @param renderer the renderer (targeting the buffer)
+   * @param area     the world area (at most the buffer size)
+   * @param draw     draws the layers for a camera
+   */
+  void bg_cache_t::draw_area(SDL_Renderer& renderer,
+                             const SDL_Rect& area,
+                             const std::function<void(const SDL_Rect&)>& draw) {
+    SDL_Rect pieces[4];
+    int count = split(area, w, h, pieces);
+
+    SDL_BlendMode blend;
+    SDL_GetRenderDrawBlendMode(&renderer, &blend);
+
+    for (int i=0; i<count; i++) {
+      const SDL_Rect& piece = pieces[i];
+
+      //the viewport places the piece and clips draws to it
+      SDL_Rect port = {wrap(piece.x, w), wrap(piece.y, h), piece.w, piece.h};
+      SDL_RenderSetViewport(&renderer, &port);
+
+      //redraws are counted apart from the cached copy
+      draw::pass_scope_t pass(renderer, "bg_cache");
+
+      //clear what was here
+      SDL_Rect bounds = {0, 0, piece.w, piece.h};
+      SDL_SetRenderDrawBlendMode(&renderer, SDL_BLENDMODE_NONE);
+      SDL_SetRenderDrawColor(&renderer, 0, 0, 0, 0);
+      draw::fill_rect(&renderer, &bounds);
+      SDL_SetRenderDrawBlendMode(&renderer, blend);
+
+      draw(piece);
+    }
+  }
+
+  /**
+   * Render the cached layers, drawing any newly exposed area first
+   * @param renderer the renderer
+   * @param camera   the camera
+   * @param version  changes whenever the layers change (redraws everything)
+   * @param draw     draws the layers for a camera
+   */
+  void bg_cache_t::render(SDL_Renderer& renderer,
+                          const SDL_Rect& camera,
+                          int version,
+                          const std::function<void(const SDL_Rect&)>& draw) {
+    if (disabled ||
+        (((texture == NULL) || (w != camera.w + BG_CACHE_MARGIN) || (h != camera.h + BG_CACHE_MARGIN)) &&
+         !create(renderer, camera))) {
+      draw(camera);
+      return;
+    }
+
+    bool inside = (camera.x >= x) && ((camera.x + camera.w) <= (x + w)) &&
+                  (camera.y >= y) && ((camera.y + camera.h) <= (y + h));
+
+    if (!valid || (version != this->version) || !inside) {
+      SDL_Texture *prev = SDL_GetRenderTarget(&renderer);
+      SDL_SetRenderTarget(&renderer, texture);
+
+      //move the cached area past the camera by half the margin
+      int new_x = x;
+      int new_y = y;
+      if (camera.x < x) {
+        new_x = camera.x - (BG_CACHE_MARGIN / 2);
+      } else if ((camera.x + camera.w) > (x + w)) {
+        new_x = camera.x + camera.w + (BG_CACHE_MARGIN / 2) - w;
+      }
+      if (camera.y < y) {
+        new_y = camera.y - (BG_CACHE_MARGIN / 2);
+      } else if ((camera.y + camera.h) > (y + h)) {
+        new_y = camera.y + camera.h + (BG_CACHE_MARGIN / 2) - h;
+      }
+
+      if (!valid || (version != this->version) ||
+          (std::abs(new_x - x) >= w) || (std::abs(new_y - y) >= h)) {
+        //nothing reusable: center on the camera
+        x = camera.x - (BG_CACHE_MARGIN / 2);
+        y = camera.y - (BG_CACHE_MARGIN / 2);
+        draw_area(renderer, {x, y, w, h}, draw);
+
+      } else {
+        //columns exposed
+        if (new_x > x) {
+          draw_area(renderer, {x + w, new_y, new_x - x, h}, draw);
+        } else if (new_x < x) {
+          draw_area(renderer, {new_x, new_y, x - new_x, h}, draw);
+        }
+        //rows exposed
+        if (new_y > y) {
+          draw_area(renderer, {new_x, y + h, w, new_y - y}, draw);
+        } else if (new_y < y) {
+          draw_area(renderer, {new_x, new_y, w, y - new_y}, draw);
+        }
+        x = new_x;
+        y = new_y;
+      }
+
+      valid = true;
+      this->version = version;
+
+      //resets the viewport
+      SDL_SetRenderTarget(&renderer, prev);
+    }
+
+    //copy the camera area (wrapped pieces)
+    SDL_Rect pieces[4];
+    int count = split(camera, w, h, pieces);
+    for (int i=0; i<count; i++) {
+      const SDL_Rect& piece = pieces[i];
+      SDL_Rect sample = {wrap(piece.x, w), wrap(piece.y, h), piece.w, piece.h};
+      SDL_Rect dest = {piece.x - camera.x, piece.y - camera.y, piece.w, piece.h};
+      draw::copy(&renderer, texture, &sample, &dest);
+    }
+  }
+}}
@@ -0,0 +1,95 @@
+/*
+ * (C) 2021 Jack Hay
+ *
+ * Untitled Swamp game
+ */
+
+#ifndef _IO_JACKHAY_SWAMP_TILEMAP_BG_CACHE_H
+#define _IO_JACKHAY_SWAMP_TILEMAP_BG_CACHE_H
+
+#include <SDL2/SDL.h>
+#include <functional>
+
+namespace impl {
+namespace tilemap {
+
+  //extra pixels cached around the camera (each axis)
+  #define BG_CACHE_MARGIN 64
+
+  /**
+   * Caches static background layers around the camera in a ring buffer
+   * texture. Only the strip exposed by scrolling is redrawn and the
+   * cached area is copied to the screen in up to four pieces
+   * (the buffer holds premultiplied pixels and is copied with a
+   * premultiplied blend, so translucent layer pixels match drawing
+   * directly)
+   * (layers must be fixed to the world, render thread only)
+   */
+  struct bg_cache_t {
+  private:
+    //the ring buffer (NULL until the first render)
+    SDL_Texture *texture;
+
+    //the ring buffer size
+    int w;
+    int h;
+
+    //the world position of the cached area (wraps at w and h in the texture)
+    int x;
+    int y;
+
+    //whether the cached area has been drawn
+    bool valid;
+
+    //the version of the layers drawn
+    int version;
+
+    //whether render targets or premultiplied copies are unavailable (draw directly)
+    bool disabled;
+
+    /**
+     * Create the ring buffer for a camera size
+     * @param  renderer the renderer
+     * @param  camera   the camera
+     * @return          whether the buffer is usable
+     */
+    bool create(SDL_Renderer& renderer, const SDL_Rect& camera);
+
+    /**
+     * Redraw an area of the world into the ring buffer
+     * @param renderer the renderer (targeting the buffer)
+     * @param area     the world area (at most the buffer size)
+     * @param draw     draws the layers for a camera
+     */
+    void draw_area(SDL_Renderer& renderer,
+                   const SDL_Rect& area,
+                   const std::function<void(const SDL_Rect&)>& draw);
+
+  public:
+    /**
+     * Constructor
+     */
+    bg_cache_t();
+    bg_cache_t(const bg_cache_t&) = delete;
+    bg_cache_t& operator=(const bg_cache_t&) = delete;
+
+    /**
+     * Free the ring buffer
+     */
+    ~bg_cache_t();
+
+    /**
+     * Render the cached layers, drawing any newly exposed area first
+     * @param renderer the renderer
+     * @param camera   the camera
+     * @param version  changes whenever the layers change (redraws everything)
+     * @param draw     draws the layers for a camera
+     */
+    void render(SDL_Renderer& renderer,
+                const SDL_Rect& camera,
+                int version,
+                const std::function<void(const SDL_Rect&)>& draw);
+  };
+}}
+
+#endif /*_IO_JACKHAY_SWAMP_TILEMAP_BG_CACHE_H*/
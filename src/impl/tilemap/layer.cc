@@ -6,6 +6,7 @@
 
 #include "layer.h"
 #include "../exceptions.h"
+#include "../arena.h"
 #include <fstream>
 #include <sstream>
 #include <algorithm>
@@ -21,24 +22,26 @@ namespace tilemap {
    * @param dim       the tile dimension
    * @param tileset   the tileset that this map is associated with
    * @param stationary whether this layer is stationary
+   * @param col_offset the map column of the first column in the file
    */
   layer_t::layer_t(const std::string& rsrc_path,
                    int dim,
                    std::shared_ptr<tilemap::tileset_t> tileset,
-                   bool stationary)
-    : tileset(tileset), dim(dim), stationary(stationary)  {
+                   bool stationary,
+                   int col_offset)
+    : tileset(tileset), dim(dim), stationary(stationary), col_offset(col_offset)  {
 
     try {
       //read from the file
       std::ifstream layer_file(rsrc_path);
       int y = 0;
 
-      std::shared_ptr<tile_t> blank = std::make_shared<tile_t>(-1,-1,dim,-1);
+      std::shared_ptr<tile_t> blank = arena::make_level<tile_t>(-1,-1,dim,-1);
 
       //read each line of tiles
       std::string line;
       while (std::getline(layer_file, line)) {
-        int x = 0;
+        int x = col_offset;
         //split line by commas
         this->contents.emplace_back();
         std::stringstream s_stream(line);
@@ -54,7 +57,7 @@ namespace tilemap {
 
              if (type != -1) {
                //add the tile to the map contents
-               this->contents.back().push_back(std::make_shared<tile_t>(x,y,dim,type));
+               this->contents.back().push_back(arena::make_level<tile_t>(x,y,dim,type));
              } else {
                this->contents.back().push_back(blank);
              }
@@ -76,7 +79,7 @@ namespace tilemap {
    * @return   whether the position is in bounds
    */
   bool layer_t::in_bounds(int x, int y) const {
-    int idx_x = x / dim;
+    int idx_x = (x / dim) - col_offset;
     int idx_y = y / dim;
 
     //check bounds and get the type of the tile
@@ -90,7 +93,7 @@ namespace tilemap {
    * @return   the tile at that position
    */
   const tile_t& layer_t::get_tile(int x, int y) const {
-    return *this->contents.at(y / dim).at(x / dim);
+    return *this->contents.at(y / dim).at((x / dim) - col_offset);
   }
 
   /**
@@ -164,6 +167,20 @@ namespace tilemap {
     return max_row;
   }
 
+  /**
+   * Get the approximate size of the tiles in this layer
+   * (does not include the shared tileset)
+   * @return the tile storage size in bytes
+   */
+  size_t layer_t::get_footprint() const {
+    size_t total = 0;
+
+    for (size_t i=0; i<this->contents.size(); i++) {
+      total += this->contents.at(i).size() * (sizeof(tile_t) + sizeof(std::shared_ptr<tile_t>));
+    }
+    return total + (updatable.size() * sizeof(update_tile_t));
+  }
+
   /**
    * Set tiles in this layer to be solid/liquid if their indices
    * are in the list provided
@@ -233,6 +250,25 @@ namespace tilemap {
     return false;
   }
 
+  /**
+   * Hide tiles covered by opaque tiles in a layer drawn in front
+   * of this one (same tileset and column offset)
+   * @param front the layer in front
+   */
+  void layer_t::hide_covered(const layer_t& front) {
+    for (size_t i=0; (i<this->contents.size()) && (i<front.contents.size()); i++) {
+      for (size_t j=0; (j<this->contents.at(i).size()) && (j<front.contents.at(i).size()); j++) {
+        tile_t& t = *this->contents.at(i).at(j);
+
+        //blank tiles are shared
+        if ((t.get_type() != -1) &&
+            this->tileset->is_opaque(front.contents.at(i).at(j)->get_type())) {
+          t.set_hidden(true);
+        }
+      }
+    }
+  }
+
   /**
    * Update any animated layers
    */
@@ -252,10 +288,20 @@ namespace tilemap {
   void layer_t::render(SDL_Renderer& renderer,
                        const SDL_Rect& camera,
                        bool debug) const {
+    //single colour runs are drawn as one fill (not for the backdrop)
+    fill_run_t run(renderer);
+
     //render each tile
-    this->for_each_const([&renderer,&camera,this, debug](tile_t& t){
-      //render the tile
-      t.render(renderer,camera,this->tileset, this->stationary, debug);
-    });
+    for (size_t i=0; i<this->contents.size(); i++) {
+      for (size_t j=0; j<this->contents.at(i).size(); j++) {
+        const tile_t& t = *this->contents.at(i).at(j);
+
+        if (this->stationary || debug || !run.add(t, *this->tileset, camera)) {
+          //render the tile
+          t.render(renderer,camera,*tileset, this->stationary, debug);
+        }
+      }
+    }
+    run.flush();
   }
 }}
@@ -39,6 +39,10 @@ namespace tilemap {
     //whether this layer is stationary (serving as a backdrop)
     bool stationary;
 
+    //the map column of the first column in this layer
+    //(non zero for a region of a larger map)
+    int col_offset;
+
     /**
      * Do some function on each tile
      */
@@ -68,11 +72,13 @@ namespace tilemap {
      * @param dim       the tile dimension
      * @param tileset   the tileset that this map is associated with
      * @param stationary whether this layer is stationary
+     * @param col_offset the map column of the first column in the file
      */
     layer_t(const std::string& rsrc_path,
             int dim,
             std::shared_ptr<tilemap::tileset_t> tileset,
-            bool stationary);
+            bool stationary,
+            int col_offset=0);
     layer_t(const layer_t&) = delete;
     layer_t& operator=(const layer_t&) = delete;
 
@@ -104,6 +110,25 @@ namespace tilemap {
      */
     int get_layer_cols() const;
 
+    /**
+     * Get the approximate size of the tiles in this layer
+     * (does not include the shared tileset)
+     * @return the tile storage size in bytes
+     */
+    size_t get_footprint() const;
+
+    /**
+     * Get the tileset this layer renders from
+     * @return the tileset
+     */
+    const tileset_t& get_tileset() const { return *tileset; }
+
+    /**
+     * Check whether this layer is stationary (drawn without scrolling)
+     * @return whether this layer is stationary
+     */
+    bool is_stationary() const { return stationary; }
+
     /**
      * Set tiles in this layer to be solid/liquid if their indices
      * are in the list provided
@@ -129,6 +154,13 @@ namespace tilemap {
      */
     bool is_collided(int x, int y) const;
 
+    /**
+     * Hide tiles covered by opaque tiles in a layer drawn in front
+     * of this one (same tileset and column offset)
+     * @param front the layer in front
+     */
+    void hide_covered(const layer_t& front);
+
     /**
      * Update any animated layers
      */
@@ -5,9 +5,11 @@
  */
 
 #include "map_components.h"
+#include "../accounting.h"
 #include "../environment/texture_constructor.h"
 #include "../environment/proc_generation.h"
 #include "noise.h"
+#include "../draw.h"
 
 namespace impl {
 namespace tilemap {
@@ -20,12 +22,12 @@ namespace tilemap {
 
   /**
    * Constructor
+   * @param page_dim the dimension of each atlas page
    */
-  map_components_t::map_components_t()
-    : anims(),
-      anim_bounds(),
-      statics(),
-      static_bounds() {}
+  map_components_t::map_components_t(int page_dim)
+    : atlas(page_dim, TEXTURE_GENERATED),
+      anims(),
+      statics() {}
 
   /**
    * Check for a collision between two rectangles
@@ -40,55 +42,36 @@ namespace tilemap {
             ((camera.y + camera.h) > other.y));
   }
 
-  /**
-   * Free static textures
-   */
-  map_components_t::~map_components_t() {
-    for (size_t i=0; i<statics.size(); i++) {
-      if (statics.at(i) != NULL) {
-        SDL_DestroyTexture(statics.at(i));
-      }
-    }
-  }
-
   /**
    * Add a static component
-   * (Assumes ownership of texture)
-   * @param texture the texture
-   * @param bounds  the bounds
+   * @param region the packed texture
+   * @param bounds the bounds
    */
-  void map_components_t::add_static(SDL_Texture *texture, SDL_Rect&& bounds) {
-    statics.push_back(texture);
-    static_bounds.push_back(bounds);
+  void map_components_t::add_static(const atlas::atlas_region_t& region, SDL_Rect&& bounds) {
+    statics.push_back({region, bounds});
   }
 
   /**
    * Add an animated component
-   * @param texture  the texture
+   * @param region   the packed texture (all frames)
    * @param bounds   the bounds
    * @param frames   the number of frames
    * @param duration the duration of each frame
    */
-  void map_components_t::add_dynamic(SDL_Texture *texture,
+  void map_components_t::add_dynamic(const atlas::atlas_region_t& region,
                                      SDL_Rect&& bounds,
                                      int frames,
                                      int duration) {
-    anims.push_back(std::make_unique<entity::anim_set_t>(
-      texture,
-      bounds.w,
-      bounds.h,
-      frames,
-      duration
-    ));
-
     //actual width corrected for frame count
     int actual_width = bounds.w / frames;
 
-    anim_bounds.push_back({
-      bounds.x,
-      bounds.y,
-      actual_width,
-      bounds.h
+    anims.push_back({
+      region,
+      {bounds.x, bounds.y, actual_width, bounds.h},
+      frames,
+      duration,
+      0,
+      0
     });
   }
 
@@ -97,62 +80,91 @@ namespace tilemap {
    */
   void map_components_t::update() {
     for (size_t i=0; i<anims.size(); i++) {
-      anims.at(i)->update();
+      anim_t& anim = anims.at(i);
+      anim.ticks++;
+
+      if (anim.ticks >= anim.duration) {
+        anim.ticks = 0;
+        anim.current_frame = (anim.current_frame + 1) % anim.frames;
+      }
     }
   }
 
   /**
    * Render the texture
+   * (consecutive components on the same page are batched by sdl)
    * @param renderer sdl renderer
    * @param camera   camera position
    * @param debug    whether debug enabled
    */
   void map_components_t::render(SDL_Renderer& renderer, const SDL_Rect& camera, bool debug) const {
-
     //draw statics first
+    render_statics(renderer,camera);
+    render_anims(renderer,camera,debug);
+  }
+
+  /**
+   * Render only the static components
+   * @param renderer sdl renderer
+   * @param camera   camera position
+   */
+  void map_components_t::render_statics(SDL_Renderer& renderer, const SDL_Rect& camera) const {
     for (size_t i=0; i<statics.size(); i++) {
+      const static_t& component = statics.at(i);
 
       //check for a collision
-      if (camera_collides(camera,static_bounds.at(i))) {
-        const SDL_Rect& curr_bounds = static_bounds.at(i);
+      if (draw::visible(camera_collides(camera,component.bounds))) {
+        const SDL_Rect& curr_bounds = component.bounds;
 
-        SDL_Rect sample_bounds = {0,
-                                  0,
-                                  curr_bounds.w,
-                                  curr_bounds.h};
         SDL_Rect image_bounds = {curr_bounds.x - camera.x,
                                  curr_bounds.y - camera.y,
                                  curr_bounds.w,
                                  curr_bounds.h};
 
-        SDL_RenderCopy(&renderer,
-                       statics.at(i),
-                       &sample_bounds,
-                       &image_bounds);
+        draw::copy(&renderer,
+                   atlas.get_texture(component.region.page),
+                   &component.region.rect,
+                   &image_bounds);
       }
     }
+  }
 
-    //draw animations
+  /**
+   * Render only the animated components
+   * @param renderer sdl renderer
+   * @param camera   camera position
+   * @param debug    whether debug enabled
+   */
+  void map_components_t::render_anims(SDL_Renderer& renderer, const SDL_Rect& camera, bool debug) const {
     for (size_t i=0; i<anims.size(); i++) {
+      const anim_t& anim = anims.at(i);
+
       //check that anim in camera
-      if (camera_collides(camera,anim_bounds.at(i))) {
-        const SDL_Rect& curr_bounds = anim_bounds.at(i);
+      if (draw::visible(camera_collides(camera,anim.bounds))) {
+        const SDL_Rect& curr_bounds = anim.bounds;
+
+        //the current frame within the region
+        SDL_Rect sample_bounds = {anim.region.rect.x + (anim.current_frame * curr_bounds.w),
+                                  anim.region.rect.y,
+                                  curr_bounds.w,
+                                  curr_bounds.h};
+        SDL_Rect image_bounds = {curr_bounds.x - camera.x,
+                                 curr_bounds.y - camera.y,
+                                 curr_bounds.w,
+                                 curr_bounds.h};
+
         //render the animation
-        anims.at(i)->render(renderer,
-                            curr_bounds.x + (curr_bounds.w / 2) - camera.x,
-                            curr_bounds.y + (curr_bounds.h / 2) - camera.y,
-                            false);
+        draw::copy(&renderer,
+                   atlas.get_texture(anim.region.page),
+                   &sample_bounds,
+                   &image_bounds);
 
         if (debug) {
-          SDL_Rect debug_bounds = {curr_bounds.x - camera.x,
-                                   curr_bounds.y - camera.y,
-                                   curr_bounds.w, curr_bounds.h};
-
           //set the draw color
           SDL_SetRenderDrawColor(&renderer,255,102,0,255);
 
           //render the bounds
-          SDL_RenderDrawRect(&renderer,&debug_bounds);
+          draw::rect(&renderer,&image_bounds);
         }
       }
     }
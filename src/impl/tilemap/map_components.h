@@ -12,7 +12,7 @@
 #include <vector>
 #include <utility>
 #include <memory>
-#include "../entity/anim_set.h"
+#include "../atlas.h"
 
 namespace impl {
 namespace tilemap {
@@ -20,17 +20,40 @@ namespace tilemap {
   /*
    * Procedurally generated background
    * Contains foliage, etc
+   * (components are packed into shared atlas pages)
    */
   struct map_components_t {
   private:
+    /**
+     * A static component
+     */
+    typedef struct static_t {
+      atlas::atlas_region_t region;
+      SDL_Rect bounds;
+    } static_t;
+
+    /**
+     * An animated component
+     * (frames are side by side in the region)
+     */
+    typedef struct anim_t {
+      atlas::atlas_region_t region;
+      //bounds of a single frame
+      SDL_Rect bounds;
+      int frames;
+      //the duration of each frame in ticks
+      int duration;
+      int ticks;
+      int current_frame;
+    } anim_t;
+
+    //the pages holding every component
+    atlas::atlas_t atlas;
+
     //any animated components
-    std::vector<std::unique_ptr<entity::anim_set_t>> anims;
-    //bounds of animated components
-    std::vector<SDL_Rect> anim_bounds;
+    std::vector<anim_t> anims;
     //static components
-    std::vector<SDL_Texture*> statics;
-    //bounds of static components
-    std::vector<SDL_Rect> static_bounds;
+    std::vector<static_t> statics;
 
     /**
      * Check for a collision between two rectangles
@@ -42,36 +65,43 @@ namespace tilemap {
   public:
     /**
      * Constructor
+     * @param page_dim the dimension of each atlas page
      */
-    map_components_t();
+    map_components_t(int page_dim=ATLAS_PAGE_DIM);
     map_components_t(const map_components_t&) = delete;
     map_components_t& operator=(const map_components_t&) = delete;
 
     /**
-     * Free static textures
+     * Get the atlas to pack component textures into
+     * @return the atlas
      */
-    ~map_components_t();
+    atlas::atlas_t& get_atlas() { return atlas; }
 
     /**
      * Add a static component
-     * (Assumes ownership of texture)
-     * @param texture the texture
-     * @param bounds  the bounds
+     * @param region the packed texture
+     * @param bounds the bounds
      */
-    void add_static(SDL_Texture *texture, SDL_Rect&& bounds);
+    void add_static(const atlas::atlas_region_t& region, SDL_Rect&& bounds);
 
     /**
      * Add an animated component
-     * @param texture  the texture
+     * @param region   the packed texture (all frames)
      * @param bounds   the bounds
      * @param frames   the number of frames
      * @param duration the duration of each frame
      */
-    void add_dynamic(SDL_Texture *texture,
+    void add_dynamic(const atlas::atlas_region_t& region,
                      SDL_Rect&& bounds,
                      int frames,
                      int duration);
 
+    /**
+     * Get the size of the component textures
+     * @return the texture size in bytes
+     */
+    size_t get_footprint() const { return atlas.get_footprint(); }
+
     /**
      * Update any animated textures
      */
@@ -84,6 +114,21 @@ namespace tilemap {
      * @param debug    debug mode
      */
     void render(SDL_Renderer& renderer, const SDL_Rect& camera, bool debug) const;
+
+    /**
+     * Render only the static components
+     * @param renderer sdl renderer
+     * @param camera   camera position
+     */
+    void render_statics(SDL_Renderer& renderer, const SDL_Rect& camera) const;
+
+    /**
+     * Render only the animated components
+     * @param renderer sdl renderer
+     * @param camera   camera position
+     * @param debug    whether debug enabled
+     */
+    void render_anims(SDL_Renderer& renderer, const SDL_Rect& camera, bool debug) const;
   };
 
 }}
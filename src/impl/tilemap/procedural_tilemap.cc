@@ -5,20 +5,22 @@
  */
 
 #include "procedural_tilemap.h"
+#include "terrain_gen.h"
 #include <math.h>
 #include <algorithm>
-#include <stdlib.h>
 #include <cmath>
 #include "noise.h"
 #include "../environment/proc_generation.h"
 #include "../environment/texture_constructor.h"
+#include "../environment/gen_batch.h"
+#include "../cache.h"
+#include "../draw.h"
+#include "../arena.h"
 #include <iostream>
 
 namespace impl {
 namespace tilemap {
 
-  //the minimum terrain index in the tilemap (headroom)
-  #define TERRAIN_MIN_IDX 10
   #define MAX_TILESET_WIDTH 64
 
   #define HILL_NOISE_AMP 65
@@ -27,52 +29,45 @@ namespace tilemap {
   //the basic ground tile
   #define GRND_TILE 0
 
-  // 1/FG_TREE_RATE chance of a tree @ each tile position
-  #define FG_TREE_RATE 6
-  // 1/FG_ANIM_RATE the rate at which foreground trees have animated foliage
-  #define FG_ANIM_RATE 4
-  //foreground tree leaf density
-  #define FG_LEAF_COUNT 200
-  //foliage animation frame duration
-  #define FG_TREE_FRAME_DURATION 10
-
-  //whether to add a bush (only if we didn't add a tree)
-  #define FG_BUSH_RATE 3
-
-  /**
-   * Clamp a value
-   * @param min  the min value (incl)
-   * @param  val the value
-   * @param  max the max
-   * @return     clamped [min,max)
-   */
-  size_t clamp(size_t min, int val, size_t max) {
-    if (val < (int)min) {
-      return min;
-    }
-    if (val >= (int)max) {
-      return max - 1;
-    }
-    return val;
-  }
+  //cached terrain parts
+  #define CACHE_TERRAIN_LAYOUT 0
+  #define CACHE_TERRAIN_TILESET 1
 
   /**
    * Constructor
    * @param dim      tile dimension
    * @param width_p  map width in pixels
    * @param height_p map height in pixels
+   * @param renderer the renderer for generating textures
+   * @param seed     the generation seed (same seed, same map)
    */
-  procedural_tilemap_t::procedural_tilemap_t(int dim, int width_p, int height_p, SDL_Renderer& renderer)
+  procedural_tilemap_t::procedural_tilemap_t(int dim, int width_p, int height_p,
+                                             SDL_Renderer& renderer,
+                                             uint64_t seed)
     : dim(dim),
+      seed(seed),
       width_p(width_p),
       height_p(height_p),
-      tiles(),
-      fg_tiles(),
+      tiles(arena::level()),
+      fg_tiles(arena::level()),
       hills(),
       near_ground(std::make_unique<map_components_t>()),
-      fore_ground(std::make_unique<map_components_t>()) {
-    //generate terrain procedurally
-    this->generate_terrain(renderer);
+      fore_ground(std::make_unique<map_components_t>()),
+      bg_cache() {
+    //load terrain generated for the same parameters before, or generate it
+    if (!this->load_terrain(renderer)) {
+      this->generate_terrain(renderer);
+    }
+    //skip ground under the dark fill
+    hide_covered_tiles(tiles, fg_tiles, *tileset);
+    //add foreground plants
+    environment::gen_batch_t batch;
+    std::vector<fg_plant_t> plants;
+    queue_fg_plants(batch, plants, tiles, seed, 0, 0, width_p / dim);
+    //build in parallel (or load from the cache), pack into shared pages
+    batch.build();
+    batch.upload(renderer, fore_ground->get_atlas());
+    place_fg_plants(*fore_ground, batch, plants, dim);
     //generate background procedurally
     this->generate_bg(renderer);
   }
@@ -87,6 +82,7 @@ namespace tilemap {
       renderer,
       MED_LIGHT_GREEN_R,MED_LIGHT_GREEN_G,MED_LIGHT_GREEN_B,
       FBM_PERSISTENCE_0_66,
+      rng::rng_t(seed, rng::HILLS, 0).next_float(),
       width_p,200,
       HILL_NOISE_AMP,
       8
@@ -97,6 +93,7 @@ namespace tilemap {
       renderer,
       MED_DARK_GREEN_R,MED_DARK_GREEN_G,MED_DARK_GREEN_B,
       FBM_PERSISTENCE_0_66,
+      rng::rng_t(seed, rng::HILLS, 1).next_float(),
       width_p,200,
       HILL_NOISE_AMP2,
       32
@@ -112,21 +109,7 @@ namespace tilemap {
     size_t tiles_across = width_p / dim;
     size_t tiles_down = height_p / dim;
 
-    tiles.reserve(tiles_down);
-    fg_tiles.reserve(tiles_down);
-
-    for (size_t r=0; r<tiles_down; r++) {
-      tiles.emplace_back();
-      tiles.back().reserve(tiles_across);
-      fg_tiles.emplace_back();
-      fg_tiles.back().reserve(tiles_across);
-
-      for (size_t c=0; c<tiles_across; c++) {
-        //all tiles start as empty
-        tiles.back().push_back(tile_t((int)c,(int)r,dim,-1));
-        fg_tiles.back().push_back(tile_t((int)c,(int)r,dim,-1));
-      }
-    }
+    init_tiles();
 
     //start ground height roughly 1/3 of total height
     int ground = (int) 2 * (tiles_down / 3);
@@ -145,22 +128,15 @@ namespace tilemap {
     //make tile 0
     tileset_constructor.draw_rect(grnd_tile,0,0,dim,dim);
 
-    //create a random seed
-    float seed = static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
+    //terrain noise seed
+    float fbm_seed = rng::rng_t(seed, rng::TERRAIN).next_float();
 
     size_t prev_height = ground;
 
     //walk around and generate a surface level
     for (size_t i=0; i<tiles_across; i++) {
-      //create an fbm value
-      float noise_val = noise::fractal_brownian_motion(seed,
-                                                       (float)i/tiles_across,
-                                                       FBM_PERSISTENCE_0_75);
-
       //get the tile height at this position
-      size_t theight = clamp(TERRAIN_MIN_IDX,
-                             ground - (noise_val * 10),
-                             tiles_down-3);
+      size_t theight = raw_surface_height(fbm_seed, i, tiles_across, tiles_down);
 
       if (i > 0) {
         //make sure the height diff within 1
@@ -190,210 +166,141 @@ namespace tilemap {
       prev_height = theight;
     }
     //erode the corners of the surface tiles
-    erode_grnd_corners(tileset_constructor);
+    erode_grnd_corners(tiles, tileset_constructor, seed, 0);
 
-    //generate foreground terrain and tiles
-    generate_fg(tileset_constructor,renderer);
+    //generate foreground terrain tiles
+    add_fg_tiles(tiles, fg_tiles, tileset_constructor, seed, 0);
 
-    //generate the tileset
-    tileset = tileset_constructor.generate_tileset(renderer);
+    //generate the tileset and save the result for next time
+    std::vector<SDL_Surface*> tileset_surfaces = tileset_constructor.generate_surfaces();
+    store_terrain(tileset_surfaces, tileset_constructor.get_tile_count());
+    tileset = upload_tileset(renderer, tileset_surfaces, dim, tileset_constructor.get_tile_count());
   }
 
   /**
-   * Erode the corners of ground tiles based on slope
-   * @param constructor texture constructor
+   * Create the (empty) tile grids
    */
-  void procedural_tilemap_t::erode_grnd_corners(tileset_constructor_t& tileset_constructor) {
-    //get the height of the first tile
-    tile_builder::tile_slope prev_slope = tile_builder::FLAT;
-
-    //whether we need to fill in a one-wide gap (looks bad)
-    bool dropped_down = false;
-
-    //for each column
-    for (size_t i=1; i<(tiles.at(0).size() - 1); i++) {
-      //get the current ground tile
-      tile_t& curr_tile = get_grnd_tile(i);
-      int curr_y_depth = curr_tile.get_y_depth();
-      tile_t& prev_tile = get_grnd_tile(i-1);
-      int prev_y_depth = prev_tile.get_y_depth();
-
-      //check if this tile should slope up
-      if (curr_y_depth < prev_y_depth) {
-        if (dropped_down) {
-          //fill in gap
-          tiles.at(prev_tile.get_y_idx() - 1).at(i-1).set_type(0);
-          tiles.at(prev_tile.get_y_idx() - 1).at(i-1).set_solid(true);
-          tiles.at(prev_tile.get_y_idx() - 1).at(i-2).set_type(0);
-          tiles.at(prev_tile.get_y_idx() - 1).at(i-2).set_solid(true);
-
-        } else {
-          prev_slope = tile_builder::SLOPE_L;
-
-          //make a new tile
-          curr_tile.set_type(tile_builder::make_grnd_tile(tileset_constructor,
-                                                          tile_builder::SLOPE_L));
-
-          //add non colliding slope
-          tiles.at(prev_tile.get_y_idx() - 1).at(i-1).set_type(
-            tile_builder::make_low_slope_grnd_tile(tileset_constructor,
-                                                   tile_builder::SLOPE_L)
-          );
-        }
-
-        dropped_down = false;
+  void procedural_tilemap_t::init_tiles() {
+    size_t tiles_across = width_p / dim;
+    size_t tiles_down = height_p / dim;
 
-      } else if (curr_y_depth > prev_y_depth) {
-        //we dropped down
-        dropped_down = true;
+    tiles.reserve(tiles_down);
+    fg_tiles.reserve(tiles_down);
 
-        //previous tile should slope down or both
-        if (prev_slope == tile_builder::SLOPE_L) {
-          //int type = prev_tile.get_type();
-          tile_builder::edit_grnd_tile(tileset_constructor,
-                                       prev_tile.get_type(),
-                                       tile_builder::SLOPE_BOTH);
+    for (size_t r=0; r<tiles_down; r++) {
+      tiles.emplace_back();
+      tiles.back().reserve(tiles_across);
+      fg_tiles.emplace_back();
+      fg_tiles.back().reserve(tiles_across);
 
-          prev_slope = tile_builder::FLAT;
+      for (size_t c=0; c<tiles_across; c++) {
+        //all tiles start as empty
+        tiles.back().push_back(tile_t((int)c,(int)r,dim,-1));
+        fg_tiles.back().push_back(tile_t((int)c,(int)r,dim,-1));
+      }
+    }
+  }
 
-        } else {
-          //make a new tile
-          prev_tile.set_type(tile_builder::make_grnd_tile(tileset_constructor,
-                                                          tile_builder::SLOPE_R));
+  /**
+   * Get the cache key for the generated terrain
+   * @param  part which part of the terrain (layout or tileset)
+   * @param  page the tileset page
+   * @return      the key
+   */
+  uint64_t procedural_tilemap_t::terrain_key(int part, int page) const {
+    cache::key_t key("procedural_terrain");
+    key.add(part).add(page).add(seed).add(dim).add(width_p).add(height_p)
+       .add(TERRAIN_MIN_IDX)
+       .add_rgb(DARK_GREEN_R,DARK_GREEN_G,DARK_GREEN_B)
+       .add_rgb(DARK_R,DARK_G,DARK_B);
+    return key.get();
+  }
 
-          //no change to current tile
-          prev_slope = tile_builder::FLAT;
-        }
+  /**
+   * Save the generated tile layout and tileset pixels
+   * @param tileset_surfaces the generated tileset pixels (each page)
+   * @param tile_count       the tile types on those pages
+   */
+  void procedural_tilemap_t::store_terrain(const std::vector<SDL_Surface*>& tileset_surfaces,
+                                           int tile_count) const {
+    if (!cache::enabled()) {
+      return;
+    }
 
-        //add non colliding slope
-        tiles.at(curr_tile.get_y_idx() - 1).at(i).set_type(
-          tile_builder::make_low_slope_grnd_tile(tileset_constructor,
-                                                 tile_builder::SLOPE_R)
-        );
+    //(type, solid, fg type) for each position
+    std::vector<int32_t> layout;
+    layout.reserve((tiles.size() * tiles.at(0).size() * 3) + 2);
 
-      } else {
-        //no change to current tile
-        prev_slope = tile_builder::FLAT;
+    for (size_t r=0; r<tiles.size(); r++) {
+      for (size_t c=0; c<tiles.at(r).size(); c++) {
+        layout.push_back(tiles.at(r).at(c).get_type());
+        layout.push_back(tiles.at(r).at(c).is_solid());
+        layout.push_back(fg_tiles.at(r).at(c).get_type());
+      }
+    }
 
-        // TODO don't draw on top of slopes
-        //add ground uneveness
-        // tiles.at(curr_tile.get_y_idx() - 1).at(i).set_type(
-        //   tile_builder::make_flat_grnd_tile(tileset_constructor)
-        // );
+    //followed by the tile type and page counts
+    layout.push_back(tile_count);
+    layout.push_back(tileset_surfaces.size());
 
-        //flat (looking for single wide hollows)
-        dropped_down = false;
-      }
+    cache::store_ints(terrain_key(CACHE_TERRAIN_LAYOUT), layout);
+    for (size_t i=0; i<tileset_surfaces.size(); i++) {
+      SDL_Surface& page = *tileset_surfaces.at(i);
+      cache::store_surface(terrain_key(CACHE_TERRAIN_TILESET, i), page, 1, page.w);
     }
   }
 
   /**
-   * Generate the foreground
-   * @param tileset_constructor the tileset constructor
-   * @param renderer            the sdl renderer
+   * Load the tile layout and tileset generated for the same
+   * parameters before
+   * @param  renderer the renderer for creating the tileset
+   * @return          whether the terrain was loaded
    */
-  void procedural_tilemap_t::generate_fg(tileset_constructor_t& tileset_constructor,
-                                         SDL_Renderer& renderer) {
-    //add dark tiles
-    tileset_constructor.set_default_color(
-      DARK_R,
-      DARK_G,
-      DARK_B
-    );
-
-    //create a dark foreground tile
-    int dark_tile = tileset_constructor.add_tile();
-    tileset_constructor.fill_tile(
-      dark_tile,
-      DARK_R,
-      DARK_G,
-      DARK_B
-    );
-
-    for (size_t i=0; i<fg_tiles.at(0).size(); i++) {
-      //get the terrain height here
-      tile_t& grnd = get_grnd_tile(i);
-      int gidx = grnd.get_y_idx();
-
-      //add a tree with some probability
-      if (rand() % FG_TREE_RATE == 0) {
-        environment::texture_constructor_t tree_constructor;
-        //generate a tree
-        environment::proc_generation::branching_tree_growth(
-          tree_constructor,
-          50,150,
-          DARK_R,
-          DARK_G,
-          DARK_B
-        );
-
-        if (rand() % FG_ANIM_RATE == 0) {
-          //add foliage
-          environment::proc_generation::trunk_foliage(tree_constructor,
-                                                      FG_LEAF_COUNT,
-                                                      DARK_GREEN_R,
-                                                      DARK_GREEN_G,
-                                                      DARK_GREEN_B,
-                                                      true, //foreground (1 color)
-                                                      DARK_GREEN_R,
-                                                      DARK_GREEN_G,
-                                                      DARK_GREEN_B);
-
-          int w,h;
-          SDL_Texture *tr = tree_constructor.generate(renderer,w,h);
-          int frames = tree_constructor.get_frames();
-
-          //add a dynamic texture
-          fore_ground->add_dynamic(
-            tr,
-            {(int)i*dim,(gidx+1)*dim - h,w,h},
-            frames,
-            FG_TREE_FRAME_DURATION
-          );
-
-        } else {
-          int w,h;
-          SDL_Texture *tr = tree_constructor.generate(renderer,w,h);
-
-          //add a static texture
-          fore_ground->add_static(
-            tr,
-            {(int)i*dim - (w / 2),(gidx+2)*dim - h,w,h}
-          );
-        }
+  bool procedural_tilemap_t::load_terrain(SDL_Renderer& renderer) {
+    std::vector<int32_t> layout;
+    size_t tiles_across = width_p / dim;
+    size_t tiles_down = height_p / dim;
+
+    if (!cache::load_ints(terrain_key(CACHE_TERRAIN_LAYOUT), layout) ||
+        (layout.size() != ((tiles_across * tiles_down * 3) + 2)) ||
+        (layout.back() <= 0)) {
+      return false;
+    }
 
-      } else if (rand() % FG_BUSH_RATE == 0) {
-        environment::texture_constructor_t bush_constructor;
-        //generate a tree
-        environment::proc_generation::branching_tree_growth(
-          bush_constructor,
-          50,150,
-          DARK_R,
-          DARK_G,
-          DARK_B,
-          1 // starting volume
-        );
-
-        int w,h;
-        SDL_Texture *tr = bush_constructor.generate(renderer,w,h);
-
-        //add a static texture
-        fore_ground->add_static(
-          tr,
-          {(int)i*dim - (w / 2),(gidx+3)*dim - h,w,h}
-        );
+    //the last page holds at least one tile type
+    int tile_count = layout.at(layout.size() - 2);
+    if ((tile_count <= ((layout.back() - 1) * tileset_page_tiles(dim))) ||
+        (tile_count > (layout.back() * tileset_page_tiles(dim)))) {
+      return false;
+    }
+
+    std::vector<SDL_Surface*> tileset_surfaces;
+    for (int i=0; i<layout.back(); i++) {
+      SDL_Surface *page = NULL;
+      int frames, frame_w;
+      if (!cache::load_surface(terrain_key(CACHE_TERRAIN_TILESET, i), page, frames, frame_w)) {
+        //incomplete
+        for (size_t j=0; j<tileset_surfaces.size(); j++) {
+          SDL_FreeSurface(tileset_surfaces.at(j));
+        }
+        return false;
       }
+      tileset_surfaces.push_back(page);
+    }
 
-      //create a rough ground tile at this level
-      fg_tiles.at(gidx).at(i).set_type(
-        tile_builder::make_fg_surface_tile(tileset_constructor)
-      );
+    init_tiles();
 
-      //add solid tiles below this point
-      for (int t=(gidx+1); t<(int)fg_tiles.size(); t++) {
-        fg_tiles.at(t).at(i).set_type(dark_tile);
+    size_t i = 0;
+    for (size_t r=0; r<tiles_down; r++) {
+      for (size_t c=0; c<tiles_across; c++) {
+        tiles.at(r).at(c).set_type(layout.at(i++));
+        tiles.at(r).at(c).set_solid(layout.at(i++) != 0);
+        fg_tiles.at(r).at(c).set_type(layout.at(i++));
       }
     }
+
+    tileset = upload_tileset(renderer, tileset_surfaces, dim, tile_count);
+    return true;
   }
 
   /**
@@ -424,17 +331,7 @@ namespace tilemap {
    * @return   tile
    */
   tile_t& procedural_tilemap_t::get_grnd_tile(int x) {
-    //look through each row
-    for (size_t i=0; i<this->tiles.size(); i++) {
-      //check if the x coord is in the bounds of this row
-      if ((x >= 0) && (x < (int)tiles.at(i).size())) {
-        //return first solid in col
-        if (tiles.at(i).at(x).is_solid()) {
-          return tiles.at(i).at(x);
-        }
-      }
-    }
-    return tiles.back().at(x);
+    return grnd_tile(tiles, x);
   }
 
   /**
@@ -443,17 +340,7 @@ namespace tilemap {
    * @return   tile
    */
   const tile_t& procedural_tilemap_t::get_grnd_tile(int x) const {
-    //look through each row
-    for (size_t i=0; i<this->tiles.size(); i++) {
-      //check if the x coord is in the bounds of this row
-      if ((x >= 0) && (x < (int)tiles.at(i).size())) {
-        //return first solid in col
-        if (tiles.at(i).at(x).is_solid()) {
-          return tiles.at(i).at(x);
-        }
-      }
-    }
-    return tiles.back().at(x);
+    return grnd_tile(tiles, x);
   }
 
   /**
@@ -556,6 +443,30 @@ namespace tilemap {
     return height_p;
   }
 
+  /**
+   * Get the approximate memory footprint of the map
+   * (texture bytes and tile storage)
+   * @return the footprint in bytes
+   */
+  size_t procedural_tilemap_t::get_footprint() const {
+    size_t total = tileset->get_footprint() +
+                   near_ground->get_footprint() +
+                   fore_ground->get_footprint();
+
+    for (size_t i=0; i<hills.size(); i++) {
+      total += hills.at(i)->get_footprint();
+    }
+
+    for (size_t i=0; i<tiles.size(); i++) {
+      total += tiles.at(i).size() * sizeof(tile_t);
+    }
+
+    for (size_t i=0; i<fg_tiles.size(); i++) {
+      total += fg_tiles.at(i).size() * sizeof(tile_t);
+    }
+    return total;
+  }
+
   /**
    * Update any updatable tiles
    */
@@ -578,29 +489,26 @@ namespace tilemap {
                           LIGHT_GREEN_R,
                           LIGHT_GREEN_G,
                           LIGHT_GREEN_B,255);
-    SDL_RenderFillRect(&renderer,&bounds);
+    draw::fill_rect(&renderer,&bounds);
 
     //render background hills
     for (size_t i=0; i<hills.size(); i++) {
       hills.at(i)->render(renderer,camera);
     }
 
-    //draw tiles
-    for (size_t r=0; r<tiles.size(); r++) {
-      for (size_t c=0; c<tiles.at(r).size(); c++) {
-        //render the tile
-        tiles.at(r).at(c).render(
-          renderer,
-          camera,
-          tileset,
-          false,
-          debug
-        );
-      }
+    //draw tiles and near ground statics (redrawn only where scrolled into view)
+    if (debug) {
+      render_tiles(renderer,camera,tiles,*tileset,debug);
+      near_ground->render_statics(renderer,camera);
+    } else {
+      bg_cache.render(renderer,camera,0,[this,&renderer](const SDL_Rect& view) {
+        render_tiles(renderer,view,tiles,*tileset,false);
+        near_ground->render_statics(renderer,view);
+      });
     }
 
-    //render near ground components
-    near_ground->render(renderer,camera,debug);
+    //render near ground animations
+    near_ground->render_anims(renderer,camera,debug);
   }
 
 
@@ -615,17 +523,6 @@ namespace tilemap {
     fore_ground->render(renderer,camera,debug);
 
     //draw tiles
-    for (size_t r=0; r<fg_tiles.size(); r++) {
-      for (size_t c=0; c<fg_tiles.at(r).size(); c++) {
-        //render the tile
-        fg_tiles.at(r).at(c).render(
-          renderer,
-          camera,
-          tileset,
-          false,
-          debug
-        );
-      }
-    }
+    render_tiles(renderer,camera,fg_tiles,*tileset,debug);
   }
 }}
@@ -10,6 +10,7 @@
 #include <vector>
 #include <string>
 #include <memory>
+#include <memory_resource>
 #include "tileset.h"
 #include "abstract_tilemap.h"
 #include "tile.h"
@@ -17,7 +18,9 @@
 #include "static_hill_bg.h"
 #include "tileset_constructor.h"
 #include "map_components.h"
+#include "bg_cache.h"
 #include "tile_builder.h"
+#include "../rng.h"
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL.h>
 
@@ -33,6 +36,9 @@ namespace tilemap {
     //dimension of tiles
     int dim;
 
+    //the seed for all generation in this map
+    uint64_t seed;
+
     //dimensions of map in pixels
     int width_p;
     int height_p;
@@ -41,10 +47,10 @@ namespace tilemap {
     std::shared_ptr<tileset_t> tileset;
 
     //ground tiles
-    std::vector<std::vector<tile_t>> tiles;
+    std::pmr::vector<std::pmr::vector<tile_t>> tiles;
 
     //foreground tiles
-    std::vector<std::vector<tile_t>> fg_tiles;
+    std::pmr::vector<std::pmr::vector<tile_t>> fg_tiles;
 
     //hills
     std::vector<std::unique_ptr<static_hill_bg_t>> hills;
@@ -55,6 +61,9 @@ namespace tilemap {
     //foreground map components
     std::unique_ptr<map_components_t> fore_ground;
 
+    //ground tiles and near ground statics around the camera
+    mutable bg_cache_t bg_cache;
+
     /**
      * Called by the constructor _after_ generating ground layer
      * @param renderer the renderer
@@ -68,19 +77,33 @@ namespace tilemap {
     void generate_terrain(SDL_Renderer& renderer);
 
     /**
-     * Erode the corners of ground tiles based on slope
-     * @param constructor texture constructor
+     * Create the (empty) tile grids
+     */
+    void init_tiles();
+
+    /**
+     * Get the cache key for the generated terrain
+     * @param  part which part of the terrain (layout or tileset)
+     * @param  page the tileset page
+     * @return      the key
+     */
+    uint64_t terrain_key(int part, int page=0) const;
+
+    /**
+     * Save the generated tile layout and tileset pixels
+     * @param tileset_surfaces the generated tileset pixels (each page)
+     * @param tile_count       the tile types on those pages
      */
-    void erode_grnd_corners(tileset_constructor_t& tileset_constructor);
+    void store_terrain(const std::vector<SDL_Surface*>& tileset_surfaces,
+                       int tile_count) const;
 
     /**
-     * Generate the foreground
-     * Created after the ground layer is generated
-     * @param tileset_constructor the tileset constructor
-     * @param renderer            the sdl renderer
+     * Load the tile layout and tileset generated for the same
+     * parameters before
+     * @param  renderer the renderer for creating the tileset
+     * @return          whether the terrain was loaded
      */
-    void generate_fg(tileset_constructor_t& tileset_constructor,
-                     SDL_Renderer& renderer);
+    bool load_terrain(SDL_Renderer& renderer);
 
     /**
      * Check that a position is in bounds
@@ -114,8 +137,12 @@ namespace tilemap {
      * @param dim      tile dimension
      * @param width_p  map width in pixels
      * @param height_p map height in pixels
+     * @param renderer the renderer for generating textures
+     * @param seed     the generation seed (same seed, same map)
      */
-    procedural_tilemap_t(int dim, int width_p, int height_p, SDL_Renderer& renderer);
+    procedural_tilemap_t(int dim, int width_p, int height_p,
+                         SDL_Renderer& renderer,
+                         uint64_t seed);
     procedural_tilemap_t(const procedural_tilemap_t&) = delete;
     procedural_tilemap_t& operator=(const procedural_tilemap_t&) = delete;
 
@@ -169,6 +196,13 @@ namespace tilemap {
      */
     int get_height() const override;
 
+    /**
+     * Get the approximate memory footprint of the map
+     * (texture bytes and tile storage)
+     * @return the footprint in bytes
+     */
+    size_t get_footprint() const override;
+
     /**
      * Update any updatable tiles
      */
@@ -0,0 +1,294 @@
+/*
+ * (C) 2021 Jack Hay
+ *
+ * Untitled Swamp game
+ */
+
+#include "regions.h"
+#include "../exceptions.h"
+#include "../logger.h"
+#include <json/nlohmann_json.h>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+namespace impl {
+namespace tilemap {
+
+  typedef nlohmann::json json;
+
+  #define COMMA ','
+
+  /**
+   * Conversion to region files from json
+   * @param j the json to load
+   * @param r the region files to load into
+   */
+  void from_json(const json& j, region_files_t& r) {
+    j.at("layer_paths").get_to(r.layer_paths);
+    j.at("env_path").get_to(r.env_path);
+    j.at("items_path").get_to(r.items_path);
+    j.at("tblocks_path").get_to(r.tblocks_path);
+  }
+
+  /**
+   * Conversion to json from region files
+   * @param j the json to write
+   * @param r the region files
+   */
+  void to_json(json& j, const region_files_t& r) {
+    j = {{"layer_paths", r.layer_paths},
+         {"env_path", r.env_path},
+         {"items_path", r.items_path},
+         {"tblocks_path", r.tblocks_path}};
+  }
+
+  /**
+   * Load a region manifest
+   * Throws a resource exception if load fails
+   * @param  path      the manifest path (relative to the base path)
+   * @param  base_path resource directory base path
+   * @return           the manifest
+   */
+  region_manifest_t load_region_manifest(const std::string& path,
+                                         const std::string& base_path) {
+    region_manifest_t manifest;
+
+    try {
+      std::ifstream in_stream(base_path + path);
+      json config;
+      in_stream >> config;
+
+      config.at("region_cols").get_to(manifest.region_cols);
+      config.at("cols").get_to(manifest.cols);
+      config.at("rows").get_to(manifest.rows);
+      config.at("regions").get_to(manifest.regions);
+
+    } catch (...) {
+      throw exceptions::rsrc_exception_t(path);
+    }
+
+    if ((manifest.region_cols <= 0) || manifest.regions.empty()) {
+      throw exceptions::rsrc_exception_t(path, "region manifest has no regions: ");
+    }
+    return manifest;
+  }
+
+  /**
+   * Get the path with a region suffix (maps/a.txt -> maps/a.r3.txt)
+   * @param  path   the original path
+   * @param  region the region index
+   * @return        the region path
+   */
+  static std::string region_path(const std::string& path, int region) {
+    size_t dot = path.rfind('.');
+    size_t slash = path.rfind('/');
+    std::string suffix = ".r" + std::to_string(region);
+
+    //no extension
+    if ((dot == std::string::npos) ||
+        ((slash != std::string::npos) && (dot < slash))) {
+      return path + suffix;
+    }
+    return path.substr(0, dot) + suffix + path.substr(dot);
+  }
+
+  /**
+   * Read a layer file as rows of tile values
+   * @param  path the full path
+   * @return      the rows
+   */
+  static std::vector<std::vector<int>> read_layer(const std::string& path) {
+    std::vector<std::vector<int>> rows;
+    std::ifstream layer_file(path);
+    if (!layer_file.is_open()) {
+      throw exceptions::rsrc_exception_t(path);
+    }
+
+    std::string line;
+    while (std::getline(layer_file, line)) {
+      rows.emplace_back();
+      std::stringstream s_stream(line);
+
+      while (s_stream.good()) {
+        std::string substr;
+        std::getline(s_stream, substr, COMMA);
+
+        //same parsing as layer_t
+        try {
+          rows.back().push_back(std::stoi(substr));
+        } catch (...) { }
+      }
+    }
+    return rows;
+  }
+
+  /**
+   * Write some columns of a layer
+   * @param path  the full path
+   * @param rows  the layer rows
+   * @param first the first column
+   * @param last  one past the last column
+   */
+  static void write_layer(const std::string& path,
+                          const std::vector<std::vector<int>>& rows,
+                          int first,
+                          int last) {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+      throw exceptions::rsrc_exception_t(path, "failed to write region ");
+    }
+
+    for (size_t r=0; r<rows.size(); r++) {
+      //rows may be shorter than the level
+      int end = std::min(last, (int)rows.at(r).size());
+      for (int c=first; c<end; c++) {
+        out << rows.at(r).at(c) << COMMA;
+      }
+      out << "\n";
+    }
+  }
+
+  /**
+   * Split an object list (env, items, transparent blocks) by the
+   * region containing each object's x position
+   * @param  path        the object cfg (relative to the base path, may be "")
+   * @param  base_path   resource directory base path
+   * @param  tile_dim    the tile dimension
+   * @param  region_cols the width of each region in tile columns
+   * @param  regions     the number of regions
+   * @return             the path of the object cfg for each region ("" if none)
+   */
+  static std::vector<std::string> split_objects(const std::string& path,
+                                                const std::string& base_path,
+                                                int tile_dim,
+                                                int region_cols,
+                                                int regions) {
+    std::vector<std::string> paths(regions, "");
+    if (path.empty()) {
+      return paths;
+    }
+
+    json config;
+    try {
+      std::ifstream in_stream(base_path + path);
+      in_stream >> config;
+    } catch (...) {
+      throw exceptions::rsrc_exception_t(path);
+    }
+
+    //bucket each object by its anchor
+    std::vector<json> buckets(regions, json::array());
+    for (const json& obj : config) {
+      int region = (obj.at("x").get<int>() / tile_dim) / region_cols;
+      buckets.at(std::max(0, std::min(region, regions - 1))).push_back(obj);
+    }
+
+    for (int i=0; i<regions; i++) {
+      if (!buckets.at(i).empty()) {
+        paths.at(i) = region_path(path, i);
+
+        std::ofstream out(base_path + paths.at(i));
+        if (!out.is_open()) {
+          throw exceptions::rsrc_exception_t(paths.at(i), "failed to write region ");
+        }
+        out << buckets.at(i).dump(2);
+      }
+    }
+    return paths;
+  }
+
+  /**
+   * Split a level into regions (offline, run with -s)
+   * Writes the layer and object files for each region and a manifest
+   * named after the level cfg (i.e. swamp.json -> swamp_regions.json)
+   * Throws a resource exception if the level can't be read or written
+   * @param  cfg_path    the level configuration (relative to the base path)
+   * @param  base_path   resource directory base path
+   * @param  tile_dim    the tile dimension (objects are anchored by pixel position)
+   * @param  region_cols the width of each region in tile columns
+   * @return             the manifest path (relative to the base path)
+   */
+  std::string split_level(const std::string& cfg_path,
+                          const std::string& base_path,
+                          int tile_dim,
+                          int region_cols) {
+    json config;
+    std::vector<std::string> layer_paths;
+    int entity_layer_idx;
+
+    try {
+      std::ifstream in_stream(base_path + cfg_path);
+      in_stream >> config;
+      config.at("map_layer_paths").get_to(layer_paths);
+      config.at("entity_layer_idx").get_to(entity_layer_idx);
+
+    } catch (...) {
+      throw exceptions::rsrc_exception_t(cfg_path);
+    }
+
+    if ((entity_layer_idx < 0) || (entity_layer_idx >= (int)layer_paths.size()) ||
+        (region_cols <= 0) || (tile_dim <= 0)) {
+      throw exceptions::rsrc_exception_t(cfg_path, "invalid level for region split ");
+    }
+
+    //read every layer
+    std::vector<std::vector<std::vector<int>>> layers;
+    for (size_t i=0; i<layer_paths.size(); i++) {
+      layers.push_back(read_layer(base_path + layer_paths.at(i)));
+    }
+
+    //the level size is taken from the entity layer (as in tilemap_t)
+    const std::vector<std::vector<int>>& entity_layer = layers.at(entity_layer_idx);
+    int cols = 0;
+    for (size_t r=0; r<entity_layer.size(); r++) {
+      cols = std::max(cols, (int)entity_layer.at(r).size());
+    }
+    int regions = std::max(1, (cols + region_cols - 1) / region_cols);
+
+    region_manifest_t manifest;
+    manifest.region_cols = region_cols;
+    manifest.cols = cols;
+    manifest.rows = entity_layer.size();
+    manifest.regions.resize(regions);
+
+    //write layer strips
+    for (int i=0; i<regions; i++) {
+      for (size_t l=0; l<layers.size(); l++) {
+        std::string path = region_path(layer_paths.at(l), i);
+        write_layer(base_path + path, layers.at(l), i * region_cols, (i + 1) * region_cols);
+        manifest.regions.at(i).layer_paths.push_back(path);
+      }
+    }
+
+    //split anchored objects
+    std::vector<std::string> env = split_objects(config.value("env_elems_path", ""),
+                                                 base_path, tile_dim, region_cols, regions);
+    std::vector<std::string> items = split_objects(config.value("items_path", ""),
+                                                   base_path, tile_dim, region_cols, regions);
+    std::vector<std::string> tblocks = split_objects(config.value("transparent_blocks_path", ""),
+                                                     base_path, tile_dim, region_cols, regions);
+    for (int i=0; i<regions; i++) {
+      manifest.regions.at(i).env_path = env.at(i);
+      manifest.regions.at(i).items_path = items.at(i);
+      manifest.regions.at(i).tblocks_path = tblocks.at(i);
+    }
+
+    //write the manifest
+    std::string manifest_path = cfg_path.substr(0, cfg_path.rfind('.')) + "_regions.json";
+    std::ofstream out(base_path + manifest_path);
+    if (!out.is_open()) {
+      throw exceptions::rsrc_exception_t(manifest_path, "failed to write region ");
+    }
+
+    json j = {{"region_cols", manifest.region_cols},
+              {"cols", manifest.cols},
+              {"rows", manifest.rows},
+              {"regions", manifest.regions}};
+    out << j.dump(2);
+
+    logger::log_info("split " + cfg_path + " into " + std::to_string(regions) +
+                     " regions, set \"regions_path\" : \"" + manifest_path + "\" in the level cfg");
+    return manifest_path;
+  }
+}}
@@ -0,0 +1,74 @@
+/*
+ * (C) 2021 Jack Hay
+ *
+ * Untitled Swamp game
+ */
+
+#ifndef _IO_JACKHAY_SWAMP_TILEMAP_REGIONS_H
+#define _IO_JACKHAY_SWAMP_TILEMAP_REGIONS_H
+
+#include <string>
+#include <vector>
+
+namespace impl {
+namespace tilemap {
+
+  //default region width in tile columns
+  #define REGION_DEFAULT_COLS 64
+
+  /**
+   * The files for one region (paths relative to the resource dir,
+   * "" if the region has none of that kind)
+   */
+  struct region_files_t {
+    //one file per map layer (same order as the level's layers)
+    std::vector<std::string> layer_paths;
+    //environment elements anchored in this region
+    std::string env_path;
+    //items anchored in this region
+    std::string items_path;
+    //transparent blocks anchored in this region
+    std::string tblocks_path;
+  };
+
+  /**
+   * A level split into column strips (written by split_level)
+   */
+  struct region_manifest_t {
+    //the width of each region in tile columns
+    int region_cols;
+    //the full level dimensions in tiles
+    int cols;
+    int rows;
+    //the files for each region (left to right)
+    std::vector<region_files_t> regions;
+  };
+
+  /**
+   * Load a region manifest
+   * Throws a resource exception if load fails
+   * @param  path      the manifest path (relative to the base path)
+   * @param  base_path resource directory base path
+   * @return           the manifest
+   */
+  region_manifest_t load_region_manifest(const std::string& path,
+                                         const std::string& base_path);
+
+  /**
+   * Split a level into regions (offline, run with -s)
+   * Writes the layer and object files for each region and a manifest
+   * named after the level cfg (i.e. swamp.json -> swamp_regions.json)
+   * Throws a resource exception if the level can't be read or written
+   * @param  cfg_path    the level configuration (relative to the base path)
+   * @param  base_path   resource directory base path
+   * @param  tile_dim    the tile dimension (objects are anchored by pixel position)
+   * @param  region_cols the width of each region in tile columns
+   * @return             the manifest path (relative to the base path)
+   */
+  std::string split_level(const std::string& cfg_path,
+                          const std::string& base_path,
+                          int tile_dim,
+                          int region_cols);
+}}
+
+#endif /*_IO_JACKHAY_SWAMP_TILEMAP_REGIONS_H*/
@@ -5,41 +5,122 @@
  */
 
 #include "static_hill_bg.h"
+#include "../accounting.h"
 #include "noise.h"
 #include "../environment/texture_constructor.h"
+#include "../environment/gen_batch.h"
+#include "../cache.h"
+#include "../draw.h"
+#include <algorithm>
 
 namespace impl {
 namespace tilemap {
 
+  /**
+   * Queue a strip of hills for generation
+   * @param  batch       the generation batch
+   * @param  r,g,b       color
+   * @param  fbm_persist fractal brownian motion persistence
+   * @param  fbm_seed    fractal brownian motion seed [0,1]
+   * @param  x           the world x position of the strip
+   * @param  width       the width of the strip
+   * @param  height      the height of the strip
+   * @param  amplitude   the hill amplitude
+   * @param  noise_width the noise period in pixels
+   * @return             the index of the result in the batch
+   */
+  size_t queue_hill_bg(environment::gen_batch_t& batch,
+                       int r,int g,int b,
+                       float fbm_persist,
+                       float fbm_seed,
+                       int x,
+                       int width,
+                       int height,
+                       int amplitude,
+                       int noise_width) {
+
+    //everything that affects the hill's pixels
+    cache::key_t key("static_hill_bg");
+    key.add_rgb(r,g,b).add_float(fbm_persist).add_float(fbm_seed)
+       .add(x).add(width).add(height).add(amplitude).add(noise_width);
+
+    return batch.add([=](environment::texture_constructor_t& texture_constructor) {
+      float noise_val;
+      int hill_height;
+
+      texture_constructor.set_default_color(r,g,b);
+
+      for (int i=0; i<width; i++) {
+        //sample in world coordinates so adjacent strips line up
+        noise_val = noise::fractal_brownian_motion(fbm_seed,
+                                                   (float)(x + i)/noise_width,
+                                                   fbm_persist);
+
+        hill_height = noise_val * amplitude;
+
+        if (hill_height >= height) {
+          hill_height = height - 4;
+        }
+
+        //draw this slice
+        texture_constructor.set_line(
+          i,hill_height,i,height,1
+        );
+      }
+    }, key.get());
+  }
+
   /**
    * Constructor
    * @param renderer    renderer for creating textures
    * @param r,g,b       color
    * @param fbm_persist fractal brownian motion persistence
+   * @param fbm_seed    fractal brownian motion seed [0,1]
    * @param chunk_width the width of each chunk
    */
   static_hill_bg_t::static_hill_bg_t(SDL_Renderer& renderer,
                    int r,int g,int b,
                    float fbm_persist,
+                   float fbm_seed,
                    int width,
                    int height,
                    int amplitude,
                    int offset)
-    : width(width),
+    : x(0),
+      width(width),
       height(height),
       offset(offset),
       texture(NULL) {
 
     //generate textures
-    this->generate(renderer,fbm_persist,amplitude,r,g,b);
+    this->generate(renderer,fbm_persist,fbm_seed,amplitude,r,g,b);
   }
 
+  /**
+   * Constructor for an already generated strip (takes ownership)
+   * @param texture the hill texture
+   * @param x       the world x position of the strip
+   * @param width   the texture width
+   * @param height  the texture height
+   * @param offset  height offset during render
+   */
+  static_hill_bg_t::static_hill_bg_t(SDL_Texture* texture,
+                                     int x,
+                                     int width,
+                                     int height,
+                                     int offset)
+    : x(x),
+      width(width),
+      height(height),
+      offset(offset),
+      texture(texture) {}
+
   /**
    * Destructor to free sdl textures
    */
   static_hill_bg_t::~static_hill_bg_t() {
     if (this->texture != NULL) {
-      SDL_DestroyTexture(this->texture);
+      accounting::free_texture(this->texture);
       this->texture=NULL;
     }
   }
@@ -49,36 +130,21 @@ namespace tilemap {
    */
   void static_hill_bg_t::generate(SDL_Renderer& renderer,
                                  float fbm_persist,
+                                 float fbm_seed,
                                  int amplitude,
                                  int r, int g, int b) {
-
-    //fbm random seed
-    float fbm_seed = static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
-    float noise_val;
-    int hill_height;
-
-    environment::texture_constructor_t texture_constructor;
-    texture_constructor.set_default_color(r,g,b);
-
-    for (int i=0; i<width; i++) {
-      noise_val = noise::fractal_brownian_motion(fbm_seed,
-                                                 (float)i/width,
-                                                 fbm_persist);
-
-      hill_height = noise_val * amplitude;
-
-      if (hill_height >= height) {
-        hill_height = height - 4;
-      }
-
-      //draw this slice
-      texture_constructor.set_line(
-        i,hill_height,i,height,1
-      );
-    }
+    environment::gen_batch_t batch;
+    //one strip over the whole map
+    size_t idx = queue_hill_bg(batch,r,g,b,
+                               fbm_persist,fbm_seed,
+                               0,width,height,
+                               amplitude,width);
+    batch.generate(renderer);
 
     //set the texture
-    this->texture = texture_constructor.generate(renderer,width,height);
+    this->texture = batch.get(idx).texture;
+    this->width = batch.get(idx).w;
+    this->height = batch.get(idx).h;
   }
 
   /**
@@ -88,17 +154,21 @@ namespace tilemap {
    */
   void static_hill_bg_t::render(SDL_Renderer& renderer, const SDL_Rect& camera) const {
 
-    if (texture != NULL) {
+    //the visible part of this strip
+    int left = std::max(x, camera.x);
+    int right = std::min(x + width, camera.x + camera.w);
+
+    if ((texture != NULL) && (left < right)) {
       //data to sample from the hills texture
-      SDL_Rect sample_bounds = {camera.x, 0, camera.w, height};
+      SDL_Rect sample_bounds = {left - x, 0, right - left, height};
 
       //the x y position to render at
-      SDL_Rect image_bounds = {0,offset,camera.w,height};
+      SDL_Rect image_bounds = {left - camera.x,offset,right - left,height};
 
-      SDL_RenderCopy(&renderer,
-                     this->texture,
-                     &sample_bounds,
-                     &image_bounds);
+      draw::copy(&renderer,
+                 this->texture,
+                 &sample_bounds,
+                 &image_bounds);
     }
   }
 
@@ -9,16 +9,43 @@
 
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL.h>
+#include "../environment/gen_batch.h"
 
 namespace impl {
 namespace tilemap {
 
+  /**
+   * Queue a strip of hills for generation
+   * @param  batch       the generation batch
+   * @param  r,g,b       color
+   * @param  fbm_persist fractal brownian motion persistence
+   * @param  fbm_seed    fractal brownian motion seed [0,1]
+   * @param  x           the world x position of the strip
+   * @param  width       the width of the strip
+   * @param  height      the height of the strip
+   * @param  amplitude   the hill amplitude
+   * @param  noise_width the noise period in pixels
+   * @return             the index of the result in the batch
+   */
+  size_t queue_hill_bg(environment::gen_batch_t& batch,
+                       int r,int g,int b,
+                       float fbm_persist,
+                       float fbm_seed,
+                       int x,
+                       int width,
+                       int height,
+                       int amplitude,
+                       int noise_width);
+
   /*
    * Procedurally generated hill textures for background
    */
   struct static_hill_bg_t {
   private:
 
+    //the world x position of the texture
+    int x;
+
     //the dimensions of the texture
     int width;
     int height;
@@ -33,6 +60,7 @@ namespace tilemap {
      */
     void generate(SDL_Renderer& renderer,
                   float fbm_persist,
+                  float fbm_seed,
                   int amplitude,
                   int r, int g, int b);
   public:
@@ -41,21 +69,43 @@ namespace tilemap {
      * @param renderer    renderer for creating textures
      * @param r,g,b       color
      * @param fbm_persist fractal brownian motion persistence
+     * @param fbm_seed    fractal brownian motion seed [0,1]
      * @param chunk_width the width of each chunk
      */
     static_hill_bg_t(SDL_Renderer& renderer,
                      int r,int g,int b,
                      float fbm_persist,
+                     float fbm_seed,
                      int width,
                      int height,
                      int amplitude,
                      int offset);
+
+    /**
+     * Constructor for an already generated strip (takes ownership)
+     * @param texture the hill texture
+     * @param x       the world x position of the strip
+     * @param width   the texture width
+     * @param height  the texture height
+     * @param offset  height offset during render
+     */
+    static_hill_bg_t(SDL_Texture* texture,
+                     int x,
+                     int width,
+                     int height,
+                     int offset);
     static_hill_bg_t(const static_hill_bg_t&) = delete;
     static_hill_bg_t& operator=(const static_hill_bg_t&) = delete;
 
     //free textures
     ~static_hill_bg_t();
 
+    /**
+     * Get the size of the hill texture
+     * @return the texture size in bytes
+     */
+    size_t get_footprint() const { return (size_t) width * height * 4; }
+
     /**
      * Render the hills
      * @param renderer sdl renderer
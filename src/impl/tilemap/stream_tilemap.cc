@@ -0,0 +1,583 @@
+/*
+ * (C) 2021 Jack Hay
+ *
+ * Untitled Swamp game
+ */
+
+#include "stream_tilemap.h"
+#include "tileset_constructor.h"
+#include "tile_builder.h"
+#include "noise.h"
+#include "../rng.h"
+#include "../jobs.h"
+#include "../draw.h"
+#include <algorithm>
+
+namespace impl {
+namespace tilemap {
+
+  //chunk width in tiles
+  #define CHUNK_W 32
+
+  //columns generated on each side of a chunk so corner erosion
+  //matches the neighbouring chunks at the seams
+  #define CHUNK_APRON 16
+
+  //atlas page size for a chunk's plants (a chunk holds a few)
+  #define CHUNK_ATLAS_DIM 512
+
+  //terrain noise period in columns
+  #define STREAM_NOISE_PERIOD 300
+
+  //chunks kept loaded beyond the view on each side
+  #define STREAM_MARGIN 2
+  //extra chunks before a loaded chunk is dropped (avoids thrashing at a boundary)
+  #define STREAM_HYSTERESIS 2
+
+  //chunks generated up front so the player starts on the ground
+  #define STREAM_INITIAL_CHUNKS 3
+
+  //map width in chunks (keeps pixel positions within an int)
+  #define STREAM_MAX_CHUNKS 65536
+
+  #define HILL_NOISE_AMP 65
+  #define HILL_NOISE_AMP2 85
+  #define HILL_HEIGHT 200
+  #define HILL_OFFSET 8
+  #define HILL_OFFSET2 32
+
+  /**
+   * Constructor
+   * @param idx the chunk index
+   */
+  stream_chunk_t::stream_chunk_t(int idx)
+    : idx(idx),
+      tiles(),
+      fg_tiles(),
+      tileset_surfaces(),
+      tile_count(0),
+      plant_batch(),
+      plants(),
+      hill_batch(),
+      hill_idx{0,0},
+      hills(),
+      fore_ground(std::make_unique<map_components_t>(CHUNK_ATLAS_DIM)) {}
+
+  //free the tileset surfaces if never uploaded
+  stream_chunk_t::~stream_chunk_t() {
+    for (size_t i=0; i<tileset_surfaces.size(); i++) {
+      SDL_FreeSurface(tileset_surfaces.at(i));
+    }
+  }
+
+  /**
+   * Upload built pixels to textures (render thread)
+   * @param renderer the renderer
+   * @param dim      the tile dimension
+   */
+  void stream_chunk_t::upload(SDL_Renderer& renderer, int dim) {
+    //frees the surfaces (even if it throws)
+    std::vector<SDL_Surface*> surfaces;
+    surfaces.swap(tileset_surfaces);
+    tileset = upload_tileset(renderer, surfaces, dim, tile_count);
+
+    //skip ground under the dark fill
+    hide_covered_tiles(tiles, fg_tiles, *tileset);
+
+    plant_batch.upload(renderer, fore_ground->get_atlas());
+    place_fg_plants(*fore_ground, plant_batch, plants, dim);
+
+    hill_batch.upload(renderer);
+    int offsets[2] = {HILL_OFFSET, HILL_OFFSET2};
+    for (int i=0; i<2; i++) {
+      const environment::gen_result_t& hr = hill_batch.get(hill_idx[i]);
+      hills.push_back(std::make_unique<static_hill_bg_t>(
+        hr.texture,
+        idx * CHUNK_W * dim,
+        hr.w,
+        hr.h,
+        offsets[i]
+      ));
+    }
+  }
+
+  /**
+   * Get the approximate memory footprint of the chunk
+   * @return the footprint in bytes
+   */
+  size_t stream_chunk_t::get_footprint() const {
+    size_t total = fore_ground->get_footprint();
+
+    if (tileset) {
+      total += tileset->get_footprint();
+    }
+
+    for (size_t i=0; i<hills.size(); i++) {
+      total += hills.at(i)->get_footprint();
+    }
+
+    for (size_t i=0; i<tiles.size(); i++) {
+      total += (tiles.at(i).size() + fg_tiles.at(i).size()) * sizeof(tile_t);
+    }
+    return total;
+  }
+
+  /**
+   * Generate a chunk (CPU only, safe on any thread)
+   * @param  idx        the chunk index
+   * @param  dim        the tile dimension
+   * @param  tiles_down the number of rows
+   * @param  seed       the map seed
+   * @return            the chunk, ready for upload
+   */
+  static std::unique_ptr<stream_chunk_t> build_chunk(int idx, int dim, int tiles_down, uint64_t seed) {
+    std::unique_ptr<stream_chunk_t> chunk = std::make_unique<stream_chunk_t>(idx);
+
+    //generate the chunk plus an apron on each side
+    int grid_w = CHUNK_W + (2 * CHUNK_APRON);
+    int col_base = (idx * CHUNK_W) - CHUNK_APRON;
+
+    tile_grid_t tiles;
+    tiles.reserve(tiles_down);
+    for (int r=0; r<tiles_down; r++) {
+      tiles.emplace_back();
+      tiles.back().reserve(grid_w);
+      for (int c=0; c<grid_w; c++) {
+        //all tiles start as empty
+        tiles.back().push_back(tile_t(col_base + c,r,dim,-1));
+      }
+    }
+
+    tileset_constructor_t tileset_constructor(dim);
+
+    //set to default ground cover
+    tileset_constructor.set_default_color(
+      DARK_GREEN_R,
+      DARK_GREEN_G,
+      DARK_GREEN_B);
+
+    //add the zero tile
+    int grnd_tile = tileset_constructor.add_tile();
+    tileset_constructor.draw_rect(grnd_tile,0,0,dim,dim);
+
+    //terrain noise seed (shared by every chunk)
+    float fbm_seed = rng::rng_t(seed, rng::TERRAIN).next_float();
+
+    //heights depend only on the column, so they match the neighbouring chunks
+    std::vector<int> heights;
+    surface_heights(fbm_seed, col_base, grid_w, STREAM_NOISE_PERIOD, tiles_down, heights);
+
+    for (int i=0; i<grid_w; i++) {
+      int col = col_base + i;
+      int theight = heights.at(i);
+
+      //at the start of the world: add a wall
+      if (col == 0) {
+        tiles.at(theight-1).at(i).set_type(grnd_tile);
+        tiles.at(theight-1).at(i).set_solid(true);
+        tiles.at(theight-2).at(i).set_type(grnd_tile);
+        tiles.at(theight-2).at(i).set_solid(true);
+        tiles.at(theight-3).at(i).set_type(grnd_tile);
+        tiles.at(theight-3).at(i).set_solid(true);
+      }
+      tiles.at(theight).at(i).set_type(grnd_tile);
+      tiles.at(theight).at(i).set_solid(true);
+      tiles.at(theight+1).at(i).set_type(grnd_tile);
+      tiles.at(theight+2).at(i).set_type(grnd_tile);
+    }
+
+    //erode the corners of the surface tiles (the apron supplies the neighbours)
+    erode_grnd_corners(tiles, tileset_constructor, seed, col_base);
+
+    //keep only the chunk's own columns
+    for (int r=0; r<tiles_down; r++) {
+      std::pmr::vector<tile_t>& row = tiles.at(r);
+      row.erase(row.begin() + CHUNK_APRON + CHUNK_W, row.end());
+      row.erase(row.begin(), row.begin() + CHUNK_APRON);
+    }
+    chunk->tiles = std::move(tiles);
+
+    //empty foreground grid
+    chunk->fg_tiles.reserve(tiles_down);
+    for (int r=0; r<tiles_down; r++) {
+      chunk->fg_tiles.emplace_back();
+      chunk->fg_tiles.back().reserve(CHUNK_W);
+      for (int c=0; c<CHUNK_W; c++) {
+        chunk->fg_tiles.back().push_back(tile_t((idx * CHUNK_W) + c,r,dim,-1));
+      }
+    }
+
+    //generate foreground terrain tiles
+    add_fg_tiles(chunk->tiles, chunk->fg_tiles, tileset_constructor, seed, idx * CHUNK_W);
+    chunk->tileset_surfaces = tileset_constructor.generate_surfaces();
+    chunk->tile_count = tileset_constructor.get_tile_count();
+
+    //trees and bushes
+    queue_fg_plants(chunk->plant_batch, chunk->plants, chunk->tiles,
+                    seed, idx * CHUNK_W, 0, CHUNK_W);
+    chunk->plant_batch.build();
+
+    //hill strips under this chunk (far, near)
+    int x = idx * CHUNK_W * dim;
+    chunk->hill_idx[0] = queue_hill_bg(
+      chunk->hill_batch,
+      MED_LIGHT_GREEN_R,MED_LIGHT_GREEN_G,MED_LIGHT_GREEN_B,
+      FBM_PERSISTENCE_0_66,
+      rng::rng_t(seed, rng::HILLS, 0).next_float(),
+      x,CHUNK_W * dim,HILL_HEIGHT,
+      HILL_NOISE_AMP,
+      STREAM_NOISE_PERIOD * dim
+    );
+    chunk->hill_idx[1] = queue_hill_bg(
+      chunk->hill_batch,
+      MED_DARK_GREEN_R,MED_DARK_GREEN_G,MED_DARK_GREEN_B,
+      FBM_PERSISTENCE_0_66,
+      rng::rng_t(seed, rng::HILLS, 1).next_float(),
+      x,CHUNK_W * dim,HILL_HEIGHT,
+      HILL_NOISE_AMP2,
+      STREAM_NOISE_PERIOD * dim
+    );
+    chunk->hill_batch.build();
+
+    return chunk;
+  }
+
+  /**
+   * Constructor (generates the chunks around the start)
+   * @param dim      tile dimension
+   * @param height_p map height in pixels
+   * @param renderer the renderer for generating textures
+   * @param seed     the generation seed (same seed, same map)
+   */
+  stream_tilemap_t::stream_tilemap_t(int dim, int height_p,
+                                     SDL_Renderer& renderer,
+                                     uint64_t seed)
+    : dim(dim),
+      seed(seed),
+      height_p(height_p),
+      resident(),
+      pending(),
+      retired(),
+      ready(std::make_shared<stream_ready_t>()),
+      view_x(0),
+      view_w(0),
+      chunk_version(0),
+      bg_cache() {
+
+    //the start is needed immediately
+    for (int i=0; i<STREAM_INITIAL_CHUNKS; i++) {
+      std::unique_ptr<stream_chunk_t> chunk = build_chunk(i, dim, height_p / dim, seed);
+      chunk->upload(renderer, dim);
+      resident[i] = std::move(chunk);
+    }
+  }
+
+  /**
+   * Queue a chunk for generation on the job pool
+   * @param idx the chunk index
+   */
+  void stream_tilemap_t::request(int idx) {
+    pending.insert(idx);
+
+    //the job holds the ready list, not the map
+    std::shared_ptr<stream_ready_t> ready = this->ready;
+    int dim = this->dim;
+    int tiles_down = height_p / dim;
+    uint64_t seed = this->seed;
+
+    jobs::pool().submit([ready,idx,dim,tiles_down,seed]() {
+      std::unique_ptr<stream_chunk_t> chunk;
+      try {
+        chunk = build_chunk(idx, dim, tiles_down, seed);
+      } catch (...) {
+        //handed to the render thread
+        std::unique_lock<std::mutex> lk(ready->lock);
+        if (!ready->error) {
+          ready->error = std::current_exception();
+        }
+        return;
+      }
+
+      std::unique_lock<std::mutex> lk(ready->lock);
+      ready->chunks.push_back(std::move(chunk));
+    });
+  }
+
+  /**
+   * Upload finished chunks and free retired ones (render thread)
+   * @param renderer the renderer
+   */
+  void stream_tilemap_t::sync(SDL_Renderer& renderer) const {
+    //free textures of dropped chunks
+    retired.clear();
+
+    std::vector<std::unique_ptr<stream_chunk_t>> chunks;
+    std::exception_ptr error;
+    {
+      std::unique_lock<std::mutex> lk(ready->lock);
+      chunks.swap(ready->chunks);
+      error = ready->error;
+    }
+
+    //a chunk failed to generate
+    if (error) {
+      std::rethrow_exception(error);
+    }
+
+    for (size_t i=0; i<chunks.size(); i++) {
+      int idx = chunks.at(i)->idx;
+      pending.erase(idx);
+      chunks.at(i)->upload(renderer, dim);
+      resident[idx] = std::move(chunks.at(i));
+      chunk_version++;
+    }
+  }
+
+  /**
+   * Get the resident chunk containing a position
+   * @param  x the x coordinate
+   * @return   the chunk or NULL if not loaded
+   */
+  const stream_chunk_t* stream_tilemap_t::find_chunk(int x) const {
+    auto it = resident.find((x / dim) / CHUNK_W);
+    if (it == resident.end()) {
+      return NULL;
+    }
+    return it->second.get();
+  }
+
+  /**
+   * Check that a position is in bounds
+   * @return   whether the position is in bounds
+   */
+  bool stream_tilemap_t::in_bounds(int x, int y) const {
+    return (x >= 0) && (y >= 0) &&
+           (x < get_width()) &&
+           (y < height_p) &&
+           ((y / dim) < (height_p / dim));
+  }
+
+  /**
+   * Get a tile (PRECOND: in_bounds called)
+   * @return   the tile at that position or NULL if not loaded
+   */
+  const tile_t* stream_tilemap_t::get_tile(int x, int y) const {
+    const stream_chunk_t *chunk = find_chunk(x);
+    if (chunk == NULL) {
+      return NULL;
+    }
+    return &chunk->tiles.at(y / dim).at((x / dim) % CHUNK_W);
+  }
+
+  /**
+   * Check if the tile at a position is solid
+   * (columns not loaded yet are solid)
+   * @param  x the x coordinate
+   * @param  y the y coordinate
+   * @return   whether the tile at this position is solid
+   */
+  bool stream_tilemap_t::is_solid(int x, int y) const {
+    if (!this->in_bounds(x,y)) {
+      return false;
+    }
+    const tile_t *tile = this->get_tile(x,y);
+    return (tile == NULL) || tile->is_solid();
+  }
+
+  /**
+   * Check if the tile at a position is liquid
+   * @param  x the x coordinate
+   * @param  y the y coordinate
+   * @return   whether the tile at this position is liquid
+   */
+  bool stream_tilemap_t::is_liquid(int x, int y) const {
+    if (!this->in_bounds(x,y)) {
+      return false;
+    }
+    const tile_t *tile = this->get_tile(x,y);
+    return (tile != NULL) && tile->is_liquid();
+  }
+
+  /**
+   * Check if a bounding box collides with some solid tile
+   * @param  other the bounding box
+   * @return       whether the bounding box collides
+   */
+  bool stream_tilemap_t::is_collided(const SDL_Rect& other) const {
+    //get the tiles that might intersect
+    for (int i=(other.x - dim); i<(other.w + other.x + (2 * dim)); i+=(dim / 2)) {
+      for (int j=(other.y - dim); j<(other.h + other.y + (2 * dim)); j+=(dim / 2)) {
+        if (this->in_bounds(i,j)) {
+          //get the tile
+          const tile_t *curr = this->get_tile(i,j);
+
+          //not loaded: block until it is
+          if (curr == NULL) {
+            SDL_Rect col = {(i / dim) * dim, (j / dim) * dim, dim, dim};
+            if (SDL_HasIntersection(&col, &other)) {
+              return true;
+            }
+
+          //check for a solid collision
+          } else if (curr->is_collided(other) && curr->is_solid()) {
+            return true;
+          }
+        }
+      }
+    }
+    return false;
+  }
+
+  /**
+   * Check if a position collides with some solid tile
+   * @param  x position x
+   * @param  y position y
+   * @return   whether this position collides with a solid tile
+   */
+  bool stream_tilemap_t::is_collided(int x, int y) const {
+    //generate positions that might intersect
+    for (int i=(x - dim); i<(x + dim); i+=(dim / 2)) {
+      for (int j=(y - dim); j<(y + dim); j+=(dim / 2)) {
+        //check if the current tile is collided and solid
+        if (this->in_bounds(i,j)) {
+
+          //get the tile
+          const tile_t *curr = this->get_tile(i,j);
+          if (curr == NULL) {
+            //not loaded: block until it is
+            if (((x / dim) == (i / dim)) && ((y / dim) == (j / dim))) {
+              return true;
+            }
+
+          } else if (curr->is_collided(x,y) && curr->is_solid()) {
+            return true;
+          }
+        }
+      }
+    }
+    return false;
+  }
+
+  /**
+   * Get the width of the map in pixels
+   * @return the width of the map in pixels
+   */
+  int stream_tilemap_t::get_width() const {
+    return STREAM_MAX_CHUNKS * CHUNK_W * dim;
+  }
+
+  /**
+   * Get the height of the map in pixels
+   * @return the height of the map in pixels
+   */
+  int stream_tilemap_t::get_height() const {
+    return height_p;
+  }
+
+  /**
+   * Get the approximate memory footprint of the map
+   * (resident chunks only)
+   * @return the footprint in bytes
+   */
+  size_t stream_tilemap_t::get_footprint() const {
+    size_t total = 0;
+    for (auto it=resident.begin(); it!=resident.end(); it++) {
+      total += it->second->get_footprint();
+    }
+    return total;
+  }
+
+  /**
+   * Update any updatable tiles, request chunks near the camera
+   * and drop distant ones
+   */
+  void stream_tilemap_t::update() {
+    for (auto it=resident.begin(); it!=resident.end(); it++) {
+      it->second->fore_ground->update();
+    }
+
+    //the chunk range around the last rendered view
+    int chunk_p = CHUNK_W * dim;
+    int first = (view_x / chunk_p) - STREAM_MARGIN;
+    int last = ((view_x + view_w) / chunk_p) + STREAM_MARGIN;
+
+    //request missing chunks
+    for (int c=std::max(first, 0); c<=std::min(last, STREAM_MAX_CHUNKS - 1); c++) {
+      if ((resident.find(c) == resident.end()) && (pending.find(c) == pending.end())) {
+        request(c);
+      }
+    }
+
+    //drop chunks well outside the range
+    for (auto it=resident.begin(); it!=resident.end();) {
+      if ((it->first < (first - STREAM_HYSTERESIS)) ||
+          (it->first > (last + STREAM_HYSTERESIS))) {
+        //textures are freed on the render thread
+        retired.push_back(std::move(it->second));
+        it = resident.erase(it);
+        chunk_version++;
+      } else {
+        it++;
+      }
+    }
+  }
+
+  /**
+   * Render the background tilemap elements
+   * Note: this includes the entity layer
+   * @param renderer the sdl renderer
+   * @param camera   the camera
+   * @param debug    whether debug mode enabled
+   */
+  void stream_tilemap_t::render_bg(SDL_Renderer& renderer, const SDL_Rect& camera, bool debug) const {
+    //used by update to pick chunks
+    view_x = camera.x;
+    view_w = camera.w;
+
+    this->sync(renderer);
+
+    SDL_Rect bounds = {-1,-1,camera.w+2,camera.h+2};
+    //draw the background color
+    SDL_SetRenderDrawColor(&renderer,
+                          LIGHT_GREEN_R,
+                          LIGHT_GREEN_G,
+                          LIGHT_GREEN_B,255);
+    draw::fill_rect(&renderer,&bounds);
+
+    //render background hills (far strips first)
+    for (size_t h=0; h<2; h++) {
+      for (auto it=resident.begin(); it!=resident.end(); it++) {
+        it->second->hills.at(h)->render(renderer,camera);
+      }
+    }
+
+    //draw tiles (redrawn only where scrolled into view)
+    if (debug) {
+      for (auto it=resident.begin(); it!=resident.end(); it++) {
+        render_tiles(renderer,camera,it->second->tiles,*it->second->tileset,debug);
+      }
+    } else {
+      bg_cache.render(renderer,camera,chunk_version,[this,&renderer](const SDL_Rect& view) {
+        for (auto it=resident.begin(); it!=resident.end(); it++) {
+          render_tiles(renderer,view,it->second->tiles,*it->second->tileset,false);
+        }
+      });
+    }
+  }
+
+  /**
+   * Render the foreground tilemap elements
+   * @param renderer the sdl renderer
+   * @param camera   the camera
+   * @param debug    whether debug mode enabled
+   */
+  void stream_tilemap_t::render_fg(SDL_Renderer& renderer, const SDL_Rect& camera, bool debug) const {
+    for (auto it=resident.begin(); it!=resident.end(); it++) {
+      //draw foreground components
+      it->second->fore_ground->render(renderer,camera,debug);
+
+      //draw tiles
+      render_tiles(renderer,camera,it->second->fg_tiles,*it->second->tileset,debug);
+    }
+  }
+}}
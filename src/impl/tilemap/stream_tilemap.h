@@ -0,0 +1,258 @@
+/*
+ * (C) 2021 Jack Hay
+ *
+ * Untitled Swamp game
+ */
+
+#ifndef _IO_JACKHAY_SWAMP_STREAM_TILEMAP_H
+#define _IO_JACKHAY_SWAMP_STREAM_TILEMAP_H
+
+#include <vector>
+#include <map>
+#include <set>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <exception>
+#include "abstract_tilemap.h"
+#include "tile.h"
+#include "tileset.h"
+#include "static_hill_bg.h"
+#include "map_components.h"
+#include "terrain_gen.h"
+#include "bg_cache.h"
+#include "../environment/gen_batch.h"
+#include <SDL2/SDL_image.h>
+#include <SDL2/SDL.h>
+
+namespace impl {
+namespace tilemap {
+
+  /**
+   * A column chunk of a streamed procedural map
+   * Built on the job pool, uploaded on the render thread
+   */
+  struct stream_chunk_t {
+    //the chunk index (world column / chunk width)
+    int idx;
+
+    //ground and foreground tiles (tile x is the world column)
+    tile_grid_t tiles;
+    tile_grid_t fg_tiles;
+
+    //built tileset pages waiting for upload
+    std::vector<SDL_Surface*> tileset_surfaces;
+    //the tile types on those pages
+    int tile_count;
+
+    //the tileset (after upload)
+    std::shared_ptr<tileset_t> tileset;
+
+    //built plants waiting for upload
+    environment::gen_batch_t plant_batch;
+    std::vector<fg_plant_t> plants;
+
+    //built hill strips waiting for upload (far, near)
+    environment::gen_batch_t hill_batch;
+    size_t hill_idx[2];
+
+    //hill strips (after upload)
+    std::vector<std::unique_ptr<static_hill_bg_t>> hills;
+
+    //foreground map components (after upload)
+    std::unique_ptr<map_components_t> fore_ground;
+
+    stream_chunk_t(int idx);
+    stream_chunk_t(const stream_chunk_t&) = delete;
+    stream_chunk_t& operator=(const stream_chunk_t&) = delete;
+
+    //free the tileset surfaces if never uploaded
+    ~stream_chunk_t();
+
+    /**
+     * Upload built pixels to textures (render thread)
+     * @param renderer the renderer
+     * @param dim      the tile dimension
+     */
+    void upload(SDL_Renderer& renderer, int dim);
+
+    /**
+     * Get the approximate memory footprint of the chunk
+     * @return the footprint in bytes
+     */
+    size_t get_footprint() const;
+  };
+
+  /**
+   * Chunks finished by the job pool (shared with pending jobs
+   * so a chunk finishing after the map is gone is still freed)
+   */
+  struct stream_ready_t {
+    std::mutex lock;
+    std::vector<std::unique_ptr<stream_chunk_t>> chunks;
+    //the first chunk that failed to generate (rethrown by sync)
+    std::exception_ptr error;
+  };
+
+  /**
+   * Defines a procedurally generated map that extends indefinitely
+   * to the right. Chunks of columns are generated in the background as
+   * the camera approaches them and dropped once it moves far enough away
+   * (Uses the same interface as the regular tilemap)
+   */
+  struct stream_tilemap_t : public abstract_tilemap_t {
+  private:
+    //dimension of tiles
+    int dim;
+
+    //the seed for all generation in this map
+    uint64_t seed;
+
+    //height of map in pixels
+    int height_p;
+
+    //chunks in memory by index
+    //(render and update never run at the same time, both modify this)
+    mutable std::map<int, std::unique_ptr<stream_chunk_t>> resident;
+
+    //chunks requested but not yet uploaded
+    mutable std::set<int> pending;
+
+    //chunks dropped by update, freed on the render thread
+    mutable std::vector<std::unique_ptr<stream_chunk_t>> retired;
+
+    //finished chunks waiting for upload
+    std::shared_ptr<stream_ready_t> ready;
+
+    //the last camera position rendered
+    mutable std::atomic<int> view_x;
+    mutable std::atomic<int> view_w;
+
+    //changes whenever chunks are added or dropped
+    mutable int chunk_version;
+
+    //ground tiles around the camera
+    mutable bg_cache_t bg_cache;
+
+    /**
+     * Queue a chunk for generation on the job pool
+     * @param idx the chunk index
+     */
+    void request(int idx);
+
+    /**
+     * Upload finished chunks and free retired ones (render thread)
+     * @param renderer the renderer
+     */
+    void sync(SDL_Renderer& renderer) const;
+
+    /**
+     * Get the resident chunk containing a position
+     * @param  x the x coordinate
+     * @return   the chunk or NULL if not loaded
+     */
+    const stream_chunk_t* find_chunk(int x) const;
+
+    /**
+     * Check that a position is in bounds
+     * @return   whether the position is in bounds
+     */
+    bool in_bounds(int x, int y) const;
+
+    /**
+     * Get a tile (PRECOND: in_bounds called)
+     * @return   the tile at that position or NULL if not loaded
+     */
+    const tile_t* get_tile(int x, int y) const;
+
+  public:
+    /**
+     * Constructor (generates the chunks around the start)
+     * @param dim      tile dimension
+     * @param height_p map height in pixels
+     * @param renderer the renderer for generating textures
+     * @param seed     the generation seed (same seed, same map)
+     */
+    stream_tilemap_t(int dim, int height_p,
+                     SDL_Renderer& renderer,
+                     uint64_t seed);
+    stream_tilemap_t(const stream_tilemap_t&) = delete;
+    stream_tilemap_t& operator=(const stream_tilemap_t&) = delete;
+
+    /**
+     * Check if the tile at a position is solid
+     * (columns not loaded yet are solid)
+     * @param  x the x coordinate
+     * @param  y the y coordinate
+     * @return   whether the tile at this position is solid
+     */
+    bool is_solid(int x, int y) const override;
+
+    /**
+     * Check if the tile at a position is liquid
+     * @param  x the x coordinate
+     * @param  y the y coordinate
+     * @return   whether the tile at this position is liquid
+     */
+    bool is_liquid(int x, int y) const override;
+
+    /**
+     * Check if a bounding box collides with some solid tile
+     * @param  other the bounding box
+     * @return       whether the bounding box collides
+     */
+    bool is_collided(const SDL_Rect& other) const override;
+
+    /**
+     * Check if a position collides with some solid tile
+     * @param  x position x
+     * @param  y position y
+     * @return   whether this position collides with a solid tile
+     */
+    bool is_collided(int x, int y) const override;
+
+    /**
+     * Get the width of the map in pixels
+     * @return the width of the map in pixels
+     */
+    int get_width() const override;
+
+    /**
+     * Get the height of the map in pixels
+     * @return the height of the map in pixels
+     */
+    int get_height() const override;
+
+    /**
+     * Get the approximate memory footprint of the map
+     * (resident chunks only)
+     * @return the footprint in bytes
+     */
+    size_t get_footprint() const override;
+
+    /**
+     * Update any updatable tiles, request chunks near the camera
+     * and drop distant ones
+     */
+    void update() override;
+
+    /**
+     * Render the background tilemap elements
+     * Note: this includes the entity layer
+     * @param renderer the sdl renderer
+     * @param camera   the camera
+     * @param debug    whether debug mode enabled
+     */
+    void render_bg(SDL_Renderer& renderer, const SDL_Rect& camera, bool debug) const override;
+
+    /**
+     * Render the foreground tilemap elements
+     * @param renderer the sdl renderer
+     * @param camera   the camera
+     * @param debug    whether debug mode enabled
+     */
+    void render_fg(SDL_Renderer& renderer, const SDL_Rect& camera, bool debug) const override;
+  };
+}}
+
+#endif /*_IO_JACKHAY_SWAMP_STREAM_TILEMAP_H*/
@@ -0,0 +1,478 @@
+/*
+ * (C) 2021 Jack Hay
+ *
+ * Untitled Swamp game
+ */
+
+#include "terrain_gen.h"
+#include "tile_builder.h"
+#include "noise.h"
+#include "../rng.h"
+#include "../cache.h"
+#include "../environment/proc_generation.h"
+#include <algorithm>
+
+namespace impl {
+namespace tilemap {
+
+  // 1/FG_TREE_RATE chance of a tree @ each tile position
+  #define FG_TREE_RATE 6
+  // 1/FG_ANIM_RATE the rate at which foreground trees have animated foliage
+  #define FG_ANIM_RATE 4
+  //foreground tree leaf density
+  #define FG_LEAF_COUNT 200
+  //foliage animation frame duration
+  #define FG_TREE_FRAME_DURATION 10
+
+  //whether to add a bush (only if we didn't add a tree)
+  #define FG_BUSH_RATE 3
+
+  /**
+   * Clamp a value
+   * @param min  the min value (incl)
+   * @param  val the value
+   * @param  max the max
+   * @return     clamped [min,max)
+   */
+  size_t clamp(size_t min, int val, size_t max) {
+    if (val < (int)min) {
+      return min;
+    }
+    if (val >= (int)max) {
+      return max - 1;
+    }
+    return val;
+  }
+
+  /**
+   * Get the ground tile (first solid) for a given column
+   * @param  tiles the ground tiles
+   * @param  x     the column
+   * @return       the tile
+   */
+  tile_t& grnd_tile(tile_grid_t& tiles, int x) {
+    //look through each row
+    for (size_t i=0; i<tiles.size(); i++) {
+      //check if the x coord is in the bounds of this row
+      if ((x >= 0) && (x < (int)tiles.at(i).size())) {
+        //return first solid in col
+        if (tiles.at(i).at(x).is_solid()) {
+          return tiles.at(i).at(x);
+        }
+      }
+    }
+    return tiles.back().at(x);
+  }
+
+  /**
+   * Get the ground tile (first solid) for a given column
+   * @param  tiles the ground tiles
+   * @param  x     the column
+   * @return       the tile
+   */
+  const tile_t& grnd_tile(const tile_grid_t& tiles, int x) {
+    //look through each row
+    for (size_t i=0; i<tiles.size(); i++) {
+      //check if the x coord is in the bounds of this row
+      if ((x >= 0) && (x < (int)tiles.at(i).size())) {
+        //return first solid in col
+        if (tiles.at(i).at(x).is_solid()) {
+          return tiles.at(i).at(x);
+        }
+      }
+    }
+    return tiles.back().at(x);
+  }
+
+  /**
+   * Get the raw surface height of a world column
+   * @param  fbm_seed   the terrain noise seed
+   * @param  col        the world column
+   * @param  period     noise period in columns
+   * @param  tiles_down the number of rows
+   * @return            the height (row index)
+   */
+  int raw_surface_height(float fbm_seed, int col, int period, int tiles_down) {
+    //start ground height roughly 1/3 of total height
+    int ground = (int) 2 * (tiles_down / 3);
+
+    //create an fbm value
+    float noise_val = noise::fractal_brownian_motion(fbm_seed,
+                                                     (float)col/period,
+                                                     FBM_PERSISTENCE_0_75);
+
+    //get the tile height at this position
+    return clamp(TERRAIN_MIN_IDX,
+                 ground - (noise_val * 10),
+                 tiles_down-3);
+  }
+
+  /**
+   * Get the surface heights of a range of world columns, neighbouring
+   * columns are within 1 of each other. Each height depends only on its
+   * column (not on where the range starts), so separately generated
+   * ranges meet without a step
+   * @param fbm_seed   the terrain noise seed
+   * @param first_col  the first world column
+   * @param count      the number of columns
+   * @param period     noise period in columns
+   * @param tiles_down the number of rows
+   * @param heights    the heights set by the call (row indices)
+   */
+  void surface_heights(float fbm_seed,
+                       int first_col,
+                       int count,
+                       int period,
+                       int tiles_down,
+                       std::vector<int>& heights) {
+    //the height is the lowest raw height plus the distance to it:
+    //min(raw(k) + |col - k|), which never steps more than 1 per column.
+    //raw heights lie in [TERRAIN_MIN_IDX, tiles_down-3], so a column further
+    //than that range can't beat the column's own raw height and the window
+    //gives the same result as searching every column
+    int reach = std::max((tiles_down - 3) - TERRAIN_MIN_IDX, 0);
+
+    std::vector<int> raw;
+    raw.reserve(count + (2 * reach));
+    for (int k=first_col-reach; k<first_col+count+reach; k++) {
+      raw.push_back(raw_surface_height(fbm_seed, k, period, tiles_down));
+    }
+
+    heights.clear();
+    heights.reserve(count);
+    for (int i=0; i<count; i++) {
+      //raw.at(i + reach) is this column
+      int height = raw.at(i + reach);
+      for (int d=1; d<=reach; d++) {
+        height = std::min(height, std::min(raw.at(i + reach - d), raw.at(i + reach + d)) + d);
+      }
+      heights.push_back(height);
+    }
+  }
+
+  /**
+   * Erode the corners of ground tiles based on slope
+   * @param tiles               the ground tiles
+   * @param tileset_constructor the tileset constructor
+   * @param seed                the generation seed
+   * @param col_base            the world column of the first grid column
+   */
+  void erode_grnd_corners(tile_grid_t& tiles,
+                          tileset_constructor_t& tileset_constructor,
+                          uint64_t seed,
+                          int col_base) {
+    //get the height of the first tile
+    tile_builder::tile_slope prev_slope = tile_builder::FLAT;
+
+    //whether we need to fill in a one-wide gap (looks bad)
+    bool dropped_down = false;
+
+    //for each column
+    for (size_t i=1; i<(tiles.at(0).size() - 1); i++) {
+      //get the current ground tile
+      tile_t& curr_tile = grnd_tile(tiles,i);
+      int curr_y_depth = curr_tile.get_y_depth();
+      tile_t& prev_tile = grnd_tile(tiles,i-1);
+      int prev_y_depth = prev_tile.get_y_depth();
+      //per column stream
+      rng::rng_t col_rng(seed, rng::GRND_TILES, col_base + i);
+
+      //check if this tile should slope up
+      if (curr_y_depth < prev_y_depth) {
+        if (dropped_down) {
+          //fill in gap
+          tiles.at(prev_tile.get_y_idx() - 1).at(i-1).set_type(0);
+          tiles.at(prev_tile.get_y_idx() - 1).at(i-1).set_solid(true);
+          tiles.at(prev_tile.get_y_idx() - 1).at(i-2).set_type(0);
+          tiles.at(prev_tile.get_y_idx() - 1).at(i-2).set_solid(true);
+
+        } else {
+          prev_slope = tile_builder::SLOPE_L;
+
+          //make a new tile
+          curr_tile.set_type(tile_builder::make_grnd_tile(tileset_constructor,
+                                                          col_rng,
+                                                          tile_builder::SLOPE_L));
+
+          //add non colliding slope
+          tiles.at(prev_tile.get_y_idx() - 1).at(i-1).set_type(
+            tile_builder::make_low_slope_grnd_tile(tileset_constructor,
+                                                   tile_builder::SLOPE_L)
+          );
+        }
+
+        dropped_down = false;
+
+      } else if (curr_y_depth > prev_y_depth) {
+        //we dropped down
+        dropped_down = true;
+
+        //previous tile should slope down or both
+        if (prev_slope == tile_builder::SLOPE_L) {
+          //the tile may be shared, edit a copy
+          int type = tileset_constructor.copy_tile(prev_tile.get_type());
+          tile_builder::edit_grnd_tile(tileset_constructor,
+                                       col_rng,
+                                       type,
+                                       tile_builder::SLOPE_BOTH);
+          prev_tile.set_type(tileset_constructor.finish_tile(type));
+
+          prev_slope = tile_builder::FLAT;
+
+        } else {
+          //make a new tile
+          prev_tile.set_type(tile_builder::make_grnd_tile(tileset_constructor,
+                                                          col_rng,
+                                                          tile_builder::SLOPE_R));
+
+          //no change to current tile
+          prev_slope = tile_builder::FLAT;
+        }
+
+        //add non colliding slope
+        tiles.at(curr_tile.get_y_idx() - 1).at(i).set_type(
+          tile_builder::make_low_slope_grnd_tile(tileset_constructor,
+                                                 tile_builder::SLOPE_R)
+        );
+
+      } else {
+        //no change to current tile
+        prev_slope = tile_builder::FLAT;
+
+        // TODO don't draw on top of slopes
+        //add ground uneveness
+        // tiles.at(curr_tile.get_y_idx() - 1).at(i).set_type(
+        //   tile_builder::make_flat_grnd_tile(tileset_constructor)
+        // );
+
+        //flat (looking for single wide hollows)
+        dropped_down = false;
+      }
+    }
+  }
+
+  /**
+   * Add the foreground surface and dark fill tiles
+   * @param tiles               the ground tiles
+   * @param fg_tiles            the foreground tiles
+   * @param tileset_constructor the tileset constructor
+   * @param seed                the generation seed
+   * @param col_base            the world column of the first grid column
+   */
+  void add_fg_tiles(const tile_grid_t& tiles,
+                    tile_grid_t& fg_tiles,
+                    tileset_constructor_t& tileset_constructor,
+                    uint64_t seed,
+                    int col_base) {
+    //add dark tiles
+    tileset_constructor.set_default_color(
+      DARK_R,
+      DARK_G,
+      DARK_B
+    );
+
+    //create a dark foreground tile
+    int dark_tile = tileset_constructor.add_tile();
+    tileset_constructor.fill_tile(
+      dark_tile,
+      DARK_R,
+      DARK_G,
+      DARK_B
+    );
+
+    for (size_t i=0; i<fg_tiles.at(0).size(); i++) {
+      //get the terrain height here
+      int gidx = grnd_tile(tiles,i).get_y_idx();
+      //per column stream
+      rng::rng_t tile_rng(seed, rng::FG_TILES, col_base + i);
+
+      //create a rough ground tile at this level
+      fg_tiles.at(gidx).at(i).set_type(
+        tile_builder::make_fg_surface_tile(tileset_constructor, tile_rng)
+      );
+
+      //add solid tiles below this point
+      for (int t=(gidx+1); t<(int)fg_tiles.size(); t++) {
+        fg_tiles.at(t).at(i).set_type(dark_tile);
+      }
+    }
+  }
+
+  /**
+   * Hide ground tiles covered by opaque foreground tiles
+   * @param tiles    the ground tiles
+   * @param fg_tiles the foreground tiles (same grid)
+   * @param tileset  the tileset both sample
+   */
+  void hide_covered_tiles(tile_grid_t& tiles,
+                          const tile_grid_t& fg_tiles,
+                          const tileset_t& tileset) {
+    for (size_t r=0; (r<tiles.size()) && (r<fg_tiles.size()); r++) {
+      for (size_t c=0; (c<tiles.at(r).size()) && (c<fg_tiles.at(r).size()); c++) {
+        tiles.at(r).at(c).set_hidden(tileset.is_opaque(fg_tiles.at(r).at(c).get_type()));
+      }
+    }
+  }
+
+  /**
+   * Render a grid of tiles, merging single colour runs
+   * (debug mode renders each tile so bounds are drawn)
+   * @param renderer the sdl renderer
+   * @param camera   the camera
+   * @param tiles    the tiles
+   * @param tileset  the tileset the tiles sample
+   * @param debug    whether debug mode enabled
+   */
+  void render_tiles(SDL_Renderer& renderer,
+                    const SDL_Rect& camera,
+                    const tile_grid_t& tiles,
+                    const tileset_t& tileset,
+                    bool debug) {
+    fill_run_t run(renderer);
+
+    for (size_t r=0; r<tiles.size(); r++) {
+      for (size_t c=0; c<tiles.at(r).size(); c++) {
+        const tile_t& tile = tiles.at(r).at(c);
+
+        if (debug || !run.add(tile, tileset, camera)) {
+          //render the tile
+          tile.render(
+            renderer,
+            camera,
+            tileset,
+            false,
+            debug
+          );
+        }
+      }
+    }
+    run.flush();
+  }
+
+  /**
+   * Decide where trees and bushes go and queue them for generation
+   * @param batch    the generation batch
+   * @param plants   the queued plants (added to by the call)
+   * @param tiles    the ground tiles
+   * @param seed     the generation seed
+   * @param col_base the world column of the first grid column
+   * @param first    the first grid column to populate
+   * @param last     one past the last grid column to populate
+   */
+  void queue_fg_plants(environment::gen_batch_t& batch,
+                       std::vector<fg_plant_t>& plants,
+                       const tile_grid_t& tiles,
+                       uint64_t seed,
+                       int col_base,
+                       size_t first,
+                       size_t last) {
+    for (size_t i=first; i<last; i++) {
+      //get the terrain height here
+      int gidx = grnd_tile(tiles,i).get_y_idx();
+      int col = col_base + i;
+      //per column stream
+      rng::rng_t plant_rng(seed, rng::FG_PLANTS, col);
+
+      //everything that affects the plant's pixels
+      cache::key_t key("procedural_fg_plant");
+      key.add(50).add(150).add(FG_LEAF_COUNT)
+         .add_rgb(DARK_R,DARK_G,DARK_B)
+         .add_rgb(DARK_GREEN_R,DARK_GREEN_G,DARK_GREEN_B);
+
+      //add a tree with some probability
+      if (plant_rng.next_int(FG_TREE_RATE) == 0) {
+        //trees sometimes have animated foliage
+        bool animated = plant_rng.next_int(FG_ANIM_RATE) == 0;
+        key.add(plant_rng.get_state()).add(animated);
+
+        size_t idx = batch.add(
+          [plant_rng,animated](environment::texture_constructor_t& tree_constructor) mutable {
+          //generate a tree
+          environment::proc_generation::branching_tree_growth(
+            tree_constructor,
+            plant_rng,
+            50,150,
+            DARK_R,
+            DARK_G,
+            DARK_B
+          );
+
+          if (animated) {
+            //add foliage
+            environment::proc_generation::trunk_foliage(tree_constructor,
+                                                        plant_rng,
+                                                        FG_LEAF_COUNT,
+                                                        DARK_GREEN_R,
+                                                        DARK_GREEN_G,
+                                                        DARK_GREEN_B,
+                                                        true, //foreground (1 color)
+                                                        DARK_GREEN_R,
+                                                        DARK_GREEN_G,
+                                                        DARK_GREEN_B);
+          }
+        }, key.get());
+        plants.push_back({col, gidx, false, animated, idx});
+
+      } else if (plant_rng.next_int(FG_BUSH_RATE) == 0) {
+        key.add(plant_rng.get_state()).add(1);
+
+        size_t idx = batch.add(
+          [plant_rng](environment::texture_constructor_t& bush_constructor) mutable {
+          //generate a tree
+          environment::proc_generation::branching_tree_growth(
+            bush_constructor,
+            plant_rng,
+            50,150,
+            DARK_R,
+            DARK_G,
+            DARK_B,
+            1 // starting volume
+          );
+        }, key.get());
+        plants.push_back({col, gidx, true, false, idx});
+      }
+    }
+  }
+
+  /**
+   * Add generated plants to the foreground (after upload)
+   * @param fore_ground the foreground components
+   * @param batch       the batch (uploaded to the foreground atlas)
+   * @param plants      the plants
+   * @param dim         the tile dimension
+   */
+  void place_fg_plants(map_components_t& fore_ground,
+                       const environment::gen_batch_t& batch,
+                       const std::vector<fg_plant_t>& plants,
+                       int dim) {
+    for (size_t p=0; p<plants.size(); p++) {
+      const fg_plant_t& plant = plants.at(p);
+      const environment::gen_result_t& tr = batch.get(plant.batch_idx);
+      int x = plant.col*dim;
+
+      if (plant.bush) {
+        //add a static texture
+        fore_ground.add_static(
+          tr.region,
+          {x - (tr.w / 2),(plant.gidx+3)*dim - tr.h,tr.w,tr.h}
+        );
+
+      } else if (plant.animated) {
+        //add a dynamic texture
+        fore_ground.add_dynamic(
+          tr.region,
+          {x,(plant.gidx+1)*dim - tr.h,tr.w,tr.h},
+          tr.frames,
+          FG_TREE_FRAME_DURATION
+        );
+
+      } else {
+        //add a static texture
+        fore_ground.add_static(
+          tr.region,
+          {x - (tr.w / 2),(plant.gidx+2)*dim - tr.h,tr.w,tr.h}
+        );
+      }
+    }
+  }
+}}
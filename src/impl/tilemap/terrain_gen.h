@@ -0,0 +1,174 @@
+/*
+ * (C) 2021 Jack Hay
+ *
+ * Untitled Swamp game
+ */
+
+#ifndef _IO_JACKHAY_SWAMP_TILEMAP_TERRAIN_GEN_H
+#define _IO_JACKHAY_SWAMP_TILEMAP_TERRAIN_GEN_H
+
+#include <vector>
+#include <memory_resource>
+#include <cstdint>
+#include "tile.h"
+#include "tileset_constructor.h"
+#include "map_components.h"
+#include "../environment/gen_batch.h"
+
+namespace impl {
+namespace tilemap {
+
+  /*
+   * Procedural terrain steps shared by the fixed size and the
+   * streamed procedural tilemaps. Each works on a grid of columns
+   * where column i has the world column col_base + i (for random streams)
+   */
+
+  //rows of tiles (rows share the grid's resource)
+  typedef std::pmr::vector<std::pmr::vector<tile_t>> tile_grid_t;
+
+  //the minimum terrain index in the tilemap (headroom)
+  #define TERRAIN_MIN_IDX 10
+
+  /**
+   * A tree or bush queued for generation
+   */
+  struct fg_plant_t {
+    //world column
+    int col;
+    //ground tile row
+    int gidx;
+    bool bush;
+    bool animated;
+    //index in the generation batch
+    size_t batch_idx;
+  };
+
+  /**
+   * Get the ground tile (first solid) for a given column
+   * @param  tiles the ground tiles
+   * @param  x     the column
+   * @return       the tile
+   */
+  tile_t& grnd_tile(tile_grid_t& tiles, int x);
+
+  /**
+   * Get the ground tile (first solid) for a given column
+   * @param  tiles the ground tiles
+   * @param  x     the column
+   * @return       the tile
+   */
+  const tile_t& grnd_tile(const tile_grid_t& tiles, int x);
+
+  /**
+   * Get the raw surface height of a world column
+   * @param  fbm_seed   the terrain noise seed
+   * @param  col        the world column
+   * @param  period     noise period in columns
+   * @param  tiles_down the number of rows
+   * @return            the height (row index)
+   */
+  int raw_surface_height(float fbm_seed, int col, int period, int tiles_down);
+
+  /**
+   * Get the surface heights of a range of world columns, neighbouring
+   * columns are within 1 of each other. Each height depends only on its
+   * column (not on where the range starts), so separately generated
+   * ranges meet without a step
+   * @param fbm_seed   the terrain noise seed
+   * @param first_col  the first world column
+   * @param count      the number of columns
+   * @param period     noise period in columns
+   * @param tiles_down the number of rows
+   * @param heights    the heights set by the call (row indices)
+   */
+  void surface_heights(float fbm_seed,
+                       int first_col,
+                       int count,
+                       int period,
+                       int tiles_down,
+                       std::vector<int>& heights);
+
+  /**
+   * Erode the corners of ground tiles based on slope
+   * @param tiles               the ground tiles
+   * @param tileset_constructor the tileset constructor
+   * @param seed                the generation seed
+   * @param col_base            the world column of the first grid column
+   */
+  void erode_grnd_corners(tile_grid_t& tiles,
+                          tileset_constructor_t& tileset_constructor,
+                          uint64_t seed,
+                          int col_base);
+
+  /**
+   * Add the foreground surface and dark fill tiles
+   * @param tiles               the ground tiles
+   * @param fg_tiles            the foreground tiles
+   * @param tileset_constructor the tileset constructor
+   * @param seed                the generation seed
+   * @param col_base            the world column of the first grid column
+   */
+  void add_fg_tiles(const tile_grid_t& tiles,
+                    tile_grid_t& fg_tiles,
+                    tileset_constructor_t& tileset_constructor,
+                    uint64_t seed,
+                    int col_base);
+
+  /**
+   * Hide ground tiles covered by opaque foreground tiles
+   * @param tiles    the ground tiles
+   * @param fg_tiles the foreground tiles (same grid)
+   * @param tileset  the tileset both sample
+   */
+  void hide_covered_tiles(tile_grid_t& tiles,
+                          const tile_grid_t& fg_tiles,
+                          const tileset_t& tileset);
+
+  /**
+   * Render a grid of tiles, merging single colour runs
+   * (debug mode renders each tile so bounds are drawn)
+   * @param renderer the sdl renderer
+   * @param camera   the camera
+   * @param tiles    the tiles
+   * @param tileset  the tileset the tiles sample
+   * @param debug    whether debug mode enabled
+   */
+  void render_tiles(SDL_Renderer& renderer,
+                    const SDL_Rect& camera,
+                    const tile_grid_t& tiles,
+                    const tileset_t& tileset,
+                    bool debug);
+
+  /**
+   * Decide where trees and bushes go and queue them for generation
+   * @param batch    the generation batch
+   * @param plants   the queued plants (added to by the call)
+   * @param tiles    the ground tiles
+   * @param seed     the generation seed
+   * @param col_base the world column of the first grid column
+   * @param first    the first grid column to populate
+   * @param last     one past the last grid column to populate
+   */
+  void queue_fg_plants(environment::gen_batch_t& batch,
+                       std::vector<fg_plant_t>& plants,
+                       const tile_grid_t& tiles,
+                       uint64_t seed,
+                       int col_base,
+                       size_t first,
+                       size_t last);
+
+  /**
+   * Add generated plants to the foreground (after upload)
+   * @param fore_ground the foreground components
+   * @param batch       the batch (uploaded to the foreground atlas)
+   * @param plants      the plants
+   * @param dim         the tile dimension
+   */
+  void place_fg_plants(map_components_t& fore_ground,
+                       const environment::gen_batch_t& batch,
+                       const std::vector<fg_plant_t>& plants,
+                       int dim);
+}}
+
+#endif /*_IO_JACKHAY_SWAMP_TILEMAP_TERRAIN_GEN_H*/
@@ -5,6 +5,7 @@
  */
 
 #include "tile.h"
+#include "../draw.h"
 #include <iostream>
 
 namespace impl {
@@ -22,6 +23,7 @@ namespace tilemap {
       : type(type),
         solid(false),
         liquid(false),
+        hidden(false),
         x(x), y(y),
         dim(dim) {}
 
@@ -33,6 +35,7 @@ namespace tilemap {
       : type(other.type),
         solid(other.solid),
         liquid(other.liquid),
+        hidden(other.hidden),
         x(other.x),
         y(other.y),
         dim(other.dim) {}
@@ -46,6 +49,7 @@ namespace tilemap {
       this->type = other.type;
       this->solid = other.solid;
       this->liquid = other.liquid;
+      this->hidden = other.hidden;
       this->x = other.x;
       this->y = other.y;
       this->dim = other.dim;
@@ -95,11 +99,16 @@ namespace tilemap {
      */
     void tile_t::render(SDL_Renderer& renderer,
                         const SDL_Rect& camera,
-                        const std::shared_ptr<tileset_t> tileset,
+                        const tileset_t& tileset,
                         bool stationary,
                         bool debug) const {
       //check the collision
-      if (this->is_collided(camera) || stationary) {
+      bool in_camera = this->is_collided(camera) || stationary;
+
+      //covered tiles count as culled
+      draw::visible(in_camera && !hidden);
+
+      if (in_camera) {
         int rel_x = (x * dim);
         int rel_y = (y * dim);
 
@@ -109,8 +118,10 @@ namespace tilemap {
           rel_y -= camera.y;
         }
 
-        //render this tile
-        tileset->render(renderer,rel_x,rel_y,this->type);
+        //render this tile (unless covered)
+        if (!hidden) {
+          tileset.render(renderer,rel_x,rel_y,this->type);
+        }
 
         if (debug) {
           SDL_Rect image_bounds = {(x * dim) - camera.x,
@@ -122,15 +133,72 @@ namespace tilemap {
             SDL_SetRenderDrawColor(&renderer,255,0,0,127);
 
             //render the bounds
-            SDL_RenderDrawRect(&renderer,&image_bounds);
+            draw::rect(&renderer,&image_bounds);
           } else if (liquid) {
             //set the draw color
             SDL_SetRenderDrawColor(&renderer,0,0,255,127);
 
             //render the bounds
-            SDL_RenderDrawRect(&renderer,&image_bounds);
+            draw::rect(&renderer,&image_bounds);
           }
         }
       }
     }
+
+    /**
+     * Constructor
+     * @param renderer the sdl renderer
+     */
+    fill_run_t::fill_run_t(SDL_Renderer& renderer)
+      : renderer(renderer),
+        bounds({0,0,0,0}),
+        color({0,0,0,0}),
+        open(false) {}
+
+    /**
+     * Add a tile to the run if it is a visible single colour tile
+     * @param  tile    the tile
+     * @param  tileset the tileset the tile samples
+     * @param  camera  the camera
+     * @return         whether the tile was added (otherwise render it)
+     */
+    bool fill_run_t::add(const tile_t& tile, const tileset_t& tileset, const SDL_Rect& camera) {
+      SDL_Color tile_color;
+      if (tile.is_hidden() || !tile.is_collided(camera) ||
+          !tileset.get_fill(tile.get_type(), tile_color)) {
+        return false;
+      }
+
+      //drawn as part of the run
+      draw::visible(true);
+
+      int dim = tile.get_dim();
+      int rel_x = (tile.get_x_idx() * dim) - camera.x;
+      int rel_y = (tile.get_y_idx() * dim) - camera.y;
+
+      //extend the run with the next tile in the row
+      if (open &&
+          (rel_y == bounds.y) && (rel_x == (bounds.x + bounds.w)) && (dim == bounds.h) &&
+          (tile_color.r == color.r) && (tile_color.g == color.g) && (tile_color.b == color.b)) {
+        bounds.w += dim;
+        return true;
+      }
+
+      flush();
+      bounds = {rel_x, rel_y, dim, dim};
+      color = tile_color;
+      open = true;
+      return true;
+    }
+
+    /**
+     * Draw the run so far
+     */
+    void fill_run_t::flush() {
+      if (open) {
+        SDL_SetRenderDrawColor(&renderer,color.r,color.g,color.b,255);
+        draw::fill_rect(&renderer,&bounds);
+        open = false;
+      }
+    }
 }}
@@ -28,6 +28,8 @@ namespace tilemap {
 
     //whether this tile is liquid
     bool liquid;
+    //whether this tile is covered by opaque tiles in front of it
+    bool hidden;
 
     //this tile's position
     int x;
@@ -46,6 +48,18 @@ namespace tilemap {
      */
     int get_y_idx() const { return y; }
 
+    /**
+     * Get the x index of this tile
+     * @return x index
+     */
+    int get_x_idx() const { return x; }
+
+    /**
+     * Get the dimension of this tile
+     * @return dim
+     */
+    int get_dim() const { return dim; }
+
     /**
      * Get the height of this tile
      * @return height
@@ -103,6 +117,18 @@ namespace tilemap {
      */
     void set_liquid(bool liquid) { this->liquid = liquid; }
 
+    /**
+     * Check whether this tile is covered (not drawn)
+     * @return whether this tile is hidden
+     */
+    bool is_hidden() const { return this->hidden; }
+
+    /**
+     * Set this tile covered by opaque tiles in front of it
+     * @param hidden the setting for the tile
+     */
+    void set_hidden(bool hidden) { this->hidden = hidden; }
+
     /**
      * Render this tile
      * - Checks if the camera box collides with the tile position
@@ -115,10 +141,46 @@ namespace tilemap {
      */
     void render(SDL_Renderer& renderer,
                 const SDL_Rect& camera,
-                const std::shared_ptr<tileset_t> tileset,
+                const tileset_t& tileset,
                 bool stationary,
                 bool debug) const;
   };
+
+  /**
+   * Merges horizontal runs of single colour tiles into one fill
+   * (tiles in a layer never overlap so fills can be drawn late)
+   */
+  struct fill_run_t {
+  private:
+    SDL_Renderer& renderer;
+    //the run so far (screen position)
+    SDL_Rect bounds;
+    SDL_Color color;
+    bool open;
+
+  public:
+    /**
+     * Constructor
+     * @param renderer the sdl renderer
+     */
+    fill_run_t(SDL_Renderer& renderer);
+    fill_run_t(const fill_run_t&) = delete;
+    fill_run_t& operator=(const fill_run_t&) = delete;
+
+    /**
+     * Add a tile to the run if it is a visible single colour tile
+     * @param  tile    the tile
+     * @param  tileset the tileset the tile samples
+     * @param  camera  the camera
+     * @return         whether the tile was added (otherwise render it)
+     */
+    bool add(const tile_t& tile, const tileset_t& tileset, const SDL_Rect& camera);
+
+    /**
+     * Draw the run so far
+     */
+    void flush();
+  };
 }}
 
 #endif /*_IO_JACKHAY_SWAMP_TILE_H*/
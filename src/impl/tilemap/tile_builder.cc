@@ -6,27 +6,28 @@
 
 #include "tile_builder.h"
 #include "noise.h"
-#include <stdlib.h>
 
 namespace impl {
 namespace tilemap {
 namespace tile_builder {
 
-  bool probably() {
-    return (rand() % 3 >= 1);
+  bool probably(rng::rng_t& rng) {
+    return (rng.next_int(3) >= 1);
   }
 
-  bool maybe() {
-    return (rand() % 4 == 1);
+  bool maybe(rng::rng_t& rng) {
+    return (rng.next_int(4) == 1);
   }
 
   /**
    * Make a ground tile
    * @param  tileset_constructor the tileset constructor
+   * @param  rng                 the random stream for this tile
    * @param  s                   the slope of the tile
    * @return                     the tile type (id)
    */
   [[nodiscard]] int make_grnd_tile(tileset_constructor_t& tileset_constructor,
+                                   rng::rng_t& rng,
                                    tile_slope s) {
     //allocate a new tile
     int new_id = tileset_constructor.add_tile();
@@ -40,9 +41,10 @@ namespace tile_builder {
     );
 
     //edit the new tile
-    edit_grnd_tile(tileset_constructor,new_id,s);
+    edit_grnd_tile(tileset_constructor,rng,new_id,s);
 
-    return new_id;
+    //reuse an identical tile
+    return tileset_constructor.finish_tile(new_id);
   }
 
   /**
@@ -80,38 +82,42 @@ namespace tile_builder {
         d1 += 2;
       }
     }
-    return new_id;
+    return tileset_constructor.finish_tile(new_id);
   }
 
   /**
    * Make a tile that adds roughness to flat ground
    * @param  tileset_constructor the tileset constuctor
+   * @param  rng                 the random stream for this tile
    * @return                     the tileid
    */
-  [[nodiscard]] int make_flat_grnd_tile(tileset_constructor_t& tileset_constructor) {
+  [[nodiscard]] int make_flat_grnd_tile(tileset_constructor_t& tileset_constructor,
+                                        rng::rng_t& rng) {
     int new_id = tileset_constructor.add_tile();
     int dim = tileset_constructor.get_dim();
 
     for (int i=0; i<dim; i++) {
-      if (rand() % 3 == 0) {
+      if (rng.next_int(3) == 0) {
         tileset_constructor.set(new_id,i,dim-1);
       }
     }
 
-    return new_id;
+    return tileset_constructor.finish_tile(new_id);
   }
 
   /**
    * Make a foreground surface tile
    * @param  tileset_constructor the tileset constructor
+   * @param  rng                 the random stream for this tile
    * @return                     the tile id
    */
-  [[nodiscard]] int make_fg_surface_tile(tileset_constructor_t& tileset_constructor) {
+  [[nodiscard]] int make_fg_surface_tile(tileset_constructor_t& tileset_constructor,
+                                         rng::rng_t& rng) {
     int new_id = tileset_constructor.add_tile();
     int dim = tileset_constructor.get_dim();
 
     //create random fbm seed
-    float seed = static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
+    float seed = rng.next_float();
 
     for (int i=0; i<dim; i++) {
       //create noise
@@ -129,16 +135,18 @@ namespace tile_builder {
 
     //add trees
 
-    return new_id;
+    return tileset_constructor.finish_tile(new_id);
   }
 
   /**
-   * Edit the slope of a ground tile
+   * Edit the slope of a ground tile (not yet finished)
    * @param tileset_constructor the tileset constructor
+   * @param rng                 the random stream for this tile
    * @param id                  the id of the tile to edit
    * @param s                   the slope to edit to
    */
   void edit_grnd_tile(tileset_constructor_t& tileset_constructor,
+                      rng::rng_t& rng,
                       int id,
                       tile_slope s) {
     //get the tile dimension
@@ -151,21 +159,21 @@ namespace tile_builder {
       tileset_constructor.erase(id,1,0);
 
       //probably erase
-      if (probably()) {
+      if (probably(rng)) {
         tileset_constructor.erase(id,0,2);
       }
-      if (probably()) {
+      if (probably(rng)) {
         tileset_constructor.erase(id,1,1);
       }
-      if (probably()) {
+      if (probably(rng)) {
         tileset_constructor.erase(id,2,0);
       }
 
       //maybe erase
-      if (maybe()) {
+      if (maybe(rng)) {
         tileset_constructor.erase(id,0,3);
       }
-      if (maybe()) {
+      if (maybe(rng)) {
         tileset_constructor.erase(id,3,0);
       }
 
@@ -8,6 +8,7 @@
 #define _IO_JACKHAY_SWAMP_TILEMAP_TILEBUILDER_H
 
 #include "tileset_constructor.h"
+#include "../rng.h"
 
 namespace impl {
 namespace tilemap {
@@ -52,10 +53,12 @@ namespace tile_builder {
   /**
    * Make a ground tile
    * @param  tileset_constructor the tileset constructor
+   * @param  rng                 the random stream for this tile
    * @param  s                   the slope of the tile
    * @return                     the tile type (id)
    */
   [[nodiscard]] int make_grnd_tile(tileset_constructor_t& tileset_constructor,
+                                   rng::rng_t& rng,
                                    tile_slope s);
 
   /**
@@ -70,24 +73,30 @@ namespace tile_builder {
   /**
    * Make a tile that adds roughness to flat ground
    * @param  tileset_constructor the tileset constuctor
+   * @param  rng                 the random stream for this tile
    * @return                     the tileid
    */
-  [[nodiscard]] int make_flat_grnd_tile(tileset_constructor_t& tileset_constructor);
+  [[nodiscard]] int make_flat_grnd_tile(tileset_constructor_t& tileset_constructor,
+                                        rng::rng_t& rng);
 
   /**
    * Make a foreground surface tile
    * @param  tileset_constructor the tileset constructor
+   * @param  rng                 the random stream for this tile
    * @return                     the tile id
    */
-  [[nodiscard]] int make_fg_surface_tile(tileset_constructor_t& tileset_constructor);
+  [[nodiscard]] int make_fg_surface_tile(tileset_constructor_t& tileset_constructor,
+                                         rng::rng_t& rng);
 
   /**
-   * Edit the slope of a ground tile
+   * Edit the slope of a ground tile (not yet finished)
    * @param tileset_constructor the tileset constructor
+   * @param rng                 the random stream for this tile
    * @param id                  the id of the tile to edit
    * @param s                   the slope to edit to
    */
   void edit_grnd_tile(tileset_constructor_t& tileset_constructor,
+                      rng::rng_t& rng,
                       int id,
                       tile_slope s);
 
@@ -6,10 +6,111 @@
 
 #include "tilemap.h"
 #include "../exceptions.h"
+#include "../logger.h"
+#include "../jobs.h"
+#include <algorithm>
+#include <thread>
 
 namespace impl {
 namespace tilemap {
 
+  /**
+   * Get the approximate size of the tiles in this region
+   * @return the tile storage size in bytes
+   */
+  size_t tilemap_region_t::get_footprint() const {
+    size_t total = entity_layer->get_footprint();
+
+    for (size_t i=0; i<bg_layers.size(); i++) {
+      total += bg_layers.at(i)->get_footprint();
+    }
+
+    for (size_t i=0; i<fg_layers.size(); i++) {
+      total += fg_layers.at(i)->get_footprint();
+    }
+    return total;
+  }
+
+  /**
+   * Load the layers of a region
+   * @param  rsrc_paths         the full path to each layer
+   * @param  tileset            the tileset to use with this map
+   * @param  entity_layer_idx   the index of the entity layer
+   * @param  dim                the dimension of a tile
+   * @param  entity_layer_solid the indices of solid tiles
+   * @param  entity_layer_water the indices of liquid tiles
+   * @param  bg_stationary      whether the first layer is stationary
+   * @param  first_layer        the first layer to load (1 to skip a backdrop)
+   * @param  col_offset         the map column of the first column in the region
+   * @return                    the region
+   */
+  static std::unique_ptr<tilemap_region_t> load_region(const std::vector<std::string>& rsrc_paths,
+                                                       std::shared_ptr<tilemap::tileset_t> tileset,
+                                                       int entity_layer_idx,
+                                                       int dim,
+                                                       const std::vector<int>& entity_layer_solid,
+                                                       const std::vector<int>& entity_layer_water,
+                                                       bool bg_stationary,
+                                                       size_t first_layer,
+                                                       int col_offset) {
+    //sanity check
+    if ((entity_layer_idx >= (int)rsrc_paths.size()) || (entity_layer_idx < (int)first_layer)) {
+      throw exceptions::rsrc_exception_t("tilemap entity layer index out of bounds");
+    }
+
+    std::unique_ptr<tilemap_region_t> region = std::make_unique<tilemap_region_t>();
+
+    //load the tilemap layers
+    for(size_t i=first_layer; i<rsrc_paths.size(); i++) {
+      if ((int) i == entity_layer_idx) {
+        region->entity_layer =
+          std::make_unique<tilemap::layer_t>(rsrc_paths.at(entity_layer_idx),
+                                             dim,
+                                             tileset,
+                                             false,
+                                             col_offset);
+
+        //set solid/liquid tiles for this layer
+        region->entity_layer->set_natured_tiles(entity_layer_solid,
+                                                entity_layer_water);
+
+      } else if ((int) i < entity_layer_idx) {
+        //load as a background layer (first layer marked as stationary if configured)
+        region->bg_layers.push_back(std::make_unique<tilemap::layer_t>(rsrc_paths.at(i),
+                                                                       dim,
+                                                                       tileset,
+                                                                       bg_stationary && (i == 0),
+                                                                       col_offset));
+      } else {
+        //load as a foreground layer
+        region->fg_layers.push_back(std::make_unique<tilemap::layer_t>(rsrc_paths.at(i),
+                                                                       dim,
+                                                                       tileset,
+                                                                       false,
+                                                                       col_offset));
+      }
+    }
+
+    //skip tiles covered by opaque tiles in front (back to front, no backdrop)
+    std::vector<tilemap::layer_t*> ordered;
+    for (size_t i=0; i<region->bg_layers.size(); i++) {
+      if (!(bg_stationary && (first_layer == 0) && (i == 0))) {
+        ordered.push_back(region->bg_layers.at(i).get());
+      }
+    }
+    ordered.push_back(region->entity_layer.get());
+    for (size_t i=0; i<region->fg_layers.size(); i++) {
+      ordered.push_back(region->fg_layers.at(i).get());
+    }
+
+    for (size_t i=0; i<ordered.size(); i++) {
+      for (size_t j=i+1; j<ordered.size(); j++) {
+        ordered.at(i)->hide_covered(*ordered.at(j));
+      }
+    }
+    return region;
+  }
+
   /**
    * Constructor
    * @param rsrc_paths         the path to each layer
@@ -27,56 +128,273 @@ namespace tilemap {
                        const std::vector<int>& entity_layer_solid,
                        const std::vector<int>& entity_layer_water,
                        bool bg_stationary)
-    : bg_layers(), fg_layers(),
+    : tileset(tileset),
+      entity_layer_idx(entity_layer_idx),
+      dim(dim),
       entity_layer_solid(entity_layer_solid),
-      entity_layer_water(entity_layer_water) {
+      entity_layer_water(entity_layer_water),
+      manifest(),
+      base_path(),
+      backdrop(),
+      regions(),
+      radius(0),
+      hysteresis(0),
+      pending(),
+      failed(),
+      ready(),
+      paged_in(),
+      paged_out(),
+      view_x(0),
+      view_w(0),
+      region_version(0),
+      bg_cache() {
 
-    //sanity check
-    if ((entity_layer_idx >= (int)rsrc_paths.size()) || (entity_layer_idx < 0)) {
-      throw exceptions::rsrc_exception_t("tilemap entity layer index out of bounds");
+    //the whole level is a single region
+    regions[0] = load_region(rsrc_paths,
+                             tileset,
+                             entity_layer_idx,
+                             dim,
+                             entity_layer_solid,
+                             entity_layer_water,
+                             bg_stationary,
+                             0,0);
+
+    //set map pixel dimensions
+    const layer_t& entity_layer = *regions.at(0)->entity_layer;
+    this->width_p = entity_layer.get_layer_cols() * dim;
+    this->height_p = (entity_layer.get_layer_rows() - 1) * dim;
+
+    this->region_cols = std::max(1, entity_layer.get_layer_cols());
+    this->region_count = 1;
+  }
+
+  /**
+   * Constructor for a level split into regions
+   * (regions are loaded as the camera approaches them)
+   * @param manifest           the region files
+   * @param base_path          resource directory base path
+   * @param backdrop_path      the full path to the stationary background layer
+   *                           ("" if the background isn't stationary)
+   * @param tileset            the tileset to use with this map
+   * @param entity_layer_idx   the index of the entity layer
+   * @param dim                the dimension of a tile
+   * @param entity_layer_solid the indices of solid tiles
+   * @param entity_layer_water the indices of liquid tiles
+   * @param radius             regions kept loaded on each side of the camera
+   * @param hysteresis         extra regions before a region is dropped
+   */
+  tilemap_t::tilemap_t(std::shared_ptr<const region_manifest_t> manifest,
+                       const std::string& base_path,
+                       const std::string& backdrop_path,
+                       std::shared_ptr<tilemap::tileset_t> tileset,
+                       int entity_layer_idx,
+                       int dim,
+                       const std::vector<int>& entity_layer_solid,
+                       const std::vector<int>& entity_layer_water,
+                       int radius,
+                       int hysteresis)
+    : tileset(tileset),
+      entity_layer_idx(entity_layer_idx),
+      dim(dim),
+      entity_layer_solid(entity_layer_solid),
+      entity_layer_water(entity_layer_water),
+      manifest(manifest),
+      base_path(base_path),
+      backdrop(),
+      regions(),
+      region_cols(manifest->region_cols),
+      region_count(manifest->regions.size()),
+      radius(std::max(0, radius)),
+      hysteresis(std::max(0, hysteresis)),
+      pending(),
+      failed(),
+      ready(std::make_shared<region_ready_t>()),
+      paged_in(),
+      paged_out(),
+      view_x(0),
+      view_w(0),
+      region_version(0),
+      bg_cache(),
+      width_p(manifest->cols * dim),
+      height_p((manifest->rows - 1) * dim) {
+
+    //the stationary background is the size of the screen, not split
+    if (!backdrop_path.empty()) {
+      backdrop = std::make_unique<tilemap::layer_t>(backdrop_path, dim, tileset, true);
     }
+  }
 
-    //load the tilemap layers
-    for(size_t i=0; i<rsrc_paths.size(); i++) {
-      if ((int) i == entity_layer_idx) {
-        this->entity_layer =
-          std::make_unique<tilemap::layer_t>(rsrc_paths.at(entity_layer_idx),
-                                             dim,
-                                             tileset,
-                                             false);
+  /**
+   * Get the index of the region containing an x coordinate
+   * (clamped to the map)
+   * @param  x the x coordinate
+   * @return   the region index
+   */
+  int tilemap_t::region_of(int x) const {
+    return std::max(0, std::min(region_count - 1, (x / dim) / region_cols));
+  }
 
-        //set solid/liquid tiles for this layer
-        this->entity_layer->set_natured_tiles(entity_layer_solid,
-                                              entity_layer_water);
+  /**
+   * Get the resident region containing an x coordinate
+   * @param  x the x coordinate
+   * @return   the region or NULL if not loaded
+   */
+  const tilemap_region_t* tilemap_t::find_region(int x) const {
+    auto it = regions.find(region_of(x));
+    if (it == regions.end()) {
+      return NULL;
+    }
+    return it->second.get();
+  }
 
-      } else if ((int) i < entity_layer_idx) {
-        //load as a background layer (first layer marked as stationary if configured)
-        this->bg_layers.push_back(std::make_unique<tilemap::layer_t>(rsrc_paths.at(i),
-                                                                     dim,
-                                                                     tileset,
-                                                                     bg_stationary && (i == 0)));
+  /**
+   * Check whether a position is inside the map
+   * @return whether the position is in the map
+   */
+  bool tilemap_t::in_map(int x, int y) const {
+    return (x >= 0) && (y >= 0) && (x < width_p) && (y < (height_p + dim));
+  }
+
+  /**
+   * Queue a region for loading on the job pool
+   * @param idx the region index
+   */
+  void tilemap_t::request(int idx) {
+    pending.insert(idx);
+
+    //full layer paths for this region
+    std::vector<std::string> rsrc_paths = manifest->regions.at(idx).layer_paths;
+    for (size_t i=0; i<rsrc_paths.size(); i++) {
+      rsrc_paths.at(i) = base_path + rsrc_paths.at(i);
+    }
+
+    //the job holds the ready list, not the map
+    std::shared_ptr<region_ready_t> ready = this->ready;
+    std::shared_ptr<tilemap::tileset_t> tileset = this->tileset;
+    int entity_layer_idx = this->entity_layer_idx;
+    int dim = this->dim;
+    std::vector<int> solid = entity_layer_solid;
+    std::vector<int> water = entity_layer_water;
+    size_t first_layer = backdrop ? 1 : 0;
+    int col_offset = idx * region_cols;
+
+    jobs::pool().submit([=]() {
+      std::unique_ptr<tilemap_region_t> region;
+      try {
+        region = load_region(rsrc_paths, tileset, entity_layer_idx, dim,
+                             solid, water, false, first_layer, col_offset);
+      } catch (exceptions::rsrc_exception_t& e) {
+        logger::log_lazy(LOG_ERR, [&]() {
+          return "failed to load region " + std::to_string(idx) + ": " + e.trace();
+        });
+      }
+
+      std::unique_lock<std::mutex> lk(ready->lock);
+      ready->regions.push_back(std::make_pair(idx, std::move(region)));
+    });
+  }
+
+  /**
+   * Take regions finished by the job pool
+   */
+  void tilemap_t::adopt() {
+    std::vector<std::pair<int, std::unique_ptr<tilemap_region_t>>> loaded;
+    {
+      std::unique_lock<std::mutex> lk(ready->lock);
+      loaded.swap(ready->regions);
+    }
+
+    for (size_t i=0; i<loaded.size(); i++) {
+      int idx = loaded.at(i).first;
+      pending.erase(idx);
+
+      if (!loaded.at(i).second) {
+        failed.insert(idx);
+
+      } else if (regions.find(idx) == regions.end()) {
+        regions[idx] = std::move(loaded.at(i).second);
+        paged_in.push_back(idx);
+        region_version++;
+      }
+    }
+  }
+
+  /**
+   * Page regions in and out around the last rendered camera
+   */
+  void tilemap_t::page_regions() {
+    adopt();
+
+    int x = view_x;
+    int w = view_w;
+    int first = region_of(x) - radius;
+    int last = region_of(x + w) + radius;
+
+    //the camera is over a region that isn't loaded: load it now
+    int center = region_of(x + (w / 2));
+    if ((regions.find(center) == regions.end()) && (failed.find(center) == failed.end())) {
+      if (pending.find(center) == pending.end()) {
+        request(center);
+      }
+
+      //help the pool until it arrives
+      while (regions.find(center) == regions.end() &&
+             (failed.find(center) == failed.end())) {
+        if (!jobs::pool().run_one()) {
+          std::this_thread::yield();
+        }
+        adopt();
+      }
+    }
+
+    //request nearby regions
+    for (int r=std::max(first, 0); r<=std::min(last, region_count - 1); r++) {
+      if ((regions.find(r) == regions.end()) &&
+          (pending.find(r) == pending.end()) &&
+          (failed.find(r) == failed.end())) {
+        request(r);
+      }
+    }
+
+    //drop regions well outside the range
+    for (auto it=regions.begin(); it!=regions.end();) {
+      if ((it->first < (first - hysteresis)) ||
+          (it->first > (last + hysteresis))) {
+        paged_out.push_back(it->first);
+        it = regions.erase(it);
+        region_version++;
       } else {
-        //load as a foreground layer
-        this->fg_layers.push_back(std::make_unique<tilemap::layer_t>(rsrc_paths.at(i),
-                                                                     dim,
-                                                                     tileset,
-                                                                     false));
+        it++;
       }
     }
+  }
 
-    //set map pixel dimensions
-    this->width_p = entity_layer->get_layer_cols() * dim;
-    this->height_p = (entity_layer->get_layer_rows() - 1) * dim;
+  /**
+   * Take the regions paged in and out since the last call
+   * (objects anchored in them are added or removed by the state)
+   * @param in  the regions paged in (set by the call)
+   * @param out the regions paged out (set by the call)
+   */
+  void tilemap_t::take_region_changes(std::vector<int>& in, std::vector<int>& out) {
+    in.clear();
+    out.clear();
+    in.swap(paged_in);
+    out.swap(paged_out);
   }
 
   /**
    * Check if the tile at a position is solid
+   * (regions not loaded yet are solid)
    * @param  x the x coordinate
    * @param  y the y coordinate
    * @return   whether the tile at this position is solid
    */
   bool tilemap_t::is_solid(int x, int y) const {
-    return entity_layer->is_solid(x,y);
+    const tilemap_region_t *region = find_region(x);
+    if (region == NULL) {
+      return in_map(x,y);
+    }
+    return region->entity_layer->is_solid(x,y);
   }
 
   /**
@@ -86,7 +404,8 @@ namespace tilemap {
    * @return   whether the tile at this position is liquid
    */
   bool tilemap_t::is_liquid(int x, int y) const {
-    return entity_layer->is_liquid(x,y);
+    const tilemap_region_t *region = find_region(x);
+    return (region != NULL) && region->entity_layer->is_liquid(x,y);
   }
 
 
@@ -96,7 +415,22 @@ namespace tilemap {
    * @return       whether the bounding box collides
    */
   bool tilemap_t::is_collided(const SDL_Rect& other) const {
-    return entity_layer->is_collided(other);
+    //check each region the box might touch
+    int first = region_of(other.x - dim);
+    int last = region_of(other.x + other.w + (2 * dim));
+
+    for (int r=first; r<=last; r++) {
+      auto it = regions.find(r);
+      if (it == regions.end()) {
+        //not loaded: block until it is
+        return true;
+      }
+
+      if (it->second->entity_layer->is_collided(other)) {
+        return true;
+      }
+    }
+    return false;
   }
 
   /**
@@ -106,7 +440,22 @@ namespace tilemap {
    * @return   whether this position collides with a solid tile
    */
   bool tilemap_t::is_collided(int x, int y) const {
-    return entity_layer->is_collided(x,y);
+    //check each region the position might touch
+    int first = region_of(x - dim);
+    int last = region_of(x + dim);
+
+    for (int r=first; r<=last; r++) {
+      auto it = regions.find(r);
+      if (it == regions.end()) {
+        //not loaded: block until it is
+        return true;
+      }
+
+      if (it->second->entity_layer->is_collided(x,y)) {
+        return true;
+      }
+    }
+    return false;
   }
 
   /**
@@ -125,20 +474,52 @@ namespace tilemap {
     return height_p;
   }
 
+  /**
+   * Get the approximate memory footprint of the map
+   * (texture bytes and tile storage of resident regions)
+   * @return the footprint in bytes
+   */
+  size_t tilemap_t::get_footprint() const {
+    //all layers share the tileset
+    size_t total = tileset->get_footprint();
+
+    if (backdrop) {
+      total += backdrop->get_footprint();
+    }
+
+    for (auto it=regions.begin(); it!=regions.end(); it++) {
+      total += it->second->get_footprint();
+    }
+    return total;
+  }
+
   /**
    * Update any updatable tiles
    */
   void tilemap_t::update() {
-    //update foreground
-    for (size_t i=0; i<bg_layers.size(); i++) {
-      bg_layers.at(i)->update();
+    //page regions around the camera
+    if (manifest) {
+      page_regions();
     }
-    //update the entity layer
-    entity_layer->update();
 
-    //update background
-    for (size_t i=0; i<fg_layers.size(); i++) {
-      fg_layers.at(i)->update();
+    if (backdrop) {
+      backdrop->update();
+    }
+
+    for (auto it=regions.begin(); it!=regions.end(); it++) {
+      const tilemap_region_t& region = *it->second;
+
+      //update foreground
+      for (size_t i=0; i<region.bg_layers.size(); i++) {
+        region.bg_layers.at(i)->update();
+      }
+      //update the entity layer
+      region.entity_layer->update();
+
+      //update background
+      for (size_t i=0; i<region.fg_layers.size(); i++) {
+        region.fg_layers.at(i)->update();
+      }
     }
   }
 
@@ -152,12 +533,60 @@ namespace tilemap {
   void tilemap_t::render_bg(SDL_Renderer& renderer,
                             const SDL_Rect& camera,
                             bool debug) const {
-    //render the background
-    for (size_t i=0; i<bg_layers.size(); i++) {
-      bg_layers.at(i)->render(renderer,camera,debug);
+    //used by update to pick regions
+    view_x = camera.x;
+    view_w = camera.w;
+
+    if (backdrop) {
+      backdrop->render(renderer,camera,debug);
+    }
+
+    //every region has the same layers
+    size_t bg_count = regions.empty() ? 0 : regions.begin()->second->bg_layers.size();
+
+    //stationary layers (only ever the first) don't scroll
+    for (size_t i=0; i<bg_count; i++) {
+      for (auto it=regions.begin(); it!=regions.end(); it++) {
+        if (it->second->bg_layers.at(i)->is_stationary()) {
+          it->second->bg_layers.at(i)->render(renderer,camera,debug);
+        }
+      }
+    }
+
+    //redrawn only where scrolled into view
+    if (debug) {
+      render_scrolling(renderer,camera,debug);
+    } else {
+      bg_cache.render(renderer,camera,region_version,[this,&renderer](const SDL_Rect& view) {
+        render_scrolling(renderer,view,false);
+      });
+    }
+  }
+
+  /**
+   * Render the background layers that scroll with the world
+   * and the entity layer
+   * @param renderer the sdl renderer
+   * @param camera   the camera
+   * @param debug    whether debug mode enabled
+   */
+  void tilemap_t::render_scrolling(SDL_Renderer& renderer,
+                                   const SDL_Rect& camera,
+                                   bool debug) const {
+    size_t bg_count = regions.empty() ? 0 : regions.begin()->second->bg_layers.size();
+
+    //render the background (by layer, so layers overlap across regions)
+    for (size_t i=0; i<bg_count; i++) {
+      for (auto it=regions.begin(); it!=regions.end(); it++) {
+        if (!it->second->bg_layers.at(i)->is_stationary()) {
+          it->second->bg_layers.at(i)->render(renderer,camera,debug);
+        }
+      }
     }
     //render the entity layer
-    entity_layer->render(renderer,camera,debug);
+    for (auto it=regions.begin(); it!=regions.end(); it++) {
+      it->second->entity_layer->render(renderer,camera,debug);
+    }
   }
 
 
@@ -170,9 +599,13 @@ namespace tilemap {
   void tilemap_t::render_fg(SDL_Renderer& renderer,
                             const SDL_Rect& camera,
                             bool debug) const {
+    size_t fg_count = regions.empty() ? 0 : regions.begin()->second->fg_layers.size();
+
     //render the foreground
-    for (size_t i=0; i<fg_layers.size(); i++) {
-      fg_layers.at(i)->render(renderer,camera,debug);
+    for (size_t i=0; i<fg_count; i++) {
+      for (auto it=regions.begin(); it!=regions.end(); it++) {
+        it->second->fg_layers.at(i)->render(renderer,camera,debug);
+      }
     }
   }
 }}
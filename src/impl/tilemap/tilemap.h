@@ -9,8 +9,14 @@
 
 #include <vector>
 #include <string>
+#include <map>
+#include <set>
+#include <mutex>
+#include <atomic>
 #include "layer.h"
+#include "regions.h"
 #include "abstract_tilemap.h"
+#include "bg_cache.h"
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL.h>
 
@@ -18,10 +24,10 @@ namespace impl {
 namespace tilemap {
 
   /**
-   * Defines a loaded tilemap
+   * The layers for a column strip of a map
+   * (the whole map if it isn't split into regions)
    */
-  struct tilemap_t : public abstract_tilemap_t {
-  private:
+  struct tilemap_region_t {
     //the layers behind the entity layer
     std::vector<std::unique_ptr<tilemap::layer_t>> bg_layers;
 
@@ -31,15 +37,137 @@ namespace tilemap {
     //the layers in front of the entity
     std::vector<std::unique_ptr<tilemap::layer_t>> fg_layers;
 
+    /**
+     * Get the approximate size of the tiles in this region
+     * @return the tile storage size in bytes
+     */
+    size_t get_footprint() const;
+  };
+
+  /**
+   * Regions loaded by the job pool (shared with pending jobs so
+   * a region finishing after the map is gone is still freed)
+   * A null region means the load failed
+   */
+  struct region_ready_t {
+    std::mutex lock;
+    std::vector<std::pair<int, std::unique_ptr<tilemap_region_t>>> regions;
+  };
+
+  /**
+   * Defines a loaded tilemap
+   * Levels split into regions (see split_level) page regions in
+   * and out around the camera
+   */
+  struct tilemap_t : public abstract_tilemap_t {
+  private:
+    //the tileset shared by all layers
+    std::shared_ptr<tilemap::tileset_t> tileset;
+
+    //the index of the entity layer
+    int entity_layer_idx;
+
+    //the dimension of a tile
+    int dim;
+
     //the indices of tiles that are solid ground
     std::vector<int> entity_layer_solid;
     //the indices of tiles that are water
     std::vector<int> entity_layer_water;
 
+    //the region files (null if the whole level is loaded at once)
+    std::shared_ptr<const region_manifest_t> manifest;
+    //resource directory base path
+    std::string base_path;
+
+    //the stationary background layer of a split level (never paged)
+    std::unique_ptr<tilemap::layer_t> backdrop;
+
+    //resident regions by index
+    std::map<int, std::unique_ptr<tilemap_region_t>> regions;
+
+    //the width of each region in tile columns and the number of regions
+    int region_cols;
+    int region_count;
+
+    //regions kept around the camera, and the extra distance
+    //before a region is dropped (avoids thrashing at a boundary)
+    int radius;
+    int hysteresis;
+
+    //regions requested from the job pool but not adopted yet
+    std::set<int> pending;
+    //regions that failed to load (not requested again)
+    std::set<int> failed;
+    //regions finished by the job pool
+    std::shared_ptr<region_ready_t> ready;
+
+    //regions paged in and out since the last take_region_changes
+    std::vector<int> paged_in;
+    std::vector<int> paged_out;
+
+    //the last camera position rendered
+    mutable std::atomic<int> view_x;
+    mutable std::atomic<int> view_w;
+
+    //changes whenever regions are paged in or out
+    int region_version;
+
+    //the scrolling layers around the camera
+    mutable bg_cache_t bg_cache;
+
     //the dimensions of the map in pixels for camera
     int width_p;
     int height_p;
 
+    /**
+     * Get the index of the region containing an x coordinate
+     * (clamped to the map)
+     * @param  x the x coordinate
+     * @return   the region index
+     */
+    int region_of(int x) const;
+
+    /**
+     * Get the resident region containing an x coordinate
+     * @param  x the x coordinate
+     * @return   the region or NULL if not loaded
+     */
+    const tilemap_region_t* find_region(int x) const;
+
+    /**
+     * Render the background layers that scroll with the world
+     * and the entity layer
+     * @param renderer the sdl renderer
+     * @param camera   the camera
+     * @param debug    whether debug mode enabled
+     */
+    void render_scrolling(SDL_Renderer& renderer,
+                          const SDL_Rect& camera,
+                          bool debug) const;
+
+    /**
+     * Check whether a position is inside the map
+     * @return whether the position is in the map
+     */
+    bool in_map(int x, int y) const;
+
+    /**
+     * Queue a region for loading on the job pool
+     * @param idx the region index
+     */
+    void request(int idx);
+
+    /**
+     * Take regions finished by the job pool
+     */
+    void adopt();
+
+    /**
+     * Page regions in and out around the last rendered camera
+     */
+    void page_regions();
+
   public:
     /**
      * Constructor
@@ -58,11 +186,46 @@ namespace tilemap {
               const std::vector<int>& entity_layer_solid,
               const std::vector<int>& entity_layer_water,
               bool bg_stationary);
+
+    /**
+     * Constructor for a level split into regions
+     * (regions are loaded as the camera approaches them)
+     * @param manifest           the region files
+     * @param base_path          resource directory base path
+     * @param backdrop_path      the full path to the stationary background layer
+     *                           ("" if the background isn't stationary)
+     * @param tileset            the tileset to use with this map
+     * @param entity_layer_idx   the index of the entity layer
+     * @param dim                the dimension of a tile
+     * @param entity_layer_solid the indices of solid tiles
+     * @param entity_layer_water the indices of liquid tiles
+     * @param radius             regions kept loaded on each side of the camera
+     * @param hysteresis         extra regions before a region is dropped
+     */
+    tilemap_t(std::shared_ptr<const region_manifest_t> manifest,
+              const std::string& base_path,
+              const std::string& backdrop_path,
+              std::shared_ptr<tilemap::tileset_t> tileset,
+              int entity_layer_idx,
+              int dim,
+              const std::vector<int>& entity_layer_solid,
+              const std::vector<int>& entity_layer_water,
+              int radius,
+              int hysteresis);
     tilemap_t(const tilemap_t&) = delete;
     tilemap_t& operator=(const tilemap_t&) = delete;
 
+    /**
+     * Take the regions paged in and out since the last call
+     * (objects anchored in them are added or removed by the state)
+     * @param in  the regions paged in (set by the call)
+     * @param out the regions paged out (set by the call)
+     */
+    void take_region_changes(std::vector<int>& in, std::vector<int>& out);
+
     /**
      * Check if the tile at a position is solid
+     * (regions not loaded yet are solid)
      * @param  x the x coordinate
      * @param  y the y coordinate
      * @return   whether the tile at this position is solid
@@ -104,6 +267,13 @@ namespace tilemap {
      */
     int get_height() const override;
 
+    /**
+     * Get the approximate memory footprint of the map
+     * (texture bytes and tile storage)
+     * @return the footprint in bytes
+     */
+    size_t get_footprint() const override;
+
     /**
      * Update any updatable tiles
      */
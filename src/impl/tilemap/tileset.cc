@@ -5,13 +5,78 @@
  */
 
 #include "tileset.h"
+#include "../accounting.h"
+#include "../compositor.h"
 #include "../exceptions.h"
 #include "../utils.h"
+#include "../cache.h"
+#include "../rng.h"
+#include "../draw.h"
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <set>
+#include <algorithm>
 
 namespace impl {
 namespace tilemap {
 
+  #define COMMA ','
+
+  /**
+   * Get the tile types used by some layers
+   * (cached by layer file, size and modification time)
+   * Throws rsrc_exception_t
+   * @param  layer_paths the layer files (full paths)
+   * @return             the types used (sorted)
+   */
+  std::vector<int> used_tile_types(const std::vector<std::string>& layer_paths) {
+    //the key changes when any layer is edited
+    cache::key_t key("used_tile_types");
+    for (size_t i=0; i<layer_paths.size(); i++) {
+      std::error_code ec;
+      std::filesystem::path path(layer_paths.at(i));
+      key.add(rng::hash_str(layer_paths.at(i)))
+         .add(std::filesystem::file_size(path, ec))
+         .add(std::filesystem::last_write_time(path, ec).time_since_epoch().count());
+    }
+
+    std::vector<int32_t> cached;
+    if (cache::load_ints(key.get(), cached)) {
+      return std::vector<int>(cached.begin(), cached.end());
+    }
+
+    std::set<int> used;
+    for (size_t i=0; i<layer_paths.size(); i++) {
+      std::ifstream layer_file(layer_paths.at(i));
+      if (!layer_file.is_open()) {
+        throw exceptions::rsrc_exception_t(layer_paths.at(i));
+      }
+
+      //same format as layer_t
+      std::string line;
+      while (std::getline(layer_file, line)) {
+        std::stringstream s_stream(line);
+        while (s_stream.good()) {
+          std::string substr;
+          std::getline(s_stream, substr, COMMA);
+
+          try {
+            int type = std::stoi(substr);
+            if (type >= 0) {
+              used.insert(type);
+            }
+          } catch (...) { }
+        }
+      }
+    }
+
+    std::vector<int32_t> types(used.begin(), used.end());
+    cache::store_ints(key.get(), types);
+    return std::vector<int>(types.begin(), types.end());
+  }
+
   /**
    * Constructor loads tiles, throws exception on failure
    * @param rsrc_path the path to the resource
@@ -21,11 +86,35 @@ namespace tilemap {
   tileset_t::tileset_t(const std::string& rsrc_path,
                        int tile_dim,
                        SDL_Renderer& renderer)
-    : tile_dim(tile_dim) {
+    : tile_dim(tile_dim),
+      pages(),
+      tiles(),
+      fills(),
+      footprint(0) {
     //load resource
     load(rsrc_path, renderer);
   }
 
+  /**
+   * Constructor loads only the tiles a level uses,
+   * throws exception on failure
+   * @param rsrc_path the path to the resource
+   * @param tile_dim  the dimensions of tiles
+   * @param renderer  the renderer for loading texture
+   * @param used      the tile types to load (see used_tile_types)
+   */
+  tileset_t::tileset_t(const std::string& rsrc_path,
+                       int tile_dim,
+                       SDL_Renderer& renderer,
+                       const std::vector<int>& used)
+    : tile_dim(tile_dim),
+      pages(),
+      tiles(),
+      fills(),
+      footprint(0) {
+    load_compact(rsrc_path, renderer, used);
+  }
+
   /**
    * Construct from a preloaded texture (assumes ownership)
    * @param texture the preloaded texture
@@ -36,19 +125,77 @@ namespace tilemap {
   tileset_t::tileset_t(SDL_Texture* texture,
                        int w, int h, int tile_dim)
     : tile_dim(tile_dim),
-      tiles_wide(w / tile_dim),
-      tiles_high(h / tile_dim),
-      texture(texture) {}
+      pages(),
+      tiles(),
+      fills(),
+      footprint(0) {
+    add_page(texture, w, h, w / tile_dim, (w / tile_dim) * (h / tile_dim));
+  }
+
+  /**
+   * Construct without pages (added with add_page)
+   * @param tile_dim the dimension of the tiles
+   */
+  tileset_t::tileset_t(int tile_dim)
+    : tile_dim(tile_dim),
+      pages(),
+      tiles(),
+      fills(),
+      footprint(0) {}
 
   /**
    * Destructor frees texture allocation
    */
   tileset_t::~tileset_t() {
-    if (texture != NULL) {
-      SDL_DestroyTexture(texture);
+    for (size_t i=0; i<pages.size(); i++) {
+      accounting::free_texture(pages.at(i));
+    }
+  }
+
+  /**
+   * Add a page of tiles laid out in rows (assumes ownership)
+   * Tile types continue from the previous page
+   * @param texture    the page texture
+   * @param w          the width of the texture
+   * @param h          the height of the texture
+   * @param tiles_wide the number of tiles in each row
+   * @param count      the number of tile types on the page
+   */
+  void tileset_t::add_page(SDL_Texture* texture, int w, int h, int tiles_wide, int count) {
+    pages.push_back(texture);
+    footprint += (size_t) w * h * 4;
+
+    for (int i=0; i<count; i++) {
+      add_tile(pages.size() - 1, {(i % tiles_wide) * tile_dim,
+                                  (i / tiles_wide) * tile_dim,
+                                  tile_dim,
+                                  tile_dim});
     }
   }
 
+  /**
+   * Add a single tile type from some page
+   * @param page the page index
+   * @param rect the bounds of the tile in the page
+   */
+  void tileset_t::add_tile(int page, const SDL_Rect& rect) {
+    tiles.push_back({page, rect});
+  }
+
+  /**
+   * Set the page and bounds of some tile type
+   * (types skipped over render nothing)
+   * @param type the tile type
+   * @param page the page index
+   * @param rect the bounds of the tile in the page
+   */
+  void tileset_t::set_tile(int type, int page, const SDL_Rect& rect) {
+    if (type >= (int)tiles.size()) {
+      tiles.resize(type + 1, {-1, {0,0,0,0}});
+    }
+    tiles.at(type) = {page, rect};
+  }
+
   /**
    * Load the tileset
    * Throws rsrc_exception_t
@@ -59,11 +206,190 @@ namespace tilemap {
     int width, height = 0;
 
     //load the texture
-    this->texture = utils::load_texture(rsrc_path,renderer,width,height);
+    SDL_Texture *texture = utils::load_texture(rsrc_path,renderer,width,height);
 
     //Get image dimensions
-    this->tiles_wide = width / this->tile_dim;
-    this->tiles_high = height / this->tile_dim;
+    int tiles_wide = width / this->tile_dim;
+    int tiles_high = height / this->tile_dim;
+    add_page(texture, width, height, tiles_wide, tiles_wide * tiles_high);
+  }
+
+  /**
+   * Record the fill of a tile type from its pixels
+   * @param type    the tile type
+   * @param surface the pixels (32 bit)
+   * @param rect    the bounds of the tile in the surface
+   */
+  void tileset_t::summarize_tile(int type, SDL_Surface& surface, const SDL_Rect& rect) {
+    if (type >= (int)fills.size()) {
+      fills.resize(type + 1, {false, false, {0,0,0,0}});
+    }
+
+    //tiles past the edge of the pixels are not opaque
+    if ((surface.format->BytesPerPixel != 4) ||
+        ((rect.x + rect.w) > surface.w) ||
+        ((rect.y + rect.h) > surface.h)) {
+      fills.at(type) = {false, false, {0,0,0,0}};
+      return;
+    }
+
+    bool opaque = true;
+    bool uniform = true;
+    SDL_Color first = {0,0,0,0};
+
+    SDL_LockSurface(&surface);
+    for (int y=rect.y; opaque && (y<(rect.y + rect.h)); y++) {
+      Uint32 *row = (Uint32*)((Uint8*)surface.pixels + (y * surface.pitch));
+
+      for (int x=rect.x; x<(rect.x + rect.w); x++) {
+        SDL_Color px;
+        SDL_GetRGBA(row[x], surface.format, &px.r, &px.g, &px.b, &px.a);
+
+        if (px.a != 255) {
+          opaque = false;
+          break;
+        }
+
+        if ((x == rect.x) && (y == rect.y)) {
+          first = px;
+        } else if ((px.r != first.r) || (px.g != first.g) || (px.b != first.b)) {
+          uniform = false;
+        }
+      }
+    }
+    SDL_UnlockSurface(&surface);
+
+    fills.at(type) = {opaque, opaque && uniform, first};
+  }
+
+  /**
+   * Record the fill of tiles laid out in rows on a page
+   * (call with the page pixels before they are freed)
+   * @param first      the type of the first tile on the page
+   * @param tiles_wide the number of tiles in each row
+   * @param count      the number of tile types on the page
+   * @param surface    the page pixels
+   */
+  void tileset_t::summarize_page(int first, int tiles_wide, int count, SDL_Surface& surface) {
+    for (int i=0; i<count; i++) {
+      summarize_tile(first + i, surface, {(i % tiles_wide) * tile_dim,
+                                          (i / tiles_wide) * tile_dim,
+                                          tile_dim,
+                                          tile_dim});
+    }
+  }
+
+  /**
+   * Check whether a tile type covers everything behind it
+   * @param  type the tile type
+   * @return      whether every pixel is opaque
+   */
+  bool tileset_t::is_opaque(int type) const {
+    return (type >= 0) && (type < (int)fills.size()) && fills.at(type).opaque;
+  }
+
+  /**
+   * Get the colour of a tile type that is a single opaque colour
+   * @param  type  the tile type
+   * @param  color the colour (set by the call)
+   * @return       whether the tile is a single opaque colour
+   */
+  bool tileset_t::get_fill(int type, SDL_Color& color) const {
+    if ((type >= 0) && (type < (int)fills.size()) && fills.at(type).uniform) {
+      color = fills.at(type).color;
+      return true;
+    }
+    return false;
+  }
+
+  /**
+   * Load only some tiles, packed into compact pages
+   * (types keep their ids, others render nothing)
+   * Throws rsrc_exception_t
+   * @param rsrc_path the path to the image file
+   * @param renderer  the sdl renderer for loading the texture
+   * @param used      the tile types to load
+   */
+  void tileset_t::load_compact(const std::string& rsrc_path,
+                               SDL_Renderer& renderer,
+                               const std::vector<int>& used) {
+    SDL_Surface *image = IMG_Load(rsrc_path.c_str());
+    if (image == NULL) {
+      throw exceptions::rsrc_exception_t(rsrc_path);
+    }
+
+    //same transparency as utils::load_texture, copy pixels as they are
+    SDL_SetColorKey(image,SDL_TRUE,SDL_MapRGB(image->format,0,0xFF,0xFF));
+    SDL_SetSurfaceBlendMode(image,SDL_BLENDMODE_NONE);
+
+    int tiles_wide = image->w / tile_dim;
+    int tiles_high = image->h / tile_dim;
+
+    //tiles in the image only
+    std::vector<int> types;
+    for (size_t i=0; i<used.size(); i++) {
+      if ((used.at(i) >= 0) && (used.at(i) < (tiles_wide * tiles_high))) {
+        types.push_back(used.at(i));
+      }
+    }
+
+    //square pages up to the max page size (or the renderer's largest texture)
+    int max_w, max_h;
+    utils::max_texture_size(renderer, max_w, max_h);
+    int max_dim = std::min(TILESET_PAGE_MAX_DIM, std::min(max_w, max_h));
+    int max_cols = std::max(1, max_dim / tile_dim);
+    size_t next = 0;
+
+    while (next < types.size()) {
+      int count = std::min((int)(types.size() - next), max_cols * max_cols);
+      int cols = std::min(count, max_cols);
+      int rows = (count + cols - 1) / cols;
+
+      SDL_Surface *page = SDL_CreateRGBSurfaceWithFormat(0,
+                                                         cols * tile_dim,
+                                                         rows * tile_dim,
+                                                         32,
+                                                         SDL_PIXELFORMAT_RGBA32);
+      if (page == NULL) {
+        SDL_FreeSurface(image);
+        throw exceptions::rsrc_exception_t(rsrc_path,
+                                           "could not create tileset page (" +
+                                           std::string(SDL_GetError()) + ")");
+      }
+      SDL_FillRect(page, NULL, 0);
+
+      for (int i=0; i<count; i++) {
+        int type = types.at(next + i);
+        SDL_Rect src = {(type % tiles_wide) * tile_dim,
+                        (type / tiles_wide) * tile_dim,
+                        tile_dim, tile_dim};
+        SDL_Rect dst = {(i % cols) * tile_dim,
+                        (i / cols) * tile_dim,
+                        tile_dim, tile_dim};
+        SDL_BlitSurface(image, &src, page, &dst);
+        set_tile(type, pages.size(), dst);
+        summarize_tile(type, *page, dst);
+      }
+
+      SDL_Texture *texture = SDL_CreateTextureFromSurface(&renderer,page);
+      if (texture == NULL) {
+        SDL_FreeSurface(page);
+        SDL_FreeSurface(image);
+        throw exceptions::rsrc_exception_t(rsrc_path,
+                                           "could not create texture (" +
+                                           std::string(SDL_GetError()) + ")");
+      }
+
+      accounting::track_texture(texture, TEXTURE_FILE, page->w, page->h);
+      compositor::mirror(texture, *page);
+      pages.push_back(texture);
+      footprint += (size_t) page->w * page->h * 4;
+
+      SDL_FreeSurface(page);
+      next += count;
+    }
+
+    SDL_FreeSurface(image);
   }
 
   /**
@@ -76,22 +402,18 @@ namespace tilemap {
    */
   void tileset_t::render(SDL_Renderer& renderer, int x, int y, int type) const {
 
-    if (type >= 0) {
-      SDL_Rect sample_bounds;
-      //determine the coords of the tile within the set
-      sample_bounds.x = (type % this->tiles_wide) * this->tile_dim;
-      sample_bounds.y = (type / this->tiles_wide) * this->tile_dim;
-      sample_bounds.w = this->tile_dim;
-      sample_bounds.h = this->tile_dim;
+    if ((type >= 0) && (type < (int)tiles.size()) && (tiles.at(type).page >= 0)) {
+      //the page and coords of the tile within the set
+      const atlas::atlas_region_t& tile = tiles.at(type);
 
       //bound the image
       SDL_Rect image_bounds = {x,y,this->tile_dim,this->tile_dim};
 
       //render the texture
-      SDL_RenderCopy(&renderer,
-                     this->texture,
-                     &sample_bounds,
-                     &image_bounds);
+      draw::copy(&renderer,
+                 pages.at(tile.page),
+                 &tile.rect,
+                 &image_bounds);
     }
   }
 
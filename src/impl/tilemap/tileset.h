@@ -8,26 +8,59 @@
 #define _IO_JACKHAY_SWAMP_TILESET_H
 
 #include <string>
+#include <vector>
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL.h>
+#include "../atlas.h"
 
 namespace impl {
 namespace tilemap {
 
+  //the max width and height of a tileset page (a new page is started
+  //rather than exceeding texture size limits)
+  #define TILESET_PAGE_MAX_DIM 2048
+
+  /**
+   * Get the tile types used by some layers
+   * (cached by layer file, size and modification time)
+   * Throws rsrc_exception_t
+   * @param  layer_paths the layer files (full paths)
+   * @return             the types used (sorted)
+   */
+  std::vector<int> used_tile_types(const std::vector<std::string>& layer_paths);
+
   /**
    * Defines a loaded tileset
+   * (tiles may be spread over several texture pages)
    */
   struct tileset_t {
   private:
     //the dimension of tiles in this set
     int tile_dim;
 
-    //the complete dimensions of the set
-    int tiles_wide;
-    int tiles_high;
+    //loaded pages
+    std::vector<SDL_Texture*> pages;
 
-    //loaded tiles
-    SDL_Texture* texture = NULL;
+    //the page and bounds of each tile type
+    std::vector<atlas::atlas_region_t> tiles;
+
+    /**
+     * What a tile type's pixels cover (for skipping hidden
+     * tiles and merging single colour tiles)
+     */
+    typedef struct tile_fill_t {
+      //every pixel is opaque
+      bool opaque;
+      //every pixel is opaque and the same colour
+      bool uniform;
+      SDL_Color color;
+    } tile_fill_t;
+
+    //the fill of each tile type (if known)
+    std::vector<tile_fill_t> fills;
+
+    //the total page bytes
+    size_t footprint;
 
     /**
      * Load the tileset
@@ -38,6 +71,26 @@ namespace tilemap {
     void load(const std::string& rsrc_path,
               SDL_Renderer& renderer);
 
+    /**
+     * Load only some tiles, packed into compact pages
+     * (types keep their ids, others render nothing)
+     * Throws rsrc_exception_t
+     * @param rsrc_path the path to the image file
+     * @param renderer  the sdl renderer for loading the texture
+     * @param used      the tile types to load
+     */
+    void load_compact(const std::string& rsrc_path,
+                      SDL_Renderer& renderer,
+                      const std::vector<int>& used);
+
+    /**
+     * Record the fill of a tile type from its pixels
+     * @param type    the tile type
+     * @param surface the pixels (32 bit)
+     * @param rect    the bounds of the tile in the surface
+     */
+    void summarize_tile(int type, SDL_Surface& surface, const SDL_Rect& rect);
+
   public:
     /**
      * Constructor loads tiles, throws exception on failure
@@ -49,6 +102,19 @@ namespace tilemap {
               int tile_dim,
               SDL_Renderer& renderer);
 
+    /**
+     * Constructor loads only the tiles a level uses,
+     * throws exception on failure
+     * @param rsrc_path the path to the resource
+     * @param tile_dim  the dimensions of tiles
+     * @param renderer  the renderer for loading texture
+     * @param used      the tile types to load (see used_tile_types)
+     */
+    tileset_t(const std::string& rsrc_path,
+              int tile_dim,
+              SDL_Renderer& renderer,
+              const std::vector<int>& used);
+
     /**
      * Construct from a preloaded texture (assumes ownership)
      * @param texture the preloaded texture
@@ -59,12 +125,82 @@ namespace tilemap {
     tileset_t(SDL_Texture* texture,
               int w, int h, int tile_dim);
 
+    /**
+     * Construct without pages (added with add_page)
+     * @param tile_dim the dimension of the tiles
+     */
+    tileset_t(int tile_dim);
+
     tileset_t(const tileset_t&) = delete;
     tileset_t& operator=(const tileset_t&) = delete;
 
     //destructor
     ~tileset_t();
 
+    /**
+     * Get the size of the tileset texture
+     * @return the texture size in bytes
+     */
+    size_t get_footprint() const { return footprint; }
+
+    /**
+     * Add a page of tiles laid out in rows (assumes ownership)
+     * Tile types continue from the previous page
+     * @param texture    the page texture
+     * @param w          the width of the texture
+     * @param h          the height of the texture
+     * @param tiles_wide the number of tiles in each row
+     * @param count      the number of tile types on the page
+     */
+    void add_page(SDL_Texture* texture, int w, int h, int tiles_wide, int count);
+
+    /**
+     * Add a single tile type from some page
+     * @param page the page index
+     * @param rect the bounds of the tile in the page
+     */
+    void add_tile(int page, const SDL_Rect& rect);
+
+    /**
+     * Set the page and bounds of some tile type
+     * (types skipped over render nothing)
+     * @param type the tile type
+     * @param page the page index
+     * @param rect the bounds of the tile in the page
+     */
+    void set_tile(int type, int page, const SDL_Rect& rect);
+
+    /**
+     * Record the fill of tiles laid out in rows on a page
+     * (call with the page pixels before they are freed)
+     * @param first      the type of the first tile on the page
+     * @param tiles_wide the number of tiles in each row
+     * @param count      the number of tile types on the page
+     * @param surface    the page pixels
+     */
+    void summarize_page(int first, int tiles_wide, int count, SDL_Surface& surface);
+
+    /**
+     * Check whether a tile type covers everything behind it
+     * @param  type the tile type
+     * @return      whether every pixel is opaque
+     */
+    bool is_opaque(int type) const;
+
+    /**
+     * Get the colour of a tile type that is a single opaque colour
+     * @param  type  the tile type
+     * @param  color the colour (set by the call)
+     * @return       whether the tile is a single opaque colour
+     */
+    bool get_fill(int type, SDL_Color& color) const;
+
+    /**
+     * Get the number of tile types
+     * @return the number of tile types
+     */
+    int get_tile_count() const { return tiles.size(); }
+
     /**
      * Render a tile. Takes the position of the tile
      * and the type of the tile
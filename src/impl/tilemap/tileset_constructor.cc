@@ -5,48 +5,144 @@
  */
 
 #include "tileset_constructor.h"
+#include "../accounting.h"
+#include "../exceptions.h"
+#include "../utils.h"
+#include <algorithm>
 
 namespace impl {
 namespace tilemap {
 
+  //fnv-1a
+  #define TILE_HASH_BASIS 14695981039346656037ULL
+  #define TILE_HASH_PRIME 1099511628211ULL
+
   /**
    * Constructor
    */
   tileset_constructor_t::tileset_constructor_t(int dim)
     : dim(dim),
-      texture_constructor(),
-      last_type(-1) {}
+      pages(),
+      r(0), g(0), b(0),
+      last_type(-1),
+      finished() {}
+
+  /**
+   * Get the number of tiles in each row of a generated tileset page
+   * @param  dim the tile dimension
+   * @return     the number of columns
+   */
+  int tileset_page_cols(int dim) {
+    return std::max(1, std::min(TILESET_MAX_WIDTH, TILESET_PAGE_MAX_DIM / dim));
+  }
 
   /**
-   * Get the x offset of a tile in the map
+   * Get the number of tiles on each generated tileset page
+   * @param  dim the tile dimension
+   * @return     the number of tiles
+   */
+  int tileset_page_tiles(int dim) {
+    return tileset_page_cols(dim) * std::max(1, TILESET_PAGE_MAX_DIM / dim);
+  }
+
+  /**
+   * Get the x offset of a tile in its page
    * @param  tile the tile
    * @return      the x offset
    */
-  int tileset_constructor_t::offset_x(int tile) {
-    return (tile % TILESET_MAX_WIDTH) * dim;
+  int tileset_constructor_t::offset_x(int tile) const {
+    return ((tile % tileset_page_tiles(dim)) % tileset_page_cols(dim)) * dim;
   }
 
   /**
-   * Get the y offset of a tile in the map
+   * Get the y offset of a tile in its page
    * @param  tile the tile
    * @return the offset
    */
-  int tileset_constructor_t::offset_y(int tile) {
-    return (tile / TILESET_MAX_WIDTH) * dim;
+  int tileset_constructor_t::offset_y(int tile) const {
+    return ((tile % tileset_page_tiles(dim)) / tileset_page_cols(dim)) * dim;
+  }
+
+  /**
+   * Get the page a tile is drawn in (PRECOND: tile added)
+   * @param  tile the tile
+   * @return      the page texture constructor
+   */
+  environment::texture_constructor_t& tileset_constructor_t::page(int tile) {
+    return *pages.at(tile / tileset_page_tiles(dim));
+  }
+
+  /**
+   * Get the page a tile is drawn in (PRECOND: tile added)
+   * @param  tile the tile
+   * @return      the page texture constructor
+   */
+  const environment::texture_constructor_t& tileset_constructor_t::page(int tile) const {
+    return *pages.at(tile / tileset_page_tiles(dim));
+  }
+
+  /**
+   * Hash the pixels of a tile
+   * @param  tile the tile
+   * @return      the content hash
+   */
+  uint64_t tileset_constructor_t::hash_tile(int tile) const {
+    uint64_t h = TILE_HASH_BASIS;
+    int offx = offset_x(tile);
+    int offy = offset_y(tile);
+
+    for (int y=0; y<dim; y++) {
+      for (int x=0; x<dim; x++) {
+        Uint8 pr = 0, pg = 0, pb = 0;
+        //unset pixels hash differently from black
+        Uint32 px = page(tile).get(offx + x, offy + y, pr, pg, pb)
+                    ? (0xff000000 | (pr << 16) | (pg << 8) | pb)
+                    : 0;
+        h = (h ^ px) * TILE_HASH_PRIME;
+      }
+    }
+    return h;
+  }
+
+  /**
+   * Check if two tiles have the same pixels
+   * @param  a,b the tiles
+   * @return     whether the tiles match
+   */
+  bool tileset_constructor_t::same_tile(int a, int b) const {
+    for (int y=0; y<dim; y++) {
+      for (int x=0; x<dim; x++) {
+        Uint8 ar = 0, ag = 0, ab = 0;
+        Uint8 br = 0, bg = 0, bb = 0;
+        bool a_set = page(a).get(offset_x(a) + x, offset_y(a) + y, ar, ag, ab);
+        bool b_set = page(b).get(offset_x(b) + x, offset_y(b) + y, br, bg, bb);
+
+        if ((a_set != b_set) || (ar != br) || (ag != bg) || (ab != bb)) {
+          return false;
+        }
+      }
+    }
+    return true;
   }
 
   /**
    * Set the default drawing color
    */
   void tileset_constructor_t::set_default_color(Uint8 r, Uint8 g, Uint8 b) {
-    texture_constructor.set_default_color(r,g,b);
+    this->r = r;
+    this->g = g;
+    this->b = b;
+
+    for (size_t i=0; i<pages.size(); i++) {
+      pages.at(i)->set_default_color(r,g,b);
+    }
   }
 
   /**
    * Set a pixel
    */
   void tileset_constructor_t::set(int tile, int x, int y) {
-    texture_constructor.set(
+    page(tile).set(
       offset_x(tile) + x,
       offset_y(tile) + y
     );
@@ -57,9 +153,9 @@ namespace tilemap {
    */
   void tileset_constructor_t::fill_tile(int tile, Uint8 r, Uint8 g, Uint8 b) {
     //set the default color
-    texture_constructor.set_default_color(r,g,b);
+    set_default_color(r,g,b);
 
-    texture_constructor.set_rect(
+    page(tile).set_rect(
       offset_x(tile), offset_y(tile),
       dim,dim
     );
@@ -72,7 +168,7 @@ namespace tilemap {
    * @param w,h   dimensions
    */
   void tileset_constructor_t::draw_rect(int tile, int x, int y, int w, int h) {
-    texture_constructor.set_rect(
+    page(tile).set_rect(
       offset_x(tile), offset_y(tile),
       w,h
     );
@@ -89,7 +185,7 @@ namespace tilemap {
     int offy = offset_y(tile);
 
     //set the line with the correct offset
-    texture_constructor.set_line(
+    page(tile).set_line(
       x1 + offx,
       y1 + offy,
       x2 + offx,
@@ -105,7 +201,7 @@ namespace tilemap {
    * @param y    pos y
    */
   void tileset_constructor_t::erase(int tile, int x, int y) {
-    texture_constructor.erase(x + offset_x(tile), y + offset_y(tile));
+    page(tile).erase(x + offset_x(tile), y + offset_y(tile));
   }
 
   /**
@@ -117,19 +213,19 @@ namespace tilemap {
    * @return the tile type
    */
   [[nodiscard]] int tileset_constructor_t::add_tile(const std::vector<environment::px_t>& pxs) {
-    last_type++;
+    int new_id = add_tile();
 
     for (size_t i=0; i<pxs.size(); i++) {
-      texture_constructor.set(
-        std::get<PINFO_POS>(pxs.at(i)).first + offset_x(last_type),
-        std::get<PINFO_POS>(pxs.at(i)).second + offset_y(last_type),
+      page(new_id).set(
+        std::get<PINFO_POS>(pxs.at(i)).first + offset_x(new_id),
+        std::get<PINFO_POS>(pxs.at(i)).second + offset_y(new_id),
         std::get<0>(std::get<PINFO_RGB>(pxs.at(i))),
         std::get<1>(std::get<PINFO_RGB>(pxs.at(i))),
         std::get<2>(std::get<PINFO_RGB>(pxs.at(i)))
       );
     }
 
-    return last_type;
+    return new_id;
   }
 
   /**
@@ -138,19 +234,182 @@ namespace tilemap {
    */
   [[nodiscard]] int tileset_constructor_t::add_tile() {
     last_type++;
+
+    //start a new page
+    if ((last_type / tileset_page_tiles(dim)) >= (int)pages.size()) {
+      pages.push_back(std::make_unique<environment::texture_constructor_t>());
+      pages.back()->set_default_color(r,g,b);
+    }
+
+    //the page covers the whole tile (even if pixels are left unset)
+    page(last_type).include(offset_x(last_type), offset_y(last_type));
+    page(last_type).include(offset_x(last_type) + dim - 1, offset_y(last_type) + dim - 1);
     return last_type;
   }
 
+  /**
+   * Finish drawing a tile: if an earlier finished tile has the same
+   * pixels, the new tile is erased (its space reused when it was the
+   * last tile added) and the earlier one is returned
+   * Note: finished tiles may be shared, use copy_tile to edit one
+   * @param  tile the tile
+   * @return      the tile type to use
+   */
+  [[nodiscard]] int tileset_constructor_t::finish_tile(int tile) {
+    std::vector<int>& candidates = finished[hash_tile(tile)];
+
+    for (size_t i=0; i<candidates.size(); i++) {
+      int other = candidates.at(i);
+      if ((other != tile) && same_tile(other, tile)) {
+        page(tile).erase_rect(offset_x(tile), offset_y(tile), dim, dim);
+
+        //reuse the space
+        if (tile == last_type) {
+          int local = tile % tileset_page_tiles(dim);
+          int cols = tileset_page_cols(dim);
+          last_type--;
+
+          if (local == 0) {
+            //the page is empty
+            pages.pop_back();
+          } else {
+            page(last_type).shrink(std::min(local, cols) * dim,
+                                   (((local - 1) / cols) + 1) * dim);
+          }
+        }
+        return other;
+      }
+    }
+
+    candidates.push_back(tile);
+    return tile;
+  }
+
+  /**
+   * Create a new tile with the pixels of another
+   * @param  tile the tile to copy
+   * @return      the new tile type
+   */
+  [[nodiscard]] int tileset_constructor_t::copy_tile(int tile) {
+    int new_id = add_tile();
+
+    for (int y=0; y<dim; y++) {
+      for (int x=0; x<dim; x++) {
+        Uint8 pr, pg, pb;
+        if (page(tile).get(offset_x(tile) + x, offset_y(tile) + y, pr, pg, pb)) {
+          page(new_id).set(offset_x(new_id) + x, offset_y(new_id) + y, pr, pg, pb);
+        }
+      }
+    }
+    return new_id;
+  }
+
   /**
    * Generate the tileset so far
    * @param renderer the renderer
    * @return the tileset
    */
   std::shared_ptr<tileset_t> tileset_constructor_t::generate_tileset(SDL_Renderer& renderer) const {
-    int tsw,tsh;
-    SDL_Texture *t = texture_constructor.generate(renderer,tsw,tsh);
-    //make tileset
-    return std::make_shared<tileset_t>(t,tsw,tsh,dim);
+    return upload_tileset(renderer, generate_surfaces(), dim, get_tile_count());
+  }
+
+  /**
+   * Generate the tileset pixel buffers so far
+   * @return the surface for each page (caller frees or uploads)
+   */
+  std::vector<SDL_Surface*> tileset_constructor_t::generate_surfaces() const {
+    std::vector<SDL_Surface*> surfaces;
+    for (size_t i=0; i<pages.size(); i++) {
+      surfaces.push_back(pages.at(i)->generate_surface());
+    }
+    return surfaces;
+  }
+
+  /**
+   * Make a tileset from generated pages (frees the surfaces, even if it throws)
+   * Pages taller than the renderer's largest texture are uploaded in bands
+   * of rows, throws gen exception if a page is too wide or can't be uploaded
+   * @param  renderer the renderer
+   * @param  surfaces the pixels for each page
+   * @param  dim      the tile dimension
+   * @param  count    the number of tile types over all pages
+   * @return          the tileset
+   */
+  std::shared_ptr<tileset_t> upload_tileset(SDL_Renderer& renderer,
+                                            const std::vector<SDL_Surface*>& surfaces,
+                                            int dim,
+                                            int count) {
+    std::shared_ptr<tileset_t> tileset = std::make_shared<tileset_t>(dim);
+    int cols = tileset_page_cols(dim);
+
+    //pages are generated at TILESET_PAGE_MAX_DIM, the renderer may allow less
+    int max_w, max_h;
+    utils::max_texture_size(renderer, max_w, max_h);
+    int band_rows = max_h / dim;
+
+    for (size_t i=0; i<surfaces.size(); i++) {
+      SDL_Surface *page = surfaces.at(i);
+
+      if ((page->w > max_w) || (band_rows < 1)) {
+        //tiles can't be moved to other columns (the layout is fixed)
+        std::string size = std::to_string(page->w) + "x" + std::to_string(page->h);
+        for (size_t j=i; j<surfaces.size(); j++) {
+          SDL_FreeSurface(surfaces.at(j));
+        }
+        throw exceptions::gen_exception_t("tileset page " + size + " doesn't fit the largest texture");
+      }
+
+      //every page but the last is full
+      int page_count = std::max(0, std::min(tileset_page_tiles(dim),
+                                            count - tileset->get_tile_count()));
+
+      //find opaque and single colour tiles before the pixels are freed
+      tileset->summarize_page(tileset->get_tile_count(), cols, page_count, *page);
+
+      try {
+        int rows = page->h / dim;
+        for (int r=0; (r < rows) && ((r * cols) < page_count); r+=band_rows) {
+          int band_h = std::min(band_rows, rows - r) * dim;
+          int band_count = std::min(page_count - (r * cols), band_rows * cols);
+
+          //the whole page or a view of some of its rows (pixels not copied)
+          SDL_Surface *band = page;
+          if (band_h != page->h) {
+            band = SDL_CreateRGBSurfaceWithFormatFrom((Uint8*) page->pixels + ((size_t) r * dim * page->pitch),
+                                                      page->w, band_h, 32, page->pitch,
+                                                      page->format->format);
+            if (band == NULL) {
+              throw exceptions::gen_exception_t("failed to split tileset page: " +
+                                                std::string(SDL_GetError()));
+            }
+          }
+
+          if (band == page) {
+            //freed with the band
+            page = NULL;
+          }
+
+          //frees the band (a view doesn't own the page pixels)
+          int tsw,tsh;
+          SDL_Texture *t = environment::upload_surface(renderer,band,tsw,tsh);
+          accounting::track_texture(t, TEXTURE_TILESET, tsw, tsh);
+          tileset->add_page(t, tsw, tsh, cols, band_count);
+        }
+      } catch (exceptions::gen_exception_t&) {
+        if (page != NULL) {
+          SDL_FreeSurface(page);
+        }
+        for (size_t j=i+1; j<surfaces.size(); j++) {
+          SDL_FreeSurface(surfaces.at(j));
+        }
+        throw;
+      }
+
+      if (page != NULL) {
+        SDL_FreeSurface(page);
+      }
+    }
+    return tileset;
   }
 
 }}
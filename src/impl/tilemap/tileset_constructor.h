@@ -10,6 +10,8 @@
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL.h>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 #include "tileset.h"
 #include "../environment/texture_constructor.h"
 
@@ -19,33 +21,77 @@ namespace tilemap {
   //the max width of a tileset row
   #define TILESET_MAX_WIDTH 64
 
+  /**
+   * Get the number of tiles in each row of a generated tileset page
+   * @param  dim the tile dimension
+   * @return     the number of columns
+   */
+  int tileset_page_cols(int dim);
+
+  /**
+   * Get the number of tiles on each generated tileset page
+   * @param  dim the tile dimension
+   * @return     the number of tiles
+   */
+  int tileset_page_tiles(int dim);
+
   /*
-   * Procedurally generated background
-   * Contains foliage, etc
+   * Procedurally generated tileset
+   * Tiles are laid out in rows over one or more pages
    */
   struct tileset_constructor_t {
   private:
     //the dimension of tiles
     int dim;
-    //texture constructor
-    environment::texture_constructor_t texture_constructor;
+    //texture constructor for each page
+    std::vector<std::unique_ptr<environment::texture_constructor_t>> pages;
+
+    //default drawing color
+    Uint8 r;
+    Uint8 g;
+    Uint8 b;
 
     //the last type
     int last_type;
 
+    //finished tiles by content hash
+    std::unordered_map<uint64_t, std::vector<int>> finished;
+
     /**
-     * Get the x offset of a tile in the map
+     * Get the x offset of a tile in its page
      * @param  tile the tile
      * @return      the x offset
      */
-    int offset_x(int tile);
+    int offset_x(int tile) const;
 
     /**
-     * Get the y offset of a tile in the map
+     * Get the y offset of a tile in its page
      * @param  tile the tile
      * @return the offset
      */
-    int offset_y(int tile);
+    int offset_y(int tile) const;
+
+    /**
+     * Get the page a tile is drawn in (PRECOND: tile added)
+     * @param  tile the tile
+     * @return      the page texture constructor
+     */
+    environment::texture_constructor_t& page(int tile);
+    const environment::texture_constructor_t& page(int tile) const;
+
+    /**
+     * Hash the pixels of a tile
+     * @param  tile the tile
+     * @return      the content hash
+     */
+    uint64_t hash_tile(int tile) const;
+
+    /**
+     * Check if two tiles have the same pixels
+     * @param  a,b the tiles
+     * @return     whether the tiles match
+     */
+    bool same_tile(int a, int b) const;
 
   public:
     /**
@@ -116,14 +162,58 @@ namespace tilemap {
      */
     [[nodiscard]] int add_tile();
 
+    /**
+     * Finish drawing a tile: if an earlier finished tile has the same
+     * pixels, the new tile is erased (its space reused when it was the
+     * last tile added) and the earlier one is returned
+     * Note: finished tiles may be shared, use copy_tile to edit one
+     * @param  tile the tile
+     * @return      the tile type to use
+     */
+    [[nodiscard]] int finish_tile(int tile);
+
+    /**
+     * Create a new tile with the pixels of another
+     * @param  tile the tile to copy
+     * @return      the new tile type
+     */
+    [[nodiscard]] int copy_tile(int tile);
+
     /**
      * Generate the tileset so far
      * @param renderer sdl renderer for generating texture
      * @return the tileset
      */
     std::shared_ptr<tileset_t> generate_tileset(SDL_Renderer& renderer) const;
+
+    /**
+     * Generate the tileset pixel buffers so far
+     * @return the surface for each page (caller frees or uploads)
+     */
+    std::vector<SDL_Surface*> generate_surfaces() const;
+
+    /**
+     * Get the number of tile types added so far
+     * @return the count
+     */
+    int get_tile_count() const { return last_type + 1; }
   };
 
+  /**
+   * Make a tileset from generated pages (frees the surfaces, even if it throws)
+   * Pages taller than the renderer's largest texture are uploaded in bands
+   * of rows, throws gen exception if a page is too wide or can't be uploaded
+   * @param  renderer the renderer
+   * @param  surfaces the pixels for each page
+   * @param  dim      the tile dimension
+   * @param  count    the number of tile types over all pages
+   * @return          the tileset
+   */
+  std::shared_ptr<tileset_t> upload_tileset(SDL_Renderer& renderer,
+                                            const std::vector<SDL_Surface*>& surfaces,
+                                            int dim,
+                                            int count);
+
 }}
 
 #endif /*_IO_JACKHAY_SWAMP_TILEMAP_TILESET_CONSTRUCTOR_H*/
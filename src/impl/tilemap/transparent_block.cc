@@ -5,8 +5,11 @@
  */
 
 #include "transparent_block.h"
+#include "../accounting.h"
 #include "../utils.h"
 #include "../exceptions.h"
+#include "../draw.h"
+#include "../arena.h"
 #include <json/nlohmann_json.h>
 #include <fstream>
 #include <algorithm>
@@ -67,20 +70,20 @@ namespace tilemap {
 
         //check for mode
         if (cfg.texture) {
-          blocks.push_back(std::make_shared<transparent_block_t>(cfg.x,
-                                                                 cfg.y,
-                                                                 cfg.w,
-                                                                 cfg.h,
-                                                                 base_path + cfg.texture_path,
-                                                                 renderer));
+          blocks.push_back(arena::make_level<transparent_block_t>(cfg.x,
+                                                                  cfg.y,
+                                                                  cfg.w,
+                                                                  cfg.h,
+                                                                  base_path + cfg.texture_path,
+                                                                  renderer));
         } else {
-          blocks.push_back(std::make_shared<transparent_block_t>(cfg.x,
-                                                                 cfg.y,
-                                                                 cfg.w,
-                                                                 cfg.h,
-                                                                 DEFAULT_R,
-                                                                 DEFAULT_G,
-                                                                 DEFAULT_B));
+          blocks.push_back(arena::make_level<transparent_block_t>(cfg.x,
+                                                                  cfg.y,
+                                                                  cfg.w,
+                                                                  cfg.h,
+                                                                  DEFAULT_R,
+                                                                  DEFAULT_G,
+                                                                  DEFAULT_B));
         }
       }
 
@@ -136,7 +139,7 @@ namespace tilemap {
    */
   transparent_block_t::~transparent_block_t() {
     if (texture != NULL) {
-      SDL_DestroyTexture(texture);
+      accounting::free_texture(texture);
     }
   }
 
@@ -185,7 +188,7 @@ namespace tilemap {
   void transparent_block_t::render(SDL_Renderer& renderer,
                                   const SDL_Rect& camera,
                                   bool debug) const {
-    if (this->is_collided(camera,true) && !transparent) {
+    if (draw::visible(this->is_collided(camera,true) && !transparent)) {
 
       if (texture != NULL) {
         //render the texture
@@ -199,10 +202,10 @@ namespace tilemap {
                                  texture_w,texture_h};
 
         //render the texture
-        SDL_RenderCopy(&renderer,
-                       texture,
-                       &sample_bounds,
-                       &image_bounds);
+        draw::copy(&renderer,
+                   texture,
+                   &sample_bounds,
+                   &image_bounds);
       } else {
         SDL_SetRenderDrawColor(&renderer,r,g,b,255);
 
@@ -210,7 +213,7 @@ namespace tilemap {
                               (bounds.y - (bounds.h / 2)) - camera.y,
                               bounds.w,bounds.h};
         //render rect
-        SDL_RenderFillRect(&renderer,&fill_rect);
+        draw::fill_rect(&renderer,&fill_rect);
       }
 
       if (debug) {
@@ -221,7 +224,7 @@ namespace tilemap {
         //set the draw color
         SDL_SetRenderDrawColor(&renderer,255,255,0,255);
         //render the bounds
-        SDL_RenderDrawRect(&renderer,&debug_bounds);
+        draw::rect(&renderer,&debug_bounds);
       }
     }
   }
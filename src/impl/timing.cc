@@ -0,0 +1,168 @@
+/*
+ * (C) 2021 Jack Hay
+ *
+ * Untitled Swamp game
+ */
+
+#include "timing.h"
+#include "draw.h"
+#include <algorithm>
+
+namespace impl {
+namespace timing {
+
+  /**
+   * Constructor
+   * @param capacity the number of durations kept
+   */
+  recorder_t::recorder_t(size_t capacity)
+    : samples(std::max((size_t) 1, capacity), 0.0f),
+      next(0),
+      count(0),
+      sorted(),
+      lock() {
+    sorted.reserve(samples.size());
+  }
+
+  /**
+   * Record a duration
+   * @param ms the duration in milliseconds
+   */
+  void recorder_t::record(float ms) {
+    std::unique_lock<std::mutex> lk(lock);
+    samples.at(next) = ms;
+    next = (next + 1) % samples.size();
+    count = std::min(count + 1, samples.size());
+  }
+
+  /**
+   * Record the time since a start point
+   * @param start the start point
+   */
+  void recorder_t::record_since(std::chrono::steady_clock::time_point start) {
+    std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    record(elapsed.count());
+  }
+
+  /**
+   * Get the value at a percentile of sorted durations
+   * @param  sorted the sorted durations (not empty)
+   * @param  p      the percentile (0 to 1)
+   * @return        the duration
+   */
+  static float percentile(const std::vector<float>& sorted, float p) {
+    size_t idx = (size_t) (p * (sorted.size() - 1) + 0.5f);
+    return sorted.at(std::min(idx, sorted.size() - 1));
+  }
+
+  /**
+   * Summarize the recent durations
+   * @return the stats (all zero if nothing recorded)
+   */
+  stats_t recorder_t::get_stats() const {
+    std::unique_lock<std::mutex> lk(lock);
+    if (count == 0) {
+      return {0.0f, 0.0f, 0.0f, 0.0f, 0};
+    }
+
+    //order doesn't matter here
+    sorted.assign(samples.begin(), samples.begin() + count);
+    std::sort(sorted.begin(), sorted.end());
+
+    return {percentile(sorted, 0.5f),
+            percentile(sorted, 0.95f),
+            percentile(sorted, 0.99f),
+            sorted.back(),
+            count};
+  }
+
+  /**
+   * Copy the recent durations, oldest first
+   * @param out the durations (set by the call)
+   */
+  void recorder_t::get_samples(std::vector<float>& out) const {
+    std::unique_lock<std::mutex> lk(lock);
+    out.clear();
+
+    size_t first = (count < samples.size()) ? 0 : next;
+    for (size_t i=0; i<count; i++) {
+      out.push_back(samples.at((first + i) % samples.size()));
+    }
+  }
+
+  /**
+   * Render thread frame durations (start to start)
+   * @return the recorder
+   */
+  recorder_t& frames() {
+    static recorder_t recorder;
+    return recorder;
+  }
+
+  /**
+   * Update thread tick durations (the update work)
+   * @return the recorder
+   */
+  recorder_t& ticks() {
+    static recorder_t recorder;
+    return recorder;
+  }
+
+  /**
+   * Input latency (from sdl receiving an event to the tick applying it)
+   * @return the recorder
+   */
+  recorder_t& input() {
+    static recorder_t recorder;
+    return recorder;
+  }
+
+  /**
+   * Draw recent durations as a bar graph
+   * Bars over the budget are red, the budget is marked
+   * @param renderer the renderer
+   * @param recorder the durations
+   * @param bounds   the graph position on screen
+   * @param budget   the target duration in milliseconds (half the graph height)
+   */
+  void render_graph(SDL_Renderer& renderer,
+                    const recorder_t& recorder,
+                    const SDL_Rect& bounds,
+                    float budget) {
+    //reused between frames (render thread)
+    static std::vector<float> recent;
+    recorder.get_samples(recent);
+
+    //backing
+    SDL_SetRenderDrawColor(&renderer,0,0,0,255);
+    draw::fill_rect(&renderer,&bounds);
+
+    int bar_w = std::max(1, bounds.w / (int) recorder.get_capacity());
+    int bottom = bounds.y + bounds.h;
+
+    //the most recent that fit
+    size_t first = recent.size() - std::min(recent.size(), (size_t) (bounds.w / bar_w));
+
+    //within budget
+    SDL_SetRenderDrawColor(&renderer,0,200,0,255);
+    for (int over=0; over<2; over++) {
+      for (size_t i=first; i<recent.size(); i++) {
+        if ((recent.at(i) > budget) != (over == 1)) {
+          continue;
+        }
+
+        int h = (int) std::min((float) bounds.h, (recent.at(i) / (budget * 2)) * bounds.h);
+        SDL_Rect bar = {bounds.x + ((int) (i - first) * bar_w), bottom - h, bar_w, h};
+        draw::fill_rect(&renderer,&bar);
+      }
+      //over budget
+      SDL_SetRenderDrawColor(&renderer,220,0,0,255);
+    }
+
+    //the budget
+    SDL_SetRenderDrawColor(&renderer,255,255,255,255);
+    draw::line(&renderer,
+               bounds.x, bottom - (bounds.h / 2),
+               bounds.x + bounds.w - 1, bottom - (bounds.h / 2));
+  }
+}}
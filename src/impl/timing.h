@@ -0,0 +1,125 @@
+/*
+ * (C) 2021 Jack Hay
+ *
+ * Untitled Swamp game
+ */
+
+#ifndef _IO_JACKHAY_SWAMP_TIMING_H
+#define _IO_JACKHAY_SWAMP_TIMING_H
+
+#include <SDL2/SDL.h>
+#include <vector>
+#include <mutex>
+#include <chrono>
+
+namespace impl {
+namespace timing {
+
+  //the number of recent durations kept
+  #define TIMING_SAMPLES 240
+
+  /**
+   * Summary of the recent durations (milliseconds)
+   */
+  struct stats_t {
+    float p50;
+    float p95;
+    float p99;
+    float max;
+    //the number of durations summarized
+    size_t count;
+  };
+
+  /**
+   * Keeps the most recent durations in a ring
+   * (recorded and read from different threads)
+   */
+  struct recorder_t {
+  private:
+    //durations in milliseconds
+    std::vector<float> samples;
+
+    //the next sample to overwrite
+    size_t next;
+
+    //the number of samples recorded (up to capacity)
+    size_t count;
+
+    //sorted copy for percentiles (reused)
+    mutable std::vector<float> sorted;
+
+    mutable std::mutex lock;
+
+  public:
+    /**
+     * Constructor
+     * @param capacity the number of durations kept
+     */
+    recorder_t(size_t capacity=TIMING_SAMPLES);
+    recorder_t(const recorder_t&) = delete;
+    recorder_t& operator=(const recorder_t&) = delete;
+
+    /**
+     * Record a duration
+     * @param ms the duration in milliseconds
+     */
+    void record(float ms);
+
+    /**
+     * Record the time since a start point
+     * @param start the start point
+     */
+    void record_since(std::chrono::steady_clock::time_point start);
+
+    /**
+     * Summarize the recent durations
+     * @return the stats (all zero if nothing recorded)
+     */
+    stats_t get_stats() const;
+
+    /**
+     * Copy the recent durations, oldest first
+     * @param out the durations (set by the call)
+     */
+    void get_samples(std::vector<float>& out) const;
+
+    /**
+     * Get the number of durations kept
+     * @return the capacity
+     */
+    size_t get_capacity() const { return samples.size(); }
+  };
+
+  /**
+   * Render thread frame durations (start to start)
+   * @return the recorder
+   */
+  recorder_t& frames();
+
+  /**
+   * Update thread tick durations (the update work)
+   * @return the recorder
+   */
+  recorder_t& ticks();
+
+  /**
+   * Input latency (from sdl receiving an event to the tick applying it)
+   * @return the recorder
+   */
+  recorder_t& input();
+
+  /**
+   * Draw recent durations as a bar graph
+   * Bars over the budget are red, the budget is marked
+   * @param renderer the renderer
+   * @param recorder the durations
+   * @param bounds   the graph position on screen
+   * @param budget   the target duration in milliseconds (half the graph height)
+   */
+  void render_graph(SDL_Renderer& renderer,
+                    const recorder_t& recorder,
+                    const SDL_Rect& bounds,
+                    float budget);
+}}
+
+#endif /*_IO_JACKHAY_SWAMP_TIMING_H*/
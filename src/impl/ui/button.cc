@@ -5,8 +5,10 @@
  */
 
 #include "button.h"
+#include "../accounting.h"
 #include "colors.h"
 #include "../utils.h"
+#include "../draw.h"
 
 namespace impl {
 namespace ui {
@@ -43,7 +45,7 @@ namespace ui {
   button_t::~button_t() {
     //free the texture
     if (texture != NULL) {
-      SDL_DestroyTexture(texture);
+      accounting::free_texture(texture);
       texture = NULL;
     }
   }
@@ -120,7 +122,7 @@ namespace ui {
       SDL_Rect rect = {x,y,w,h};
 
       //render the bounds
-      SDL_RenderDrawRect(&renderer,&rect);
+      draw::rect(&renderer,&rect);
 
       //set the draw color
       SDL_SetRenderDrawColor(&renderer,R_FILL,G_FILL,B_FILL,255);
@@ -128,16 +130,16 @@ namespace ui {
       SDL_Rect fill = {x+1,y+1,w-2,h-2};
 
       //render the fill
-      SDL_RenderFillRect(&renderer,&fill);
+      draw::fill_rect(&renderer,&fill);
 
       SDL_SetRenderDrawColor(&renderer,R_HIGHLIGHT,G_HIGHLIGHT,B_HIGHLIGHT,255);
 
       //render the highlight
       //vert
-      SDL_RenderDrawLine(&renderer,x+1,y+h-1,x+w-2,y+h-1);
+      draw::line(&renderer,x+1,y+h-1,x+w-2,y+h-1);
 
       //horiz
-      SDL_RenderDrawLine(&renderer,x+w-1,y+1,x+w-1,y+h-1);
+      draw::line(&renderer,x+w-1,y+1,x+w-1,y+h-1);
 
     } else {
       //render the button
@@ -146,7 +148,7 @@ namespace ui {
       SDL_Rect rect = {x,y,w,h};
 
       //render the bounds
-      SDL_RenderDrawRect(&renderer,&rect);
+      draw::rect(&renderer,&rect);
 
       //set the draw color
       SDL_SetRenderDrawColor(&renderer,R_BORDER,G_BORDER,B_BORDER,255);
@@ -154,14 +156,14 @@ namespace ui {
       SDL_Rect fill = {x+1,y+1,w-2,h-2};
 
       //render the fill
-      SDL_RenderFillRect(&renderer,&fill);
+      draw::fill_rect(&renderer,&fill);
 
       SDL_SetRenderDrawColor(&renderer,R_HIGHLIGHT,G_HIGHLIGHT,B_HIGHLIGHT,255);
 
       //render the highlight
-      SDL_RenderDrawLine(&renderer,x,y,x + w - 2,y);
+      draw::line(&renderer,x,y,x + w - 2,y);
 
-      SDL_RenderDrawLine(&renderer,x,y,x,y + h - 1);
+      draw::line(&renderer,x,y,x,y + h - 1);
     }
 
     //the y position depends on the click state
@@ -178,10 +180,10 @@ namespace ui {
 
     if (texture != NULL) {
       //render the texture
-      SDL_RenderCopy(&renderer,
-                     texture,
-                     &sample_bounds,
-                     &text_bounds);
+      draw::copy(&renderer,
+                 texture,
+                 &sample_bounds,
+                 &text_bounds);
     }
   }
 }}
@@ -5,8 +5,10 @@
  */
 
 #include "map.h"
+#include "../accounting.h"
 #include "colors.h"
 #include "../utils.h"
+#include "../draw.h"
 
 namespace impl {
 namespace ui {
@@ -36,7 +38,7 @@ namespace ui {
   map_t::~map_t() {
     // free the SDL texture
     if (texture != NULL) {
-      SDL_DestroyTexture(texture);
+      accounting::free_texture(texture);
     }
   }
 
@@ -117,24 +119,24 @@ namespace ui {
     SDL_Rect rect = {x-1,y-1,texture_w + 2,texture_h + 2};
 
     //render the bounds
-    SDL_RenderDrawRect(&renderer,&rect);
+    draw::rect(&renderer,&rect);
 
     SDL_SetRenderDrawColor(&renderer,R_HIGHLIGHT,G_HIGHLIGHT,B_HIGHLIGHT,255);
 
     //render the highlight
     //horiz
-    SDL_RenderDrawLine(&renderer,
-                       x,
-                       y+texture_h,
-                       x+texture_w,
-                       y+texture_h);
+    draw::line(&renderer,
+               x,
+               y+texture_h,
+               x+texture_w,
+               y+texture_h);
 
     //vert
-    SDL_RenderDrawLine(&renderer,
-                       x+texture_w,
-                       y,
-                       x+texture_w,
-                       y+texture_h-1);
+    draw::line(&renderer,
+               x+texture_w,
+               y,
+               x+texture_w,
+               y+texture_h-1);
 
     //render the texture
     //create a clip for the current frame
@@ -144,10 +146,10 @@ namespace ui {
     SDL_Rect image_bounds = {x,y,texture_w,texture_h};
 
     //render the texture
-    SDL_RenderCopy(&renderer,
-                   texture,
-                   &sample_bounds,
-                   &image_bounds);
+    draw::copy(&renderer,
+               texture,
+               &sample_bounds,
+               &image_bounds);
   }
 
 }}
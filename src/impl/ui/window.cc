@@ -7,6 +7,7 @@
 #include "window.h"
 #include <iostream>
 #include "colors.h"
+#include "../draw.h"
 
 namespace impl {
 namespace ui {
@@ -144,13 +145,9 @@ namespace ui {
    */
   void window_t::handle_event(const SDL_Event& e) {
     if (e.type == SDL_MOUSEMOTION) {
-     int mx = 0;
-     int my = 0;
-     SDL_GetMouseState(&mx,&my);
-
-     //scale the position
-     cursor_x = mx / window_scale;
-     cursor_y = my / window_scale;
+     //scale the position (from the event, it may have been queued)
+     cursor_x = e.motion.x / window_scale;
+     cursor_y = e.motion.y / window_scale;
     } else if ((e.type == SDL_MOUSEBUTTONDOWN) &&
               (e.button.button == SDL_BUTTON_LEFT)) {
 
@@ -188,7 +185,7 @@ namespace ui {
     SDL_Rect rect = {x,y,w,h};
 
     //render the bounds
-    SDL_RenderDrawRect(&renderer,&rect);
+    draw::rect(&renderer,&rect);
 
     //set the draw color
     SDL_SetRenderDrawColor(&renderer,R_FILL,G_FILL,B_FILL,255);
@@ -196,14 +193,14 @@ namespace ui {
     SDL_Rect fill = {x+1,y+1,w-2,h-2};
 
     //render the fill
-    SDL_RenderFillRect(&renderer,&fill);
+    draw::fill_rect(&renderer,&fill);
 
     SDL_SetRenderDrawColor(&renderer,R_HIGHLIGHT,G_HIGHLIGHT,B_HIGHLIGHT,255);
 
     //render the highlight
-    SDL_RenderDrawLine(&renderer,x,y,x + w - 2,y);
+    draw::line(&renderer,x,y,x + w - 2,y);
 
-    SDL_RenderDrawLine(&renderer,x,y,x,y + h - 1);
+    draw::line(&renderer,x,y,x,y + h - 1);
 
     for (size_t i=0; i<subcomponents.size(); i++) {
       for (size_t j=0; j<subcomponents.at(i).size(); j++) {
@@ -213,13 +210,13 @@ namespace ui {
 
     // Render the cursor
     SDL_SetRenderDrawColor(&renderer,0,0,0,225);
-    SDL_RenderDrawPoint(&renderer,cursor_x,cursor_y);
-    SDL_RenderDrawPoint(&renderer,cursor_x - 1,cursor_y);
-    SDL_RenderDrawPoint(&renderer,cursor_x - 1,cursor_y - 1);
-    SDL_RenderDrawPoint(&renderer,cursor_x,cursor_y - 1);
-    SDL_RenderDrawPoint(&renderer,cursor_x - 1,cursor_y - 2);
-    SDL_RenderDrawPoint(&renderer,cursor_x - 1,cursor_y + 1);
-    SDL_RenderDrawPoint(&renderer,cursor_x + 1,cursor_y - 1);
-    SDL_RenderDrawPoint(&renderer,cursor_x + 1,cursor_y + 1);
+    draw::point(&renderer,cursor_x,cursor_y);
+    draw::point(&renderer,cursor_x - 1,cursor_y);
+    draw::point(&renderer,cursor_x - 1,cursor_y - 1);
+    draw::point(&renderer,cursor_x,cursor_y - 1);
+    draw::point(&renderer,cursor_x - 1,cursor_y - 2);
+    draw::point(&renderer,cursor_x - 1,cursor_y + 1);
+    draw::point(&renderer,cursor_x + 1,cursor_y - 1);
+    draw::point(&renderer,cursor_x + 1,cursor_y + 1);
   }
 }}
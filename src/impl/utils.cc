@@ -6,7 +6,11 @@
 
 #include "utils.h"
 #include "exceptions.h"
-#include "logger.h"
+#include "accounting.h"
+#include "compositor.h"
+#include "text.h"
+#include "metrics.h"
+#include <climits>
 
 namespace impl {
 namespace utils {
@@ -47,6 +51,12 @@ namespace utils {
     w = surface->w;
     h = surface->h;
 
+    accounting::track_texture(texture, TEXTURE_FILE, w, h);
+    compositor::mirror(texture, *surface);
+
+    static metrics::counter_t& loaded = metrics::counter("textures_loaded");
+    loaded.add();
+
     //free surface
     SDL_FreeSurface(surface);
     return texture;
@@ -70,17 +80,11 @@ namespace utils {
                          int size, int& w, int& h,
                          SDL_Color color) {
 
-    //load the font by path
-    TTF_Font *font = TTF_OpenFont(font_path.c_str(), size);
-    if (!font) {
-      //failed to load the font
-      throw exceptions::rsrc_exception_t(font_path,
-                                         "could not load font (" +
-                                         std::string(TTF_GetError()) + ")");
-    }
+    //opened once and shared
+    TTF_Font& font = text::get_font(font_path, size);
 
     //load the text surface
-    SDL_Surface* text_surface = TTF_RenderText_Solid(font,text.c_str(),color);
+    SDL_Surface* text_surface = TTF_RenderText_Solid(&font,text.c_str(),color);
     if (!text_surface) {
       throw exceptions::rsrc_exception_t(font_path,
                                          "could not create text surface from font");
@@ -93,6 +97,9 @@ namespace utils {
     w = text_surface->w;
     h = text_surface->h;
 
+    accounting::track_texture(text_texture, TEXTURE_FONT, w, h);
+    compositor::mirror(text_texture, *text_surface);
+
     //free the original surface
     SDL_FreeSurface(text_surface);
 
@@ -106,35 +113,38 @@ namespace utils {
    * @param x        the position x
    * @param y        the position y
    * @param font     the loaded ttf font
+   * @param scale    window pixels per position unit (overlays)
    */
   void render_text(SDL_Renderer& renderer,
                    const std::string& text,
                    int x, int y,
-                   TTF_Font& font) {
-
-     SDL_Surface* text_s;
-     SDL_Color color = {255,255,255};
-
-     //create text for debug
-     text_s = TTF_RenderText_Solid(&font,text.c_str(),color);
+                   TTF_Font& font,
+                   int scale) {
+    SDL_Color color = {255,255,255,255};
 
-     if (!text_s) {
-       logger::log_err("failed to render text: " + std::string(TTF_GetError()));
-
-     } else {
-       //create a texture
-       SDL_Texture* text_texture = SDL_CreateTextureFromSurface(&renderer,text_s);
-
-       SDL_Rect sample = {0,0,text_s->w,text_s->h};
-       //the position on screen
-       SDL_Rect dest = {x,y,text_s->w,text_s->h};
-
-       //render the text
-       SDL_RenderCopy(&renderer,text_texture,&sample,&dest);
+    //glyphs are packed once per font
+    text::get_glyphs(renderer,font).draw(renderer,text,x * scale,y * scale,color);
+  }
 
-       //free
-       SDL_DestroyTexture(text_texture);
-       SDL_FreeSurface(text_s);
-     }
+  /**
+   * Get the largest texture the renderer can create
+   * (INT_MAX when the renderer doesn't report a limit)
+   * @param renderer the renderer
+   * @param w        the max width set by the call
+   * @param h        the max height set by the call
+   */
+  void max_texture_size(SDL_Renderer& renderer, int& w, int& h) {
+    SDL_RendererInfo info;
+    w = INT_MAX;
+    h = INT_MAX;
+
+    if (SDL_GetRendererInfo(&renderer, &info) == 0) {
+      if (info.max_texture_width > 0) {
+        w = info.max_texture_width;
+      }
+      if (info.max_texture_height > 0) {
+        h = info.max_texture_height;
+      }
+    }
   }
 }}
@@ -53,11 +53,21 @@ namespace utils {
    * @param x        the position x
    * @param y        the position y
    * @param font     the loaded ttf font
+   * @param scale    window pixels per position unit (overlays)
    */
   void render_text(SDL_Renderer& renderer,
                    const std::string& text,
                    int x, int y,
-                   TTF_Font& font);
+                   TTF_Font& font, int scale=1);
+
+  /**
+   * Get the largest texture the renderer can create
+   * (INT_MAX when the renderer doesn't report a limit)
+   * @param renderer the renderer
+   * @param w        the max width set by the call
+   * @param h        the max height set by the call
+   */
+  void max_texture_size(SDL_Renderer& renderer, int& w, int& h);
 }}
 
 #endif /*_IO_JACKHAY_SWAMP_UTILS_H*/
@@ -13,23 +13,30 @@
 #include "impl/exceptions.h"
 #include "impl/logger.h"
 #include "impl/launcher.h"
+#include "impl/tilemap/regions.h"
 #include "updater/updater.h"
 
 /**
  * Setup the sdl window launcher
  * @param  debug whether debug mode enabled
+ * @param  software whether to composite frames on the cpu
  * @param  base_path the path to the configuration
  * @param  base_path_parent the path to the parent of the resource dir
  * @param  font_path the path to the font to use
  * @param  cfg_name  the name of the cfg file
+ * @param  split_cfg a level cfg to split into regions instead of launching ("" to launch)
+ * @param  region_cols the width of each region in tile columns
  * @param  call_count the number of times setup has run
  * @return       return value
  */
 int setup(bool debug,
+          bool software,
           const std::string& base_path,
           const std::string& base_path_parent,
           const std::string& font_path,
           const std::string& cfg_name,
+          const std::string& split_cfg,
+          int region_cols,
           int call_count) {
 
   //read from the configuration file
@@ -49,10 +56,13 @@ int setup(bool debug,
                                                   base_path_parent)) {
       //reload cfg
       return setup(debug,
+                   software,
                    base_path,
                    base_path_parent,
                    font_path,
                    cfg_name,
+                   split_cfg,
+                   region_cols,
                    call_count + 1);
     }
     #endif
@@ -63,10 +73,21 @@ int setup(bool debug,
       cfg.debug = debug;
     }
 
+    if (software) {
+      //override the render backend
+      cfg.software_compositor = software;
+    }
+
     //set base directory and font paths
     cfg.base_path = base_path;
     cfg.font = font_path;
 
+    //split a level for region streaming (offline step, no window)
+    if (!split_cfg.empty()) {
+      impl::tilemap::split_level(split_cfg, base_path, cfg.tile_dim, region_cols);
+      return EXIT_SUCCESS;
+    }
+
     //initialize from the configuration
     if (!impl::launcher::init_from_cfg(cfg)) {
       return EXIT_FAILURE;
@@ -85,10 +106,13 @@ int setup(bool debug,
     if ((call_count < 1) && updater::pull_initial(base_path,base_path_parent)) {
       //reload
       return setup(debug,
+                   software,
                    base_path,
                    base_path_parent,
                    font_path,
                    cfg_name,
+                   split_cfg,
+                   region_cols,
                    call_count + 1);
     }
     #endif
@@ -102,8 +126,12 @@ int setup(bool debug,
  * Entrypoint
  * -- Command Line Arguments --
  * -d <debug>         | whether debug mode is enabled
+ * -w <software>      | composite frames on the cpu
  * -c <config_path>   | the path to the config file
  * -b <base_path>     | directory where cfg is
+ * -s <level_cfg>     | split a level into regions and exit
+ * -r <region_cols>   | region width in tiles for -s
+ * -l <log_level>     | debug, info, warn or err (debug mode logs debug)
  *
  * @param  argc number of args
  * @param  argv cmd line args
@@ -116,9 +144,19 @@ int main(int argc, char *argv[]) {
   //whether debug mode enabled
   bool debug = false;
 
+  //whether frames are composited on the cpu
+  bool software = false;
+
   //the name of the cfg file
   std::string cfg_name = "cfg.json";
 
+  //level to split into regions (none by default)
+  std::string split_cfg = "";
+  int region_cols = REGION_DEFAULT_COLS;
+
+  //the lowest level logged (unset by default)
+  int log_level = -1;
+
   #ifdef BUILD__MACOS__
   //get the home directory
   const std::string home_dir = std::string(getenv("HOME"));
@@ -132,21 +170,44 @@ int main(int argc, char *argv[]) {
   #endif
 
   //get command line options (all values have defaults, none are required)
-  while ((c = getopt(argc, argv, "dc:b:")) != -1) {
+  while ((c = getopt(argc, argv, "dwc:b:s:r:l:")) != -1) {
     if (c == 'd') {
       //parse server port
       debug = true;
+    } else if (c == 'w') {
+      software = true;
     } else if (c == 'c') {
       cfg_name = std::string(optarg);
     } else if (c == 'b') {
       base_path = std::string(optarg);
+    } else if (c == 's') {
+      split_cfg = std::string(optarg);
+    } else if (c == 'r') {
+      region_cols = atoi(optarg);
+    } else if (c == 'l') {
+      if (!impl::logger::parse_level(std::string(optarg), log_level)) {
+        impl::logger::log_err("unknown log level: " + std::string(optarg));
+      }
     }
   }
 
+  if (log_level < 0) {
+    log_level = debug ? LOG_DEBUG : LOG_INFO;
+  }
+  impl::logger::set_level(log_level);
+  impl::logger::start();
+
   //load resources and launch
-  return setup(debug,
-               base_path,
-               base_path_parent,
-               font,
-               cfg_name,0);
+  int status = setup(debug,
+                     software,
+                     base_path,
+                     base_path_parent,
+                     font,
+                     cfg_name,
+                     split_cfg,
+                     region_cols,0);
+
+  //write any buffered messages
+  impl::logger::stop();
+  return status;
 }
@@ -0,0 +1,78 @@
+/*
+ * (C) 2021 Jack Hay
+ *
+ * Untitled Swamp game
+ */
+
+#include "impl/state/recency.h"
+#include <cassert>
+#include <stdexcept>
+#include <iostream>
+
+using impl::state::recency_t;
+
+/**
+ * Levels entered in order then a generated map added from a level
+ * (the generated map is tracked and the oldest level is evicted first)
+ */
+static void new_swamp_then_evict() {
+  recency_t recency;
+  size_t title = recency.add();
+  size_t swamp = recency.add();
+  size_t tracks = recency.add();
+
+  recency.touch(title);
+  recency.touch(swamp);
+  recency.touch(tracks);
+
+  //new swamp from a level adds a state and enters it
+  size_t generated = recency.add();
+  assert(generated == 3);
+  recency.touch(generated);
+  assert(recency.size() == 4);
+
+  //title states are never evicted, nor is the current state
+  bool evicted[4] = {false, false, false, false};
+  auto evictable = [&](size_t i) {
+    return (i != title) && (i != generated) && !evicted[i];
+  };
+
+  size_t lru = recency.oldest(evictable);
+  assert(lru == swamp);
+  evicted[lru] = true;
+
+  lru = recency.oldest(evictable);
+  assert(lru == tracks);
+  evicted[lru] = true;
+
+  //nothing left
+  assert(recency.oldest(evictable) == recency.size());
+
+  //leaving the generated map makes it evictable
+  recency.touch(swamp);
+  evicted[swamp] = false;
+  assert(recency.oldest([&](size_t i) { return i == generated || i == swamp; }) == generated);
+}
+
+/**
+ * States that were never added can't be touched
+ */
+static void touch_untracked() {
+  recency_t recency;
+  recency.add();
+
+  bool thrown = false;
+  try {
+    recency.touch(1);
+  } catch (std::out_of_range&) {
+    thrown = true;
+  }
+  assert(thrown);
+}
+
+int main() {
+  new_swamp_then_evict();
+  touch_untracked();
+  std::cout << "recency_test passed" << std::endl;
+  return 0;
+}